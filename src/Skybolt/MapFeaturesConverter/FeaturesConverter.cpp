@@ -5,15 +5,19 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "FeaturesConverter.h"
+#include "NodeLocationIndex.h"
+#include "PhaseReport.h"
 #include <SkyboltCommon/Exception.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <readosm/readosm.h>
+#include <algorithm>
 #include <sstream>
 #include <map>
-#include <set>
+#include <unordered_map>
 #include <iostream>
 #include <boost/algorithm/string.hpp>  
 #include <boost/lexical_cast.hpp>
+#include <px_sched/px_sched.h>
 
 using namespace skybolt::math;
 using skybolt::sim::LatLon;
@@ -31,32 +35,90 @@ static float calcBuildingHeightFromLevelCount(int levelCount)
 	return buildingGroundLevelHeight * (levelCount - 1) + buildingLevelHeight;
 }
 
-static LatLonAltPoints toLatLonAlt(const LatLonPoints& points, const sim::PlanetAltitudeProvider& provider)
+//! Feature whose point altitudes are sampled after parsing, so that sampling can be done in parallel
+struct PendingAltitudes
 {
-	LatLonAltPoints result(points.size());
-	int i = 0;
-	for (const LatLon& point : points)
+	enum class Mode
+	{
+		PerPoint, //!< Each point is placed on the terrain
+		Minimum //!< All points are placed at the lowest terrain altitude under the feature
+	};
+
+	PolyFeature* feature;
+	Mode mode;
+};
+
+//! Samples altitudes for a range of features with a single batched request, so that features in the same terrain tile share lookups
+static void sampleAltitudes(const PendingAltitudes* begin, const PendingAltitudes* end, const sim::PlanetAltitudeProvider& provider)
+{
+	LatLonPoints points;
+	for (const PendingAltitudes* item = begin; item != end; ++item)
 	{
-		result[i] = toLatLonAlt(point, provider.getAltitude(point));
-		++i;
+		for (const sim::LatLonAlt& point : item->feature->points)
+		{
+			points.push_back(toLatLon(point));
+		}
+	}
+
+	std::vector<double> altitudes;
+	provider.getAltitudes(points, altitudes);
+
+	size_t i = 0;
+	for (const PendingAltitudes* item = begin; item != end; ++item)
+	{
+		LatLonAltPoints& featurePoints = item->feature->points;
+		if (item->mode == PendingAltitudes::Mode::PerPoint)
+		{
+			for (sim::LatLonAlt& point : featurePoints)
+			{
+				point.alt = altitudes[i++];
+			}
+		}
+		else
+		{
+			double alt = math::posInfinity();
+			for (size_t j = 0; j < featurePoints.size(); ++j)
+			{
+				alt = std::min(alt, altitudes[i + j]);
+			}
+			for (sim::LatLonAlt& point : featurePoints)
+			{
+				point.alt = alt;
+			}
+			i += featurePoints.size();
+		}
 	}
-	return result;
 }
 
-static LatLonAltPoints toLatLonWithMinAlt(const LatLonPoints& points, const sim::PlanetAltitudeProvider& provider)
+static void sampleAltitudes(const std::vector<PendingAltitudes>& items, const sim::PlanetAltitudeProvider& provider, px_sched::Scheduler* scheduler)
 {
-	LatLonAltPoints result(points.size());
-	double alt = math::posInfinity();
-	for (const LatLon& point : points)
+	static const size_t chunkSize = 256;
+
+	if (scheduler)
+	{
+		px_sched::Sync sync;
+		for (size_t begin = 0; begin < items.size(); begin += chunkSize)
+		{
+			const PendingAltitudes* first = items.data() + begin;
+			const PendingAltitudes* last = items.data() + std::min(begin + chunkSize, items.size());
+			scheduler->run([first, last, &provider] {
+				sampleAltitudes(first, last, provider);
+			}, &sync);
+		}
+		scheduler->waitFor(sync);
+	}
+	else
 	{
-		alt = std::min(alt, provider.getAltitude(point));
+		sampleAltitudes(items.data(), items.data() + items.size(), provider);
 	}
+}
 
-	int i = 0;
-	for (const LatLon& point : points)
+static LatLonAltPoints toLatLonAltWithZeroAlt(const LatLonPoints& points)
+{
+	LatLonAltPoints result(points.size());
+	for (size_t i = 0; i < points.size(); ++i)
 	{
-		result[i] = toLatLonAlt(point, alt);
-		++i;
+		result[i] = toLatLonAlt(points[i], 0.0);
 	}
 	return result;
 }
@@ -68,8 +130,10 @@ struct ParserData
 		std::vector<long long> nodes;
 	};
 
-	std::map<long long, LatLon> nodes;
-	std::map<long long, Way> ways;
+	NodeLocationIndex nodes; //!< Locations of nodes referenced by features
+	std::vector<long long> relationWayIds; //!< Sorted IDs of ways referenced by feature relations
+	std::unordered_map<long long, Way> ways; //!< Ways referenced by feature relations
+	size_t parsedNodeCount = 0;
 
 	struct ParserAirport
 	{
@@ -81,10 +145,16 @@ struct ParserData
 	std::vector<Airport::Runway> runways;
 
 	std::vector<FeaturePtr> features;
-
-	const sim::PlanetAltitudeProvider* altitudeProvider;
+	std::vector<PendingAltitudes> pendingAltitudes;
 };
 
+//! Sets the feature's points, with altitudes to be sampled after parsing
+static void setPoints(ParserData& data, PolyFeature& feature, const LatLonPoints& points, PendingAltitudes::Mode mode)
+{
+	feature.points = toLatLonAltWithZeroAlt(points);
+	data.pendingAltitudes.push_back({&feature, mode});
+}
+
 float getHighwayRoadWidth(int laneCount) {return 3.7f * laneCount;}
 float getResidentialRoadWidth(int laneCount) {return 3.5f * laneCount;}
 
@@ -96,10 +166,11 @@ static int parseNode(const void* user_data, const readosm_node* node)
 		throw skybolt::Exception("Undefined longitude");
 
 	ParserData& data = *(ParserData*)user_data;
-	data.nodes[node->id] = LatLon(node->latitude * degToRadD(), node->longitude * degToRadD());
+	data.nodes.setLocation(node->id, LatLon(node->latitude * degToRadD(), node->longitude * degToRadD()));
 
-	if (data.nodes.size() % 1000000 == 0)
-		printf("Loaded %zu nodes\n", data.nodes.size());
+	++data.parsedNodeCount;
+	if (data.parsedNodeCount % 10000000 == 0)
+		printf("Parsed %zu nodes\n", data.parsedNodeCount);
 
 	return READOSM_OK;
 }
@@ -212,38 +283,79 @@ static void printTags(const readosm_way& way)
 	}
 }
 
+static void readPoint(long long nodeId, const ParserData& data, std::vector<LatLon>& points)
+{
+	const LatLon* location = data.nodes.findLocation(nodeId);
+	if (!location)
+	{
+		std::stringstream ss;
+		ss << nodeId;
+		throw skybolt::Exception("Invalid node ID " + ss.str());
+	}
+	points.push_back(*location);
+}
+
 static void readPoints(const readosm_way& way, const ParserData& data, std::vector<LatLon>& points)
 {
 	for (int i = 0; i < way.node_ref_count; ++i)
 	{
-		long long nodeId = way.node_refs[i];
-
-		std::map<long long, LatLon>::const_iterator it = data.nodes.find(nodeId);
-		if (it == data.nodes.end())
-		{
-			std::stringstream ss;
-			ss << nodeId;
-			throw skybolt::Exception("Invalid node ID " + ss.str());
-		}
-		points.push_back(it->second);
+		readPoint(way.node_refs[i], data, points);
 	}
 }
 
 static void readPoints(const ParserData::Way& way, const ParserData& data, std::vector<LatLon>& points)
 {
-	for (size_t i = 0; i < way.nodes.size(); ++i)
+	for (long long nodeId : way.nodes)
 	{
-		long long nodeId = way.nodes[i];
+		readPoint(nodeId, data, points);
+	}
+}
 
-		std::map<long long, LatLon>::const_iterator it = data.nodes.find(nodeId);
-		if (it == data.nodes.end())
-		{
-			std::stringstream ss;
-			ss << nodeId;
-			throw skybolt::Exception("Invalid node ID " + ss.str());
-		}
-		points.push_back(it->second);
+static bool isRoadHighway(const char* value)
+{
+	return strcmp(value, "motorway") == 0
+		|| strcmp(value, "motorway_link") == 0
+		|| strcmp(value, "trunk") == 0
+		|| strcmp(value, "primary") == 0
+		|| strcmp(value, "secondary") == 0
+		|| strcmp(value, "tertiary") == 0
+		|| strcmp(value, "residential") == 0;
+}
+
+//! @returns true if the way may produce a feature in parseWay()
+static bool isFeatureWay(const readosm_way& way)
+{
+	const char* value = getTagValue(way, "highway");
+	if (value && isRoadHighway(value))
+	{
+		return true;
+	}
+
+	if (getTag(way, "building") || getTag(way, "building:part"))
+	{
+		return true;
+	}
+
+	value = getTagValue(way, "natural");
+	if (value && strcmp(value, "water") == 0)
+	{
+		return true;
 	}
+
+	value = getTagValue(way, "aeroway");
+	return value && (strcmp(value, "aerodrome") == 0 || strcmp(value, "runway") == 0);
+}
+
+//! @returns true if the relation may produce features in parseRelation()
+static bool isFeatureRelation(const readosm_relation& relation)
+{
+	return getTagValueString(relation, "natural") == "water"
+		|| getTagValueString(relation, "aeroway") == "aerodrome";
+}
+
+static bool isRelationWay(const ParserData& data, long long wayId)
+{
+	return std::binary_search(data.relationWayIds.begin(), data.relationWayIds.end(), wayId);
 }
 
 static double longitudeDifference(double a, double b)
@@ -300,24 +412,16 @@ static int parseWay(const void* user_data, const readosm_way* way)
 	ParserData& data = *(ParserData*)user_data;
 	std::vector<FeaturePtr>& features = data.features;
 
-	ParserData::Way parsedWay;
-	for (int i = 0; i < way->node_ref_count; ++i)
+	if (isRelationWay(data, way->id))
 	{
-		parsedWay.nodes.push_back(way->node_refs[i]);
+		ParserData::Way& parsedWay = data.ways[way->id];
+		parsedWay.nodes.assign(way->node_refs, way->node_refs + way->node_ref_count);
 	}
-	data.ways[way->id] = parsedWay;
 
 	const readosm_tag* tag = getTag(*way, "highway");
 	if (tag)
 	{
-		if (strcmp(tag->value, "motorway") == 0
-			|| strcmp(tag->value, "motorway_link") == 0
-			|| strcmp(tag->value, "trunk") == 0
-			|| strcmp(tag->value, "primary") == 0
-			|| strcmp(tag->value, "secondary") == 0
-			|| strcmp(tag->value, "tertiary") == 0
-			|| strcmp(tag->value, "residential") == 0
-			)
+		if (isRoadHighway(tag->value))
 		{
 			std::shared_ptr<Road> roadPtr = std::make_shared<Road>();
 			Road& road = *roadPtr;
@@ -339,7 +443,7 @@ static int parseWay(const void* user_data, const readosm_way* way)
 
 				if (latLonPoints.size() >= 2)
 				{
-					road.points = toLatLonAlt(latLonPoints, *data.altitudeProvider);
+					setPoints(data, road, latLonPoints, PendingAltitudes::Mode::PerPoint);
 					features.push_back(roadPtr);
 				}
 			}
@@ -395,7 +499,7 @@ static int parseWay(const void* user_data, const readosm_way* way)
 
 		if (points.size() >= 2)
 		{
-			building.points = toLatLonWithMinAlt(points, *data.altitudeProvider);
+			setPoints(data, building, points, PendingAltitudes::Mode::Minimum);
 			features.push_back(buildingPtr);
 		}
 	}
@@ -413,7 +517,7 @@ static int parseWay(const void* user_data, const readosm_way* way)
 			{
 				std::shared_ptr<Water> waterPtr = std::make_shared<Water>();
 				Water& water = *waterPtr;
-				water.points = toLatLonAlt(points, *data.altitudeProvider);
+				setPoints(data, water, points, PendingAltitudes::Mode::PerPoint);
 				features.push_back(waterPtr);
 			}
 		}
@@ -463,6 +567,15 @@ static int parseWay(const void* user_data, const readosm_way* way)
 	return READOSM_OK;
 }
 
+struct LatLonHash
+{
+	size_t operator()(const LatLon& p) const
+	{
+		size_t h = std::hash<double>()(p.lat);
+		return h ^ (std::hash<double>()(p.lon) + 0x9e3779b9 + (h << 6) + (h >> 2));
+	}
+};
+
 std::vector<LatLonPoints> readMultiPolygonRelation(const readosm_relation& relation, const ParserData& data)
 {
 	std::vector<LatLonPoints> polygons;
@@ -475,9 +588,13 @@ std::vector<LatLonPoints> readMultiPolygonRelation(const readosm_relation& relat
 		{
 			if (strcmp(member.role, "outer") == 0)
 			{
-				const ParserData::Way& way = data.ways.find(member.id)->second;
+				auto it = data.ways.find(member.id);
+				if (it == data.ways.end())
+				{
+					continue; // Way is not in the input file
+				}
 				LatLonPoints points;
-				readPoints(way, data, points);
+				readPoints(it->second, data, points);
 				if (points.size() >= 2)
 				{
 					parts.emplace_back(points);
@@ -491,33 +608,39 @@ std::vector<LatLonPoints> readMultiPolygonRelation(const readosm_relation& relat
 		// OSM ways in a multipolygon are *not* gauranteed to be in contiguous order.
 		// We reorder them here into contiguous rings.
 		// Two ways join when the last point in one equals the first point in the other.
-		std::vector<int> nextPartIndices(parts.size(), -1);
-		std::set<int> unallocatedParts;
+		// Index parts by first point. If several parts start at the same point, the first part is used.
+		std::unordered_map<LatLon, int, LatLonHash> partIndicesByFirstPoint;
+		for (int i = 0; i < (int)parts.size(); ++i)
+		{
+			partIndicesByFirstPoint.emplace(parts[i].front(), i);
+		}
 
+		std::vector<int> nextPartIndices(parts.size(), -1);
 		for (int i = 0; i < (int)parts.size(); ++i)
 		{
-			for (int j = 0; j < (int)parts.size(); ++j)
+			auto it = partIndicesByFirstPoint.find(parts[i].back());
+			if (it != partIndicesByFirstPoint.end())
 			{
-				if (parts[i].back() == parts[j].front())
-				{
-					nextPartIndices[i] = j;
-					break;
-				}
+				nextPartIndices[i] = it->second;
 			}
-			unallocatedParts.insert(i);
 		}
 
-		while (!unallocatedParts.empty())
+		std::vector<bool> allocatedParts(parts.size(), false);
+		for (int firstIndex = 0; firstIndex < (int)parts.size(); ++firstIndex)
 		{
+			if (allocatedParts[firstIndex])
+			{
+				continue;
+			}
+
 			LatLonPoints points;
-			int nextIndex = *unallocatedParts.begin();
-			int firstIndex = nextIndex;
+			int nextIndex = firstIndex;
 			bool joined = false;
-			while (nextIndex != -1)
+			while (nextIndex != -1 && !allocatedParts[nextIndex])
 			{
 				const LatLonPoints& part = parts[nextIndex];
 				points.insert(points.end(), part.begin(), part.begin() + part.size() - 1); // insert from first point to second last point inclusive
-				unallocatedParts.erase(nextIndex);
+				allocatedParts[nextIndex] = true;
 				nextIndex = nextPartIndices[nextIndex];
 				if (nextIndex == firstIndex)
 				{
@@ -549,7 +672,7 @@ int parseRelation(const void* user_data, const readosm_relation* relation)
 		for (const LatLonPoints& polygon : polygons)
 		{
 			auto water = std::make_shared<Water>();
-			water->points = toLatLonAlt(polygon, *data.altitudeProvider);
+			setPoints(data, *water, polygon, PendingAltitudes::Mode::PerPoint);
 			features.push_back(water);
 		}
 	}
@@ -638,10 +761,40 @@ std::map<std::string, AirportPtr> createAirports(const ParserData& data, const s
 	return result;
 }
 
-ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider)
+//! Pass 1 callback. Records the ways referenced by feature relations.
+static int collectRelationWayIds(const void* user_data, const readosm_relation* relation)
+{
+	ParserData& data = *(ParserData*)user_data;
+	if (isFeatureRelation(*relation))
+	{
+		for (int i = 0; i < relation->member_count; ++i)
+		{
+			const readosm_member& member = relation->members[i];
+			if (member.member_type == READOSM_MEMBER_WAY)
+			{
+				data.relationWayIds.push_back(member.id);
+			}
+		}
+	}
+	return READOSM_OK;
+}
+
+//! Pass 2 callback. Records the nodes referenced by feature ways and ways of feature relations.
+static int collectWayNodeIds(const void* user_data, const readosm_way* way)
+{
+	ParserData& data = *(ParserData*)user_data;
+	if (isFeatureWay(*way) || isRelationWay(data, way->id))
+	{
+		for (int i = 0; i < way->node_ref_count; ++i)
+		{
+			data.nodes.addRequiredId(way->node_refs[i]);
+		}
+	}
+	return READOSM_OK;
+}
+
+static void parsePbf(const std::string& filename, ParserData& data, readosm_node_callback nodeFunc, readosm_way_callback wayFunc, readosm_relation_callback relationFunc)
 {
-	ParserData data;
-	data.altitudeProvider = &provider;
 	const void *osm_handle;
 	try
 	{
@@ -653,7 +806,7 @@ ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProv
 		}
 
 		const void *userData = &data;
-		ret = readosm_parse(osm_handle, userData, parseNode, parseWay, parseRelation);
+		ret = readosm_parse(osm_handle, userData, nodeFunc, wayFunc, relationFunc);
 		if (ret != READOSM_OK)
 		{
 			std::stringstream ss;
@@ -667,6 +820,40 @@ ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProv
 		throw skybolt::Exception("Error converting " + filename + ". Reason: " + e.what());
 	}
 	readosm_close(osm_handle);
+}
+
+ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider, px_sched::Scheduler* scheduler)
+{
+	ParserData data;
+
+	// The file is parsed in three passes so that only the nodes and ways needed by features are kept in memory,
+	// allowing large extracts to be converted. Passes rely on PBF files storing nodes, then ways, then relations.
+	{
+		ScopedPhaseReport report("Finding ways used by relations");
+		parsePbf(filename, data, nullptr, nullptr, collectRelationWayIds);
+		std::sort(data.relationWayIds.begin(), data.relationWayIds.end());
+		data.relationWayIds.erase(std::unique(data.relationWayIds.begin(), data.relationWayIds.end()), data.relationWayIds.end());
+	}
+
+	{
+		ScopedPhaseReport report("Finding nodes used by ways");
+		parsePbf(filename, data, nullptr, collectWayNodeIds, nullptr);
+		data.nodes.finalizeIds();
+	}
+
+	{
+		ScopedPhaseReport report("Loading " + std::to_string(data.nodes.getRequiredCount()) + " nodes and creating features");
+		parsePbf(filename, data, parseNode, parseWay, parseRelation);
+	}
+
+	// Release parser memory before sampling altitudes, which may load many terrain tiles
+	data.nodes = NodeLocationIndex();
+	data.ways.clear();
+
+	{
+		ScopedPhaseReport report("Sampling altitudes of " + std::to_string(data.pendingAltitudes.size()) + " features");
+		sampleAltitudes(data.pendingAltitudes, provider, scheduler);
+	}
 
 	ReadPbfResult result;
 	printf("Matching %zu runways with %zu airports\n", data.runways.size(), data.airports.size());
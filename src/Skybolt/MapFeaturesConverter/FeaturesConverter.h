@@ -8,6 +8,7 @@
 
 #include <SkyboltSim/PlanetAltitudeProvider.h>
 #include <SkyboltVis/Renderable/Planet/Features/PlanetFeaturesSource.h>
+#include <SkyboltVis/SkyboltVisFwd.h>
 
 namespace skybolt {
 namespace mapfeatures {
@@ -17,7 +18,11 @@ struct ReadPbfResult
 	std::vector<FeaturePtr> features; //!< All the features
 	std::map<std::string, AirportPtr> airports; //!< Map of names to airport features
 };
-ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider);
+
+//! Reads features from an OSM PBF file.
+//! The file is parsed several times so that only nodes referenced by features are held in memory.
+//! @param scheduler is used to sample feature altitudes in parallel, in which case the provider must be thread safe. May be null.
+ReadPbfResult readPbf(const std::string& filename, const sim::PlanetAltitudeProvider& provider, px_sched::Scheduler* scheduler = nullptr);
 
 } // namespace mapfeatures
 } // namespace skybolt
\ No newline at end of file
@@ -0,0 +1,84 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "NodeLocationIndex.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <limits>
+
+namespace skybolt {
+namespace mapfeatures {
+
+void NodeLocationIndex::addRequiredId(long long id)
+{
+	assert(!mFinalized);
+	mIds.push_back(id);
+
+	// Most IDs are referenced by several ways, so deduplicate periodically rather than holding every reference
+	if (mIds.size() >= mCompactThreshold)
+	{
+		compactIds();
+		mCompactThreshold = std::max(mCompactThreshold, mIds.size() * 2);
+	}
+}
+
+void NodeLocationIndex::compactIds()
+{
+	std::sort(mIds.begin(), mIds.end());
+	mIds.erase(std::unique(mIds.begin(), mIds.end()), mIds.end());
+}
+
+void NodeLocationIndex::finalizeIds()
+{
+	compactIds();
+	mIds.shrink_to_fit();
+
+	constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+	mLocations.assign(mIds.size(), sim::LatLon(nan, nan));
+	mFinalized = true;
+}
+
+std::ptrdiff_t NodeLocationIndex::findIndex(long long id) const
+{
+	assert(mFinalized);
+	auto i = std::lower_bound(mIds.begin(), mIds.end(), id);
+	if (i != mIds.end() && *i == id)
+	{
+		return i - mIds.begin();
+	}
+	return -1;
+}
+
+bool NodeLocationIndex::setLocation(long long id, const sim::LatLon& location)
+{
+	std::ptrdiff_t index = findIndex(id);
+	if (index < 0)
+	{
+		return false;
+	}
+
+	if (std::isnan(mLocations[index].lat))
+	{
+		++mLocationCount;
+	}
+	mLocations[index] = location;
+	return true;
+}
+
+const sim::LatLon* NodeLocationIndex::findLocation(long long id) const
+{
+	std::ptrdiff_t index = findIndex(id);
+	if (index < 0 || std::isnan(mLocations[index].lat))
+	{
+		return nullptr;
+	}
+	return &mLocations[index];
+}
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -0,0 +1,57 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltSim/Spatial/LatLon.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace skybolt {
+namespace mapfeatures {
+
+//! Stores the locations of a known set of OSM nodes in arrays sorted by node ID.
+//! Costs 24 bytes per stored node, compared to around 80 bytes for a std::map entry,
+//! and only nodes registered with addRequiredId() are stored.
+//! Usage is: register all required IDs, call finalizeIds(), then set and find locations.
+class NodeLocationIndex
+{
+public:
+	//! Must be called before finalizeIds(). Duplicate IDs are allowed.
+	void addRequiredId(long long id);
+
+	//! Sorts and deduplicates the required IDs. Must be called before setLocation() and findLocation().
+	void finalizeIds();
+
+	//! Stores the node's location if the node is required
+	//! @returns true if the node is required
+	bool setLocation(long long id, const sim::LatLon& location);
+
+	//! @returns nullptr if the node is not required or its location was not set
+	const sim::LatLon* findLocation(long long id) const;
+
+	size_t getRequiredCount() const { return mIds.size(); }
+
+	//! @returns number of nodes with locations set
+	size_t getLocationCount() const { return mLocationCount; }
+
+private:
+	void compactIds();
+
+	//! @returns index of the ID in mIds, or -1 if not found
+	std::ptrdiff_t findIndex(long long id) const;
+
+private:
+	std::vector<long long> mIds; //!< Sorted after finalizeIds()
+	std::vector<sim::LatLon> mLocations; //!< Indexed the same as mIds
+	size_t mCompactThreshold = 1 << 20; //!< Size at which mIds is deduplicated during registration to bound memory use
+	size_t mLocationCount = 0;
+	bool mFinalized = false;
+};
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -0,0 +1,60 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "PhaseReport.h"
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2 // Use GetProcessMemoryInfo from kernel32 so psapi.lib is not required
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <stdio.h>
+
+namespace skybolt {
+namespace mapfeatures {
+
+size_t getPeakMemoryUsageBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef __APPLE__
+		return size_t(usage.ru_maxrss); // bytes
+#else
+		return size_t(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+	}
+	return 0;
+#endif
+}
+
+ScopedPhaseReport::ScopedPhaseReport(const std::string& name) :
+	mName(name),
+	mStartTime(std::chrono::steady_clock::now())
+{
+	printf("%s...\n", mName.c_str());
+}
+
+ScopedPhaseReport::~ScopedPhaseReport()
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count();
+	double peakMemoryMb = double(getPeakMemoryUsageBytes()) / (1024.0 * 1024.0);
+	printf("%s took %.2fs. Peak memory: %.0f MB\n", mName.c_str(), seconds, peakMemoryMb);
+}
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -0,0 +1,31 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace skybolt {
+namespace mapfeatures {
+
+//! @returns peak resident memory use of the process in bytes, or 0 if not available on this platform
+size_t getPeakMemoryUsageBytes();
+
+//! Prints the wall clock duration of a conversion phase and the peak memory use of the process when destroyed
+class ScopedPhaseReport
+{
+public:
+	ScopedPhaseReport(const std::string& name);
+	~ScopedPhaseReport();
+
+private:
+	std::string mName;
+	std::chrono::steady_clock::time_point mStartTime;
+};
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -5,6 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "FeaturesConverter.h"
+#include "PhaseReport.h"
 #include <iostream>
 
 //#define PERFORM_HEIGHTMAP_LEVELING_UNDER_FEATURES
@@ -16,6 +17,7 @@
 #include <px_sched/px_sched.h>
 
 #include <SkyboltVis/ElevationProvider/TilePlanetAltitudeProvider.h>
+#include <SkyboltVis/Renderable/Planet/Features/MappedFeatureTile.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/CachedTileSource.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/MapboxElevationTileSource.h>
 #include <SkyboltVis/Renderable/Planet/Tile/TileSource/SphericalMercatorToPlateCarreeTileSource.h>
@@ -37,8 +39,30 @@ std::string tileCacheDirectory = "cache";
 std::string heightmapSourceDirectory = "DEM/CombinedElevation";
 std::string heightmapDestinationDirectory = "SkyboltAssets/Assets/SeattleElevation/Tiles/Earth/Elevation";
 
+//! Converts existing feature tiles to the version 2 format in place
+int main_convertTiles(const std::string& directory)
+{
+	try
+	{
+		ScopedPhaseReport report("Converting feature tiles");
+		size_t count = mapfeatures::convertTilesToV2(directory);
+		printf("Converted %zu tiles\n", count);
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "Exception thrown: " << e.what() << std::endl;
+		return 1;
+	}
+}
+
 int main(int argc, char *argv[])
 {
+	if (argc > 2 && std::string(argv[1]) == "--convertTilesToV2")
+	{
+		return main_convertTiles(argv[2]);
+	}
+
 	try
 	{
 		auto params = EngineCommandLineParser::parse(argc, argv);
@@ -66,15 +90,21 @@ int main(int argc, char *argv[])
 		std::string tileSourceCacheDirectory = tileCacheDirectory  + "/" + calcSha1(config.urlTemplate);
 		auto tileSource = std::make_shared<CachedTileSource>(uncachedTileSource, tileSourceCacheDirectory);
 #endif
+		px_sched::Scheduler scheduler;
+		scheduler.init();
+
 		TilePlanetAltitudeProvider altitudeProvider(tileSource, maxHeightmapTileLod);
-		ReadPbfResult result = mapfeatures::readPbf("washington-latest.osm.pbf", altitudeProvider);
+		ReadPbfResult result = mapfeatures::readPbf("washington-latest.osm.pbf", altitudeProvider, &scheduler);
 		{
 			printf("Feature Conversion Stats:\n%s\n", mapfeatures::statsToString(result.features).c_str());
 
 			mapfeatures::TreeCreatorParams treeCreatorParams;
 			treeCreatorParams.minFeatureSizeFraction = 0.1;
 			treeCreatorParams.maxLodLevel = maxFeatureTileLod;
-			mapfeatures::WorldFeatures worldFeatures = mapfeatures::createWorldFeatures(treeCreatorParams, result.features);
+			mapfeatures::WorldFeatures worldFeatures = [&] {
+				ScopedPhaseReport report("Building feature tree");
+				return mapfeatures::createWorldFeatures(treeCreatorParams, result.features, &scheduler);
+			}();
 
 #ifdef PERFORM_HEIGHTMAP_LEVELING_UNDER_FEATURES
 			double borderMeters = 100.0;
@@ -90,8 +120,11 @@ int main(int argc, char *argv[])
 				static_cast<Airport*>(airport)->altitude = mapfeatures::getAltitudeAtPosition(heightmapDestinationDirectory, airport->calcBounds().center());
 			}
 #endif
-			mapfeatures::save(worldFeatures.tree, outputDirectory);
-			mapfeatures::saveAirports(result.airports, "SkyboltAssets/Assets/Core/Airports/airports.apt");
+			{
+				ScopedPhaseReport report("Writing feature tiles");
+				mapfeatures::save(worldFeatures.tree, outputDirectory, &scheduler);
+				mapfeatures::saveAirports(result.airports, "SkyboltAssets/Assets/Core/Airports/airports.apt");
+			}
 		}
 	}
 	catch (const std::exception& e)
@@ -0,0 +1,239 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "TilePack.h"
+#include "SkyboltCommon/Exception.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace skybolt {
+namespace file {
+
+namespace fs = std::filesystem;
+
+static const char dataFileMagic[8] = {'S', 'B', 'T', 'P', 'D', 'A', 'T', '1'};
+static const char indexFileMagic[8] = {'S', 'B', 'T', 'P', 'I', 'D', 'X', '1'};
+
+#pragma pack(push, 1)
+struct IndexFileEntry
+{
+	std::uint64_t key;
+	std::uint64_t offset;
+	std::uint64_t size;
+};
+#pragma pack(pop)
+
+static bool hasMagic(const fs::path& path, const char (&magic)[8])
+{
+	std::ifstream file(path, std::ios::binary);
+	char buffer[8];
+	return file.read(buffer, sizeof(buffer)) && std::memcmp(buffer, magic, sizeof(buffer)) == 0;
+}
+
+static void writeOrThrow(std::ofstream& file, const void* data, size_t size, const fs::path& path)
+{
+	file.write(static_cast<const char*>(data), size);
+	file.flush();
+	if (!file)
+	{
+		throw Exception("Could not write to tile pack file: " + path.string());
+	}
+}
+
+//! @returns the lock, or null if another process holds it
+//! @throws skybolt::Exception if the lock file could not be opened
+static std::unique_ptr<boost::interprocess::file_lock> tryLockWriter(const fs::path& lockPath)
+{
+	// The lock file must exist before it can be locked
+	std::ofstream(lockPath, std::ios::app);
+
+	std::unique_ptr<boost::interprocess::file_lock> lock;
+	try
+	{
+		lock = std::make_unique<boost::interprocess::file_lock>(lockPath.string().c_str());
+	}
+	catch (const boost::interprocess::interprocess_exception& e)
+	{
+		throw Exception("Could not open tile pack lock file: " + lockPath.string() + ": " + e.what());
+	}
+	return lock->try_lock() ? std::move(lock) : nullptr;
+}
+
+TilePack::TilePack(const fs::path& path, OpenMode mode) :
+	mDataPath(path),
+	mIndex(0, &hashPackedTileKey)
+{
+	fs::path indexPath = path;
+	indexPath += getIndexExtension();
+
+	if (mode == OpenMode::ReadWrite)
+	{
+		if (path.has_parent_path())
+		{
+			fs::create_directories(path.parent_path());
+		}
+		fs::path lockPath = path;
+		lockPath += getLockExtension();
+		mWriterLock = tryLockWriter(lockPath);
+	}
+
+	bool exists = fs::exists(path) && fs::exists(indexPath);
+	if (exists)
+	{
+		if (!hasMagic(path, dataFileMagic) || !hasMagic(indexPath, indexFileMagic))
+		{
+			throw Exception("Invalid tile pack: " + path.string());
+		}
+
+		mDataSize = fs::file_size(path);
+
+		// Load index. Entries are appended in the same order as their items, so loading stops at the first entry
+		// that was not completely written, or whose item was not completely written.
+		std::uint64_t validIndexSize = sizeof(indexFileMagic);
+		std::uint64_t validDataSize = sizeof(dataFileMagic);
+		{
+			std::ifstream indexFile(indexPath, std::ios::binary);
+			indexFile.seekg(sizeof(indexFileMagic));
+			IndexFileEntry entry;
+			while (indexFile.read(reinterpret_cast<char*>(&entry), sizeof(entry)) && entry.offset + entry.size <= mDataSize)
+			{
+				mIndex[entry.key] = {entry.offset, entry.size};
+				validIndexSize += sizeof(entry);
+				validDataSize = std::max(validDataSize, entry.offset + entry.size);
+			}
+		}
+
+		// Truncate anything after the last valid entry and item, so that new entries are appended at entry boundaries
+		// and new items do not leave stale entries pointing at them.
+		// Only the writer may truncate, otherwise a tile being appended by the writer would be corrupted.
+		if (mWriterLock)
+		{
+			if (fs::file_size(indexPath) > validIndexSize)
+			{
+				fs::resize_file(indexPath, validIndexSize);
+			}
+			if (mDataSize > validDataSize)
+			{
+				fs::resize_file(path, validDataSize);
+				mDataSize = validDataSize;
+			}
+		}
+	}
+	else if (mode == OpenMode::ReadOnly)
+	{
+		throw Exception("Tile pack does not exist: " + path.string());
+	}
+	else
+	{
+		mDataSize = sizeof(dataFileMagic);
+	}
+
+	if (!mWriterLock)
+	{
+		return;
+	}
+
+	std::ios::openmode openMode = std::ios::binary | (exists ? std::ios::app : std::ios::trunc);
+	mDataFile.open(path, openMode);
+	mIndexFile.open(indexPath, openMode);
+	if (!mDataFile || !mIndexFile)
+	{
+		throw Exception("Could not open tile pack: " + path.string());
+	}
+
+	if (!exists)
+	{
+		writeOrThrow(mDataFile, dataFileMagic, sizeof(dataFileMagic), path);
+		writeOrThrow(mIndexFile, indexFileMagic, sizeof(indexFileMagic), indexPath);
+	}
+}
+
+TilePack::~TilePack() = default;
+
+bool TilePack::contains(const QuadTreeTileKey& key) const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mIndex.find(packTileKey(key)) != mIndex.end();
+}
+
+bool TilePack::read(const QuadTreeTileKey& key, const PayloadReader& reader) const
+{
+	IndexEntry entry;
+	{
+		std::shared_lock<std::shared_mutex> lock(mMutex);
+		auto i = mIndex.find(packTileKey(key));
+		if (i == mIndex.end())
+		{
+			return false;
+		}
+		entry = i->second;
+
+		// Fast path for items within the current mapping
+		if (mMappedRegion && entry.offset + entry.size <= mMappedRegion->get_size())
+		{
+			reader(static_cast<const std::uint8_t*>(mMappedRegion->get_address()) + entry.offset, entry.size);
+			return true;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	reader(mapItem(entry), entry.size);
+	return true;
+}
+
+const std::uint8_t* TilePack::mapItem(const IndexEntry& entry) const
+{
+	if (!mMappedRegion || entry.offset + entry.size > mMappedRegion->get_size())
+	{
+		// Map the whole file. The file was extended since it was last mapped.
+		mMappedRegion.reset();
+		boost::interprocess::file_mapping mapping(mDataPath.string().c_str(), boost::interprocess::read_only);
+		mMappedRegion = std::make_unique<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+	}
+	return static_cast<const std::uint8_t*>(mMappedRegion->get_address()) + entry.offset;
+}
+
+bool TilePack::append(const QuadTreeTileKey& key, const void* data, size_t size)
+{
+	PackedQuadTreeTileKey packedKey = packTileKey(key);
+
+	if (!mWriterLock)
+	{
+		return false;
+	}
+
+	std::scoped_lock<std::mutex> writeLock(mWriteMutex);
+	if (contains(key))
+	{
+		return false;
+	}
+
+	fs::path indexPath = mDataPath;
+	indexPath += getIndexExtension();
+
+	IndexFileEntry fileEntry{packedKey, mDataSize, size};
+	writeOrThrow(mDataFile, data, size, mDataPath);
+	writeOrThrow(mIndexFile, &fileEntry, sizeof(fileEntry), indexPath);
+	mDataSize += size;
+
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	mIndex[packedKey] = {fileEntry.offset, fileEntry.size};
+	return true;
+}
+
+size_t TilePack::getTileCount() const
+{
+	std::shared_lock<std::shared_mutex> lock(mMutex);
+	return mIndex.size();
+}
+
+} // namespace file
+} // namespace skybolt
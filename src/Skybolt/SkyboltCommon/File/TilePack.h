@@ -0,0 +1,101 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltCommon/Math/QuadTree.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace boost {
+namespace interprocess {
+class file_lock;
+class mapped_region;
+} // namespace interprocess
+} // namespace boost
+
+namespace skybolt {
+namespace file {
+
+//! Stores tile payloads in a single file, avoiding the overhead of one file per tile.
+//! Payloads are appended to a data file, and their locations are appended to a sidecar index file
+//! which is loaded into memory when the pack is opened. Payloads are read through a memory mapping of the data file.
+//! Tiles are written before their index entry, so a pack interrupted mid-write loses at most the tile being written.
+//! A pack has at most one writer process, enforced by a lock file stored alongside at the path with getLockExtension() appended.
+//! The lock does not exclude other TilePack instances in the same process, so only one writable instance should be opened per pack per process.
+//! Thread safe.
+class TilePack
+{
+public:
+	enum class OpenMode
+	{
+		ReadOnly, //!< Opens an existing pack without modifying it
+		ReadWrite //!< Opens the pack for appending, creating it if it does not exist
+	};
+
+	//! Opens the pack at the given path.
+	//! The index is stored alongside at the path with getIndexExtension() appended.
+	//! In ReadWrite mode, if another process is writing to the pack, the pack is opened without write access and tiles appended
+	//! by the other process after opening are not visible.
+	//! @throws skybolt::Exception if the pack could not be opened, or if the pack does not exist in ReadOnly mode
+	explicit TilePack(const std::filesystem::path& path, OpenMode mode = OpenMode::ReadWrite);
+	~TilePack();
+
+	//! @returns true if tiles can be appended to the pack
+	bool isWritable() const { return mWriterLock != nullptr; }
+
+	bool contains(const QuadTreeTileKey& key) const;
+
+	typedef std::function<void(const std::uint8_t* data, size_t size)> PayloadReader;
+
+	//! Calls the reader with a pointer to the tile's payload in the mapped file.
+	//! The pointer is only valid for the duration of the call.
+	//! @returns false if the tile is not in the pack
+	bool read(const QuadTreeTileKey& key, const PayloadReader& reader) const;
+
+	//! Appends a tile to the pack. Does nothing if the tile already exists or the pack is not writable.
+	//! @returns true if the tile was added
+	//! @throws skybolt::Exception if the tile could not be written
+	bool append(const QuadTreeTileKey& key, const void* data, size_t size);
+
+	size_t getTileCount() const;
+
+	static std::string getIndexExtension() { return ".index"; }
+	static std::string getLockExtension() { return ".lock"; }
+
+private:
+	struct IndexEntry
+	{
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	//! @returns pointer to the item in the mapped data file, remapping the file if the item lies beyond the current mapping.
+	//! Must be called with mMutex held exclusively.
+	const std::uint8_t* mapItem(const IndexEntry& entry) const;
+
+private:
+	std::filesystem::path mDataPath;
+	std::unique_ptr<boost::interprocess::file_lock> mWriterLock; //!< Null if the pack is not writable
+	std::ofstream mDataFile;
+	std::ofstream mIndexFile;
+	std::uint64_t mDataSize;
+	std::mutex mWriteMutex; //!< Serializes appends
+
+	mutable std::shared_mutex mMutex; //!< Guards mIndex and mMappedRegion
+	std::unordered_map<PackedQuadTreeTileKey, IndexEntry, std::function<size_t(PackedQuadTreeTileKey)>> mIndex;
+	mutable std::unique_ptr<boost::interprocess::mapped_region> mMappedRegion;
+};
+
+} // namespace file
+} // namespace skybolt
@@ -7,38 +7,42 @@
 #include "InterpolateTableLinear.h"
 #include "MathUtility.h"
 
+#include <assert.h>
+
 namespace skybolt {
 namespace math {
 
-boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<double> &xData, double x, bool extrapolate)
+// Returns true if i is the left bound of the segment used to interpolate x.
+// Values past the last segment use the last segment, values before the first segment use the first segment.
+// Requires xData.size() >= 2.
+static bool isLeftBound(const std::vector<double> &xData, int i, double x)
 {
-	int size = (int)xData.size();
-	if (size == 0)
+	int last = (int)xData.size() - 2;
+	if (x >= xData[last])
 	{
-		return boost::none;
-	}
-	else if (size == 1)
-	{
-		InterpolationPoint point;
-		point.bounds.first = 0;
-		point.bounds.last = 0;
-		point.weight = 0;
-		return point;
+		return i == last;
 	}
+	return i < last && (i == 0 || xData[i] < x) && x <= xData[i + 1];
+}
 
-	// Find left bound
-	int i = 0;                                                                  
-	if (x >= xData[size - 2]) // Make sure we're not past the right bound
-	{
-		i = size - 2;
-	}
-	else
+// Requires xData.size() >= 2.
+static int findLeftBound(const std::vector<double> &xData, double x)
+{
+	int size = (int)xData.size();
+	// Use the last segment if we're past its left bound, or if it is the only segment.
+	// The search below requires at least 3 points, otherwise its range would be reversed.
+	if (size == 2 || x >= xData[size - 2])
 	{
-		while (x > xData[i + 1])
-		{
-			i++;
-		}
+		return size - 2;
 	}
+
+	// Find first right bound not less than x. Result is in range [1, size - 2].
+	auto it = std::lower_bound(xData.begin() + 1, xData.begin() + (size - 2), x);
+	return int(it - xData.begin()) - 1;
+}
+
+static InterpolationPoint createInterpolationPoint(const std::vector<double> &xData, int i, double x, bool extrapolate)
+{
 	double xL = xData[i];
 	double xR = xData[i + 1];
 
@@ -46,7 +50,7 @@ boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<dou
 	point.bounds.first = i;
 	point.bounds.last = i + 1;
 	point.weight = (x - xL) / (xR - xL);
-	
+
 	if (!extrapolate)
 	{
 		point.weight = math::clamp(point.weight, 0.0, 1.0);
@@ -55,6 +59,66 @@ boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<dou
 	return point;
 }
 
+static InterpolationPoint createSingleItemInterpolationPoint()
+{
+	InterpolationPoint point;
+	point.bounds.first = 0;
+	point.bounds.last = 0;
+	point.weight = 0;
+	return point;
+}
+
+boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<double> &xData, double x, bool extrapolate)
+{
+	int size = (int)xData.size();
+	if (size == 0)
+	{
+		return boost::none;
+	}
+	else if (size == 1)
+	{
+		return createSingleItemInterpolationPoint();
+	}
+
+	return createInterpolationPoint(xData, findLeftBound(xData, x), x, extrapolate);
+}
+
+boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<double> &xData, double x, bool extrapolate, InterpolationCursor& cursor)
+{
+	int size = (int)xData.size();
+	if (size == 0)
+	{
+		return boost::none;
+	}
+	else if (size == 1)
+	{
+		return createSingleItemInterpolationPoint();
+	}
+
+	// Table may have changed size since the cursor was last used
+	int i = std::min(std::max(cursor.segment, 0), size - 2);
+
+	if (!isLeftBound(xData, i, x))
+	{
+		// Try neighbouring segments before falling back to a full search
+		if (i + 1 <= size - 2 && isLeftBound(xData, i + 1, x))
+		{
+			++i;
+		}
+		else if (i > 0 && isLeftBound(xData, i - 1, x))
+		{
+			--i;
+		}
+		else
+		{
+			i = findLeftBound(xData, x);
+		}
+	}
+
+	cursor.segment = i;
+	return createInterpolationPoint(xData, i, x, extrapolate);
+}
+
 boost::optional<double> interpolateTableLinear(const std::vector<double> &xData, const std::vector<double> &yData, double x, bool extrapolate)
 {
 	boost::optional<InterpolationPoint> point = findInterpolationPoint(xData, x, extrapolate);
@@ -62,7 +126,58 @@ boost::optional<double> interpolateTableLinear(const std::vector<double> &xData,
 	{
 		return boost::none;
 	}
-	return math::lerp(xData[point->bounds.first], xData[point->bounds.last], point->weight);
+	return math::lerp(yData[point->bounds.first], yData[point->bounds.last], point->weight);
+}
+
+static bool interpolateTableLinear(const std::vector<double> &xData, const std::vector<double> &yData, const std::vector<double> &x, std::vector<double> &y, bool extrapolate, InterpolationCursor& cursor)
+{
+	if (xData.empty())
+	{
+		return false;
+	}
+
+	y.resize(x.size());
+	if (xData.size() == 1)
+	{
+		std::fill(y.begin(), y.end(), yData.front());
+		return true;
+	}
+
+	for (size_t i = 0; i < x.size(); ++i)
+	{
+		InterpolationPoint point = *findInterpolationPoint(xData, x[i], extrapolate, cursor);
+		y[i] = math::lerp(yData[point.bounds.first], yData[point.bounds.last], point.weight);
+	}
+	return true;
+}
+
+bool interpolateTableLinear(const std::vector<double> &xData, const std::vector<double> &yData, const std::vector<double> &x, std::vector<double> &y, bool extrapolate)
+{
+	InterpolationCursor cursor;
+	return interpolateTableLinear(xData, yData, x, y, extrapolate, cursor);
+}
+
+InterpolationTableLinear::InterpolationTableLinear(std::vector<double> xData, std::vector<double> yData, bool extrapolate) :
+	mXData(std::move(xData)),
+	mYData(std::move(yData)),
+	mExtrapolate(extrapolate)
+{
+	assert(mXData.size() == mYData.size());
+}
+
+boost::optional<double> InterpolationTableLinear::evaluate(double x) const
+{
+	boost::optional<InterpolationPoint> point = findInterpolationPoint(mXData, x, mExtrapolate, mCursor);
+	if (!point)
+	{
+		return boost::none;
+	}
+	return math::lerp(mYData[point->bounds.first], mYData[point->bounds.last], point->weight);
+}
+
+bool InterpolationTableLinear::evaluate(const std::vector<double> &x, std::vector<double> &y) const
+{
+	return interpolateTableLinear(mXData, mYData, x, y, mExtrapolate, mCursor);
 }
 
 } // namespace math
@@ -20,12 +20,54 @@ struct InterpolationPoint
 	double weight; //!< In range [0 to 1]
 };
 
+//! Remembers the segment found by the previous lookup so that lookups at
+//! monotonically increasing or decreasing x values do not need to search the table.
+struct InterpolationCursor
+{
+	int segment = 0; //!< Index of the left bound of the last segment found
+};
+
 //! Returns null if the input vector is empty, otherwise returns a valid result.
+//! xData must be monotonically increasing. Lookup is O(log n).
 boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<double> &xData, double x, bool extrapolate);
 
+//! As above, but first checks the segment at the cursor and its neighbour before searching.
+//! Lookup is O(1) when x moves by less than one segment since the last lookup with the same cursor.
+boost::optional<InterpolationPoint> findInterpolationPoint(const std::vector<double> &xData, double x, bool extrapolate, InterpolationCursor& cursor);
+
 //! Returns null if the input vectors is empty, otherwise returns a valid result.
 //! xData and yData must be the same length.
 boost::optional<double> interpolateTableLinear(const std::vector<double> &xData, const std::vector<double> &yData, double x, bool extrapolate);
 
+//! Interpolates the table at each value in x, writing results to y, which is resized to match x.
+//! Lookups are fastest when x is sorted.
+//! @returns false if the table is empty, in which case y is left unchanged.
+bool interpolateTableLinear(const std::vector<double> &xData, const std::vector<double> &yData, const std::vector<double> &x, std::vector<double> &y, bool extrapolate);
+
+//! Lookup table which keeps a cursor to accelerate repeated lookups at nearby x values, e.g. during playback.
+//! Not thread safe, because lookups update the cursor.
+class InterpolationTableLinear
+{
+public:
+	//! xData must be monotonically increasing, and xData and yData must be the same length.
+	InterpolationTableLinear(std::vector<double> xData, std::vector<double> yData, bool extrapolate);
+
+	//! Returns null if the table is empty, otherwise returns a valid result.
+	boost::optional<double> evaluate(double x) const;
+
+	//! Evaluates the table at each value in x, writing results to y.
+	//! @returns false if the table is empty.
+	bool evaluate(const std::vector<double> &x, std::vector<double> &y) const;
+
+	const std::vector<double>& getXData() const { return mXData; }
+	const std::vector<double>& getYData() const { return mYData; }
+
+private:
+	std::vector<double> mXData;
+	std::vector<double> mYData;
+	bool mExtrapolate;
+	mutable InterpolationCursor mCursor;
+};
+
 } // namespace math
 } // namespace skybolt
@@ -8,9 +8,9 @@
 
 #include "Box2.h"
 #include "MathUtility.h"
-#include <boost/functional/hash.hpp>
 #include <functional>
 #include <assert.h>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -42,6 +42,34 @@ struct QuadTreeTileKey
 
 QuadTreeTileKey createAncestorKey(const QuadTreeTileKey& key, int level);
 
+//! Tile key packed into 64 bits as 6 bits of level, 29 bits of x and 29 bits of y.
+//! Supports levels up to 28, which is the deepest level at which x fits in 29 bits.
+typedef std::uint64_t PackedQuadTreeTileKey;
+
+inline PackedQuadTreeTileKey packTileKey(const QuadTreeTileKey& key)
+{
+	assert(key.level >= 0 && key.level <= 28);
+	return (PackedQuadTreeTileKey(key.level) << 58) | (PackedQuadTreeTileKey(key.x) << 29) | PackedQuadTreeTileKey(key.y);
+}
+
+inline QuadTreeTileKey unpackTileKey(PackedQuadTreeTileKey key)
+{
+	constexpr PackedQuadTreeTileKey mask = (PackedQuadTreeTileKey(1) << 29) - 1;
+	return QuadTreeTileKey(int(key >> 58), int((key >> 29) & mask), int(key & mask));
+}
+
+//! Hash function that mixes all bits of the packed key
+inline size_t hashPackedTileKey(PackedQuadTreeTileKey key)
+{
+	// SplitMix64 finalizer
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return size_t(key);
+}
+
 template <class VecT, class DerivedT>
 struct QuadTreeTile
 {
@@ -337,11 +365,7 @@ struct hash<skybolt::QuadTreeTileKey>
 {
 	size_t operator()(const skybolt::QuadTreeTileKey& k) const
 	{
-		std::size_t result = 0;
-		boost::hash_combine(result, k.level);
-		boost::hash_combine(result, k.x);
-		boost::hash_combine(result, k.y);
-		return result;
+		return skybolt::hashPackedTileKey(skybolt::packTileKey(k));
 	}
 };
 } // namespace std
\ No newline at end of file
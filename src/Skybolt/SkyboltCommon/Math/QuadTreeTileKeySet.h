@@ -0,0 +1,117 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "QuadTree.h"
+#include <algorithm>
+#include <vector>
+
+namespace skybolt {
+
+//! Set of tile keys stored as packed keys in a flat open-addressing hash table with linear probing.
+//! Clearing the set retains its capacity, so a set rebuilt every frame does not reallocate.
+class QuadTreeTileKeySet
+{
+public:
+	QuadTreeTileKeySet() : mSlots(minCapacity, emptySlot) {}
+
+	//! @returns true if the key was inserted, or false if it already existed
+	bool insert(const QuadTreeTileKey& key)
+	{
+		if ((mSize + 1) * 2 > mSlots.size())
+		{
+			grow();
+		}
+		return insertPacked(packTileKey(key));
+	}
+
+	bool contains(const QuadTreeTileKey& key) const
+	{
+		PackedQuadTreeTileKey packed = packTileKey(key);
+		size_t mask = mSlots.size() - 1;
+		for (size_t i = hashPackedTileKey(packed) & mask;; i = (i + 1) & mask)
+		{
+			if (mSlots[i] == packed)
+			{
+				return true;
+			}
+			else if (mSlots[i] == emptySlot)
+			{
+				return false;
+			}
+		}
+	}
+
+	void clear()
+	{
+		std::fill(mSlots.begin(), mSlots.end(), emptySlot);
+		mSize = 0;
+	}
+
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+
+	template <typename Visitor>
+	void forEach(Visitor visitor) const
+	{
+		for (PackedQuadTreeTileKey slot : mSlots)
+		{
+			if (slot != emptySlot)
+			{
+				visitor(unpackTileKey(slot));
+			}
+		}
+	}
+
+	void swap(QuadTreeTileKeySet& other)
+	{
+		mSlots.swap(other.mSlots);
+		std::swap(mSize, other.mSize);
+	}
+
+private:
+	bool insertPacked(PackedQuadTreeTileKey packed)
+	{
+		size_t mask = mSlots.size() - 1;
+		for (size_t i = hashPackedTileKey(packed) & mask;; i = (i + 1) & mask)
+		{
+			if (mSlots[i] == packed)
+			{
+				return false;
+			}
+			else if (mSlots[i] == emptySlot)
+			{
+				mSlots[i] = packed;
+				++mSize;
+				return true;
+			}
+		}
+	}
+
+	void grow()
+	{
+		std::vector<PackedQuadTreeTileKey> oldSlots(mSlots.size() * 2, emptySlot);
+		oldSlots.swap(mSlots);
+		mSize = 0;
+		for (PackedQuadTreeTileKey slot : oldSlots)
+		{
+			if (slot != emptySlot)
+			{
+				insertPacked(slot);
+			}
+		}
+	}
+
+private:
+	static constexpr size_t minCapacity = 64; //!< Must be a power of two
+	static constexpr PackedQuadTreeTileKey emptySlot = ~PackedQuadTreeTileKey(0); //!< Not a valid packed key because level would be 63
+
+	std::vector<PackedQuadTreeTileKey> mSlots;
+	size_t mSize = 0;
+};
+
+} // namespace skybolt
@@ -0,0 +1,208 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace skybolt {
+
+struct CacheStats
+{
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+	size_t itemCount = 0;
+	size_t sizeBytes = 0;
+};
+
+//! Thread safe key-value map that removes approximately least recently used items when the byte budget is exceeded.
+//! Keys are split across shards, each with its own lock, to reduce contention between threads.
+//! Eviction uses the CLOCK algorithm, so lookups only take a shared lock and set an atomic 'referenced' flag,
+//! rather than reordering a shared recency list.
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>>
+class ShardedClockCacheMap
+{
+public:
+	typedef std::function<size_t(const ValueT&)> SizeCalculator;
+
+	//! @param capacityBytes is the total size budget, shared evenly between the shards
+	//! @param sizeCalculator returns the size of a value in bytes
+	//! @param shardCount must be a power of two
+	ShardedClockCacheMap(size_t capacityBytes, SizeCalculator sizeCalculator, size_t shardCount = 16) :
+		mShards(shardCount),
+		mShardBits(calcLog2(shardCount)),
+		mShardCapacityBytes(capacityBytes / shardCount),
+		mSizeCalculator(std::move(sizeCalculator))
+	{
+		assert(shardCount > 0);
+		assert((shardCount & (shardCount - 1)) == 0);
+		assert(mSizeCalculator);
+	}
+
+	//! @returns true if the item was found
+	bool get(const KeyT& key, ValueT& valueOut) const
+	{
+		const Shard& shard = getShard(key);
+		{
+			std::shared_lock<std::shared_mutex> lock(shard.mutex);
+			auto it = shard.indices.find(key);
+			if (it != shard.indices.end())
+			{
+				const Entry& entry = *shard.entries[it->second];
+				entry.referenced.store(true, std::memory_order_relaxed);
+				valueOut = entry.value;
+				mHits.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		mMisses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	//! Inserts the item if the key does not already exist, evicting other items if required to stay within budget.
+	//! @returns true on put
+	bool putSafe(const KeyT& key, const ValueT& value)
+	{
+		size_t sizeBytes = mSizeCalculator(value);
+
+		Shard& shard = getShard(key);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		if (shard.indices.find(key) != shard.indices.end())
+		{
+			return false;
+		}
+
+		evict(shard, sizeBytes);
+
+		auto entry = std::make_unique<Entry>(key, value, sizeBytes);
+		shard.indices[key] = shard.entries.size();
+		shard.entries.push_back(std::move(entry));
+		shard.sizeBytes += sizeBytes;
+		return true;
+	}
+
+	CacheStats getStats() const
+	{
+		CacheStats stats;
+		stats.hits = mHits.load(std::memory_order_relaxed);
+		stats.misses = mMisses.load(std::memory_order_relaxed);
+		stats.evictions = mEvictions.load(std::memory_order_relaxed);
+		for (const Shard& shard : mShards)
+		{
+			std::shared_lock<std::shared_mutex> lock(shard.mutex);
+			stats.itemCount += shard.entries.size();
+			stats.sizeBytes += shard.sizeBytes;
+		}
+		return stats;
+	}
+
+private:
+	struct Entry
+	{
+		Entry(const KeyT& key, const ValueT& value, size_t sizeBytes) :
+			key(key), value(value), sizeBytes(sizeBytes) {}
+
+		KeyT key;
+		ValueT value;
+		size_t sizeBytes;
+		mutable std::atomic<bool> referenced = false; //!< Set when the entry is used, cleared when passed over by the clock hand
+	};
+
+	struct Shard
+	{
+		mutable std::shared_mutex mutex;
+		std::vector<std::unique_ptr<Entry>> entries; //!< The clock ring
+		std::unordered_map<KeyT, size_t, HashT> indices; //!< Index into entries
+		size_t hand = 0; //!< Index of next entry to consider for eviction
+		size_t sizeBytes = 0;
+	};
+
+	static int calcLog2(size_t value)
+	{
+		int result = 0;
+		while (value > 1)
+		{
+			value >>= 1;
+			++result;
+		}
+		return result;
+	}
+
+	//! The shard's map buckets on the low bits of the hash, so select the shard from the high bits of a remixed hash.
+	//! Otherwise keys which collide in a shard's buckets, such as neighbouring packed tile keys, would also share a shard.
+	size_t getShardIndex(const KeyT& key) const
+	{
+		if (mShardBits == 0)
+		{
+			return 0;
+		}
+		std::uint64_t hash = std::uint64_t(HashT()(key)) * 0x9E3779B97F4A7C15ull;
+		return size_t(hash >> (64 - mShardBits));
+	}
+
+	const Shard& getShard(const KeyT& key) const
+	{
+		return mShards[getShardIndex(key)];
+	}
+
+	Shard& getShard(const KeyT& key)
+	{
+		return mShards[getShardIndex(key)];
+	}
+
+	//! Evicts entries until there is room for an item of size requiredBytes. Must be called with the shard's exclusive lock held.
+	void evict(Shard& shard, size_t requiredBytes)
+	{
+		while (!shard.entries.empty() && shard.sizeBytes + requiredBytes > mShardCapacityBytes)
+		{
+			if (shard.hand >= shard.entries.size())
+			{
+				shard.hand = 0;
+			}
+
+			Entry& entry = *shard.entries[shard.hand];
+			if (entry.referenced.load(std::memory_order_relaxed))
+			{
+				// Give recently used entry a second chance
+				entry.referenced.store(false, std::memory_order_relaxed);
+				++shard.hand;
+				continue;
+			}
+
+			// Evict by moving the last entry into the evicted entry's slot
+			shard.sizeBytes -= entry.sizeBytes;
+			shard.indices.erase(entry.key);
+			if (shard.hand != shard.entries.size() - 1)
+			{
+				shard.entries[shard.hand] = std::move(shard.entries.back());
+				shard.indices[shard.entries[shard.hand]->key] = shard.hand;
+			}
+			shard.entries.pop_back();
+			mEvictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	std::vector<Shard> mShards;
+	const int mShardBits; //!< log2 of the shard count
+	const size_t mShardCapacityBytes;
+	const SizeCalculator mSizeCalculator;
+
+	mutable std::atomic<size_t> mHits = 0;
+	mutable std::atomic<size_t> mMisses = 0;
+	std::atomic<size_t> mEvictions = 0;
+};
+
+} // namespace skybolt
@@ -0,0 +1,105 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <assert.h>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace skybolt {
+
+//! Fixed capacity lock free queue for passing items from one producer thread to one consumer thread.
+//! Storage is allocated once on construction, so pushing and popping never allocates.
+template <typename T>
+class SpscRingBuffer
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Items are copied by assignment and never destroyed, so must be trivially copyable");
+
+public:
+	//! @param capacity is rounded up to a power of two
+	explicit SpscRingBuffer(size_t capacity) :
+		mItems(roundUpToPowerOfTwo(capacity)),
+		mMask(mItems.size() - 1)
+	{
+	}
+
+	//! Must only be called from the producer thread
+	//! @returns false if the buffer is full
+	bool tryPush(const T& item)
+	{
+		size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mCachedHead == mItems.size())
+		{
+			mCachedHead = mHead.load(std::memory_order_acquire);
+			if (tail - mCachedHead == mItems.size())
+			{
+				return false;
+			}
+		}
+
+		mItems[tail & mMask] = item;
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//! Must only be called from the consumer thread
+	//! @returns false if the buffer is empty
+	bool tryPop(T& item)
+	{
+		size_t head = mHead.load(std::memory_order_relaxed);
+		if (head == mCachedTail)
+		{
+			mCachedTail = mTail.load(std::memory_order_acquire);
+			if (head == mCachedTail)
+			{
+				return false;
+			}
+		}
+
+		item = mItems[head & mMask];
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const { return mItems.size(); }
+
+	//! Approximate if called while another thread is pushing or popping
+	size_t size() const
+	{
+		return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+	}
+
+private:
+	static size_t roundUpToPowerOfTwo(size_t value)
+	{
+		assert(value > 0);
+		size_t result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+private:
+	// Head and tail are on separate cache lines to avoid false sharing between producer and consumer.
+	// Each side caches the other side's index so the shared index is only read when the buffer appears full or empty.
+	static constexpr size_t cacheLineSize = 64;
+
+	std::vector<T> mItems;
+	const size_t mMask;
+
+	alignas(cacheLineSize) std::atomic<size_t> mHead = 0; //!< Written by consumer
+	size_t mCachedTail = 0; //!< Consumer's copy of mTail
+
+	alignas(cacheLineSize) std::atomic<size_t> mTail = 0; //!< Written by producer
+	size_t mCachedHead = 0; //!< Producer's copy of mHead
+};
+
+} // namespace skybolt
@@ -7,9 +7,9 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
 #include <typeindex>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
 
@@ -25,11 +25,12 @@ template <typename BaseT>
 class TypedItemContainer
 {
 	typedef std::shared_ptr<BaseT> BaseTPtr;
+	typedef std::vector<BaseTPtr> Items;
 
 public:
 	~TypedItemContainer()
 	{
-		mComponentMap.clear();
+		mItemsByType.clear();
 		// Delete components in reverse order
 		for (int i = (int)mComponents.size() - 1; i >= 0; --i)
 		{
@@ -43,56 +44,59 @@ public:
 
 		for (const auto& type : getExposedTypes(*c))
 		{
-			mComponentMap.insert(typename ComponentMap::value_type(type, c));
+			mItemsByType[type].push_back(c);
 		}
 	}
 
-	virtual void removeItem(const BaseTPtr& c)
+	//! @returns true if the item was found and removed
+	virtual bool removeItem(const BaseTPtr& c)
 	{
 		{
 			auto it = std::find(mComponents.begin(), mComponents.end(), c);
-			if (it != mComponents.end())
+			if (it == mComponents.end())
 			{
-				mComponents.erase(it);
+				return false;
 			}
+			mComponents.erase(it);
 		}
 
 		for (const auto& type : getExposedTypes(*c))
 		{
-			typename ComponentMap::const_iterator it = mComponentMap.lower_bound(type);
-			typename ComponentMap::const_iterator it2 = mComponentMap.upper_bound(type);
-
-			while (it != it2)
+			auto i = mItemsByType.find(type);
+			if (i != mItemsByType.end())
 			{
-				if (it->second == c)
+				Items& items = i->second;
+				auto it = std::find(items.begin(), items.end(), c);
+				if (it != items.end())
 				{
-					mComponentMap.erase(it);
-					break;
+					items.erase(it);
 				}
 			}
 		}
+		return true;
 	}
 
-	//! @returns nullptr if not found
 	template <class DerivedT>
 	std::vector<std::shared_ptr<DerivedT>> getItemsOfType() const
 	{
 		std::vector<std::shared_ptr<DerivedT> > result;
 
-		std::type_index index = typeid(DerivedT);
-		typename ComponentMap::const_iterator it = mComponentMap.lower_bound(index);
-		typename ComponentMap::const_iterator it2 = mComponentMap.upper_bound(index);
-
-		while (it != it2)
+		const Items* items = findItemsOfType<DerivedT>();
+		if (items)
 		{
-			result.push_back(std::static_pointer_cast<DerivedT>(it->second));
-			++it;
+			result.reserve(items->size());
+			for (const BaseTPtr& item : *items)
+			{
+				result.push_back(std::static_pointer_cast<DerivedT>(item));
+			}
 		}
 
 		return result;
 	}
 
-	inline std::vector<BaseTPtr> getAllItems() const
+	//! Items are returned in the order they were added.
+	//! The returned reference is invalidated if items are added or removed.
+	inline const std::vector<BaseTPtr>& getAllItems() const
 	{
 		return mComponents;
 	}
@@ -101,10 +105,24 @@ public:
 	template <class DerivedT>
 	std::shared_ptr<DerivedT> getFirstItemOfType() const
 	{
-		typename ComponentMap::const_iterator i = mComponentMap.find(typeid(DerivedT));
-		if (i != mComponentMap.end())
-			return std::static_pointer_cast<DerivedT>(i->second);
+		const Items* items = findItemsOfType<DerivedT>();
+		if (items)
+		{
+			return std::static_pointer_cast<DerivedT>(items->front());
+		}
+		return nullptr;
+	}
 
+private:
+	//! @returns nullptr if there are no items of the type
+	template <class DerivedT>
+	const Items* findItemsOfType() const
+	{
+		auto i = mItemsByType.find(typeid(DerivedT));
+		if (i != mItemsByType.end() && !i->second.empty())
+		{
+			return &i->second;
+		}
 		return nullptr;
 	}
 
@@ -112,9 +130,9 @@ protected:
 	std::vector<BaseTPtr> mComponents;
 
 private:
-	typedef std::multimap<std::type_index, BaseTPtr> ComponentMap;
-	ComponentMap mComponentMap;
-
+	// Keyed by std::type_index rather than a process-wide id counter, because type ids assigned by a header-only
+	// registry would differ between the engine and each plugin module, which statically link their own copies.
+	std::unordered_map<std::type_index, Items> mItemsByType;
 };
 
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
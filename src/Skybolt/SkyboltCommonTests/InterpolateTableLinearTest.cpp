@@ -65,3 +65,75 @@ TEST_CASE("findInterpolationPoint")
 		CHECK(point->weight == 0.25);
 	}
 }
+
+
+TEST_CASE("findInterpolationPoint with two points")
+{
+	std::vector<double> xData = { 4, 5 };
+
+	SECTION("Extrapolate below lower bound")
+	{
+		boost::optional<InterpolationPoint> point = findInterpolationPoint(xData, 2, /* extrapolate */ true);
+		REQUIRE(point.is_initialized());
+		CHECK(point->bounds.first == 0);
+		CHECK(point->bounds.last == 1);
+		CHECK(point->weight == -2);
+	}
+
+	SECTION("Extrapolate above upper bound")
+	{
+		boost::optional<InterpolationPoint> point = findInterpolationPoint(xData, 6, /* extrapolate */ true);
+		REQUIRE(point.is_initialized());
+		CHECK(point->bounds.first == 0);
+		CHECK(point->bounds.last == 1);
+		CHECK(point->weight == 2);
+	}
+
+	SECTION("Extrapolate below lower bound with cursor")
+	{
+		InterpolationCursor cursor;
+		boost::optional<InterpolationPoint> point = findInterpolationPoint(xData, 2, /* extrapolate */ true, cursor);
+		REQUIRE(point.is_initialized());
+		CHECK(point->bounds.first == 0);
+		CHECK(point->weight == -2);
+	}
+}
+
+TEST_CASE("findInterpolationPoint with cursor matches search without cursor")
+{
+	std::vector<double> xData = { 0, 1, 2, 2, 4, 8, 9 };
+	std::vector<double> xs = { -1, 0, 0.5, 1, 2, 3, 4, 8, 8.5, 9, 10, 3, 0.5, 7, -2 };
+
+	InterpolationCursor cursor;
+	for (double x : xs)
+	{
+		boost::optional<InterpolationPoint> expected = findInterpolationPoint(xData, x, /* extrapolate */ true);
+		boost::optional<InterpolationPoint> point = findInterpolationPoint(xData, x, /* extrapolate */ true, cursor);
+		REQUIRE(expected.is_initialized());
+		REQUIRE(point.is_initialized());
+		CHECK(point->bounds.first == expected->bounds.first);
+		CHECK(point->bounds.last == expected->bounds.last);
+		CHECK(point->weight == expected->weight);
+	}
+}
+
+TEST_CASE("interpolateTableLinear")
+{
+	std::vector<double> xData = { 4, 5, 7 };
+	std::vector<double> yData = { 10, 20, 40 };
+
+	CHECK(*interpolateTableLinear(xData, yData, 4.5, /* extrapolate */ false) == 15);
+	CHECK(*interpolateTableLinear(xData, yData, 8, /* extrapolate */ false) == 40);
+
+	std::vector<double> y;
+	REQUIRE(interpolateTableLinear(xData, yData, { 3, 4.5, 6, 8 }, y, /* extrapolate */ true));
+	CHECK(y == std::vector<double>({ 0, 15, 30, 50 }));
+
+	CHECK(!interpolateTableLinear({}, {}, std::vector<double>({ 1 }), y, /* extrapolate */ true));
+
+	InterpolationTableLinear table(xData, yData, /* extrapolate */ false);
+	CHECK(*table.evaluate(6) == 30);
+	CHECK(*table.evaluate(5) == 20);
+	REQUIRE(table.evaluate({ 6, 4.5, 9 }, y));
+	CHECK(y == std::vector<double>({ 30, 15, 40 }));
+}
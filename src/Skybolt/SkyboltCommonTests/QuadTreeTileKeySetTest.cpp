@@ -0,0 +1,55 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <catch2/catch.hpp>
+#include <SkyboltCommon/Math/QuadTreeTileKeySet.h>
+
+using namespace skybolt;
+
+TEST_CASE("Pack and unpack tile key")
+{
+	std::vector<QuadTreeTileKey> keys = {
+		QuadTreeTileKey(0, 0, 0),
+		QuadTreeTileKey(3, 15, 7),
+		QuadTreeTileKey(28, (1 << 29) - 1, (1 << 28) - 1)
+	};
+
+	for (const QuadTreeTileKey& key : keys)
+	{
+		CHECK(unpackTileKey(packTileKey(key)) == key);
+	}
+	CHECK(packTileKey(QuadTreeTileKey(1, 0, 1)) != packTileKey(QuadTreeTileKey(1, 1, 0)));
+}
+
+TEST_CASE("QuadTreeTileKeySet insert and find keys")
+{
+	QuadTreeTileKeySet set;
+	CHECK(set.empty());
+
+	// Insert enough keys to force the set to grow
+	for (int x = 0; x < 100; ++x)
+	{
+		CHECK(set.insert(QuadTreeTileKey(7, x, x / 2)));
+	}
+	CHECK(!set.insert(QuadTreeTileKey(7, 5, 2)));
+	CHECK(set.size() == 100);
+
+	CHECK(set.contains(QuadTreeTileKey(7, 50, 25)));
+	CHECK(!set.contains(QuadTreeTileKey(7, 50, 26)));
+	CHECK(!set.contains(QuadTreeTileKey(6, 50, 25)));
+
+	size_t visitedCount = 0;
+	set.forEach([&](const QuadTreeTileKey& key) {
+		CHECK(key.y == key.x / 2);
+		++visitedCount;
+	});
+	CHECK(visitedCount == 100);
+
+	set.clear();
+	CHECK(set.empty());
+	CHECK(!set.contains(QuadTreeTileKey(7, 50, 25)));
+}
@@ -0,0 +1,87 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <catch2/catch.hpp>
+#include <SkyboltCommon/ShardedClockCacheMap.h>
+
+using namespace skybolt;
+
+static size_t unitSize(const int&) { return 1; }
+
+TEST_CASE("ShardedClockCacheMap put and get item")
+{
+	ShardedClockCacheMap<int, int> cache(/* capacityBytes */ 5, &unitSize, /* shardCount */ 1);
+
+	int value = 0;
+	CHECK(!cache.get(1, value));
+
+	CHECK(cache.putSafe(1, 10));
+	CHECK(!cache.putSafe(1, 20));
+	REQUIRE(cache.get(1, value));
+	CHECK(value == 10);
+
+	CacheStats stats = cache.getStats();
+	CHECK(stats.hits == 1);
+	CHECK(stats.misses == 1);
+	CHECK(stats.itemCount == 1);
+	CHECK(stats.sizeBytes == 1);
+}
+
+TEST_CASE("ShardedClockCacheMap evicts unreferenced item when byte budget exceeded")
+{
+	constexpr int capacity = 5;
+	ShardedClockCacheMap<int, int> cache(capacity, &unitSize, /* shardCount */ 1);
+
+	for (int i = 0; i < capacity; ++i)
+	{
+		cache.putSafe(i, i);
+	}
+
+	// Reference the first item so that it is given a second chance
+	int value;
+	cache.get(0, value);
+
+	cache.putSafe(55, 55);
+	CHECK(cache.get(55, value));
+	CHECK(cache.get(0, value));
+	CHECK(!cache.get(1, value));
+
+	CacheStats stats = cache.getStats();
+	CHECK(stats.evictions == 1);
+	CHECK(stats.itemCount == capacity);
+}
+
+TEST_CASE("ShardedClockCacheMap respects byte budget across shards")
+{
+	ShardedClockCacheMap<int, int> cache(/* capacityBytes */ 400, [](const int&) { return size_t(10); }, /* shardCount */ 4);
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		cache.putSafe(i, i);
+	}
+
+	CacheStats stats = cache.getStats();
+	CHECK(stats.sizeBytes <= 400);
+	CHECK(stats.itemCount == stats.sizeBytes / 10);
+	CHECK(stats.evictions == 1000 - stats.itemCount);
+}
+
+TEST_CASE("ShardedClockCacheMap spreads keys with equal low bits across shards")
+{
+	const size_t shardCount = 16;
+	const size_t itemsPerShard = 4;
+	ShardedClockCacheMap<int, int> cache(shardCount * itemsPerShard * 10, [](const int&) { return size_t(10); }, shardCount);
+
+	// Keys are multiples of the shard count, so all would be put in the same shard if selected by hash modulo shard count
+	const int keyCount = 64;
+	for (int i = 0; i < keyCount; ++i)
+	{
+		cache.putSafe(i * int(shardCount), i);
+	}
+
+	CHECK(cache.getStats().itemCount > itemsPerShard * 4);
+}
@@ -0,0 +1,80 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <catch2/catch.hpp>
+#include <SkyboltCommon/SpscRingBuffer.h>
+
+#include <thread>
+
+using namespace skybolt;
+
+TEST_CASE("SpscRingBuffer capacity is rounded up to power of two")
+{
+	SpscRingBuffer<int> buffer(5);
+	CHECK(buffer.capacity() == 8);
+}
+
+TEST_CASE("SpscRingBuffer pops items in push order")
+{
+	SpscRingBuffer<int> buffer(4);
+
+	int item;
+	CHECK(!buffer.tryPop(item));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		CHECK(buffer.tryPush(i));
+	}
+	CHECK(!buffer.tryPush(4)); // Full
+	CHECK(buffer.size() == 4);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		REQUIRE(buffer.tryPop(item));
+		CHECK(item == i);
+	}
+	CHECK(!buffer.tryPop(item));
+
+	// Wrap around
+	CHECK(buffer.tryPush(5));
+	REQUIRE(buffer.tryPop(item));
+	CHECK(item == 5);
+}
+
+TEST_CASE("SpscRingBuffer passes items between threads")
+{
+	SpscRingBuffer<int> buffer(16);
+	constexpr int itemCount = 100000;
+
+	std::thread producer([&] {
+		for (int i = 0; i < itemCount; ++i)
+		{
+			while (!buffer.tryPush(i))
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	bool inOrder = true;
+	for (int expected = 0; expected < itemCount;)
+	{
+		int item;
+		if (buffer.tryPop(item))
+		{
+			inOrder = inOrder && (item == expected);
+			++expected;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	CHECK(inOrder);
+}
@@ -0,0 +1,150 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <catch2/catch.hpp>
+#include <SkyboltCommon/File/TilePack.h>
+
+#include <string>
+
+using namespace skybolt;
+using namespace skybolt::file;
+
+namespace fs = std::filesystem;
+
+static fs::path createTestPackPath()
+{
+	fs::path path = fs::temp_directory_path() / "SkyboltTilePackTest" / "test.tilepack";
+	fs::remove_all(path.parent_path());
+	return path;
+}
+
+static std::string readString(const TilePack& pack, const QuadTreeTileKey& key)
+{
+	std::string result;
+	pack.read(key, [&](const std::uint8_t* data, size_t size) {
+		result.assign(reinterpret_cast<const char*>(data), size);
+	});
+	return result;
+}
+
+static void appendString(TilePack& pack, const QuadTreeTileKey& key, const std::string& str)
+{
+	pack.append(key, str.data(), str.size());
+}
+
+TEST_CASE("TilePack append and read tiles")
+{
+	fs::path path = createTestPackPath();
+	{
+		TilePack pack(path);
+		CHECK(pack.getTileCount() == 0);
+		CHECK(!pack.contains(QuadTreeTileKey(1, 0, 1)));
+		CHECK(!pack.read(QuadTreeTileKey(1, 0, 1), [](const std::uint8_t*, size_t) {}));
+
+		appendString(pack, QuadTreeTileKey(1, 0, 1), "first");
+		CHECK(readString(pack, QuadTreeTileKey(1, 0, 1)) == "first");
+
+		// Tiles appended after the file was mapped should be readable
+		appendString(pack, QuadTreeTileKey(2, 3, 1), "second");
+		CHECK(readString(pack, QuadTreeTileKey(2, 3, 1)) == "second");
+		CHECK(readString(pack, QuadTreeTileKey(1, 0, 1)) == "first");
+
+		// Existing tiles are not replaced
+		CHECK(!pack.append(QuadTreeTileKey(1, 0, 1), "x", 1));
+		CHECK(readString(pack, QuadTreeTileKey(1, 0, 1)) == "first");
+		CHECK(pack.getTileCount() == 2);
+	}
+
+	// Reopen pack
+	TilePack pack(path);
+	CHECK(pack.getTileCount() == 2);
+	CHECK(readString(pack, QuadTreeTileKey(1, 0, 1)) == "first");
+	CHECK(readString(pack, QuadTreeTileKey(2, 3, 1)) == "second");
+
+	appendString(pack, QuadTreeTileKey(3, 7, 7), "third");
+	CHECK(readString(pack, QuadTreeTileKey(3, 7, 7)) == "third");
+}
+
+TEST_CASE("TilePack ignores tiles that were not completely written")
+{
+	fs::path path = createTestPackPath();
+	{
+		TilePack pack(path);
+		appendString(pack, QuadTreeTileKey(1, 0, 0), "complete");
+		appendString(pack, QuadTreeTileKey(1, 1, 0), "incomplete");
+	}
+
+	fs::resize_file(path, fs::file_size(path) - 1);
+
+	TilePack pack(path);
+	CHECK(pack.getTileCount() == 1);
+	CHECK(readString(pack, QuadTreeTileKey(1, 0, 0)) == "complete");
+	CHECK(!pack.contains(QuadTreeTileKey(1, 1, 0)));
+
+	// Appending must not revive the entry of the incomplete tile
+	appendString(pack, QuadTreeTileKey(2, 0, 0), "new tile");
+	{
+		TilePack reopenedPack(path);
+		CHECK(reopenedPack.getTileCount() == 2);
+		CHECK(!reopenedPack.contains(QuadTreeTileKey(1, 1, 0)));
+		CHECK(readString(reopenedPack, QuadTreeTileKey(2, 0, 0)) == "new tile");
+	}
+}
+
+TEST_CASE("TilePack appends correctly after an index entry that was not completely written")
+{
+	fs::path path = createTestPackPath();
+	fs::path indexPath = fs::path(path) += TilePack::getIndexExtension();
+	{
+		TilePack pack(path);
+		appendString(pack, QuadTreeTileKey(1, 0, 0), "complete");
+		appendString(pack, QuadTreeTileKey(1, 1, 0), "torn");
+	}
+
+	fs::resize_file(indexPath, fs::file_size(indexPath) - 5);
+
+	{
+		TilePack pack(path);
+		CHECK(pack.getTileCount() == 1);
+		appendString(pack, QuadTreeTileKey(2, 0, 0), "new tile");
+	}
+
+	TilePack pack(path);
+	CHECK(pack.getTileCount() == 2);
+	CHECK(readString(pack, QuadTreeTileKey(1, 0, 0)) == "complete");
+	CHECK(readString(pack, QuadTreeTileKey(2, 0, 0)) == "new tile");
+	CHECK(!pack.contains(QuadTreeTileKey(1, 1, 0)));
+}
+
+TEST_CASE("TilePack throws on invalid file")
+{
+	fs::path path = createTestPackPath();
+	fs::create_directories(path.parent_path());
+	std::ofstream(path) << "not a tile pack";
+	std::ofstream(fs::path(path) += TilePack::getIndexExtension()) << "not a tile pack index";
+
+	CHECK_THROWS(TilePack(path));
+}
+
+TEST_CASE("TilePack opened read only does not create or modify the pack")
+{
+	fs::path path = createTestPackPath();
+	CHECK_THROWS(TilePack(path, TilePack::OpenMode::ReadOnly));
+	CHECK(!fs::exists(path));
+
+	{
+		TilePack pack(path);
+		CHECK(pack.isWritable());
+		appendString(pack, QuadTreeTileKey(1, 1, 0), "abc");
+	}
+
+	TilePack pack(path, TilePack::OpenMode::ReadOnly);
+	CHECK(!pack.isWritable());
+	CHECK(readString(pack, QuadTreeTileKey(1, 1, 0)) == "abc");
+	CHECK(!pack.append(QuadTreeTileKey(1, 0, 0), "def", 3));
+	CHECK(!pack.contains(QuadTreeTileKey(1, 0, 0)));
+}
@@ -105,4 +105,29 @@ TEST_CASE("TypedItemContainer add and remove item with multiple exposed types")
 
 	c.removeItem(item);
 	CHECK(c.getAllItems().empty());
-}
\ No newline at end of file
+}
+
+TEST_CASE("TypedItemContainer remove item that is not first of its type")
+{
+	TypedItemContainer<Base> c;
+
+	auto itemA = std::make_shared<DerivedA>();
+	c.addItem(itemA);
+
+	auto itemB = std::make_shared<DerivedA>();
+	c.addItem(itemB);
+
+	c.removeItem(itemB);
+	CHECK(c.getAllItems().size() == 1);
+	CHECK(c.getItemsOfType<DerivedA>().size() == 1);
+	CHECK(c.getFirstItemOfType<DerivedA>() == itemA);
+}
+
+TEST_CASE("TypedItemContainer returns no items for type that was never added")
+{
+	TypedItemContainer<Base> c;
+	c.addItem(std::make_shared<DerivedA>());
+
+	CHECK(c.getFirstItemOfType<DerivedB>() == nullptr);
+	CHECK(c.getItemsOfType<DerivedB>().empty());
+}
@@ -22,11 +22,26 @@
 
 #include <boost/log/trivial.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 namespace skybolt {
 
 static void registerAssetPackage(const std::string& folderPath)
 {
-	osgDB::Registry::instance()->getDataFilePathList().push_back(folderPath + "/");
+	// The registry is global, so guard against concurrent EngineRoot creation, and don't
+	// grow the search path each time an EngineRoot is created, e.g. for batches of headless runs.
+	static std::mutex mutex;
+	std::scoped_lock lock(mutex);
+
+	osgDB::FilePathList& paths = osgDB::Registry::instance()->getDataFilePathList();
+	std::string path = folderPath + "/";
+	if (std::find(paths.begin(), paths.end(), path) == paths.end())
+	{
+		paths.push_back(path);
+	}
 }
 
 file::Path locateFile(const std::string& filename, file::FileLocatorMode mode)
@@ -45,12 +60,13 @@ file::Path locateFile(const std::string& filename, file::FileLocatorMode mode)
 
 static std::vector<std::string> transparentMaterialNames() { return { "transparentExt", "transparent" }; }
 
-static vis::ModelFactoryPtr createModelFactory(const vis::ShaderPrograms& programs)
+static vis::ModelFactoryPtr createModelFactory(const vis::ShaderPrograms& programs, px_sched::Scheduler* scheduler)
 {
 	osg::ref_ptr<osg::Program> glassProgram = programs.getRequiredProgram("glass");
 
 	vis::ModelFactoryConfig config;
 	config.defaultProgram = programs.getRequiredProgram("model");
+	config.scheduler = scheduler;
 	for (const std::string& name : transparentMaterialNames())
 	{
 		config.stateSetModifiers[name] = [=](osg::StateSet& stateSet, const osg::Material& material) {
@@ -62,22 +78,97 @@ static vis::ModelFactoryPtr createModelFactory(const vis::ShaderPrograms& progra
 	return std::make_shared<vis::ModelFactory>(config);
 }
 
+//! Items are claimed from a shared counter by the calling thread and by helper jobs on the scheduler.
+//! The scheduler is shared with IO jobs, so helper jobs may be queued for a long time before they start.
+//! The calling thread does not wait for them to start. It runs any items not yet claimed itself,
+//! and only waits for items already claimed by helper jobs to complete.
+static sim::ParallelFor createParallelFor(px_sched::Scheduler* scheduler, int threadCount)
+{
+	return [scheduler, threadCount] (size_t count, const std::function<void(size_t)>& body) {
+		if (count == 0)
+		{
+			return;
+		}
+
+		// Shared with helper jobs, which may outlive the call
+		struct State
+		{
+			std::atomic<size_t> nextItem{0};
+			size_t completedCount = 0; //!< Guarded by mutex
+			std::mutex mutex;
+			std::condition_variable itemsCompleted;
+		};
+		auto state = std::make_shared<State>();
+
+		size_t helperCount = std::min(count - 1, size_t(threadCount));
+		for (size_t i = 0; i < helperCount; ++i)
+		{
+			// body is only called for claimed items, which the calling thread waits for, so it can be captured by reference
+			scheduler->run([state, count, &body] {
+				size_t completedCount = 0;
+				for (size_t item = state->nextItem++; item < count; item = state->nextItem++)
+				{
+					body(item);
+					++completedCount;
+				}
+
+				if (completedCount > 0)
+				{
+					std::scoped_lock lock(state->mutex);
+					state->completedCount += completedCount;
+					state->itemsCompleted.notify_one();
+				}
+			});
+		}
+
+		size_t completedCount = 0;
+		std::exception_ptr exception;
+		try
+		{
+			for (size_t item = state->nextItem++; item < count; item = state->nextItem++)
+			{
+				body(item);
+				++completedCount;
+			}
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+			++completedCount;
+		}
+
+		// Stop further items being claimed, and wait for claimed items to complete
+		size_t claimedCount = std::min(state->nextItem.exchange(count), count);
+		{
+			std::unique_lock lock(state->mutex);
+			state->completedCount += completedCount;
+			state->itemsCompleted.wait(lock, [&] { return state->completedCount == claimedCount; });
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	};
+}
+
 EngineRoot::EngineRoot(const EngineRootConfig& config) :
 	mPluginFactories(config.pluginFactories),
 	scheduler(new px_sched::Scheduler),
 	fileLocator(locateFile),
 	simWorld(std::make_unique<sim::World>()),
-	namedObjectRegistry(std::make_shared<sim::NamedObjectRegistry>())
+	namedObjectRegistry(std::make_shared<sim::NamedObjectRegistry>()),
+	simStepperConfig(config.simStepperConfig)
 {
 
-	// Create coreCount threads - 1 background threads, leaving a core for the main thread.
+	// By default, create coreCount threads - 1 background threads, leaving a core for the main thread.
 	int coreCount = std::thread::hardware_concurrency();
-	int threadCount = std::max(1, coreCount-1);
-	BOOST_LOG_TRIVIAL(info) << coreCount << " CPU cores detected. Creating " << threadCount << " background threads.";
+	schedulerThreadCount = config.schedulerThreadCount > 0 ? config.schedulerThreadCount : std::max(1, coreCount-1);
+	BOOST_LOG_TRIVIAL(info) << coreCount << " CPU cores detected. Creating " << schedulerThreadCount << " background threads.";
 
 	px_sched::SchedulerParams schedulerParams;
-	schedulerParams.max_running_threads = threadCount;
-	schedulerParams.num_threads = threadCount;
+	schedulerParams.max_running_threads = schedulerThreadCount;
+	schedulerParams.num_threads = schedulerThreadCount;
 	scheduler->init(schedulerParams);
 
 	std::vector<std::string> assetSearchPaths = {
@@ -119,8 +210,11 @@ EngineRoot::EngineRoot(const EngineRootConfig& config) :
 			"Please refer to Skybolt documentation for information about finding assets.");
 	}
 
-	programs = vis::createShaderPrograms();
-	scene.reset(new vis::Scene);
+	if (config.enableVis)
+	{
+		programs = vis::createShaderPrograms();
+		scene.reset(new vis::Scene);
+	}
 
 	Scenario* scenarioPtr = &scenario;
 	julianDateProvider = [=]() {
@@ -136,16 +230,17 @@ EngineRoot::EngineRoot(const EngineRootConfig& config) :
 	// Create object factory
 	EntityFactory::Context context;
 	context.scheduler = scheduler.get();
+	context.schedulerThreadCount = schedulerThreadCount;
 	context.simWorld = simWorld.get();
 	context.componentFactoryRegistry = componentFactoryRegistry;
 	context.scene = scene.get();
-	context.programs = &programs;
+	context.programs = config.enableVis ? &programs : nullptr;
 	context.julianDateProvider = julianDateProvider;
 	context.namedObjectRegistry = namedObjectRegistry;
 	context.stats = &stats;
 	context.visFactoryRegistry = visFactoryRegistry;
 	context.tileSourceFactory = std::make_shared<vis::JsonTileSourceFactory>(config.tileSourceFactoryConfig);
-	context.modelFactory = createModelFactory(programs);
+	context.modelFactory = config.enableVis ? createModelFactory(programs, scheduler.get()) : nullptr;
 	context.fileLocator = locateFile;
 	context.assetPackagePaths = mAssetPackagePaths;
 
@@ -153,11 +248,23 @@ EngineRoot::EngineRoot(const EngineRootConfig& config) :
 	entityFactory.reset(new EntityFactory(context, paths));
 
 	// Create default systems
+	auto entitySystem = std::make_shared<sim::EntitySystem>(simWorld.get());
+	if (config.parallelEntityUpdate)
+	{
+		entitySystem->setParallelFor(createParallelFor(scheduler.get(), schedulerThreadCount));
+	}
+
 	systemRegistry = std::make_shared<sim::SystemRegistry>(sim::SystemRegistry({
-		std::make_shared<sim::EntitySystem>(simWorld.get()),
-		std::make_shared<SimVisSystem>(simWorld.get(), scene)
+		entitySystem
 	}));
 
+	if (config.enableVis)
+	{
+		auto simVisSystem = std::make_shared<SimVisSystem>(simWorld.get(), scene);
+		simVisSystem->setInterpolationEnabled(config.interpolateVisState);
+		systemRegistry->push_back(simVisSystem);
+	}
+
 	// Create plugins
 	// TODO: move plugin creation out of constructor. It should happen after EngineRoot is gauranteed to be fully created
 	// because plugins may refer to EngineRoot.
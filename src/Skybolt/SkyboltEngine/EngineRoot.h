@@ -11,6 +11,7 @@
 #include "EntityFactory.h"
 #include "Plugin/Plugin.h"
 #include <SkyboltSim/Components/NameComponent.h>
+#include <SkyboltSim/System/SimStepper.h>
 #include <SkyboltSim/System/SystemRegistry.h>
 #include <SkyboltVis/Scene.h>
 #include <SkyboltVis/Shader/ShaderProgramRegistry.h>
@@ -27,6 +28,11 @@ struct EngineRootConfig
 {
 	std::vector<PluginFactory> pluginFactories;
 	vis::JsonTileSourceFactoryConfig tileSourceFactoryConfig;
+	bool parallelEntityUpdate = false; //!< If true, thread safe entities are updated in parallel on the scheduler's threads
+	bool interpolateVisState = false; //!< If true, visuals are interpolated between dynamics substeps. See SimVisSystem::setInterpolationEnabled().
+	bool enableVis = true; //!< If false, no shader programs, scene, models or SimVisSystem are created, and entities are created without visuals. Used for headless simulation.
+	int schedulerThreadCount = 0; //!< Number of scheduler background threads. If 0, one fewer than the number of CPU cores.
+	sim::SimStepperConfig simStepperConfig;
 };
 
 class EngineRoot
@@ -44,8 +50,9 @@ public:
 	const std::vector<std::string>& getAssetPackagePaths() const { return mAssetPackagePaths; }
 
 	std::unique_ptr<px_sched::Scheduler> scheduler;
-	vis::ShaderPrograms programs;
-	vis::ScenePtr scene;
+	int schedulerThreadCount; //!< Number of threads the scheduler runs tasks on
+	vis::ShaderPrograms programs; //!< Empty if vis is disabled
+	vis::ScenePtr scene; //!< Null if vis is disabled
 	file::FileLocator fileLocator;
 	JulianDateProvider julianDateProvider;
 	std::unique_ptr<sim::World> simWorld;
@@ -54,6 +61,7 @@ public:
 	EngineStats stats;
 	Scenario scenario;
 	sim::SystemRegistryPtr systemRegistry;
+	sim::SimStepperConfig simStepperConfig; //!< Config that applications should use when creating a SimStepper
 };
 
 file::Path locateFile(const std::string& filename, file::FileLocatorMode mode);
@@ -28,6 +28,23 @@ T getOptionalNodeOrDefaultWithWarning(const json& j, const std::string& name, co
 	return defaultValue;
 }
 
+static sim::OverrunPolicy toOverrunPolicy(const std::string& name)
+{
+	if (name == "dropTime")
+	{
+		return sim::OverrunPolicy::DropTime;
+	}
+	else if (name == "catchUp")
+	{
+		return sim::OverrunPolicy::CatchUp;
+	}
+	else if (name == "runAllSubsteps")
+	{
+		return sim::OverrunPolicy::RunAllSubsteps;
+	}
+	throw std::runtime_error("Invalid overrunPolicy '" + name + "'. Expected 'dropTime', 'catchUp' or 'runAllSubsteps'.");
+}
+
 std::unique_ptr<EngineRoot> EngineRootFactory::create(const boost::program_options::variables_map& params)
 {
 	nlohmann::json settings = readEngineSettings(params);
@@ -39,12 +56,34 @@ std::unique_ptr<EngineRoot> EngineRootFactory::create(const boost::program_optio
 }
 
 std::unique_ptr<EngineRoot> EngineRootFactory::create(const std::vector<PluginFactory>& pluginFactories, const json& settings)
+{
+	return std::make_unique<EngineRoot>(createConfig(pluginFactories, settings));
+}
+
+EngineRootConfig EngineRootFactory::createConfig(const std::vector<PluginFactory>& pluginFactories, const json& settings)
 {
 	EngineRootConfig config;
 	config.pluginFactories = pluginFactories;
 	config.tileSourceFactoryConfig.apiKeys = readNameMap<std::string>(settings, "tileApiKeys");
 	config.tileSourceFactoryConfig.cacheDirectory = "Cache";
-	return std::make_unique<EngineRoot>(config);
+
+	auto simSettings = settings.find("sim");
+	if (simSettings != settings.end())
+	{
+		const json& s = simSettings.value();
+		config.parallelEntityUpdate = readOptionalOrDefault(s, "parallelEntityUpdate", config.parallelEntityUpdate);
+		config.interpolateVisState = readOptionalOrDefault(s, "interpolateVisState", config.interpolateVisState);
+
+		sim::SimStepperConfig& stepper = config.simStepperConfig;
+		stepper.dynamicsStepSize = readOptionalOrDefault(s, "dynamicsStepSize", stepper.dynamicsStepSize);
+		stepper.maxDynamicsSubsteps = readOptionalOrDefault(s, "maxDynamicsSubsteps", stepper.maxDynamicsSubsteps);
+		if (auto policy = readOptional<std::string>(s, "overrunPolicy"); policy)
+		{
+			stepper.overrunPolicy = toOverrunPolicy(*policy);
+		}
+		stepper.maxCatchUpTime = readOptionalOrDefault(s, "maxCatchUpTime", stepper.maxCatchUpTime);
+	}
+	return config;
 }
 
 } // namespace skybolt
\ No newline at end of file
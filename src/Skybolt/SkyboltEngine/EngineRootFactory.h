@@ -16,6 +16,9 @@ class EngineRootFactory
 public:
 	static std::unique_ptr<EngineRoot> create(const boost::program_options::variables_map& params);
 	static std::unique_ptr<EngineRoot> create(const std::vector<PluginFactory>& pluginFactories, const nlohmann::json& settings);
+
+	//! @returns config read from settings, which callers may modify before creating an EngineRoot
+	static EngineRootConfig createConfig(const std::vector<PluginFactory>& pluginFactories, const nlohmann::json& settings);
 };
 
 } // namespace skybolt
\ No newline at end of file
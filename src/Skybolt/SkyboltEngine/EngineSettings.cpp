@@ -10,6 +10,14 @@ nlohmann::json createDefaultEngineSettings()
 	"tileApiKeys": {
 		"bing": "",
 		"mapbox": ""
+	},
+	"sim": {
+		"parallelEntityUpdate": false,
+		"interpolateVisState": false,
+		"dynamicsStepSize": 0.016666666666666666,
+		"maxDynamicsSubsteps": 10,
+		"overrunPolicy": "dropTime",
+		"maxCatchUpTime": 1.0
 	}
 })"_json;
 }
@@ -28,6 +28,7 @@
 #include <SkyboltSim/Components/PlanetComponent.h>
 #include <SkyboltSim/Components/PropellerComponent.h>
 #include <SkyboltSim/Physics/Astronomy.h>
+#include <SkyboltSim/Spatial/Geocentric.h>
 #include <SkyboltSim/Spatial/GreatCircle.h>
 
 #include <SkyboltVis/Camera.h>
@@ -162,65 +163,88 @@ static void registerAssetSearchDirectory(const std::string& filename)
 	}
 }
 
-static void loadVisualModel(Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent, const nlohmann::json& json)
+//! Adds vis components to an entity. Loaders are created once per template, with their JSON already parsed.
+typedef std::function<void(Entity*, const EntityFactory::Context&, const VisObjectsComponentPtr&, const SimVisBindingsComponentPtr&)> VisComponentLoader;
+
+//! Creates a VisComponentLoader from a template's component JSON
+typedef std::function<VisComponentLoader(const EntityFactory::Context&, const nlohmann::json&)> VisComponentCompiler;
+
+//! @returns the filename of the model used by a vis component.
+//! Loaders request the model from the ModelFactory for each entity, rather than the prefab holding the model,
+//! so that the factory can evict models which are no longer used by any entity.
+static std::string compileModelFilename(const nlohmann::json& json)
 {
 	std::string filename = json.at("model").get<std::string>();
-	vis::ModelConfig config;
-	config.node = context.modelFactory->createModel(filename);
-
 	registerAssetSearchDirectory(getParentDirectory(filename));
-
-	vis::ModelPtr fuselageModel(new vis::Model(config));
-	visObjectsComponent->addObject(fuselageModel);
-
-	SimVisBindingPtr simVis(new SimpleSimVisBinding(entity, fuselageModel,
-		readOptionalVec3f(json, "positionRelBody", osg::Vec3f()),
-		readOptionalQuat(json, "orientationRelBody", osg::Quat())
-	));
-	simVisBindingComponent->bindings.push_back(simVis);
+	return filename;
 }
 
-static void loadVisualMainRotor(Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent, const nlohmann::json& json)
+static vis::ModelConfig createModelConfig(const EntityFactory::Context& context, const std::string& filename)
 {
-	std::string filename = json.at("model").get<std::string>();
 	vis::ModelConfig config;
-	config.node = context.modelFactory->createModel(filename);
+	config.node = context.modelFactory->createModelAsync(filename);
+	return config;
+}
 
-	registerAssetSearchDirectory(getParentDirectory(filename));
+static bool isModelComponent(const std::string& key)
+{
+	return key == "visualModel" || key == "visualMainRotor" || key == "visualTailRotor";
+}
 
-	vis::ModelPtr mainRotorModel(new vis::Model(config));
-	visObjectsComponent->addObject(mainRotorModel);
+static VisComponentLoader compileVisualModel(const EntityFactory::Context& context, const nlohmann::json& json)
+{
+	std::string filename = compileModelFilename(json);
+	osg::Vec3f positionRelBody = readOptionalVec3f(json, "positionRelBody", osg::Vec3f());
+	osg::Quat orientationRelBody = readOptionalQuat(json, "orientationRelBody", osg::Quat());
 
-	auto rotor = entity->getFirstComponentRequired<MainRotorComponent>();
-	auto node = entity->getFirstComponentRequired<Node>();
+	return [filename, positionRelBody, orientationRelBody] (Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent) {
+		vis::ModelPtr fuselageModel(new vis::Model(createModelConfig(context, filename)));
+		visObjectsComponent->addObject(fuselageModel);
 
-	SimVisBindingPtr simVis(new MainRotorVisComponent(rotor.get(), node.get(), mainRotorModel));
-	simVisBindingComponent->bindings.push_back(simVis);
+		SimVisBindingPtr simVis(new SimpleSimVisBinding(entity, fuselageModel, positionRelBody, orientationRelBody));
+		simVisBindingComponent->bindings.push_back(simVis);
+	};
 }
 
-static void loadVisualTailRotor(Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent, const nlohmann::json& json)
+static VisComponentLoader compileVisualMainRotor(const EntityFactory::Context& context, const nlohmann::json& json)
 {
-	std::string filename = json.at("model").get<std::string>();
-	vis::ModelConfig config;
-	config.node = context.modelFactory->createModel(filename);
+	std::string filename = compileModelFilename(json);
 
-	registerAssetSearchDirectory(getParentDirectory(filename));
+	return [filename] (Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent) {
+		vis::ModelPtr mainRotorModel(new vis::Model(createModelConfig(context, filename)));
+		visObjectsComponent->addObject(mainRotorModel);
 
-	vis::ModelPtr tailRotorModel(new vis::Model(config));
-	visObjectsComponent->addObject(tailRotorModel);
+		auto rotor = entity->getFirstComponentRequired<MainRotorComponent>();
+		auto node = entity->getFirstComponentRequired<Node>();
 
-	auto rotor = entity->getFirstComponentRequired<PropellerComponent>();
-	auto node = entity->getFirstComponentRequired<Node>();
+		SimVisBindingPtr simVis(new MainRotorVisComponent(rotor.get(), node.get(), mainRotorModel));
+		simVisBindingComponent->bindings.push_back(simVis);
+	};
+}
 
-	SimVisBindingPtr simVis(new PropellerVisComponent(rotor.get(), node.get(), tailRotorModel));
-	simVisBindingComponent->bindings.push_back(simVis);
+static VisComponentLoader compileVisualTailRotor(const EntityFactory::Context& context, const nlohmann::json& json)
+{
+	std::string filename = compileModelFilename(json);
+
+	return [filename] (Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent) {
+		vis::ModelPtr tailRotorModel(new vis::Model(createModelConfig(context, filename)));
+		visObjectsComponent->addObject(tailRotorModel);
+
+		auto rotor = entity->getFirstComponentRequired<PropellerComponent>();
+		auto node = entity->getFirstComponentRequired<Node>();
+
+		SimVisBindingPtr simVis(new PropellerVisComponent(rotor.get(), node.get(), tailRotorModel));
+		simVisBindingComponent->bindings.push_back(simVis);
+	};
 }
 
-static void loadVisualCamera(Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent, const nlohmann::json& json)
+static VisComponentLoader compileVisualCamera(const EntityFactory::Context& context, const nlohmann::json& json)
 {
-	vis::CameraPtr visCamera(new vis::Camera(1.0f));
-	SimVisBindingPtr cameraSimVisBinding(new CameraSimVisBinding(entity, visCamera));
-	simVisBindingComponent->bindings.push_back(cameraSimVisBinding);
+	return [] (Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent) {
+		vis::CameraPtr visCamera(new vis::Camera(1.0f));
+		SimVisBindingPtr cameraSimVisBinding(new CameraSimVisBinding(entity, visCamera));
+		simVisBindingComponent->bindings.push_back(cameraSimVisBinding);
+	};
 }
 
 struct PlanetStatsUpdater : vis::PlanetSurfaceListener, vis::QuadTreeTileLoaderListener, sim::Component
@@ -263,6 +287,54 @@ private:
 	size_t mOwnTilesLoading = 0;
 };
 
+//! Prioritizes loading of planet altitude tiles nearest the camera
+struct AltitudeLoadPrioritizer : sim::Component
+{
+	AltitudeLoadPrioritizer(const sim::World* world, const sim::Entity* planet, const std::shared_ptr<vis::TileAsyncPlanetAltitudeProvider>& provider)
+		: mWorld(world), mPlanet(planet), mProvider(provider)
+	{
+		assert(mWorld);
+		assert(mPlanet);
+		assert(mProvider);
+	}
+
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamics }; }
+
+	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override
+	{
+		sim::EntityPtr camera = mCamera.lock();
+		if (!camera)
+		{
+			// Search for camera only when we don't have one, to avoid scanning all entities every frame
+			for (const sim::EntityPtr& entity : mWorld->getEntities())
+			{
+				if (entity->getFirstComponent<sim::CameraComponent>())
+				{
+					camera = entity;
+					mCamera = entity;
+					break;
+				}
+			}
+		}
+
+		if (camera)
+		{
+			auto cameraPosition = getPosition(*camera);
+			auto planetPosition = getPosition(*mPlanet);
+			if (cameraPosition && planetPosition)
+			{
+				mProvider->setPriorityOrigin(geocentricToLatLon(*cameraPosition - *planetPosition));
+			}
+		}
+	}
+
+private:
+	const sim::World* mWorld;
+	const sim::Entity* mPlanet;
+	std::shared_ptr<vis::TileAsyncPlanetAltitudeProvider> mProvider;
+	std::weak_ptr<sim::Entity> mCamera;
+};
+
 static osg::Texture2D* createCloudTexture(const std::string& filepath)
 {
 	osg::Image* image = vis::readImageWithCorrectOrientation(filepath);
@@ -272,6 +344,16 @@ static osg::Texture2D* createCloudTexture(const std::string& filepath)
 	return texture;
 }
 
+static void addPlanetSimComponents(Entity* entity, const EntityFactory::Context& context, double planetRadius, bool hasOcean, const vis::TileSourcePtr& elevationTileSource, int elevationMaxLodLevel)
+{
+	auto altitudeProvider = std::make_shared<vis::TileAsyncPlanetAltitudeProvider>(context.scheduler, elevationTileSource, elevationMaxLodLevel);
+	auto planetComponent = std::make_shared<PlanetComponent>(planetRadius, hasOcean, altitudeProvider);
+	entity->addComponent(planetComponent);
+	entity->addComponent(std::make_shared<AltitudeLoadPrioritizer>(context.simWorld, entity, altitudeProvider));
+
+	entity->addComponent(ComponentPtr(new NameComponent("Earth", context.namedObjectRegistry, entity)));
+}
+
 static void loadPlanet(Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent, const nlohmann::json& json)
 {
 	double planetRadius = json.at("radius").get<double>();
@@ -279,6 +361,7 @@ static void loadPlanet(Entity* entity, const EntityFactory::Context& context, co
 
 	vis::PlanetConfig config;
 	config.scheduler = context.scheduler;
+	config.schedulerThreadCount = context.schedulerThreadCount;
 	config.programs = context.programs;
 	config.scene = context.scene;
 	config.innerRadius = planetRadius;
@@ -325,10 +408,10 @@ static void loadPlanet(Entity* entity, const EntityFactory::Context& context, co
 				throw Exception("Reyleigh scattering coefficient not defined");
 			}
 
-			atmosphereConfig.rayleighScaleHeight = atmosphere.at("rayleighScaleHeight").get<double>();
-			atmosphereConfig.mieScaleHeight = atmosphere.at("mieScaleHeight").get<double>();
-			atmosphereConfig.mieAngstromAlpha = atmosphere.at("mieAngstromAlpha").get<double>();
-			atmosphereConfig.mieAngstromBeta = atmosphere.at("mieAngstromBeta").get<double>();
+			atmosphereConfig.rayleighScaleHeight = atmosphere.at("rayleighScaleHeight").get<double>();
+			atmosphereConfig.mieScaleHeight = atmosphere.at("mieScaleHeight").get<double>();
+			atmosphereConfig.mieAngstromAlpha = atmosphere.at("mieAngstromAlpha").get<double>();
+			atmosphereConfig.mieAngstromBeta = atmosphere.at("mieAngstromBeta").get<double>();
 			atmosphereConfig.mieSingleScatteringAlbedo = atmosphere.at("mieSingleScatteringAlbedo").get<double>();
 			atmosphereConfig.miePhaseFunctionG = atmosphere.at("miePhaseFunctionG").get<double>();
 			atmosphereConfig.useEarthOzone = readOptionalOrDefault<bool>(atmosphere, "useEarthOzone", false);
@@ -398,104 +481,275 @@ static void loadPlanet(Entity* entity, const EntityFactory::Context& context, co
 	entity->addComponent(visObjectsComponent);
 	visObjectsComponent->addObject(visObject);
 
-	auto altitudeProvider = std::make_shared<vis::TileAsyncPlanetAltitudeProvider>(context.scheduler, config.planetTileSources.elevation, config.elevationMaxLodLevel);
-	auto planetComponent = std::make_shared<PlanetComponent>(planetRadius, hasOcean, altitudeProvider);
-	entity->addComponent(planetComponent);
-
-	entity->addComponent(ComponentPtr(new NameComponent("Earth", context.namedObjectRegistry, entity)));
+	addPlanetSimComponents(entity, context, planetRadius, hasOcean, config.planetTileSources.elevation, config.elevationMaxLodLevel);
 
 	std::shared_ptr<PlanetStatsUpdater> statsUpdater = std::make_shared<PlanetStatsUpdater>(context.stats, static_cast<vis::Planet*>(visObject.get())->getSurface());
 	entity->addComponent(statsUpdater);
 }
 
-typedef std::function<void(Entity*, const EntityFactory::Context&, VisObjectsComponentPtr&, const SimVisBindingsComponentPtr&, const nlohmann::json&)> VisComponentLoader;
+static VisComponentLoader compilePlanet(const EntityFactory::Context& context, const nlohmann::json& json)
+{
+	// Planets are rarely created, so their JSON is parsed when the planet is created
+	return [json] (Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent) {
+		loadPlanet(entity, context, visObjectsComponent, simVisBindingComponent, json);
+	};
+}
 
-EntityPtr EntityFactory::createEntityFromJson(const nlohmann::json& json, const std::string& templateName, const std::string& instanceName, const Vector3& position, const Quaternion& orientation) const
+//! Creates only the planet's sim components, for use when vis is disabled
+static VisComponentLoader compileHeadlessPlanet(const EntityFactory::Context& context, const nlohmann::json& json)
 {
-	EntityPtr entity = std::make_shared<sim::Entity>();
+	return [json] (Entity* entity, const EntityFactory::Context& context, const VisObjectsComponentPtr& visObjectsComponent, const SimVisBindingsComponentPtr& simVisBindingComponent) {
+		const nlohmann::json& elevation = json.at("surface").at("elevation");
+		entity->addComponent(std::make_shared<Node>());
+		addPlanetSimComponents(entity, context, json.at("radius").get<double>(), readOptionalOrDefault(json, "ocean", true),
+			context.tileSourceFactory->createTileSourceFromJson(elevation), elevation.at("maxLevel"));
+	};
+}
 
-	entity->addComponent(ComponentPtr(new NameComponent(instanceName, mContext.namedObjectRegistry, entity.get())));
-	entity->addComponent(ComponentPtr(new TemplateNameComponent(templateName)));
+namespace skybolt {
 
-	SimVisBindingsComponentPtr simVisBindingComponent(new SimVisBindingsComponent);
-	entity->addComponent(simVisBindingComponent);
+//! Entity template compiled into a list of component recipes, so that creating an entity
+//! does not look up factories by name, parse vis component JSON or load models.
+struct EntityPrefab
+{
+	struct ComponentRecipe
+	{
+		ComponentFactoryPtr simFactory; //!< May be null
+		const nlohmann::json* simFactoryJson; //!< Owned by the template JSON map
+		VisComponentLoader visLoader; //!< May be null
+	};
 
-	VisObjectsComponentPtr visObjectsComponent(new VisObjectsComponent(mContext.scene));
-	entity->addComponent(visObjectsComponent);
+	std::vector<ComponentRecipe> components;
+	size_t maxPoolSize; //!< Maximum number of recycled entities kept for reuse. Pooling is disabled if zero.
+};
 
-	ComponentFactoryContext componentFactoryContext;
-	componentFactoryContext.julianDateProvider = mContext.julianDateProvider;
-	componentFactoryContext.scheduler = mContext.scheduler;
-	componentFactoryContext.simWorld = mContext.simWorld;
-	componentFactoryContext.stats = mContext.stats;
+} // namespace skybolt
+
+//! Attached to entities of pooled templates so that they can be restored to their created state when recycled
+struct PrefabInstanceComponent : public sim::Component
+{
+	std::vector<const sim::Component*> prefabComponents; //!< Components created from the prefab, excluding the NameComponent
+};
+
+static std::shared_ptr<EntityPrefab> compilePrefab(const EntityFactory::Context& context, const nlohmann::json& json)
+{
+	static std::map<std::string, VisComponentCompiler> visComponentCompilers =
+	{
+		{ "camera", compileVisualCamera },
+		{ "visualModel", compileVisualModel },
+		{ "visualMainRotor", compileVisualMainRotor },
+		{ "visualTailRotor", compileVisualTailRotor },
+		{ "planet", compilePlanet }
+	};
+
+	static std::map<std::string, VisComponentCompiler> headlessComponentCompilers =
+	{
+		{ "planet", compileHeadlessPlanet }
+	};
+
+	auto prefab = std::make_shared<EntityPrefab>();
+	prefab->maxPoolSize = std::max(0, readOptionalOrDefault<int>(json, "poolSize", 0));
 
 	const nlohmann::json& components = json.at("components");
 	for (const auto& component : components)
 	{
 		for (nlohmann::json::const_iterator componentIt = component.begin(); componentIt != component.end(); ++componentIt)
 		{
-			std::string key = componentIt.key();
+			const std::string& key = componentIt.key();
 			const nlohmann::json& content = componentIt.value();
-			
+
+			EntityPrefab::ComponentRecipe recipe;
+			recipe.simFactoryJson = &content;
+
 			// Sim components
 			{
-				auto it = mContext.componentFactoryRegistry->find(key);
-				if (it != mContext.componentFactoryRegistry->end())
+				auto it = context.componentFactoryRegistry->find(key);
+				if (it != context.componentFactoryRegistry->end())
 				{
-					ComponentFactoryPtr factory = it->second;
-					auto component = factory->create(entity.get(), componentFactoryContext, content);
-					if (component)
-					{
-						entity->addComponent(component);
-					}
+					recipe.simFactory = it->second;
 				}
 			}
 			// Vis components
 			{
-				static std::map<std::string, VisComponentLoader> visComponentLoaders =
-				{
-					{"camera", loadVisualCamera },
-					{ "visualModel", loadVisualModel },
-					{ "visualMainRotor", loadVisualMainRotor },
-					{ "visualTailRotor", loadVisualTailRotor },
-					{ "planet", loadPlanet }
-				};
-
-				auto it = visComponentLoaders.find(key);
-				if (it != visComponentLoaders.end())
+				const auto& compilers = context.scene ? visComponentCompilers : headlessComponentCompilers;
+				auto it = compilers.find(key);
+				if (it != compilers.end())
 				{
-					it->second(entity.get(), mContext, visObjectsComponent, simVisBindingComponent, content);
+					recipe.visLoader = it->second(context, content);
 				}
 			}
+
+			if (recipe.simFactory || recipe.visLoader)
+			{
+				prefab->components.push_back(recipe);
+			}
 		}
 	}
+	return prefab;
+}
 
-	Node* node = entity->getFirstComponent<Node>().get();
+static void setNodeState(Entity& entity, const Vector3& position, const Quaternion& orientation)
+{
+	Node* node = entity.getFirstComponent<Node>().get();
 	if (node)
 	{
 		node->setPosition(position);
 		node->setOrientation(orientation);
 	}
+}
+
+const EntityPrefab& EntityFactory::getPrefab(const std::string& templateName, const nlohmann::json& json) const
+{
+	auto it = mPrefabs.find(templateName);
+	if (it == mPrefabs.end())
+	{
+		it = mPrefabs.insert(std::make_pair(templateName, compilePrefab(mContext, json))).first;
+	}
+	return *it->second;
+}
+
+EntityPtr EntityFactory::createEntityFromPrefab(const EntityPrefab& prefab, const std::string& templateName, const std::string& instanceName, const Vector3& position, const Quaternion& orientation) const
+{
+	EntityPtr entity = std::make_shared<sim::Entity>();
+
+	entity->addComponent(ComponentPtr(new NameComponent(instanceName, mContext.namedObjectRegistry, entity.get())));
+	entity->addComponent(ComponentPtr(new TemplateNameComponent(templateName)));
+
+	SimVisBindingsComponentPtr simVisBindingComponent(new SimVisBindingsComponent);
+	entity->addComponent(simVisBindingComponent);
+
+	VisObjectsComponentPtr visObjectsComponent(new VisObjectsComponent(mContext.scene));
+	entity->addComponent(visObjectsComponent);
+
+	ComponentFactoryContext componentFactoryContext;
+	componentFactoryContext.julianDateProvider = mContext.julianDateProvider;
+	componentFactoryContext.scheduler = mContext.scheduler;
+	componentFactoryContext.simWorld = mContext.simWorld;
+	componentFactoryContext.stats = mContext.stats;
+
+	for (const EntityPrefab::ComponentRecipe& recipe : prefab.components)
+	{
+		if (recipe.simFactory)
+		{
+			auto component = recipe.simFactory->create(entity.get(), componentFactoryContext, *recipe.simFactoryJson);
+			if (component)
+			{
+				entity->addComponent(component);
+			}
+		}
+		if (recipe.visLoader)
+		{
+			recipe.visLoader(entity.get(), mContext, visObjectsComponent, simVisBindingComponent);
+		}
+	}
+
+	if (prefab.maxPoolSize > 0)
+	{
+		auto instanceComponent = std::make_shared<PrefabInstanceComponent>();
+		for (const ComponentPtr& component : entity->getComponents())
+		{
+			if (!dynamic_cast<const NameComponent*>(component.get()))
+			{
+				instanceComponent->prefabComponents.push_back(component.get());
+			}
+		}
+		entity->addComponent(instanceComponent);
+	}
+
+	setNodeState(*entity, position, orientation);
+	return entity;
+}
+
+EntityPtr EntityFactory::takeEntityFromPool(const std::string& templateName, const std::string& instanceName, const Vector3& position, const Quaternion& orientation) const
+{
+	auto it = mEntityPools.find(templateName);
+	if (it == mEntityPools.end() || it->second.empty())
+	{
+		return nullptr;
+	}
+
+	EntityPtr entity = std::move(it->second.back());
+	it->second.pop_back();
+
+	entity->addComponent(ComponentPtr(new NameComponent(instanceName, mContext.namedObjectRegistry, entity.get())));
+	entity->getFirstComponentRequired<VisObjectsComponent>()->setInScene(true);
 
+	setNodeState(*entity, position, orientation);
+	if (auto body = entity->getFirstComponent<DynamicBodyComponent>())
+	{
+		body->setLinearVelocity(math::dvec3Zero());
+		body->setAngularVelocity(math::dvec3Zero());
+	}
 	return entity;
 }
 
+void EntityFactory::recycleEntity(const EntityPtr& entity)
+{
+	auto instanceComponent = entity->getFirstComponent<PrefabInstanceComponent>();
+	if (!instanceComponent)
+	{
+		return; // Entity's template is not pooled
+	}
+
+	const std::string& templateName = entity->getFirstComponentRequired<TemplateNameComponent>()->name;
+	auto prefabIt = mPrefabs.find(templateName);
+	assert(prefabIt != mPrefabs.end());
+
+	std::vector<EntityPtr>& pool = mEntityPools[templateName];
+	if (pool.size() >= prefabIt->second->maxPoolSize)
+	{
+		return;
+	}
+
+	// Remove components added after creation, and the NameComponent so that the name can be reused
+	std::vector<ComponentPtr> components = entity->getComponents();
+	for (const ComponentPtr& component : components)
+	{
+		const auto& prefabComponents = instanceComponent->prefabComponents;
+		if (component != instanceComponent && std::find(prefabComponents.begin(), prefabComponents.end(), component.get()) == prefabComponents.end())
+		{
+			entity->removeComponent(component);
+		}
+	}
+
+	entity->setDynamicsEnabled(true);
+	entity->getFirstComponentRequired<VisObjectsComponent>()->setInScene(false);
+	pool.push_back(entity);
+}
+
 EntityFactory::EntityFactory(const EntityFactory::Context& context, const std::vector<std::filesystem::path>& entityFilenames) :
 	mContext(context)
 {
 	assert(context.julianDateProvider);
 	assert(context.namedObjectRegistry);
-	assert(context.programs);
 	assert(context.simWorld);
 	assert(context.stats);
 	assert(context.tileSourceFactory);
-	assert(context.scene);
-	mBuiltinTemplates = {
-		{"SunBillboard", [this] {return createSun(); }},
-		{"MoonBillboard", [this] {return createMoon(); }},
-		{"Stars", [this] {return createStars(); }},
-		{"Polyline", [this] {return createPolyline(); }}
-	};
+	assert(!context.scene || context.programs);
+	if (context.scene)
+	{
+		mBuiltinTemplates = {
+			{"SunBillboard", [this] {return createSun(); }},
+			{"MoonBillboard", [this] {return createMoon(); }},
+			{"Stars", [this] {return createStars(); }},
+			{"Polyline", [this] {return createPolyline(); }}
+		};
+	}
+	else
+	{
+		// Builtin templates are purely visual, so are created as empty nodes when vis is disabled
+		auto createNode = [] {
+			EntityPtr object(new Entity());
+			object->addComponent(std::make_shared<Node>());
+			return object;
+		};
+		mBuiltinTemplates = {
+			{"SunBillboard", createNode},
+			{"MoonBillboard", createNode},
+			{"Stars", createNode},
+			{"Polyline", createNode}
+		};
+	}
 
 	for (const std::filesystem::path& filename : entityFilenames)
 	{
@@ -514,7 +768,11 @@ EntityPtr EntityFactory::createEntity(const std::string& templateName, const std
 			std::string name = nameIn.empty() ? createUniqueObjectName(templateName) : nameIn;
 			try
 			{
-				return createEntityFromJson(i->second, templateName, name, position, orientation);
+				if (EntityPtr entity = takeEntityFromPool(templateName, name, position, orientation))
+				{
+					return entity;
+				}
+				return createEntityFromPrefab(getPrefab(templateName, i->second), templateName, name, position, orientation);
 			}
 			catch (const std::exception& e)
 			{
@@ -535,6 +793,47 @@ EntityPtr EntityFactory::createEntity(const std::string& templateName, const std
 	throw std::runtime_error("Invalid templateName: " + templateName);
 }
 
+void EntityFactory::prefetchModels(const std::vector<std::string>& templateNames) const
+{
+	if (!mContext.modelFactory)
+	{
+		return; // Vis is disabled
+	}
+
+	std::vector<std::string> filenames;
+	for (const std::string& templateName : templateNames)
+	{
+		auto i = mTemplateJsonMap.find(templateName);
+		if (i == mTemplateJsonMap.end())
+		{
+			continue;
+		}
+
+		auto components = i->second.find("components");
+		if (components == i->second.end())
+		{
+			continue;
+		}
+
+		for (const auto& component : components.value())
+		{
+			for (auto componentIt = component.begin(); componentIt != component.end(); ++componentIt)
+			{
+				if (isModelComponent(componentIt.key()))
+				{
+					auto model = componentIt.value().find("model");
+					if (model != componentIt.value().end())
+					{
+						filenames.push_back(model.value().get<std::string>());
+					}
+				}
+			}
+		}
+	}
+
+	mContext.modelFactory->prefetch(filenames);
+}
+
 const float sunDistance = 10000;
 const float moonDistance = sunDistance;
 const float sunDiameter = 2.0f * tan(skybolt::math::degToRadF() * 0.53f * 0.5f) * sunDistance;
@@ -667,14 +966,6 @@ EntityPtr EntityFactory::createPolyline() const
 
 std::string EntityFactory::createUniqueObjectName(const std::string& baseName) const
 {
-	for (int i = 1; i < INT_MAX; ++i)
-	{
-		std::string name = baseName + std::to_string(i);
-		if (mContext.namedObjectRegistry->getObjectByName(name) == nullptr)
-		{
-			return name;
-		}
-	}
-	throw skybolt::Exception("Could not create unique object name from base name: " + baseName);
+	return mContext.namedObjectRegistry->createUniqueName(baseName);
 }
 
@@ -22,21 +22,24 @@
 
 namespace skybolt {
 
+struct EntityPrefab;
+
 class EntityFactory
 {
 public:
 	struct Context
 	{
 		px_sched::Scheduler* scheduler;
+		int schedulerThreadCount = 1; //!< Number of threads the scheduler runs tasks on
 		sim::World* simWorld;
-		vis::Scene* scene;
+		vis::Scene* scene; //!< If null, vis is disabled and entities are created without visual components
 		vis::VisFactoryRegistryPtr visFactoryRegistry;
-		const vis::ShaderPrograms* programs;
+		const vis::ShaderPrograms* programs; //!< May be null if vis is disabled
 		JulianDateProvider julianDateProvider;
 		sim::NamedObjectRegistryPtr namedObjectRegistry;
 		ComponentFactoryRegistryPtr componentFactoryRegistry;
 		vis::JsonTileSourceFactoryPtr tileSourceFactory;
-		vis::ModelFactoryPtr modelFactory;
+		vis::ModelFactoryPtr modelFactory; //!< May be null if vis is disabled
 		EngineStats* stats;
 		file::FileLocator fileLocator;
 		std::vector<std::string> assetPackagePaths;
@@ -44,15 +47,31 @@ public:
 
 	EntityFactory(const Context& context, const std::vector<std::filesystem::path>& entityFilenames);
 
+	//! Templates are compiled into prefabs when first used, so the first entity created from a template is the most expensive.
+	//! Entities of templates with a 'poolSize' are taken from the template's pool of recycled entities when available.
 	sim::EntityPtr createEntity(const std::string& templateName, const std::string& instanceName = "", const sim::Vector3& position = math::dvec3Zero(), const sim::Quaternion& orientation = math::dquatIdentity()) const;
 
+	//! Returns an entity, which must have been removed from the world, to its template's pool for reuse by createEntity().
+	//! Components added to the entity after creation are removed and its vis objects are removed from the scene.
+	//! Other component state is not reset, so pooling suits templates whose state is fully set by their owner, e.g. entities driven by CIGI.
+	//! Has no effect if the entity's template is not pooled or the pool is full.
+	void recycleEntity(const sim::EntityPtr& entity);
+
+	//! Starts loading the models used by the templates on background threads, e.g. while a scenario is loading.
+	//! Entities created from the templates then show their models without waiting for them to load.
+	void prefetchModels(const std::vector<std::string>& templateNames) const;
+
 	typedef std::vector<std::string> Strings;
 	Strings getTemplateNames() const {return mTemplateNames;}
 
 	std::string createUniqueObjectName(const std::string& baseName) const;
 
 private:
-	sim::EntityPtr createEntityFromJson(const nlohmann::json& json, const std::string& templateName, const std::string& instanceName, const sim::Vector3& position, const sim::Quaternion& orientation) const;
+	const EntityPrefab& getPrefab(const std::string& templateName, const nlohmann::json& json) const;
+	sim::EntityPtr createEntityFromPrefab(const EntityPrefab& prefab, const std::string& templateName, const std::string& instanceName, const sim::Vector3& position, const sim::Quaternion& orientation) const;
+
+	//! @returns nullptr if the template's pool is empty
+	sim::EntityPtr takeEntityFromPool(const std::string& templateName, const std::string& instanceName, const sim::Vector3& position, const sim::Quaternion& orientation) const;
 
 	sim::EntityPtr createSun() const;
 	sim::EntityPtr createMoon() const;
@@ -66,6 +85,10 @@ private:
 	typedef std::map<std::string, nlohmann::json> TemplateJsonMap;
 	TemplateJsonMap mTemplateJsonMap;
 
+	// Prefabs are compiled on first use, after plugins have registered their component factories
+	mutable std::map<std::string, std::shared_ptr<EntityPrefab>> mPrefabs;
+	mutable std::map<std::string, std::vector<sim::EntityPtr>> mEntityPools; //!< Recycled entities by template name
+
 	Context mContext;
 };
 
@@ -37,16 +37,10 @@ struct Sequence
 
 	boost::optional<size_t> getIndexAtTime(double time) const
 	{
-		for (size_t i = 0; i < times.size(); ++i)
+		auto it = std::lower_bound(times.begin(), times.end(), time);
+		if (it != times.end() && *it == time)
 		{
-			if (times[i] == time)
-			{
-				return i;
-			}
-			else if (times[i] > time)
-			{
-				break;
-			}
+			return size_t(it - times.begin());
 		}
 		return boost::none;
 	}
@@ -73,15 +67,9 @@ struct StateSequenceT : public Sequence
 
 	void addItemAtTime(const SequenceState& value, double time) override
 	{
-		for (size_t i = 0; i < times.size(); ++i)
-		{
-			if (time < times[i])
-			{
-				addItemAtIndex(value, time, i);
-				return;
-			}
-		}
-		addItemAtIndex(value, time, times.size());
+		// Insert after any existing items at the same time
+		auto it = std::upper_bound(times.begin(), times.end(), time);
+		addItemAtIndex(value, time, size_t(it - times.begin()));
 	}
 
 	void removeItemAtIndex(size_t index) override
@@ -138,7 +126,7 @@ public:
 
 	SequenceStatePtr getStateAtTime(double t) const override
 	{
-		boost::optional<math::InterpolationPoint> point = math::findInterpolationPoint(mSequence->times, t, /* extrapolate */ false);
+		boost::optional<math::InterpolationPoint> point = math::findInterpolationPoint(mSequence->times, t, /* extrapolate */ false, mCursor);
 		if (point)
 		{
 			return getStateAtInterpolationPoint(*point);
@@ -167,6 +155,9 @@ protected:
 
 protected:
 	std::shared_ptr<StateSequenceT<T>> mSequence;
+
+private:
+	mutable math::InterpolationCursor mCursor; //!< Accelerates lookups during playback, where t changes gradually
 };
 
 } // namespace skybolt
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "SimVisBinding/GeocentricToNedConverter.h"
 #include "SimVisBinding/SimVisBinding.h"
 #include <SkyboltSim/Components/CameraComponent.h>
+#include <SkyboltSim/Components/DynamicBodyComponent.h>
 #include <SkyboltSim/Components/Node.h>
 #include <SkyboltSim/Entity.h>
 #include <SkyboltSim/World.h>
@@ -32,6 +33,20 @@ SimVisSystem::~SimVisSystem()
 {
 }
 
+void SimVisSystem::setInterpolationEnabled(bool enabled)
+{
+	mInterpolationEnabled = enabled;
+	mPreviousStates.clear();
+}
+
+void SimVisSystem::updatePreDynamicsSubstep(double dtSubstep)
+{
+	if (mInterpolationEnabled)
+	{
+		storePreviousStates();
+	}
+}
+
 void SimVisSystem::updatePostDynamics(const System::StepArgs& args)
 {
 	// Calculate camera movement since last frame and apply offset to scene noise
@@ -41,7 +56,60 @@ void SimVisSystem::updatePostDynamics(const System::StepArgs& args)
 	mScene->translateNoiseOrigin(-cameraNedMovement);
 	mCoordinateConverter->setOrigin(cameraPosition);
 
+	if (mInterpolationEnabled)
+	{
+		syncVisInterpolated(args.interpolationAlpha);
+	}
+	else
+	{
+		syncVis(*mWorld, *mCoordinateConverter);
+	}
+}
+
+void SimVisSystem::storePreviousStates()
+{
+	mPreviousStates.clear();
+	for (const EntityPtr& entity : mWorld->getEntities())
+	{
+		if (entity->isDynamicsEnabled() && entity->getFirstComponent<DynamicBodyComponent>())
+		{
+			if (const Node* node = entity->getFirstComponent<Node>().get(); node)
+			{
+				mPreviousStates[entity.get()] = { entity, node->getPosition(), node->getOrientation() };
+			}
+		}
+	}
+}
+
+void SimVisSystem::syncVisInterpolated(double alpha)
+{
+	// Temporarily move nodes to their interpolated state while the visuals are synchronized,
+	// and then restore the simulated state so that the simulation is unaffected.
+	mSimulatedStates.clear();
+	for (const EntityPtr& entity : mWorld->getEntities())
+	{
+		auto i = mPreviousStates.find(entity.get());
+		if (i == mPreviousStates.end() || i->second.entity.expired())
+		{
+			continue;
+		}
+
+		if (Node* node = entity->getFirstComponent<Node>().get(); node)
+		{
+			const PreviousState& previous = i->second;
+			mSimulatedStates.push_back({ node, node->getPosition(), node->getOrientation() });
+			node->setPosition(glm::mix(previous.position, node->getPosition(), alpha));
+			node->setOrientation(glm::slerp(previous.orientation, node->getOrientation(), alpha));
+		}
+	}
+
 	syncVis(*mWorld, *mCoordinateConverter);
+
+	for (const SimulatedState& state : mSimulatedStates)
+	{
+		state.node->setPosition(state.position);
+		state.node->setOrientation(state.orientation);
+	}
 }
 
 SimVisSystem::SceneOriginProvider SimVisSystem::sceneOriginFromPosition(const sim::Vector3& position)
@@ -13,6 +13,8 @@
 #include <SkyboltVis/SkyboltVisFwd.h>
 
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 namespace skybolt {
 
@@ -25,8 +27,14 @@ public:
 	SimVisSystem(const sim::World* world, const vis::ScenePtr& scene);
 	~SimVisSystem();
 
+	void updatePreDynamicsSubstep(double dtSubstep) override;
 	void updatePostDynamics(const System::StepArgs& args) override;
 
+	//! If enabled, entities with a DynamicBodyComponent are visualized in a state interpolated between
+	//! the two most recent dynamics substeps, according to System::StepArgs::interpolationAlpha.
+	//! This avoids stair-stepped motion when the dynamics step rate differs from the frame rate.
+	void setInterpolationEnabled(bool enabled);
+
 	const GeocentricToNedConverter& getCoordinateConverter() const { return *mCoordinateConverter; }
 
 	void setSceneOriginProvider(SceneOriginProvider sceneOriginProvider) { mSceneOriginProvider = std::move(sceneOriginProvider); }
@@ -35,11 +43,33 @@ public:
 	static SceneOriginProvider sceneOriginFromEntity(const sim::EntityPtr& entity);
 	static SceneOriginProvider sceneOriginFromFirstCamera(const sim::World* world);
 
+private:
+	void storePreviousStates();
+	void syncVisInterpolated(double alpha);
+
 private:
 	const sim::World* mWorld;
 	vis::ScenePtr mScene;
 	SceneOriginProvider mSceneOriginProvider;
 	std::unique_ptr<GeocentricToNedConverter> mCoordinateConverter;
+
+	struct PreviousState
+	{
+		std::weak_ptr<sim::Entity> entity; //!< Used to detect if the entity was destroyed
+		sim::Vector3 position;
+		sim::Quaternion orientation;
+	};
+
+	bool mInterpolationEnabled = false;
+	std::unordered_map<const sim::Entity*, PreviousState> mPreviousStates;
+
+	struct SimulatedState
+	{
+		sim::Node* node;
+		sim::Vector3 position;
+		sim::Quaternion orientation;
+	};
+	std::vector<SimulatedState> mSimulatedStates; //!< Reused between updates to avoid reallocation
 };
 
 } // namespace skybolt
\ No newline at end of file
@@ -0,0 +1,150 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "HeadlessRunner.h"
+#include <SkyboltEngine/EngineRoot.h>
+#include <SkyboltEngine/TimeSource.h>
+#include <SkyboltSim/System/SimStepper.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <px_sched/px_sched.h>
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace skybolt {
+
+using namespace sim;
+
+static double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+HeadlessRunStats runHeadless(SimStepper& stepper, TimeSource& timeSource, const HeadlessRunConfig& config, const UpdateLoop::ShouldExit& shouldExit)
+{
+	if (config.dt <= 0)
+	{
+		throw Exception("Headless run time step must be positive");
+	}
+
+	// Extend the time range if necessary so that the time source does not stop before the run ends
+	const TimeRange& range = timeSource.getRange();
+	timeSource.setRange(TimeRange(range.start, std::max(range.end, timeSource.getTime() + config.duration)));
+	timeSource.setState(TimeSource::StatePlaying);
+
+	System::StepArgs args;
+	args.dtSim = config.dt;
+	args.dtWallClock = config.dt;
+
+	HeadlessRunStats stats;
+	auto start = std::chrono::steady_clock::now();
+
+	// Stop within half a step of the duration, so that accumulated rounding error does not add an extra step
+	while (stats.simDuration < config.duration - config.dt * 0.5)
+	{
+		if (shouldExit && shouldExit())
+		{
+			break;
+		}
+
+		timeSource.update(config.dt);
+		stepper.step(args);
+
+		stats.simDuration += config.dt;
+		++stats.stepCount;
+	}
+
+	stats.wallDuration = secondsSince(start);
+	return stats;
+}
+
+HeadlessRunStats runHeadless(EngineRoot& engineRoot, const HeadlessRunConfig& config, const UpdateLoop::ShouldExit& shouldExit)
+{
+	SimStepper stepper(engineRoot.systemRegistry, engineRoot.simStepperConfig);
+	return runHeadless(stepper, engineRoot.scenario.timeSource, config, shouldExit);
+}
+
+double BatchRunStats::getSimDuration() const
+{
+	double duration = 0;
+	for (const BatchRunResult& run : runs)
+	{
+		duration += run.stats.simDuration;
+	}
+	return duration;
+}
+
+int BatchRunStats::getFailedRunCount() const
+{
+	return int(std::count_if(runs.begin(), runs.end(), [] (const BatchRunResult& run) { return !run.error.empty(); }));
+}
+
+static BatchRunResult executeRun(const BatchRunFunction& runFunction, const BatchRun& run)
+{
+	BatchRunResult result;
+	result.seed = run.seed;
+	try
+	{
+		result.stats = runFunction(run);
+	}
+	catch (const std::exception& e)
+	{
+		result.error = e.what();
+		BOOST_LOG_TRIVIAL(error) << "Run " << run.index << " with seed " << run.seed << " failed: " << e.what();
+	}
+	return result;
+}
+
+BatchRunStats runBatch(const BatchRunConfig& config, const BatchRunFunction& runFunction)
+{
+	BatchRunStats stats;
+	stats.runs.resize(std::max(0, config.runCount));
+	if (stats.runs.empty())
+	{
+		return stats;
+	}
+
+	int threadCount = config.threadCount > 0 ? config.threadCount : std::max(1, int(std::thread::hardware_concurrency()));
+	threadCount = std::min(threadCount, config.runCount);
+
+	px_sched::SchedulerParams schedulerParams;
+	schedulerParams.max_running_threads = threadCount;
+	schedulerParams.num_threads = threadCount;
+	px_sched::Scheduler scheduler;
+	scheduler.init(schedulerParams);
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Each worker takes the next run when it finishes its previous one, so that long runs do not hold up the batch
+	std::atomic<int> nextRunIndex = 0;
+	px_sched::Sync sync;
+	for (int i = 0; i < threadCount; ++i)
+	{
+		scheduler.run([&] {
+			for (int index = nextRunIndex++; index < config.runCount; index = nextRunIndex++)
+			{
+				BatchRun run;
+				run.index = index;
+				run.seed = config.baseSeed + std::uint32_t(index);
+				stats.runs[index] = executeRun(runFunction, run);
+			}
+		}, &sync);
+	}
+	scheduler.waitFor(sync);
+
+	stats.wallDuration = secondsSince(start);
+
+	BOOST_LOG_TRIVIAL(info) << "Completed " << config.runCount << " runs (" << stats.getFailedRunCount() << " failed) on "
+		<< threadCount << " threads in " << stats.wallDuration << "s. Throughput: " << stats.getThroughput() << " sim seconds per wall second.";
+
+	return stats;
+}
+
+} // namespace skybolt
@@ -0,0 +1,87 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "UpdateLoop.h"
+#include <SkyboltEngine/SkyboltEngineFwd.h>
+#include <SkyboltSim/SkyboltSimFwd.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace skybolt {
+
+struct HeadlessRunConfig
+{
+	double dt = 1.0 / 60.0; //!< Fixed simulation time step, in seconds
+	double duration = 60.0; //!< Simulation time to run for, in seconds
+};
+
+struct HeadlessRunStats
+{
+	double simDuration = 0; //!< Simulation time elapsed, in seconds
+	double wallDuration = 0; //!< Wall clock time elapsed, in seconds
+	std::uint64_t stepCount = 0;
+
+	//! @returns simulation seconds per wall clock second
+	double getThroughput() const { return wallDuration > 0 ? simDuration / wallDuration : 0; }
+};
+
+//! Steps the simulation with a fixed time step as fast as possible, without rendering or waiting for wall clock time.
+//! The time source is played and advanced with the simulation, so that the scenario date follows simulation time.
+//! @param shouldExit is checked before each step, and may be null
+//! @throws skybolt::Exception if the time step is not positive
+HeadlessRunStats runHeadless(sim::SimStepper& stepper, TimeSource& timeSource, const HeadlessRunConfig& config, const UpdateLoop::ShouldExit& shouldExit = nullptr);
+
+//! Runs the engine's systems headlessly. The engine should be created with EngineRootConfig::enableVis set to false.
+HeadlessRunStats runHeadless(EngineRoot& engineRoot, const HeadlessRunConfig& config, const UpdateLoop::ShouldExit& shouldExit = nullptr);
+
+struct BatchRunConfig
+{
+	int runCount = 1;
+	int threadCount = 0; //!< Maximum number of runs executed in parallel. If 0, the number of CPU cores is used.
+	std::uint32_t baseSeed = 0; //!< Run i is given seed baseSeed + i, so that any run can be reproduced on its own
+};
+
+struct BatchRun
+{
+	int index;
+	std::uint32_t seed;
+};
+
+struct BatchRunResult
+{
+	std::uint32_t seed = 0;
+	HeadlessRunStats stats;
+	std::string error; //!< Empty if the run succeeded
+};
+
+struct BatchRunStats
+{
+	std::vector<BatchRunResult> runs; //!< In run index order
+	double wallDuration = 0; //!< Wall clock time taken by the whole batch, in seconds
+
+	//! @returns total simulation time of all runs, in seconds
+	double getSimDuration() const;
+
+	//! @returns total simulation seconds of all runs per wall clock second
+	double getThroughput() const { return wallDuration > 0 ? getSimDuration() / wallDuration : 0; }
+
+	int getFailedRunCount() const;
+};
+
+//! Performs one independent run, e.g. by creating a headless EngineRoot, populating its world using the run's seed and calling runHeadless().
+//! Runs execute concurrently, so the function must not share mutable state between runs without synchronization.
+typedef std::function<HeadlessRunStats(const BatchRun& run)> BatchRunFunction;
+
+//! Executes runs in parallel on a thread pool and logs the batch throughput.
+//! Exceptions thrown by a run are recorded in its result and do not stop the other runs.
+BatchRunStats runBatch(const BatchRunConfig& config, const BatchRunFunction& runFunction);
+
+} // namespace skybolt
@@ -16,7 +16,7 @@ using namespace sim;
 void runMainLoop(vis::Window& window, EngineRoot& engineRoot, UpdateLoop::ShouldExit shouldExit, SimPausedPredicate paused)
 {
 	// Run main loop
-	auto simStepper = std::make_shared<SimStepper>(engineRoot.systemRegistry);
+	auto simStepper = std::make_shared<SimStepper>(engineRoot.systemRegistry, engineRoot.simStepperConfig);
 
 	double prevElapsedTime = 0;
 	double minFrameDuration = 0.01;
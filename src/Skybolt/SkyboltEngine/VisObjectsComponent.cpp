@@ -21,9 +21,34 @@ void VisObjectsComponent::addObject(const vis::VisObjectPtr& object, bool addToS
 {
 	if (addToScene)
 	{
-		scene->addObject(object.get());
+		sceneObjects.push_back(object.get());
+		if (inScene)
+		{
+			scene->addObject(object.get());
+		}
 	}
 	objects.push_back(object);
 }
 
+void VisObjectsComponent::setInScene(bool newInScene)
+{
+	if (inScene == newInScene)
+	{
+		return;
+	}
+	inScene = newInScene;
+
+	for (vis::VisObject* object : sceneObjects)
+	{
+		if (inScene)
+		{
+			scene->addObject(object);
+		}
+		else
+		{
+			scene->removeObject(object);
+		}
+	}
+}
+
 } // namespace skybolt
\ No newline at end of file
@@ -22,11 +22,16 @@ public:
 
 	void addObject(const vis::VisObjectPtr& object, bool addToScene = true);
 
+	//! Removes objects from the scene, or adds them back. Only affects objects added with addToScene = true.
+	void setInScene(bool inScene);
+
 	const std::vector<vis::VisObjectPtr>& getObjects() const { return objects; }
 
 private:
 	std::vector<vis::VisObjectPtr> objects;
+	std::vector<vis::VisObject*> sceneObjects; //!< Objects which are in the scene while inScene is true
 	vis::Scene* scene;
+	bool inScene = true;
 };
 
 template <class T>
@@ -30,6 +30,7 @@ public:
 
 	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override;
 	void updatePostDynamics() override;
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamics, UpdatePhase::PostDynamics }; }
 
 	void setDynamicsEnabled(bool enabled) override;
 
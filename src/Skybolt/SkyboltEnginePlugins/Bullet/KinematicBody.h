@@ -26,6 +26,7 @@ public:
 	~KinematicBody();
 
 	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override;
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamics }; }
 
 private:
 	BulletWorld* mWorld;
@@ -11,6 +11,8 @@
 #include <cigicl/CigiEntityPositionCtrlV4.h>
 #include <cigicl/CigiIGSession.h>
 #include <cigicl/CigiIncomingMsg.h>
+#include <cigicl/CigiRateCtrlV3_2.h>
+#include <cigicl/CigiRateCtrlV4.h>
 #include <cigicl/CigiSOFV3.h>
 #include <cigicl/CigiViewCtrlV3.h>
 #include <cigicl/CigiViewCtrlV4.h>
@@ -23,6 +25,7 @@
 #include <SkyboltCommon/Math/MathUtility.h>
 
 #include <boost/log/trivial.hpp>
+#include <assert.h>
 
 namespace skybolt {
 
@@ -41,10 +44,105 @@ public:
 	ProcessPacketFunction function;
 };
 
+static void decodePacket(const CigiEntityCtrlV4& packet, CigiPacketRecord& record)
+{
+	record.entityCtrl.entityId = packet.GetEntityID();
+	record.entityCtrl.entityType = packet.GetEntityType();
+	record.entityCtrl.entityState = packet.GetEntityState();
+}
+
+static void decodePacket(const CigiEntityCtrlV3_3& packet, CigiPacketRecord& record)
+{
+	CigiEntityCtrlRecord& ctrl = record.entityCtrlV3.ctrl;
+	ctrl.entityId = packet.GetEntityID();
+	ctrl.entityType = packet.GetEntityType();
+	ctrl.entityState = packet.GetEntityState();
+
+	CigiEntityPositionRecord& position = record.entityCtrlV3.position;
+	position.entityId = packet.GetEntityID();
+	position.lat = packet.GetLat();
+	position.lon = packet.GetLon();
+	position.alt = packet.GetAlt();
+	position.roll = packet.GetRoll();
+	position.pitch = packet.GetPitch();
+	position.yaw = packet.GetYaw();
+}
+
+static void decodePacket(const CigiEntityPositionCtrlV4& packet, CigiPacketRecord& record)
+{
+	CigiEntityPositionRecord& position = record.entityPosition;
+	position.entityId = packet.GetEntityID();
+	position.lat = packet.GetLat();
+	position.lon = packet.GetLon();
+	position.alt = packet.GetAlt();
+	position.roll = packet.GetRoll();
+	position.pitch = packet.GetPitch();
+	position.yaw = packet.GetYaw();
+}
+
+static void decodeRateCtrl(const CigiBaseRateCtrl& packet, CigiPacketRecord& record)
+{
+	CigiRateCtrlRecord& rates = record.rateCtrl;
+	rates.entityId = packet.GetEntityID();
+	rates.applyToArticulatedPart = packet.GetArtPartEn();
+	rates.coordinateSystem = packet.GetCoordSys();
+	rates.xRate = packet.GetXRate();
+	rates.yRate = packet.GetYRate();
+	rates.zRate = packet.GetZRate();
+	rates.rollRate = packet.GetRollRate();
+	rates.pitchRate = packet.GetPitchRate();
+	rates.yawRate = packet.GetYawRate();
+}
+
+static void decodePacket(const CigiRateCtrlV3_2& packet, CigiPacketRecord& record)
+{
+	decodeRateCtrl(packet, record);
+}
+
+static void decodePacket(const CigiRateCtrlV4& packet, CigiPacketRecord& record)
+{
+	decodeRateCtrl(packet, record);
+}
+
+static void decodePacket(const CigiViewCtrlV4& packet, CigiPacketRecord& record)
+{
+	record.viewCtrl.viewId = packet.GetViewID();
+	record.viewCtrl.entityId = packet.GetEntityID();
+}
+
+static void decodePacket(const CigiViewDefV4& packet, CigiPacketRecord& record)
+{
+	record.viewDef.viewId = packet.GetViewID();
+	record.viewDef.fovLeft = packet.GetFOVLeft();
+	record.viewDef.fovRight = packet.GetFOVRight();
+	record.viewDef.fovTop = packet.GetFOVTop();
+	record.viewDef.fovBottom = packet.GetFOVBottom();
+}
+
+template <typename T>
+void CigiClient::registerPacket(int packetId, PacketHandler handler)
+{
+	assert(packetId >= 0 && packetId < mMaxPacketId);
+	mPacketHandlers[packetId] = handler;
+
+	registerEventProcessor(packetId, [this, packetId](const CigiBasePacket& packet) {
+		CigiPacketRecord record;
+		record.packetId = packetId;
+		decodePacket(static_cast<const T&>(packet), record);
+		pushPacket(record);
+	});
+}
+
 CigiClient::CigiClient(const CigiClientConfig& config) :
 	mWorld(config.world),
-	mReceiveBuffer(mMaxReceiveBufferSizeBytes)
+	mReceiveBuffers(mReceiveBatchSize),
+	mPacketQueue(mPacketQueueCapacity)
 {
+	for (UdpDatagram& datagram : mReceiveBuffers)
+	{
+		datagram.data.resize(mMaxReceiveBufferSizeBytes);
+	}
+
 	UdpCommunicatorConfig socketConfig;
 	socketConfig.localAddress = "localhost";
 	socketConfig.localPort = config.igPort;
@@ -69,17 +167,19 @@ CigiClient::CigiClient(const CigiClientConfig& config) :
 
 	if (config.cigiMajorVersion == 3)
 	{
-		registerEventProcessor<CigiEntityCtrlV3_3>(CIGI_ENTITY_CTRL_PACKET_ID_V3_3);
+		registerPacket<CigiEntityCtrlV3_3>(CIGI_ENTITY_CTRL_PACKET_ID_V3_3, &CigiClient::handleEntityCtrlV3);
+		registerPacket<CigiRateCtrlV3_2>(CIGI_RATE_CTRL_PACKET_ID_V3_2, &CigiClient::handleRateCtrl);
 		// These V3 packets are forward compatible with V4
-		registerEventProcessor<CigiViewCtrlV4>(CIGI_VIEW_CTRL_PACKET_ID_V3);
-		registerEventProcessor<CigiViewDefV4>(CIGI_VIEW_DEF_PACKET_ID_V3);
+		registerPacket<CigiViewCtrlV4>(CIGI_VIEW_CTRL_PACKET_ID_V3, &CigiClient::handleViewCtrl);
+		registerPacket<CigiViewDefV4>(CIGI_VIEW_DEF_PACKET_ID_V3, &CigiClient::handleViewDef);
 	}
 	else if (config.cigiMajorVersion == 4)
 	{
-		registerEventProcessor<CigiEntityCtrlV4>(CIGI_ENTITY_CTRL_PACKET_ID_V4);
-		registerEventProcessor<CigiEntityPositionCtrlV4>(CIGI_ENTITY_POSITION_CTRL_PACKET_ID_V4);
-		registerEventProcessor<CigiViewCtrlV4>(CIGI_VIEW_CTRL_PACKET_ID_V4);
-		registerEventProcessor<CigiViewDefV4>(CIGI_VIEW_DEF_PACKET_ID_V4);
+		registerPacket<CigiEntityCtrlV4>(CIGI_ENTITY_CTRL_PACKET_ID_V4, &CigiClient::handleEntityCtrl);
+		registerPacket<CigiEntityPositionCtrlV4>(CIGI_ENTITY_POSITION_CTRL_PACKET_ID_V4, &CigiClient::handleEntityPosition);
+		registerPacket<CigiRateCtrlV4>(CIGI_RATE_CTRL_PACKET_ID_V4, &CigiClient::handleRateCtrl);
+		registerPacket<CigiViewCtrlV4>(CIGI_VIEW_CTRL_PACKET_ID_V4, &CigiClient::handleViewCtrl);
+		registerPacket<CigiViewDefV4>(CIGI_VIEW_DEF_PACKET_ID_V4, &CigiClient::handleViewDef);
 	}
 	else
 	{
@@ -143,63 +243,31 @@ void CigiClient::sendFrame()
 	++mFrameCounter;
 }
 
-template <class BaseT>
-class TypeDelegator
+void CigiClient::processEntityCtrl(const CigiEntityCtrlRecord& packet)
 {
-public:
-	static TypeDelegator<BaseT> of(const BaseT* base)
-	{
-		return TypeDelegator<BaseT>(base);
-	}
-
-	TypeDelegator(const BaseT* base) : mBase(base) {}
-
-	template <class DerivedT>
-	TypeDelegator<BaseT>& with(const std::function<void(const DerivedT&)>& fn)
-	{
-		if (!mEvaluated)
-		{
-			auto derived = dynamic_cast<const DerivedT*>(mBase);
-			if (derived)
-			{
-				mEvaluated = true;
-				fn(*derived);
-			}
-		}
-
-		return *this;
-	}
-
-private:
-	const BaseT* mBase;
-	bool mEvaluated = false;
-};
-
-void CigiClient::processEntityCtrlV4(const CigiEntityCtrlV4& packet)
-{
-	if (packet.GetEntityState() == CigiBaseEntityCtrl::Active || packet.GetEntityState() == CigiBaseEntityCtrl::Standby)
+	if (packet.entityState == CigiBaseEntityCtrl::Active || packet.entityState == CigiBaseEntityCtrl::Standby)
 	{
 		CigiEntityPtr entity;
-		int id = packet.GetEntityID();
+		int id = packet.entityId;
 		auto it = mEntities.find(id);
 		if (it == mEntities.end())
 		{
-			int typeId = packet.GetEntityType();
-			entity = mWorld->createEntity(typeId);
-			if (entity)
+			entity = mWorld->createEntity(packet.entityType);
+			if (!entity)
 			{
-				mEntities.insert(std::make_pair(id, entity)).first;
+				return;
 			}
+			mEntities.insert(std::make_pair(id, entity));
 		}
 		else
 		{
 			entity = it->second;
 		}
-		entity->setVisible(packet.GetEntityState() == CigiBaseEntityCtrl::Active);
+		entity->setVisible(packet.entityState == CigiBaseEntityCtrl::Active);
 	}
-	else if (packet.GetEntityState() == CigiBaseEntityCtrl::Remove || packet.GetEntityState() == CigiBaseEntityCtrl::Destroyed)
+	else if (packet.entityState == CigiBaseEntityCtrl::Remove || packet.entityState == CigiBaseEntityCtrl::Destroyed)
 	{
-		auto it = mEntities.find(packet.GetEntityID());
+		auto it = mEntities.find(packet.entityId);
 		if (it != mEntities.end())
 		{
 			mWorld->destroyEntity(it->second);
@@ -208,87 +276,117 @@ void CigiClient::processEntityCtrlV4(const CigiEntityCtrlV4& packet)
 	}
 }
 
-void CigiClient::processEntityPositionCtrlV4(const CigiEntityPositionCtrlV4& packet)
+void CigiClient::processEntityPosition(const CigiEntityPositionRecord& packet)
 {
-	int id = packet.GetEntityID();
-	auto it = mEntities.find(id);
+	auto it = mEntities.find(packet.entityId);
 	if (it != mEntities.end())
 	{
-		CigiEntityPtr entity = it->second;
-		entity->setPosition(sim::LatLonAlt(packet.GetLat() * math::degToRadD(), packet.GetLon() * math::degToRadD(), packet.GetAlt()));
-		entity->setOrientation(sim::Vector3(packet.GetRoll() * math::degToRadD(), packet.GetPitch() * math::degToRadD(), packet.GetYaw() * math::degToRadD()));
+		const CigiEntityPtr& entity = it->second;
+		entity->setPosition(sim::LatLonAlt(packet.lat * math::degToRadD(), packet.lon * math::degToRadD(), packet.alt));
+		entity->setOrientation(sim::Vector3(packet.roll * math::degToRadD(), packet.pitch * math::degToRadD(), packet.yaw * math::degToRadD()));
 	}
 }
 
+void CigiClient::handleEntityCtrl(const CigiPacketRecord& record)
+{
+	processEntityCtrl(record.entityCtrl);
+}
+
+void CigiClient::handleEntityCtrlV3(const CigiPacketRecord& record)
+{
+	processEntityCtrl(record.entityCtrlV3.ctrl);
+	processEntityPosition(record.entityCtrlV3.position);
+}
+
+void CigiClient::handleEntityPosition(const CigiPacketRecord& record)
+{
+	processEntityPosition(record.entityPosition);
+}
+
+void CigiClient::handleRateCtrl(const CigiPacketRecord& record)
+{
+	const CigiRateCtrlRecord& packet = record.rateCtrl;
+	if (packet.applyToArticulatedPart)
+	{
+		return; // Articulated parts are not supported
+	}
+
+	auto it = mEntities.find(packet.entityId);
+	if (it != mEntities.end())
+	{
+		CigiCoordinateSystem coordinateSystem = (packet.coordinateSystem == CigiBaseRateCtrl::Local) ? CigiCoordinateSystem::Local : CigiCoordinateSystem::World;
+		it->second->setRates(
+			sim::Vector3(packet.xRate, packet.yRate, packet.zRate),
+			sim::Vector3(packet.rollRate * math::degToRadD(), packet.pitchRate * math::degToRadD(), packet.yawRate * math::degToRadD()),
+			coordinateSystem);
+	}
+}
+
+void CigiClient::handleViewCtrl(const CigiPacketRecord& record)
+{
+	auto camera = skybolt::findOptional(mCameras, record.viewCtrl.viewId);
+	if (camera)
+	{
+		auto entity = skybolt::findOptional(mEntities, record.viewCtrl.entityId);
+		if (entity)
+		{
+			(*camera)->setParent(*entity);
+		}
+		else
+		{
+			(*camera)->setParent(nullptr);
+		}
+	}
+}
+
+void CigiClient::handleViewDef(const CigiPacketRecord& record)
+{
+	const CigiViewDefRecord& packet = record.viewDef;
+	std::shared_ptr<CigiCamera> camera;
+	auto optionalCamera = skybolt::findOptional(mCameras, packet.viewId);
+	if (optionalCamera)
+	{
+		camera = *optionalCamera;
+	}
+	else
+	{
+		camera = mWorld->createCamera();
+		mCameras[packet.viewId] = camera;
+	}
+	camera->setHorizontalFieldOfView((packet.fovLeft + packet.fovRight) * math::degToRadD());
+	camera->setVerticalFieldOfView((packet.fovTop + packet.fovBottom) * math::degToRadD());
+}
+
 void CigiClient::update()
 {
 #ifndef MULTI_THREADED_CIGI_RECEIVER
 	processIncomingMessages();
 #endif
-	std::vector<CigiBasePacketPtr> packetQueue;
+	dispatchQueuedPackets();
+}
+
+void CigiClient::pushPacket(const CigiPacketRecord& record)
+{
+	while (!mPacketQueue.tryPush(record))
 	{
-		std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-		std::swap(packetQueue, mPacketQueue);
+#ifdef MULTI_THREADED_CIGI_RECEIVER
+		// Wait for the main thread to make room
+		std::this_thread::yield();
+#else
+		// The queue is consumed on this thread, so make room by dispatching queued packets now
+		dispatchQueuedPackets();
+#endif
 	}
+}
 
-	for (const auto& basePacket : packetQueue)
+void CigiClient::dispatchQueuedPackets()
+{
+	CigiPacketRecord record;
+	while (mPacketQueue.tryPop(record))
 	{
-		TypeDelegator<CigiBasePacket>::of(basePacket.get())
-		.with<CigiEntityCtrlV3_3>([this] (const auto& packet) {
-			CigiEntityCtrlV4 ctrlPacket;
-			ctrlPacket.SetEntityID(packet.GetEntityID());
-			ctrlPacket.SetEntityState(packet.GetEntityState());
-			ctrlPacket.SetEntityType(packet.GetEntityType());
-			processEntityCtrlV4(ctrlPacket);
-
-			constexpr bool boundsCheck = false;
-			CigiEntityPositionCtrlV4 positionPacket;
-			positionPacket.SetEntityID(packet.GetEntityID());
-			positionPacket.SetLat(packet.GetLat(), boundsCheck);
-			positionPacket.SetLon(packet.GetLon(), boundsCheck);
-			positionPacket.SetAlt(packet.GetAlt(), boundsCheck);
-			positionPacket.SetYaw(packet.GetYaw(), boundsCheck);
-			positionPacket.SetPitch(packet.GetPitch(), boundsCheck);
-			positionPacket.SetRoll(packet.GetRoll(), boundsCheck);
-			processEntityPositionCtrlV4(positionPacket);
-		})
-		.with<CigiEntityCtrlV4>([this](const auto& packet) {
-			processEntityCtrlV4(packet);
-		})
-		.with<CigiEntityPositionCtrlV4>([this](const auto& packet) {
-			processEntityPositionCtrlV4(packet);
-		})
-		.with<CigiViewCtrlV4>([this](const auto& packet) {
-			auto camera = skybolt::findOptional(mCameras, (int)packet.GetViewID());
-			if (camera)
-			{
-				auto entity = skybolt::findOptional(mEntities, (int)packet.GetEntityID());
-				if (entity)
-				{
-					(*camera)->setParent(*entity);
-				}
-				else
-				{
-					(*camera)->setParent(nullptr);
-				}
-			}
-		})
-		.with<CigiViewDefV4>([this](const auto& packet) {
-			int id = packet.GetViewID();
-			std::shared_ptr<CigiCamera> camera;
-			auto optionalCamera = skybolt::findOptional(mCameras, id);
-			if (optionalCamera)
-			{
-				camera = *optionalCamera;
-			}
-			else
-			{
-				camera = mWorld->createCamera();
-				mCameras[id] = camera;
-			}
-			camera->setHorizontalFieldOfView((packet.GetFOVLeft() + packet.GetFOVRight()) * math::degToRadD());
-			camera->setVerticalFieldOfView((packet.GetFOVTop() + packet.GetFOVBottom()) * math::degToRadD());
-		});
+		PacketHandler handler = mPacketHandlers[record.packetId];
+		assert(handler);
+		(this->*handler)(record);
 	}
 }
 
@@ -307,18 +405,39 @@ void CigiClient::resetWorld()
 
 void CigiClient::processIncomingMessages()
 {
-	try
+	CigiIncomingMsg &incomingMessage = mIncomingSession->GetIncomingMsgMgr();
+
+	// Drain all pending datagrams so that latency does not grow when the host sends more than one datagram per frame
+	for (int batch = 0; batch < mMaxReceiveBatchesPerUpdate; ++batch)
 	{
-		size_t numBytesRead = mSocket->receive(*mReceiveBuffer.data(), mMaxReceiveBufferSizeBytes);
-		if (numBytesRead > 0)
+		size_t datagramCount = 0;
+		try
 		{
-			CigiIncomingMsg &incomingMessage = mIncomingSession->GetIncomingMsgMgr();
-			incomingMessage.ProcessIncomingMsg(mReceiveBuffer.data(), (int)numBytesRead);
+			datagramCount = mSocket->receiveBatch(mReceiveBuffers);
+		}
+		catch (const std::exception& e)
+		{
+			BOOST_LOG_TRIVIAL(error) << "CigiClient error: " << e.what();
+			return;
+		}
+
+		for (size_t i = 0; i < datagramCount; ++i)
+		{
+			UdpDatagram& datagram = mReceiveBuffers[i];
+			try
+			{
+				incomingMessage.ProcessIncomingMsg(datagram.data.data(), (int)datagram.sizeBytes);
+			}
+			catch (const std::exception& e)
+			{
+				BOOST_LOG_TRIVIAL(error) << "CigiClient error: " << e.what();
+			}
+		}
+
+		if (datagramCount < mReceiveBuffers.size())
+		{
+			break;
 		}
-	}
-	catch (const std::exception& e)
-	{
-		BOOST_LOG_TRIVIAL(error) << "CigiClient error: " << e.what();
 	}
 }
 
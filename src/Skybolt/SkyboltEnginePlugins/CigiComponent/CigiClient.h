@@ -8,24 +8,30 @@
 
 #include <SkyboltSim/Spatial/LatLonAlt.h>
 #include <SkyboltSim/SimMath.h>
+#include <SkyboltCommon/SpscRingBuffer.h>
 
 #include "UdpCommunicator.h"
 
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
-#include <mutex>
 #include <string>
 #include <vector>
 #include <thread>
 
 class CigiBasePacket;
-class CigiEntityCtrlV4;
-class CigiEntityPositionCtrlV4;
 class CigiIGSession;
 
 namespace skybolt {
 
+enum class CigiCoordinateSystem
+{
+	World, //!< North-east-down frame at the entity's position
+	Local //!< Entity's body frame
+};
+
 class CigiEntity
 {
 public:
@@ -33,6 +39,11 @@ public:
 	virtual void setPosition(const sim::LatLonAlt& position) = 0;
 	virtual void setOrientation(const sim::Vector3& ypr) = 0;
 	virtual void setVisible(bool visibile) = 0;
+
+	//! Sets rates from a CIGI Rate Control packet, which remain in effect until changed.
+	//! @param linearRate is in meters per second
+	//! @param angularRate is roll, pitch and yaw rates in radians per second
+	virtual void setRates(const sim::Vector3& linearRate, const sim::Vector3& angularRate, CigiCoordinateSystem coordinateSystem) {}
 };
 
 typedef std::shared_ptr<CigiEntity> CigiEntityPtr;
@@ -74,6 +85,75 @@ struct CigiClientConfig
 
 typedef std::function<void(const CigiBasePacket& packet)> ProcessPacketFunction;
 
+struct CigiEntityCtrlRecord
+{
+	int entityId;
+	int entityType;
+	int entityState; //!< CigiBaseEntityCtrl::EntityStateGrp
+};
+
+struct CigiEntityPositionRecord
+{
+	int entityId;
+	double lat; //!< Degrees
+	double lon; //!< Degrees
+	double alt; //!< Meters
+	float roll; //!< Degrees
+	float pitch; //!< Degrees
+	float yaw; //!< Degrees
+};
+
+struct CigiRateCtrlRecord
+{
+	int entityId;
+	bool applyToArticulatedPart;
+	int coordinateSystem; //!< CigiBaseRateCtrl::CoordSysGrp
+	float xRate; //!< Meters per second
+	float yRate; //!< Meters per second
+	float zRate; //!< Meters per second
+	float rollRate; //!< Degrees per second
+	float pitchRate; //!< Degrees per second
+	float yawRate; //!< Degrees per second
+};
+
+struct CigiViewCtrlRecord
+{
+	int viewId;
+	int entityId;
+};
+
+struct CigiViewDefRecord
+{
+	int viewId;
+	float fovLeft; //!< Degrees
+	float fovRight; //!< Degrees
+	float fovTop; //!< Degrees
+	float fovBottom; //!< Degrees
+};
+
+//! Fields of a received packet, decoded on the receiving thread.
+//! Stored by value so that packets can be queued for the main thread without allocation.
+struct CigiPacketRecord
+{
+	int packetId;
+
+	struct EntityCtrlV3
+	{
+		CigiEntityCtrlRecord ctrl;
+		CigiEntityPositionRecord position;
+	};
+
+	union
+	{
+		CigiEntityCtrlRecord entityCtrl;
+		CigiEntityPositionRecord entityPosition;
+		EntityCtrlV3 entityCtrlV3; //!< V3 entity control packets also contain the position
+		CigiRateCtrlRecord rateCtrl;
+		CigiViewCtrlRecord viewCtrl;
+		CigiViewDefRecord viewDef;
+	};
+};
+
 class CigiClient
 {
 public:
@@ -87,22 +167,32 @@ public:
 private:
 	void resetWorld();
 
+	//! Receives and decodes all pending datagrams
 	void processIncomingMessages();
 
 	void registerEventProcessor(int eventId, const ProcessPacketFunction& function);
-	
+
+	typedef void (CigiClient::*PacketHandler)(const CigiPacketRecord& record);
+
+	//! Registers a packet type to be decoded on the receiving thread and handled on the main thread
 	template <typename T>
-	void registerEventProcessor(int eventId)
-	{
-		registerEventProcessor(eventId, [this](const CigiBasePacket& packet) {
-			const T* derivedPacket = static_cast<const T*>(&packet);
-			std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-			mPacketQueue.push_back(std::make_shared<T>(*derivedPacket));
-		});
-	}
+	void registerPacket(int packetId, PacketHandler handler);
 
-	void processEntityCtrlV4(const CigiEntityCtrlV4& packet);
-	void processEntityPositionCtrlV4(const CigiEntityPositionCtrlV4& packet);
+	//! Called on the receiving thread
+	void pushPacket(const CigiPacketRecord& record);
+
+	//! Called on the main thread
+	void dispatchQueuedPackets();
+
+	void handleEntityCtrl(const CigiPacketRecord& record);
+	void handleEntityCtrlV3(const CigiPacketRecord& record);
+	void handleEntityPosition(const CigiPacketRecord& record);
+	void handleRateCtrl(const CigiPacketRecord& record);
+	void handleViewCtrl(const CigiPacketRecord& record);
+	void handleViewDef(const CigiPacketRecord& record);
+
+	void processEntityCtrl(const CigiEntityCtrlRecord& packet);
+	void processEntityPosition(const CigiEntityPositionRecord& packet);
 
 private:
 	// Main thread
@@ -112,18 +202,22 @@ private:
 	std::map<int, CigiCameraPtr> mCameras;
 	std::map<int, CigiEntityPtr> mEntities;
 
+	static const int mMaxPacketId = 256;
+	std::array<PacketHandler, mMaxPacketId> mPacketHandlers = {}; //!< Indexed by CIGI packet ID
+
 	// Receiver thread
 	static const int mMaxReceiveBufferSizeBytes = 32768;
-	std::vector<unsigned char> mReceiveBuffer;
+	static const int mReceiveBatchSize = 16; //!< Max number of datagrams received per socket call
+	static const int mMaxReceiveBatchesPerUpdate = 64; //!< Limits time spent receiving if the host sends faster than we can process
+	std::vector<UdpDatagram> mReceiveBuffers;
 	std::unique_ptr<CigiIGSession> mIncomingSession;
 	std::thread mReceiverThread;
 	std::atomic_bool mTerminateReceiverThread = false;
 	std::vector<std::shared_ptr<class CigiBaseEventProcessorI>> mCigiBaseEventProcessors;
 
 	// Shared between main thread and receiver thread
-	typedef std::shared_ptr<CigiBasePacket> CigiBasePacketPtr;
-	std::vector<CigiBasePacketPtr> mPacketQueue;
-	std::mutex mPacketQueueMutex;
+	static const int mPacketQueueCapacity = 4096;
+	SpscRingBuffer<CigiPacketRecord> mPacketQueue;
 
 	std::unique_ptr<UdpCommunicator> mSocket; //!< @ThreadSafe
 };
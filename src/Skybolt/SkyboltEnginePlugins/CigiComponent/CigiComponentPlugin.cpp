@@ -5,6 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "CigiClient.h"
+#include "CigiDeadReckoning.h"
 
 #include <SkyboltEngine/EngineRoot.h>
 #include <SkyboltEngine/Plugin/Plugin.h>
@@ -22,30 +23,63 @@
 
 #include <boost/config.hpp>
 #include <boost/dll/alias.hpp>
+#include <algorithm>
 #include <assert.h>
+#include <optional>
+#include <stdexcept>
 
 namespace skybolt {
 using namespace sim;
 
+struct DeadReckoningContext
+{
+	DeadReckoningConfig config;
+	double time = 0; //!< Wall clock seconds since the CIGI component was created
+};
+
 class MyCigiEntity : public CigiEntity
 {
 public:
-	MyCigiEntity(const sim::EntityPtr& entity) : mEntity(entity)
+	MyCigiEntity(const sim::EntityPtr& entity, const DeadReckoningContext* deadReckoning) :
+		mEntity(entity),
+		mDeadReckoning(deadReckoning)
 	{
 		assert(mEntity);
+		assert(mDeadReckoning);
 	}
 
 	void setPosition(const sim::LatLonAlt& position) override
 	{
 		mPosition = position;
-		sim::setPosition(*mEntity, llaToGeocentric(position, earthRadius()));
+		sim::Vector3 geocentricPosition = llaToGeocentric(position, earthRadius());
+		if (isDeadReckoningEnabled())
+		{
+			mPositionReckoner.addSample(mDeadReckoning->time, geocentricPosition, mDeadReckoning->config);
+		}
+		else
+		{
+			sim::setPosition(*mEntity, geocentricPosition);
+		}
 	}
 
 	void setOrientation(const sim::Vector3& rpy) override
 	{
+		mRpy = rpy;
 		sim::LtpNedOrientation orientation(math::quatFromEuler(rpy));
-		sim::Quaternion orientationQuat = sim::toGeocentric(orientation, toLatLon(mPosition)).orientation;
-		sim::setOrientation(*mEntity, orientationQuat);
+		mOrientation = sim::toGeocentric(orientation, toLatLon(mPosition)).orientation;
+		if (isDeadReckoningEnabled())
+		{
+			mOrientationReckoner.addSample(mDeadReckoning->time, mOrientation, mDeadReckoning->config);
+			if (mRates)
+			{
+				// Euler angle rates map to a different angular velocity at the new attitude
+				applyRates(*mRates);
+			}
+		}
+		else
+		{
+			sim::setOrientation(*mEntity, mOrientation);
+		}
 	}
 
 	void setVisible(bool visibile) override
@@ -53,10 +87,63 @@ public:
 		// TODO
 	}
 
+	//! Rates are only applied when dead reckoning is enabled
+	void setRates(const sim::Vector3& linearRate, const sim::Vector3& angularRate, CigiCoordinateSystem coordinateSystem) override
+	{
+		mRates = Rates({linearRate, angularRate, coordinateSystem});
+		applyRates(*mRates);
+	}
+
+	//! Applies the dead reckoned state at the context's current time to the sim entity
+	void updateDeadReckoning()
+	{
+		if (mPositionReckoner.hasSamples())
+		{
+			sim::setPosition(*mEntity, mPositionReckoner.evaluate(mDeadReckoning->time, mDeadReckoning->config));
+		}
+		if (mOrientationReckoner.hasSamples())
+		{
+			sim::setOrientation(*mEntity, mOrientationReckoner.evaluate(mDeadReckoning->time, mDeadReckoning->config));
+		}
+	}
+
 	sim::EntityPtr mEntity;
 
 private:
+	bool isDeadReckoningEnabled() const { return mDeadReckoning->config.order != DeadReckoningOrder::None; }
+
+	struct Rates
+	{
+		sim::Vector3 linearRate;
+		sim::Vector3 angularRate;
+		CigiCoordinateSystem coordinateSystem;
+	};
+
+	void applyRates(const Rates& rates)
+	{
+		if (rates.coordinateSystem == CigiCoordinateSystem::Local)
+		{
+			// Linear and angular rates are about the body axes
+			mPositionReckoner.setVelocity(mOrientation * rates.linearRate);
+			mOrientationReckoner.setAngularVelocity(mOrientation * rates.angularRate);
+		}
+		else
+		{
+			// Linear rates are in the NED frame, and angular rates are rates of change of the roll, pitch and yaw angles
+			sim::Quaternion nedOrientation = sim::toGeocentric(sim::LtpNedOrientation(math::dquatIdentity()), toLatLon(mPosition)).orientation;
+			mPositionReckoner.setVelocity(nedOrientation * rates.linearRate);
+			mOrientationReckoner.setAngularVelocity(mOrientation * eulerRatesToBodyAngularVelocity(mRpy, rates.angularRate));
+		}
+	}
+
+private:
+	const DeadReckoningContext* mDeadReckoning;
 	sim::LatLonAlt mPosition = sim::LatLonAlt(0,0,0);
+	sim::Quaternion mOrientation = math::dquatIdentity(); //!< Geocentric orientation of the latest received sample
+	sim::Vector3 mRpy = sim::Vector3(0); //!< NED roll, pitch and yaw of the latest received sample
+	std::optional<Rates> mRates;
+	PositionDeadReckoner mPositionReckoner;
+	OrientationDeadReckoner mOrientationReckoner;
 };
 
 class MyCigiCamera : public CigiCamera
@@ -122,11 +209,27 @@ typedef std::map<int, std::string> TemplatesMap;
 class CigiSkyboltWorld : public CigiWorld
 {
 public:
-	CigiSkyboltWorld(EngineRoot* engineRoot, const TemplatesMap& templates, Entity* cigiGatewayEntity) :
+	CigiSkyboltWorld(EngineRoot* engineRoot, const TemplatesMap& templates, Entity* cigiGatewayEntity, const DeadReckoningConfig& deadReckoningConfig) :
 		mEngineRoot(engineRoot),
 		mTemplates(templates),
 		mCigiGatewayEntity(cigiGatewayEntity)
 	{
+		mDeadReckoning.config = deadReckoningConfig;
+	}
+
+	//! Sets the time at which subsequently received entity states are sampled
+	void advanceTime(double dt)
+	{
+		mDeadReckoning.time += dt;
+	}
+
+	//! Moves all dead reckoned entities to their extrapolated state in a single pass
+	void updateDeadReckonedEntities()
+	{
+		for (const auto& entity : mDeadReckonedEntities)
+		{
+			entity->updateDeadReckoning();
+		}
 	}
 
 	CigiEntityPtr createEntity(int typeId) override
@@ -141,15 +244,29 @@ public:
 			entity->setDynamicsEnabled(false);
 
 			mEngineRoot->simWorld->addEntity(entity);
-			return std::make_shared<MyCigiEntity>(entity);
+			auto cigiEntity = std::make_shared<MyCigiEntity>(entity, &mDeadReckoning);
+			if (mDeadReckoning.config.order != DeadReckoningOrder::None)
+			{
+				mDeadReckonedEntities.push_back(cigiEntity);
+			}
+			return cigiEntity;
 		}
 		return nullptr;
 	}
 
 	void destroyEntity(const CigiEntityPtr& cigiEntity) override
 	{
-		sim::EntityPtr simEntity = static_cast<MyCigiEntity*>(cigiEntity.get())->mEntity;
-		mEngineRoot->simWorld->removeEntity(simEntity.get());
+		auto myEntity = static_cast<MyCigiEntity*>(cigiEntity.get());
+		mEngineRoot->simWorld->removeEntity(myEntity->mEntity.get());
+		mEngineRoot->entityFactory->recycleEntity(myEntity->mEntity);
+
+		auto it = std::find_if(mDeadReckonedEntities.begin(), mDeadReckonedEntities.end(), [myEntity] (const auto& entity) {
+			return entity.get() == myEntity;
+		});
+		if (it != mDeadReckonedEntities.end())
+		{
+			mDeadReckonedEntities.erase(it);
+		}
 	}
 
 	CigiCameraPtr createCamera() override
@@ -171,6 +288,8 @@ private:
 	EngineRoot* mEngineRoot;
 	TemplatesMap mTemplates;
 	Entity* mCigiGatewayEntity;
+	DeadReckoningContext mDeadReckoning;
+	std::vector<std::shared_ptr<MyCigiEntity>> mDeadReckonedEntities;
 };
 
 typedef std::shared_ptr<CigiClient> CigiClientPtr;
@@ -179,24 +298,58 @@ typedef std::shared_ptr<CigiSkyboltWorld> CigiSkyboltWorldPtr;
 class CigiComponent : public sim::Component
 {
 public:
-	CigiComponent(const CigiClientPtr& client) :
-		mClient(client)
+	CigiComponent(const CigiClientPtr& client, const CigiSkyboltWorldPtr& world) :
+		mClient(client),
+		mWorld(world)
 	{
 		assert(mClient);
+		assert(mWorld);
 	}
 
 	void updatePreDynamics(sim::TimeReal dt, sim::TimeReal dtWallClock) override
 	{
+		// Received states are timestamped on arrival with wall clock time because the host drives the IG in real time
+		mWorld->advanceTime(dtWallClock);
 		mClient->sendFrame();
 		mClient->update();
+		mWorld->updateDeadReckonedEntities();
 	}
 
+	std::vector<sim::UpdatePhase> getUpdatePhases() const override { return { sim::UpdatePhase::PreDynamics }; }
+
 private:
 	CigiClientPtr mClient;
+	CigiSkyboltWorldPtr mWorld;
 };
 
 const std::string cigiComponentName = "cigi";
 
+static DeadReckoningOrder toDeadReckoningOrder(const std::string& order)
+{
+	if (order == "none")
+	{
+		return DeadReckoningOrder::None;
+	}
+	else if (order == "linear")
+	{
+		return DeadReckoningOrder::Linear;
+	}
+	else if (order == "quadratic")
+	{
+		return DeadReckoningOrder::Quadratic;
+	}
+	throw std::runtime_error("Unknown dead reckoning order: " + order);
+}
+
+static DeadReckoningConfig readDeadReckoningConfig(const nlohmann::json& json)
+{
+	DeadReckoningConfig config;
+	config.order = toDeadReckoningOrder(json.at("order").get<std::string>());
+	config.correctionBlendDuration = json.value("correctionBlendDuration", config.correctionBlendDuration);
+	config.maxExtrapolationDuration = json.value("maxExtrapolationDuration", config.maxExtrapolationDuration);
+	return config;
+}
+
 class CigiComponentPlugin : public Plugin
 {
 public:
@@ -225,11 +378,27 @@ public:
 				}
 			}
 
-			clientConfig.world = std::make_shared<CigiSkyboltWorld>(engineRoot, templatesMap, entity);
+			// Load models for all entity types up front, because the host may create many entities at once
+			std::vector<std::string> templateNames;
+			for (const auto& [id, templateName] : templatesMap)
+			{
+				templateNames.push_back(templateName);
+			}
+			engineRoot->entityFactory->prefetchModels(templateNames);
+
+			DeadReckoningConfig deadReckoningConfig;
+			it = json.find("deadReckoning");
+			if (it != json.end())
+			{
+				deadReckoningConfig = readDeadReckoningConfig(it.value());
+			}
+
+			auto world = std::make_shared<CigiSkyboltWorld>(engineRoot, templatesMap, entity, deadReckoningConfig);
+			clientConfig.world = world;
 
 			auto communicator = std::make_shared<CigiClient>(clientConfig);
 
-			return std::make_shared<CigiComponent>(communicator);
+			return std::make_shared<CigiComponent>(communicator, world);
 		});
 
 		mComponentFactoryRegistry->insert(std::make_pair(cigiComponentName, factory));
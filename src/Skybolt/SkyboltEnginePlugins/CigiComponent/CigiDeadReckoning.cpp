@@ -0,0 +1,177 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "CigiDeadReckoning.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+namespace skybolt {
+
+sim::Vector3 eulerRatesToBodyAngularVelocity(const sim::Vector3& rpy, const sim::Vector3& rpyRates)
+{
+	double sinRoll = std::sin(rpy.x);
+	double cosRoll = std::cos(rpy.x);
+	double sinPitch = std::sin(rpy.y);
+	double cosPitch = std::cos(rpy.y);
+
+	return sim::Vector3(
+		rpyRates.x - rpyRates.z * sinPitch,
+		rpyRates.y * cosRoll + rpyRates.z * sinRoll * cosPitch,
+		-rpyRates.y * sinRoll + rpyRates.z * cosRoll * cosPitch);
+}
+
+//! @returns weight of the correction at the given time, decreasing linearly from 1 to 0 over the blend duration
+static double calcCorrectionWeight(double time, double correctionTime, const DeadReckoningConfig& config)
+{
+	if (config.correctionBlendDuration <= 0)
+	{
+		return 0;
+	}
+	return std::clamp(1.0 - (time - correctionTime) / config.correctionBlendDuration, 0.0, 1.0);
+}
+
+static double calcExtrapolationDuration(double time, double sampleTime, const DeadReckoningConfig& config)
+{
+	return std::clamp(time - sampleTime, 0.0, config.maxExtrapolationDuration);
+}
+
+void PositionDeadReckoner::addSample(double time, const sim::Vector3& position, const DeadReckoningConfig& config)
+{
+	std::optional<sim::Vector3> displayedPosition;
+	if (mSampleCount > 0 && config.order != DeadReckoningOrder::None)
+	{
+		displayedPosition = evaluate(time, config);
+	}
+
+	if (mSampleCount > 0 && time <= mSamples[0].time)
+	{
+		mSamples[0].position = position;
+	}
+	else
+	{
+		for (int i = std::min(mSampleCount, int(mSamples.size()) - 1); i > 0; --i)
+		{
+			mSamples[i] = mSamples[i - 1];
+		}
+		mSamples[0] = {time, position};
+		mSampleCount = std::min(mSampleCount + 1, int(mSamples.size()));
+	}
+
+	mCorrection = displayedPosition ? (*displayedPosition - extrapolate(time, config)) : sim::Vector3(0);
+	mCorrectionTime = time;
+}
+
+sim::Vector3 PositionDeadReckoner::evaluate(double time, const DeadReckoningConfig& config) const
+{
+	return extrapolate(time, config) + mCorrection * calcCorrectionWeight(time, mCorrectionTime, config);
+}
+
+sim::Vector3 PositionDeadReckoner::extrapolate(double time, const DeadReckoningConfig& config) const
+{
+	assert(mSampleCount > 0);
+	const Sample& latest = mSamples[0];
+	if (config.order == DeadReckoningOrder::None)
+	{
+		return latest.position;
+	}
+
+	sim::Vector3 velocity(0);
+	sim::Vector3 acceleration(0);
+	if (mVelocity)
+	{
+		velocity = *mVelocity;
+	}
+	else if (mSampleCount >= 2)
+	{
+		const Sample& previous = mSamples[1];
+		velocity = (latest.position - previous.position) / (latest.time - previous.time);
+
+		if (config.order == DeadReckoningOrder::Quadratic && mSampleCount >= 3)
+		{
+			const Sample& oldest = mSamples[2];
+			sim::Vector3 previousVelocity = (previous.position - oldest.position) / (previous.time - oldest.time);
+
+			// Finite difference velocities are estimates at the midpoints of the sample intervals
+			acceleration = (velocity - previousVelocity) / ((latest.time - oldest.time) * 0.5);
+			velocity += acceleration * ((latest.time - previous.time) * 0.5);
+		}
+	}
+
+	double dt = calcExtrapolationDuration(time, latest.time, config);
+	return latest.position + velocity * dt + acceleration * (0.5 * dt * dt);
+}
+
+void OrientationDeadReckoner::addSample(double time, const sim::Quaternion& orientation, const DeadReckoningConfig& config)
+{
+	std::optional<sim::Quaternion> displayedOrientation;
+	if (mSampleCount > 0 && config.order != DeadReckoningOrder::None)
+	{
+		displayedOrientation = evaluate(time, config);
+	}
+
+	if (mSampleCount > 0 && time <= mSamples[0].time)
+	{
+		mSamples[0].orientation = orientation;
+	}
+	else
+	{
+		mSamples[1] = mSamples[0];
+		mSamples[0] = {time, orientation};
+		mSampleCount = std::min(mSampleCount + 1, int(mSamples.size()));
+	}
+
+	mCorrection = displayedOrientation ? (*displayedOrientation * glm::inverse(extrapolate(time, config))) : sim::Quaternion(1, 0, 0, 0);
+	mCorrectionTime = time;
+}
+
+sim::Quaternion OrientationDeadReckoner::evaluate(double time, const DeadReckoningConfig& config) const
+{
+	sim::Quaternion result = extrapolate(time, config);
+	double weight = calcCorrectionWeight(time, mCorrectionTime, config);
+	if (weight > 0)
+	{
+		result = glm::normalize(glm::slerp(sim::Quaternion(1, 0, 0, 0), mCorrection, weight) * result);
+	}
+	return result;
+}
+
+sim::Quaternion OrientationDeadReckoner::extrapolate(double time, const DeadReckoningConfig& config) const
+{
+	assert(mSampleCount > 0);
+	const Sample& latest = mSamples[0];
+	if (config.order == DeadReckoningOrder::None)
+	{
+		return latest.orientation;
+	}
+
+	sim::Vector3 angularVelocity(0);
+	if (mAngularVelocity)
+	{
+		angularVelocity = *mAngularVelocity;
+	}
+	else if (mSampleCount >= 2)
+	{
+		const Sample& previous = mSamples[1];
+		sim::Quaternion delta = latest.orientation * glm::inverse(previous.orientation);
+		if (delta.w < 0)
+		{
+			delta = -delta; // Take the shortest path
+		}
+		angularVelocity = glm::axis(delta) * (glm::angle(delta) / (latest.time - previous.time));
+	}
+
+	double rate = glm::length(angularVelocity);
+	double angle = rate * calcExtrapolationDuration(time, latest.time, config);
+	if (angle < 1e-9)
+	{
+		return latest.orientation;
+	}
+	return glm::normalize(glm::angleAxis(angle, angularVelocity / rate) * latest.orientation);
+}
+
+} // namespace skybolt
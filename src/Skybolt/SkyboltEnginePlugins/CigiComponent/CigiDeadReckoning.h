@@ -0,0 +1,105 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <SkyboltSim/SimMath.h>
+
+#include <array>
+#include <optional>
+
+namespace skybolt {
+
+enum class DeadReckoningOrder
+{
+	None, //!< Entity snaps to received states
+	Linear, //!< Extrapolate with constant velocity
+	Quadratic //!< Extrapolate position with constant acceleration, and orientation with constant angular velocity
+};
+
+struct DeadReckoningConfig
+{
+	DeadReckoningOrder order = DeadReckoningOrder::None;
+	double correctionBlendDuration = 0.2; //!< Seconds over which the error between the extrapolated and received state is blended out
+	double maxExtrapolationDuration = 1.0; //!< Entities hold their last extrapolated state if no update is received for this many seconds
+};
+
+//! Converts rates of change of roll, pitch and yaw Euler angles to angular velocity about the body axes.
+//! CIGI Rate Control gives angular rates in this form for the World and Parent coordinate systems.
+//! @param rpy is the current roll, pitch and yaw, as used by math::quatFromEuler
+sim::Vector3 eulerRatesToBodyAngularVelocity(const sim::Vector3& rpy, const sim::Vector3& rpyRates);
+
+//! Extrapolates an entity's position from timestamped samples, smoothly blending out the error when each new sample is received.
+//! Positions are in a cartesian frame, typically geocentric.
+class PositionDeadReckoner
+{
+public:
+	//! Samples with the same time as the latest sample replace it
+	void addSample(double time, const sim::Vector3& position, const DeadReckoningConfig& config);
+
+	//! Sets a velocity, in the same frame as positions, which is used instead of the velocity estimated from samples.
+	//! As with CIGI Rate Control, the rate stays in effect until it is changed.
+	void setVelocity(const std::optional<sim::Vector3>& velocity) { mVelocity = velocity; }
+
+	//! @returns the position at the given time. Must have at least one sample.
+	sim::Vector3 evaluate(double time, const DeadReckoningConfig& config) const;
+
+	bool hasSamples() const { return mSampleCount > 0; }
+
+private:
+	sim::Vector3 extrapolate(double time, const DeadReckoningConfig& config) const;
+
+private:
+	struct Sample
+	{
+		double time;
+		sim::Vector3 position;
+	};
+
+	std::array<Sample, 3> mSamples; //!< Most recent first
+	int mSampleCount = 0;
+	std::optional<sim::Vector3> mVelocity;
+
+	sim::Vector3 mCorrection = sim::Vector3(0); //!< Error between the previously displayed position and the new sample
+	double mCorrectionTime = 0;
+};
+
+//! Extrapolates an entity's orientation from timestamped samples, smoothly blending out the error when each new sample is received.
+//! Orientations are in a cartesian frame, typically geocentric. Extrapolation is at most first order (constant angular velocity).
+class OrientationDeadReckoner
+{
+public:
+	//! Samples with the same time as the latest sample replace it
+	void addSample(double time, const sim::Quaternion& orientation, const DeadReckoningConfig& config);
+
+	//! Sets an angular velocity, in the same frame as orientations, which is used instead of the angular velocity estimated from samples.
+	//! As with CIGI Rate Control, the rate stays in effect until it is changed.
+	void setAngularVelocity(const std::optional<sim::Vector3>& angularVelocity) { mAngularVelocity = angularVelocity; }
+
+	//! @returns the orientation at the given time. Must have at least one sample.
+	sim::Quaternion evaluate(double time, const DeadReckoningConfig& config) const;
+
+	bool hasSamples() const { return mSampleCount > 0; }
+
+private:
+	sim::Quaternion extrapolate(double time, const DeadReckoningConfig& config) const;
+
+private:
+	struct Sample
+	{
+		double time;
+		sim::Quaternion orientation;
+	};
+
+	std::array<Sample, 2> mSamples; //!< Most recent first
+	int mSampleCount = 0;
+	std::optional<sim::Vector3> mAngularVelocity;
+
+	sim::Quaternion mCorrection = sim::Quaternion(1, 0, 0, 0); //!< Rotation from the new sample to the previously displayed orientation
+	double mCorrectionTime = 0;
+};
+
+} // namespace skybolt
@@ -8,6 +8,11 @@
 
 #include <boost/asio.hpp>
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
 using boost::asio::ip::udp;
 
 class UdpCommunicatorImpl
@@ -56,12 +61,82 @@ public:
 		return 0;
 	}
 
+	size_t receiveBatch(std::vector<UdpDatagram>& datagrams)
+	{
+#ifdef __linux__
+		// The recvmmsg path compares IPv4 sender addresses
+		if (mEndpoint.address().is_v4())
+		{
+			return receiveBatchRecvmmsg(datagrams);
+		}
+#endif
+		size_t count = 0;
+		while (count < datagrams.size() && mReceiveSocket->available())
+		{
+			UdpDatagram& datagram = datagrams[count];
+			udp::endpoint senderEndpoint;
+			datagram.sizeBytes = mReceiveSocket->receive_from(boost::asio::buffer(datagram.data), senderEndpoint);
+			if (mEndpoint.address() == senderEndpoint.address())
+			{
+				++count;
+			}
+		}
+		return count;
+	}
+
 	void send(unsigned char& data, size_t sizeBytes)
 	{
 		mSocket->send_to(boost::asio::buffer(&data, sizeBytes), mEndpoint);
 	}
 
 private:
+#ifdef __linux__
+	size_t receiveBatchRecvmmsg(std::vector<UdpDatagram>& datagrams)
+	{
+		// Buffers are local rather than members so that concurrent calls are safe
+		size_t batchSize = datagrams.size();
+		std::vector<mmsghdr> messageHeaders(batchSize);
+		std::vector<iovec> ioVecs(batchSize);
+		std::vector<sockaddr_in> senderAddresses(batchSize);
+
+		for (size_t i = 0; i < batchSize; ++i)
+		{
+			ioVecs[i].iov_base = datagrams[i].data.data();
+			ioVecs[i].iov_len = datagrams[i].data.size();
+
+			msghdr& header = messageHeaders[i].msg_hdr;
+			header = msghdr();
+			header.msg_name = &senderAddresses[i];
+			header.msg_namelen = sizeof(sockaddr_in);
+			header.msg_iov = &ioVecs[i];
+			header.msg_iovlen = 1;
+		}
+
+		int received = recvmmsg(mReceiveSocket->native_handle(), messageHeaders.data(), (unsigned int)batchSize, MSG_DONTWAIT, nullptr);
+		if (received <= 0)
+		{
+			return 0;
+		}
+
+		// Keep only datagrams from the remote endpoint, compacting them to the front of the batch
+		unsigned long remoteAddress = mEndpoint.address().to_v4().to_ulong();
+		size_t count = 0;
+		for (int i = 0; i < received; ++i)
+		{
+			if (ntohl(senderAddresses[i].sin_addr.s_addr) == remoteAddress)
+			{
+				if (count != size_t(i))
+				{
+					std::swap(datagrams[count].data, datagrams[i].data);
+				}
+				datagrams[count].sizeBytes = messageHeaders[i].msg_len;
+				++count;
+			}
+		}
+		return count;
+	}
+#endif
+
 	boost::asio::io_service mService;
 	std::unique_ptr<udp::socket> mSocket;
 	std::unique_ptr<udp::socket> mReceiveSocket;
@@ -82,6 +157,11 @@ size_t UdpCommunicator::receive(unsigned char& data, size_t sizeBytes)
 	return mImpl->receive(data, sizeBytes);
 }
 
+size_t UdpCommunicator::receiveBatch(std::vector<UdpDatagram>& datagrams)
+{
+	return mImpl->receiveBatch(datagrams);
+}
+
 void UdpCommunicator::send(unsigned char& data, size_t sizeBytes)
 {
 	mImpl->send(data, sizeBytes);
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 struct UdpCommunicatorConfig
 {
@@ -17,6 +18,13 @@ struct UdpCommunicatorConfig
 	int localPort;
 };
 
+//! Buffer for one received datagram
+struct UdpDatagram
+{
+	std::vector<unsigned char> data; //!< Allocated by the caller. The capacity is data.size().
+	size_t sizeBytes = 0; //!< Number of bytes received
+};
+
 //! @ThreadSafe
 class UdpCommunicator
 {
@@ -25,6 +33,12 @@ public:
 	~UdpCommunicator();
 
 	size_t receive(unsigned char& data, size_t sizeBytes); //!< Returns number of bytes read
+
+	//! Receives pending datagrams without blocking, until there are no more pending or all datagrams are filled.
+	//! Uses a single recvmmsg call per batch on Linux when the remote address is IPv4.
+	//! @returns number of datagrams received
+	size_t receiveBatch(std::vector<UdpDatagram>& datagrams);
+
 	void send(unsigned char& data, size_t sizeBytes);
 
 private:
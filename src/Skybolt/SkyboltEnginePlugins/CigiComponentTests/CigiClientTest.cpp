@@ -6,6 +6,7 @@
 
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
+#include "CigiLoopbackHost.h"
 #include <CigiComponent/CigiClient.h>
 #include <CigiComponent/UdpCommunicator.h>
 
@@ -117,36 +118,6 @@ public:
 	std::set<CigiCameraPtr> cameras;
 };
 
-class CigiHost
-{
-public:
-	CigiHost(std::unique_ptr<UdpCommunicator> communicator, int cigiMajorVersion, int cigiMinorVersion) :
-		mCommunicator(std::move(communicator))
-	{
-		mSession.SetCigiVersion(CigiVersionID(cigiMajorVersion, cigiMinorVersion));
-		mSession.SetSynchronous(true);
-	}
-
-	void send(const std::function<void(CigiOutgoingMsg&)>& messageWriteFunction)
-	{
-		CigiOutgoingMsg& outgoingMessage = mSession.GetOutgoingMsgMgr();
-		outgoingMessage.BeginMsg();
-		messageWriteFunction(outgoingMessage);
-
-		Cigi_uint8* message = 0;
-		int length = 0;
-		outgoingMessage.PackageMsg(&message, length);
-
-		mCommunicator->send(*message, length);
-
-		outgoingMessage.FreeMsg();
-	}
-
-private:
-	std::unique_ptr<UdpCommunicator> mCommunicator;
-	CigiHostSession mSession;
-};
-
 static std::unique_ptr<UdpCommunicator> CreateUdpCommunicator()
 {
 	UdpCommunicatorConfig config;
@@ -158,10 +129,10 @@ static std::unique_ptr<UdpCommunicator> CreateUdpCommunicator()
 	return std::make_unique<UdpCommunicator>(config);
 }
 
-static std::unique_ptr<CigiHost> CreateCigiHost(int cigiMajorVersion, int cigiMinorVersion)
+static std::unique_ptr<CigiLoopbackHost> CreateCigiHost(int cigiMajorVersion, int cigiMinorVersion)
 {
 	auto connection = CreateUdpCommunicator();
-	return std::make_unique<CigiHost>(std::move(connection), cigiMajorVersion, cigiMinorVersion);
+	return std::make_unique<CigiLoopbackHost>(std::move(connection), cigiMajorVersion, cigiMinorVersion);
 }
 
 static std::unique_ptr<CigiClient> CreateCigiClient(int cigiMajorVersion, const std::shared_ptr<DummyWorld>& world)
@@ -332,4 +303,56 @@ TEST_CASE("Camera is replicated from CIGI V3 packets")
 		client->update();
 		return almostEqual(camera->verticalFov, 20.f * math::degToRadF(), epsilon);
 	}));
-}
\ No newline at end of file
+}
+
+TEST_CASE("All pending datagrams are processed in one update")
+{
+	int cigiMajorVersion = 3;
+	int cigiMinorVersion = 3;
+	auto world = std::make_shared<DummyWorld>();
+	auto client = CreateCigiClient(cigiMajorVersion, world);
+	auto host = CreateCigiHost(cigiMajorVersion, cigiMinorVersion);
+
+	// Send one entity per datagram
+	int entityCount = 100;
+	int datagramCount = host->sendEntityUpdates(entityCount, /* maxPacketsPerDatagram */ 1, [](int entityId, CigiEntityCtrlV3_3& entityCtrl) {
+		entityCtrl.SetEntityType(2);
+	});
+	REQUIRE(datagramCount == entityCount);
+
+	// Datagrams may take time to arrive in the socket buffer, so retry until a deadline.
+	// There are fewer tries than datagrams, so this fails if each update only processes one datagram.
+	int tryCount = 50;
+	CHECK(eventually([&] {
+		client->update();
+		return world->entities.size() == entityCount;
+	}, tryCount));
+}
+
+TEST_CASE("Benchmark sustained entity update rate", "[.][benchmark]")
+{
+	int cigiMajorVersion = 3;
+	int cigiMinorVersion = 3;
+	auto world = std::make_shared<DummyWorld>();
+	auto client = CreateCigiClient(cigiMajorVersion, world);
+	auto host = CreateCigiHost(cigiMajorVersion, cigiMinorVersion);
+
+	constexpr int entityCount = 2000;
+	constexpr int maxPacketsPerDatagram = 25; // Keeps V3 entity control datagrams within a typical MTU
+
+	// Each run is one frame in which the host sends an update for every entity and the client applies what has arrived
+	int frame = 0;
+	BENCHMARK("Send and apply " + std::to_string(entityCount) + " entity updates")
+	{
+		++frame;
+		host->sendEntityUpdates(entityCount, maxPacketsPerDatagram, [frame](int entityId, CigiEntityCtrlV3_3& entityCtrl) {
+			entityCtrl.SetAlt(frame);
+		});
+		client->update();
+	};
+
+	CHECK(eventually([&] {
+		client->update();
+		return world->entities.size() == entityCount;
+	}));
+}
@@ -0,0 +1,159 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <CigiComponent/CigiDeadReckoning.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+using namespace skybolt;
+
+constexpr double epsilon = 1e-6;
+
+static void checkVectorsEqual(const sim::Vector3& a, const sim::Vector3& b)
+{
+	CHECK(a.x == Approx(b.x).margin(epsilon));
+	CHECK(a.y == Approx(b.y).margin(epsilon));
+	CHECK(a.z == Approx(b.z).margin(epsilon));
+}
+
+TEST_CASE("Position snaps to samples when dead reckoning is disabled")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::None;
+
+	PositionDeadReckoner reckoner;
+	reckoner.addSample(0, sim::Vector3(0, 0, 0), config);
+	reckoner.addSample(1, sim::Vector3(10, 0, 0), config);
+
+	checkVectorsEqual(reckoner.evaluate(1.5, config), sim::Vector3(10, 0, 0));
+}
+
+TEST_CASE("Position is extrapolated linearly between samples")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 0;
+
+	PositionDeadReckoner reckoner;
+	reckoner.addSample(0, sim::Vector3(0, 0, 0), config);
+	checkVectorsEqual(reckoner.evaluate(0.5, config), sim::Vector3(0, 0, 0)); // No velocity known yet
+
+	reckoner.addSample(1, sim::Vector3(10, 0, 0), config);
+	checkVectorsEqual(reckoner.evaluate(1.5, config), sim::Vector3(15, 0, 0));
+}
+
+TEST_CASE("Position is extrapolated quadratically between samples")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Quadratic;
+	config.correctionBlendDuration = 0;
+
+	// Constant acceleration of 2 m/s^2 from rest: x = t^2
+	PositionDeadReckoner reckoner;
+	reckoner.addSample(0, sim::Vector3(0, 0, 0), config);
+	reckoner.addSample(1, sim::Vector3(1, 0, 0), config);
+	reckoner.addSample(2, sim::Vector3(4, 0, 0), config);
+
+	checkVectorsEqual(reckoner.evaluate(3, config), sim::Vector3(9, 0, 0));
+}
+
+TEST_CASE("Position extrapolation stops after max extrapolation duration")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 0;
+	config.maxExtrapolationDuration = 2;
+
+	PositionDeadReckoner reckoner;
+	reckoner.addSample(0, sim::Vector3(0, 0, 0), config);
+	reckoner.addSample(1, sim::Vector3(1, 0, 0), config);
+
+	checkVectorsEqual(reckoner.evaluate(10, config), sim::Vector3(3, 0, 0));
+}
+
+TEST_CASE("Position uses explicit velocity instead of estimated velocity")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 0;
+
+	PositionDeadReckoner reckoner;
+	reckoner.addSample(0, sim::Vector3(0, 0, 0), config);
+	reckoner.setVelocity(sim::Vector3(0, 2, 0));
+
+	checkVectorsEqual(reckoner.evaluate(1, config), sim::Vector3(0, 2, 0));
+}
+
+TEST_CASE("Position error is blended out after receiving a sample")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 1;
+
+	PositionDeadReckoner reckoner;
+	reckoner.setVelocity(sim::Vector3(0, 0, 0));
+	reckoner.addSample(0, sim::Vector3(0, 0, 0), config);
+
+	// New sample is 10m away from the displayed position
+	reckoner.addSample(1, sim::Vector3(10, 0, 0), config);
+	checkVectorsEqual(reckoner.evaluate(1, config), sim::Vector3(0, 0, 0)); // No discontinuity
+	checkVectorsEqual(reckoner.evaluate(1.5, config), sim::Vector3(5, 0, 0));
+	checkVectorsEqual(reckoner.evaluate(2, config), sim::Vector3(10, 0, 0));
+}
+
+TEST_CASE("Orientation is extrapolated with constant angular velocity")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 0;
+
+	sim::Vector3 axis(0, 0, 1);
+	OrientationDeadReckoner reckoner;
+	reckoner.addSample(0, glm::angleAxis(0.0, axis), config);
+	reckoner.addSample(1, glm::angleAxis(0.1, axis), config);
+
+	sim::Quaternion result = reckoner.evaluate(2, config);
+	CHECK(glm::angle(result) == Approx(0.2).margin(epsilon));
+	checkVectorsEqual(glm::axis(result), axis);
+}
+
+TEST_CASE("Orientation is extrapolated with Euler angle rates")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 0;
+
+	// Non-zero heading, so that Euler angle rates differ from angular velocity about the NED axes
+	sim::Vector3 rpy(0.2, 0.3, 1.5);
+	sim::Vector3 rpyRates(0.05, -0.1, 0.2);
+	sim::Quaternion orientation = math::quatFromEuler(rpy);
+
+	OrientationDeadReckoner reckoner;
+	reckoner.setAngularVelocity(orientation * eulerRatesToBodyAngularVelocity(rpy, rpyRates));
+	reckoner.addSample(0, orientation, config);
+
+	double dt = 0.001;
+	sim::Quaternion result = reckoner.evaluate(dt, config);
+	sim::Quaternion expected = math::quatFromEuler(rpy + rpyRates * dt);
+	CHECK(glm::angle(glm::inverse(expected) * result) == Approx(0.0).margin(1e-6));
+}
+
+TEST_CASE("Orientation error is blended out after receiving a sample")
+{
+	DeadReckoningConfig config;
+	config.order = DeadReckoningOrder::Linear;
+	config.correctionBlendDuration = 1;
+
+	sim::Vector3 axis(1, 0, 0);
+	OrientationDeadReckoner reckoner;
+	reckoner.setAngularVelocity(sim::Vector3(0, 0, 0));
+	reckoner.addSample(0, glm::angleAxis(0.0, axis), config);
+	reckoner.addSample(1, glm::angleAxis(0.4, axis), config);
+
+	CHECK(glm::angle(reckoner.evaluate(1, config)) == Approx(0.0).margin(epsilon));
+	CHECK(glm::angle(reckoner.evaluate(1.5, config)) == Approx(0.2).margin(epsilon));
+	CHECK(glm::angle(reckoner.evaluate(2, config)) == Approx(0.4).margin(epsilon));
+}
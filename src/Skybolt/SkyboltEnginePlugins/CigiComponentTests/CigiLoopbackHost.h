@@ -0,0 +1,79 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <CigiComponent/UdpCommunicator.h>
+
+#include <cigicl/CigiHostSession.h>
+#include <cigicl/CigiEntityCtrlV3_3.h>
+#include <cigicl/CigiIGCtrlV3.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+//! Stand-in for a CIGI host, which sends packets to an IG over UDP
+class CigiLoopbackHost
+{
+public:
+	CigiLoopbackHost(std::unique_ptr<UdpCommunicator> communicator, int cigiMajorVersion, int cigiMinorVersion) :
+		mCommunicator(std::move(communicator))
+	{
+		mSession.SetCigiVersion(CigiVersionID(cigiMajorVersion, cigiMinorVersion));
+		mSession.SetSynchronous(true);
+	}
+
+	//! Sends one datagram containing the packets written by messageWriteFunction
+	void send(const std::function<void(CigiOutgoingMsg&)>& messageWriteFunction)
+	{
+		CigiOutgoingMsg& outgoingMessage = mSession.GetOutgoingMsgMgr();
+		outgoingMessage.BeginMsg();
+		messageWriteFunction(outgoingMessage);
+
+		Cigi_uint8* message = 0;
+		int length = 0;
+		outgoingMessage.PackageMsg(&message, length);
+
+		mCommunicator->send(*message, length);
+
+		outgoingMessage.FreeMsg();
+	}
+
+	//! Sends CIGI V3 entity control packets for entities with IDs in the range [0, entityCount),
+	//! split across as many datagrams as required to keep each datagram within maxPacketsPerDatagram.
+	//! @param entityCtrlModifier is called to set the packet's fields for each entity
+	//! @returns number of datagrams sent
+	int sendEntityUpdates(int entityCount, int maxPacketsPerDatagram, const std::function<void(int entityId, CigiEntityCtrlV3_3&)>& entityCtrlModifier)
+	{
+		CigiIGCtrlV3 igCtrl;
+		igCtrl.SetIGMode(CigiBaseIGCtrl::IGModeGrp::Operate);
+
+		CigiEntityCtrlV3_3 entityCtrl;
+		entityCtrl.SetEntityState(CigiBaseEntityCtrl::Active);
+
+		int datagramCount = 0;
+		for (int begin = 0; begin < entityCount; begin += maxPacketsPerDatagram)
+		{
+			int end = std::min(entityCount, begin + maxPacketsPerDatagram);
+			send([&](CigiOutgoingMsg& message) {
+				message << igCtrl;
+				for (int id = begin; id < end; ++id)
+				{
+					entityCtrl.SetEntityID(id);
+					entityCtrlModifier(id, entityCtrl);
+					message << entityCtrl;
+				}
+			});
+			++datagramCount;
+		}
+		return datagramCount;
+	}
+
+private:
+	std::unique_ptr<UdpCommunicator> mCommunicator;
+	CigiHostSession mSession;
+};
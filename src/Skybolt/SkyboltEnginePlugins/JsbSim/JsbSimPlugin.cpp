@@ -87,6 +87,8 @@ public:
 		setOrientation(*mEntity, toGeocentric(LtpNedOrientation(orientation), toLatLon(lla)).orientation);
 	}
 
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamics }; }
+
 private:
 	sim::Entity* mEntity;
 	std::unique_ptr<JSBSim::FGFDMExec> mExec;
@@ -6,7 +6,9 @@
 
 #include "PythonComponent.h"
 #include <SkyboltSim/Entity.h>
+#include <SkyboltSim/EntityGroup.h>
 #include <SkyboltSim/Physics/Astronomy.h>
+#include <SkyboltCommon/VectorUtility.h>
 
 #include <filesystem>
 
@@ -22,7 +24,9 @@
 #include <assert.h>
 #include <fstream>
 #include <istream>
+#include <limits>
 #include <sstream>
+#include <unordered_map>
 
 namespace py = pybind11;
 
@@ -56,14 +60,36 @@ static py::handle julianDateToPythonDateTime(double julianDate)
 	return time;
 }
 
-PythonComponent::PythonComponent(sim::Entity* entity, JulianDateProvider julianDateProvider, const std::string& moduleName, const std::string& className) :
+PythonDateTimeCache::PythonDateTimeCache(JulianDateProvider julianDateProvider) :
+	mJulianDateProvider(julianDateProvider),
+	mJulianDate(std::numeric_limits<double>::quiet_NaN()),
+	mUtcTime(new PythonData)
+{
+}
+
+PythonDateTimeCache::~PythonDateTimeCache()
+{
+}
+
+const PythonData& PythonDateTimeCache::getUtcTime()
+{
+	double julianDate = mJulianDateProvider();
+	if (julianDate != mJulianDate)
+	{
+		mJulianDate = julianDate;
+		mUtcTime->object = py::reinterpret_steal<py::object>(julianDateToPythonDateTime(julianDate));
+	}
+	return *mUtcTime;
+}
+
+PythonComponent::PythonComponent(sim::Entity* entity, PythonDateTimeCachePtr dateTimeCache, const std::string& moduleName, const std::string& className) :
 	mEntity(entity),
 	mPythonData(new PythonData),
-	mJulianDateProvider(julianDateProvider)
+	mDateTimeCache(std::move(dateTimeCache))
 {
 	assert(mEntity);
-	auto utcTime = julianDateToPythonDateTime(mJulianDateProvider());
-	mPythonData->object = py::module::import(moduleName.c_str()).attr(className.c_str())(mEntity, utcTime);
+	assert(mDateTimeCache);
+	mPythonData->object = py::module::import(moduleName.c_str()).attr(className.c_str())(mEntity, mDateTimeCache->getUtcTime().object);
 }
 
 PythonComponent::~PythonComponent()
@@ -72,8 +98,138 @@ PythonComponent::~PythonComponent()
 
 void PythonComponent::updatePreDynamics(sim::TimeReal dt, sim::TimeReal dtWallClock)
 {
-	auto utcTime = julianDateToPythonDateTime(mJulianDateProvider());
-	mPythonData->object.attr("update")(utcTime);
+	mPythonData->object.attr("update")(mDateTimeCache->getUtcTime().object);
+}
+
+struct PythonBatch
+{
+	std::vector<sim::Entity*> members; //!< In no particular order, so that members can be removed in constant time
+	std::unordered_map<const sim::Entity*, size_t> memberIndices; //!< Index of each member in members
+	std::shared_ptr<sim::EntityGroup> group; //!< Members to update this frame
+	py::object object;
+};
+
+static std::string toBatchKey(const std::string& moduleName, const std::string& className)
+{
+	return moduleName + "." + className;
+}
+
+PythonBatchSystem::PythonBatchSystem(const sim::World* world, PythonDateTimeCachePtr dateTimeCache) :
+	mWorld(world),
+	mDateTimeCache(std::move(dateTimeCache))
+{
+	assert(mWorld);
+	assert(mDateTimeCache);
+}
+
+PythonBatchSystem::~PythonBatchSystem()
+{
+}
+
+void PythonBatchSystem::addEntity(sim::Entity* entity, const std::string& moduleName, const std::string& className)
+{
+	std::unique_ptr<PythonBatch>& batch = mBatches[toBatchKey(moduleName, className)];
+	if (!batch)
+	{
+		// Import the module before constructing the object so that the skybolt module's types are registered
+		py::module module = py::module::import(moduleName.c_str());
+		auto newBatch = std::make_unique<PythonBatch>();
+		newBatch->group = std::make_shared<sim::EntityGroup>(mWorld);
+		try
+		{
+			newBatch->object = module.attr(className.c_str())(newBatch->group, mDateTimeCache->getUtcTime().object);
+		}
+		catch (...)
+		{
+			mBatches.erase(toBatchKey(moduleName, className));
+			throw;
+		}
+		batch = std::move(newBatch);
+	}
+	if (batch->memberIndices.emplace(entity, batch->members.size()).second)
+	{
+		batch->members.push_back(entity);
+	}
+}
+
+void PythonBatchSystem::removeEntity(sim::Entity* entity, const std::string& moduleName, const std::string& className)
+{
+	auto i = mBatches.find(toBatchKey(moduleName, className));
+	if (i != mBatches.end())
+	{
+		// Empty batches are erased in the next update rather than here, because entities may be destroyed by scripts during the update
+		PythonBatch& batch = *i->second;
+		auto index = batch.memberIndices.find(entity);
+		if (index != batch.memberIndices.end())
+		{
+			size_t memberIndex = index->second;
+			batch.memberIndices.erase(index);
+			VectorUtility::fastUnstableErase(batch.members, memberIndex);
+			if (memberIndex < batch.members.size())
+			{
+				batch.memberIndices[batch.members[memberIndex]] = memberIndex;
+			}
+		}
+	}
+}
+
+void PythonBatchSystem::updatePreDynamics(const StepArgs& args)
+{
+	for (auto i = mBatches.begin(); i != mBatches.end();)
+	{
+		if (i->second->members.empty())
+		{
+			i = mBatches.erase(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	if (mBatches.empty())
+	{
+		return;
+	}
+
+	const py::object& utcTime = mDateTimeCache->getUtcTime().object;
+	for (const auto& [key, batch] : mBatches)
+	{
+		// Skip members which are not in the world (e.g. pooled entities) or have dynamics disabled,
+		// in the same way as EntitySystem does for unbatched scripts.
+		sim::EntityGroup& group = *batch->group;
+		group.clear();
+		for (const sim::Entity* entity : batch->members)
+		{
+			if (entity->isDynamicsEnabled())
+			{
+				group.add(entity); // Ignored if not in the world
+			}
+		}
+
+		if (group.size() > 0)
+		{
+			batch->object.attr("update")(utcTime);
+		}
+	}
+}
+
+PythonBatchMemberComponent::PythonBatchMemberComponent(sim::Entity* entity, const std::shared_ptr<PythonBatchSystem>& system, const std::string& moduleName, const std::string& className) :
+	mEntity(entity),
+	mSystem(system),
+	mModuleName(moduleName),
+	mClassName(className)
+{
+	assert(mEntity);
+	system->addEntity(mEntity, mModuleName, mClassName);
+}
+
+PythonBatchMemberComponent::~PythonBatchMemberComponent()
+{
+	if (auto system = mSystem.lock())
+	{
+		system->removeEntity(mEntity, mModuleName, mClassName);
+	}
 }
 
 } // namespace skybolt
\ No newline at end of file
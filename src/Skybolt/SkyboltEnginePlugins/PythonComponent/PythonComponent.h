@@ -9,22 +9,84 @@
 #include <SkyboltEngine/SkyboltEngineFwd.h>
 #include <SkyboltSim/SkyboltSimFwd.h>
 #include <SkyboltSim/Component.h>
+#include <SkyboltSim/System/System.h>
+#include <map>
 #include <string>
 
 namespace skybolt {
 
+//! Converts julian dates to python datetime objects, reusing the previous object if the date has not changed.
+//! This allows scripts updated in the same frame to share one datetime object.
+class PythonDateTimeCache
+{
+public:
+	PythonDateTimeCache(JulianDateProvider julianDateProvider);
+	~PythonDateTimeCache();
+
+	//! @returns python datetime object for the current julian date
+	const struct PythonData& getUtcTime();
+
+private:
+	JulianDateProvider mJulianDateProvider;
+	double mJulianDate;
+	std::unique_ptr<struct PythonData> mUtcTime;
+};
+
+typedef std::shared_ptr<PythonDateTimeCache> PythonDateTimeCachePtr;
+
+//! Calls the update() method of a python object once per frame for its entity.
+//! The object is constructed with the entity and the current UTC time.
 class PythonComponent : public sim::Component
 {
 public:
-	PythonComponent(sim::Entity* entity, JulianDateProvider julianDateProvider, const std::string& moduleName, const std::string& className);
+	PythonComponent(sim::Entity* entity, PythonDateTimeCachePtr dateTimeCache, const std::string& moduleName, const std::string& className);
 	~PythonComponent();
 
 	void updatePreDynamics(sim::TimeReal dt, sim::TimeReal dtWallClock) override;
+	std::vector<sim::UpdatePhase> getUpdatePhases() const override { return { sim::UpdatePhase::PreDynamics }; }
 
 private:
 	sim::Entity* mEntity;
 	std::unique_ptr<struct PythonData> mPythonData;
-	JulianDateProvider mJulianDateProvider;
+	PythonDateTimeCachePtr mDateTimeCache;
+};
+
+//! Calls the update() method of each batched python object once per frame for all entities scripted by that object's class.
+//! This avoids the overhead of calling into python once per entity.
+//! Each object is constructed with a skybolt.EntityGroup and the current UTC time, and should use the group's
+//! array methods to read and write the state of all its entities at once.
+//! As with PythonComponent, only members which are in the world and have dynamics enabled are updated,
+//! so the group is refilled with those members before each update. Rows are in no particular order.
+class PythonBatchSystem : public sim::System
+{
+public:
+	//! @param world must outlive the system
+	PythonBatchSystem(const sim::World* world, PythonDateTimeCachePtr dateTimeCache);
+	~PythonBatchSystem() override;
+
+	void addEntity(sim::Entity* entity, const std::string& moduleName, const std::string& className);
+	void removeEntity(sim::Entity* entity, const std::string& moduleName, const std::string& className);
+
+	void updatePreDynamics(const StepArgs& args) override;
+
+private:
+	const sim::World* mWorld;
+	PythonDateTimeCachePtr mDateTimeCache;
+	std::map<std::string, std::unique_ptr<struct PythonBatch>> mBatches; //!< Keyed by module and class name
+};
+
+//! Adds its entity to a PythonBatchSystem for the lifetime of the component
+class PythonBatchMemberComponent : public sim::Component
+{
+public:
+	PythonBatchMemberComponent(sim::Entity* entity, const std::shared_ptr<PythonBatchSystem>& system, const std::string& moduleName, const std::string& className);
+	~PythonBatchMemberComponent() override;
+
+private:
+	sim::Entity* mEntity;
+	std::weak_ptr<PythonBatchSystem> mSystem;
+	std::string mModuleName;
+	std::string mClassName;
 };
 
 } // namespace skybolt
\ No newline at end of file
@@ -5,7 +5,9 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PythonComponent.h"
+#include <SkyboltEngine/EngineRoot.h>
 #include <SkyboltEngine/Plugin/Plugin.h>
+#include <SkyboltCommon/VectorUtility.h>
 
 #include <boost/config.hpp>
 #include <boost/dll/alias.hpp>
@@ -20,10 +22,18 @@ class PythonComponentPlugin : public Plugin
 {
 public:
 	PythonComponentPlugin(const PluginConfig& config) :
+		mSystemRegistry(config.engineRoot->systemRegistry),
 		mComponentFactoryRegistry(config.simComponentFactoryRegistry)
 	{
-		auto factory = std::make_shared<ComponentFactoryFunctionAdapter>([](Entity* entity, const ComponentFactoryContext& context, const nlohmann::json& json) {
-			return std::make_shared<PythonComponent>(entity, context.julianDateProvider, json.at("module").get<std::string>(), json.at("class").get<std::string>());
+		// If "batched" is true, the entity is updated by a python object shared with all entities using the same class
+		auto factory = std::make_shared<ComponentFactoryFunctionAdapter>([this](Entity* entity, const ComponentFactoryContext& context, const nlohmann::json& json) -> ComponentPtr {
+			std::string moduleName = json.at("module").get<std::string>();
+			std::string className = json.at("class").get<std::string>();
+			if (json.value("batched", false))
+			{
+				return std::make_shared<PythonBatchMemberComponent>(entity, getOrCreateBatchSystem(context), moduleName, className);
+			}
+			return std::make_shared<PythonComponent>(entity, getOrCreateDateTimeCache(context.julianDateProvider), moduleName, className);
 		});
 
 		mComponentFactoryRegistry->insert(std::make_pair(pythonComponentName, factory));
@@ -32,10 +42,38 @@ public:
 	~PythonComponentPlugin()
 	{
 		mComponentFactoryRegistry->erase(pythonComponentName);
+		if (mBatchSystem)
+		{
+			VectorUtility::eraseFirst<sim::SystemPtr>(*mSystemRegistry, mBatchSystem);
+		}
 	}
 
 private:
+	PythonDateTimeCachePtr getOrCreateDateTimeCache(const JulianDateProvider& julianDateProvider)
+	{
+		if (!mDateTimeCache)
+		{
+			mDateTimeCache = std::make_shared<PythonDateTimeCache>(julianDateProvider);
+		}
+		return mDateTimeCache;
+	}
+
+	//! The system is created on first use so that it is not registered unless batched scripts are used
+	std::shared_ptr<PythonBatchSystem> getOrCreateBatchSystem(const ComponentFactoryContext& context)
+	{
+		if (!mBatchSystem)
+		{
+			mBatchSystem = std::make_shared<PythonBatchSystem>(context.simWorld, getOrCreateDateTimeCache(context.julianDateProvider));
+			mSystemRegistry->push_back(mBatchSystem);
+		}
+		return mBatchSystem;
+	}
+
+private:
+	sim::SystemRegistryPtr mSystemRegistry; //!< Shared so that it outlives the plugin
 	ComponentFactoryRegistryPtr mComponentFactoryRegistry;
+	PythonDateTimeCachePtr mDateTimeCache;
+	std::shared_ptr<PythonBatchSystem> mBatchSystem;
 };
 
 namespace plugins {
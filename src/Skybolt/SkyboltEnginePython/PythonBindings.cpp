@@ -10,6 +10,7 @@
 #include <SkyboltEngine/SimVisBinding/CameraSimVisBinding.h>
 #include <SkyboltEngine/SimVisBinding/SimVisSystem.h>
 #include <SkyboltSim/Entity.h>
+#include <SkyboltSim/EntityGroup.h>
 #include <SkyboltSim/World.h>
 #include <SkyboltSim/CameraController/CameraController.h>
 #include <SkyboltSim/CameraController/CameraControllerSelector.h>
@@ -29,6 +30,7 @@
 #include <SkyboltVis/Window/StandaloneWindow.h>
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/stl.h>
 
@@ -93,6 +95,47 @@ static Vector3 normalizeFunc(const Vector3& v)
 	return glm::normalize(v);
 }
 
+typedef void (EntityGroup::*EntityGroupStateGetter)(double* out) const;
+typedef void (EntityGroup::*EntityGroupStateSetter)(const double* in) const;
+typedef py::array_t<double, py::array::c_style> StateArray;
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> InputStateArray; //!< Converts input of other types and layouts
+
+static void checkStateArrayShape(const py::array& array, const EntityGroup& group, py::ssize_t stride)
+{
+	if (array.ndim() != 2 || array.shape(0) != py::ssize_t(group.size()) || array.shape(1) != stride)
+	{
+		throw py::value_error("Expected array of shape (" + std::to_string(group.size()) + ", " + std::to_string(stride) + ")");
+	}
+}
+
+//! Writes the group's state into 'out' if provided, avoiding allocation of a new array each call
+static StateArray getEntityGroupState(const EntityGroup& group, EntityGroupStateGetter getter, py::ssize_t stride, const py::object& out)
+{
+	StateArray result;
+	if (out.is_none())
+	{
+		result = StateArray({py::ssize_t(group.size()), stride});
+	}
+	else if (StateArray::check_(out))
+	{
+		result = py::reinterpret_borrow<StateArray>(out);
+		checkStateArrayShape(result, group, stride);
+	}
+	else
+	{
+		throw py::type_error("Expected C-contiguous float64 array");
+	}
+
+	(group.*getter)(result.mutable_data());
+	return result;
+}
+
+static void setEntityGroupState(const EntityGroup& group, EntityGroupStateSetter setter, py::ssize_t stride, const InputStateArray& in)
+{
+	checkStateArrayShape(in, group, stride);
+	(group.*setter)(in.data());
+}
+
 static bool attachCameraToWindowWithEngine(sim::Entity& camera, vis::Window& window, EngineRoot& engineRoot)
 {
 	auto viewport = createAndAddViewportToWindow(window, engineRoot.programs.getRequiredProgram("compositeFinal"));
@@ -109,7 +152,7 @@ static bool attachCameraToWindowWithEngine(sim::Entity& camera, vis::Window& win
 
 static bool stepOnceAndRenderOnce(EngineRoot& engineRoot, vis::Window& window, double dtWallClock)
 {
-	SimStepper stepper(engineRoot.systemRegistry);
+	SimStepper stepper(engineRoot.systemRegistry, engineRoot.simStepperConfig);
 	System::StepArgs args;
 	args.dtSim = dtWallClock;
 	args.dtWallClock = dtWallClock;
@@ -119,7 +162,7 @@ static bool stepOnceAndRenderOnce(EngineRoot& engineRoot, vis::Window& window, d
 
 static bool stepOnceAndRenderUntilDone(EngineRoot& engineRoot, vis::Window& window, double dtWallClock)
 {
-	SimStepper stepper(engineRoot.systemRegistry);
+	SimStepper stepper(engineRoot.systemRegistry, engineRoot.simStepperConfig);
 	System::StepArgs args;
 	args.dtSim = dtWallClock;
 	args.dtWallClock = dtWallClock;
@@ -252,15 +295,54 @@ PYBIND11_MODULE(skybolt, m) {
 		.def("addComponent", &Entity::addComponent)
 		.def_property("dynamicsEnabled", &Entity::isDynamicsEnabled, &Entity::setDynamicsEnabled);
 
+	py::class_<EntityGroup, std::shared_ptr<EntityGroup>>(m, "EntityGroup")
+		.def(py::init<const World*>(), py::keep_alive<1, 2>())
+		.def(py::init([](const World* world, const std::vector<Entity*>& entities) {
+			auto group = std::make_shared<EntityGroup>(world);
+			for (Entity* entity : entities)
+			{
+				group->add(entity);
+			}
+			return group;
+		}), py::keep_alive<1, 2>())
+		.def("add", &EntityGroup::add)
+		.def("remove", py::overload_cast<const Entity*>(&EntityGroup::remove))
+		.def("remove", py::overload_cast<EntityId>(&EntityGroup::remove))
+		.def("clear", &EntityGroup::clear)
+		.def("__len__", &EntityGroup::size)
+		.def_property_readonly("entityIds", &EntityGroup::getEntityIds)
+		.def_property_readonly("entities", &EntityGroup::getEntities)
+		.def("getPositions", [](const EntityGroup& g, const py::object& out) {
+			return getEntityGroupState(g, &EntityGroup::getPositions, EntityGroup::vector3Stride, out);
+		}, py::arg("out") = py::none())
+		.def("getOrientations", [](const EntityGroup& g, const py::object& out) {
+			return getEntityGroupState(g, &EntityGroup::getOrientations, EntityGroup::quaternionStride, out);
+		}, py::arg("out") = py::none())
+		.def("getVelocities", [](const EntityGroup& g, const py::object& out) {
+			return getEntityGroupState(g, &EntityGroup::getVelocities, EntityGroup::vector3Stride, out);
+		}, py::arg("out") = py::none())
+		.def("setPositions", [](const EntityGroup& g, const InputStateArray& in) {
+			setEntityGroupState(g, &EntityGroup::setPositions, EntityGroup::vector3Stride, in);
+		})
+		.def("setOrientations", [](const EntityGroup& g, const InputStateArray& in) {
+			setEntityGroupState(g, &EntityGroup::setOrientations, EntityGroup::quaternionStride, in);
+		})
+		.def("setVelocities", [](const EntityGroup& g, const InputStateArray& in) {
+			setEntityGroupState(g, &EntityGroup::setVelocities, EntityGroup::vector3Stride, in);
+		});
+
 	py::class_<World>(m, "World")
 		.def("getEntities", &World::getEntities, py::return_value_policy::reference)
 		.def("addEntity", &World::addEntity)
 		.def("removeEntity", &World::removeEntity)
-		.def("removeAllEntities", &World::removeAllEntities);
+		.def("removeAllEntities", &World::removeAllEntities)
+		.def("getEntityId", &World::getEntityId)
+		.def("getEntityById", &World::getEntityById);
 
 	py::class_<EntityFactory>(m, "EntityFactory")
 		.def("createEntity", &EntityFactory::createEntity, py::return_value_policy::reference,
-			py::arg("templateName"), py::arg("name") = "", py::arg("position") = math::dvec3Zero(), py::arg("orientation") = math::dquatIdentity());
+			py::arg("templateName"), py::arg("name") = "", py::arg("position") = math::dvec3Zero(), py::arg("orientation") = math::dquatIdentity())
+		.def("prefetchModels", &EntityFactory::prefetchModels, py::arg("templateNames"));
 
 	py::class_<EngineRoot>(m, "EngineRoot")
 		.def_property_readonly("world", [](const EngineRoot& r) {return r.simWorld.get(); }, py::return_value_policy::reference_internal)
@@ -0,0 +1,236 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltEngine/EngineStats.h>
+#include <SkyboltEngine/EntityFactory.h>
+#include <SkyboltEngine/VisObjectsComponent.h>
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/NameComponent.h>
+#include <SkyboltSim/Components/Node.h>
+#include <SkyboltVis/Scene.h>
+#include <SkyboltVis/Renderable/Model/ModelFactory.h>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/JsonTileSourceFactory.h>
+#include <SkyboltVis/Shader/ShaderProgramRegistry.h>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osgDB/WriteFile>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace skybolt;
+
+struct CountedComponent : public sim::Component
+{
+};
+
+struct ExtraComponent : public sim::Component
+{
+};
+
+class EntityFactoryFixture
+{
+public:
+	//! @param modelFilename if not empty, a template named SkyboltTestModelTemplate is created which uses the model
+	EntityFactoryFixture(int poolSize, bool visEnabled = true, const vis::ModelFactoryPtr& modelFactory = nullptr, const std::string& modelFilename = "")
+	{
+		std::vector<std::filesystem::path> templateFilenames;
+		templateFilenames.push_back(std::filesystem::temp_directory_path() / "SkyboltTestTemplate.json");
+		{
+			std::ofstream f(templateFilenames.back());
+			f << R"({"poolSize": )" << poolSize << R"(, "components": [{"node": {}}, {"counted": {}}]})";
+		}
+
+		if (!modelFilename.empty())
+		{
+			templateFilenames.push_back(std::filesystem::temp_directory_path() / "SkyboltTestModelTemplate.json");
+			std::ofstream f(templateFilenames.back());
+			f << R"({"components": [{"node": {}}, {"visualModel": {"model": )" << nlohmann::json(modelFilename).dump() << R"(}}]})";
+		}
+
+		auto componentFactoryRegistry = std::make_shared<ComponentFactoryRegistry>();
+		(*componentFactoryRegistry)["node"] = std::make_shared<ComponentFactoryFunctionAdapter>([] (sim::Entity* entity, const ComponentFactoryContext& context, const nlohmann::json& json) {
+			return std::make_shared<sim::Node>();
+		});
+		(*componentFactoryRegistry)["counted"] = std::make_shared<ComponentFactoryFunctionAdapter>([this] (sim::Entity* entity, const ComponentFactoryContext& context, const nlohmann::json& json) {
+			++createdComponentCount;
+			return std::make_shared<CountedComponent>();
+		});
+
+		EntityFactory::Context context;
+		context.scheduler = nullptr;
+		context.simWorld = &world;
+		context.scene = visEnabled ? &scene : nullptr;
+		context.programs = visEnabled ? &programs : nullptr;
+		context.julianDateProvider = [] { return 0.0; };
+		context.namedObjectRegistry = namedObjectRegistry;
+		context.componentFactoryRegistry = componentFactoryRegistry;
+		context.tileSourceFactory = std::make_shared<vis::JsonTileSourceFactory>(vis::JsonTileSourceFactoryConfig());
+		context.modelFactory = modelFactory;
+		context.stats = &stats;
+
+		factory = std::make_unique<EntityFactory>(context, templateFilenames);
+		for (const std::filesystem::path& filename : templateFilenames)
+		{
+			std::filesystem::remove(filename);
+		}
+	}
+
+	sim::World world;
+	vis::Scene scene;
+	vis::ShaderPrograms programs;
+	sim::NamedObjectRegistryPtr namedObjectRegistry = std::make_shared<sim::NamedObjectRegistry>();
+	EngineStats stats;
+	std::unique_ptr<EntityFactory> factory;
+	int createdComponentCount = 0;
+};
+
+TEST_CASE("Entities are created from compiled template")
+{
+	EntityFactoryFixture fixture(0);
+
+	sim::Vector3 position(1, 2, 3);
+	sim::EntityPtr entity = fixture.factory->createEntity("SkyboltTestTemplate", "a", position);
+	CHECK(sim::getName(*entity) == "a");
+	CHECK(entity->getFirstComponent<CountedComponent>());
+	CHECK(*sim::getPosition(*entity) == position);
+
+	sim::EntityPtr entity2 = fixture.factory->createEntity("SkyboltTestTemplate", "b");
+	CHECK(entity2 != entity);
+	CHECK(fixture.createdComponentCount == 2);
+}
+
+TEST_CASE("Recycled entities are not reused if template is not pooled")
+{
+	EntityFactoryFixture fixture(0);
+
+	sim::EntityPtr entity = fixture.factory->createEntity("SkyboltTestTemplate", "a");
+	fixture.factory->recycleEntity(entity);
+	entity.reset();
+
+	sim::EntityPtr entity2 = fixture.factory->createEntity("SkyboltTestTemplate", "b");
+	CHECK(fixture.createdComponentCount == 2);
+}
+
+TEST_CASE("Recycled entities are reused if template is pooled")
+{
+	EntityFactoryFixture fixture(1);
+
+	sim::EntityPtr entity = fixture.factory->createEntity("SkyboltTestTemplate", "a");
+	entity->addComponent(std::make_shared<ExtraComponent>());
+	entity->setDynamicsEnabled(false);
+
+	fixture.factory->recycleEntity(entity);
+	CHECK(fixture.namedObjectRegistry->getObjectByName("a") == nullptr);
+
+	sim::Vector3 position(1, 2, 3);
+	sim::EntityPtr entity2 = fixture.factory->createEntity("SkyboltTestTemplate", "b", position);
+	CHECK(entity2 == entity);
+	CHECK(fixture.createdComponentCount == 1);
+
+	// Check entity is restored to its created state
+	CHECK(sim::getName(*entity2) == "b");
+	CHECK(fixture.namedObjectRegistry->getObjectByName("b") == entity2.get());
+	CHECK(entity2->getComponentsOfType<sim::NameComponent>().size() == 1);
+	CHECK(!entity2->getFirstComponent<ExtraComponent>());
+	CHECK(entity2->getFirstComponent<CountedComponent>());
+	CHECK(entity2->isDynamicsEnabled());
+	CHECK(*sim::getPosition(*entity2) == position);
+
+	// Pool is empty, so a new entity is created
+	sim::EntityPtr entity3 = fixture.factory->createEntity("SkyboltTestTemplate", "c");
+	CHECK(entity3 != entity2);
+	CHECK(fixture.createdComponentCount == 2);
+}
+
+TEST_CASE("Pool does not grow beyond pool size")
+{
+	EntityFactoryFixture fixture(1);
+
+	sim::EntityPtr a = fixture.factory->createEntity("SkyboltTestTemplate", "a");
+	sim::EntityPtr b = fixture.factory->createEntity("SkyboltTestTemplate", "b");
+	fixture.factory->recycleEntity(a);
+	fixture.factory->recycleEntity(b);
+
+	CHECK(fixture.factory->createEntity("SkyboltTestTemplate", "c") == a);
+	CHECK(fixture.factory->createEntity("SkyboltTestTemplate", "d") != b);
+}
+
+TEST_CASE("Entities are created without visuals when vis is disabled")
+{
+	EntityFactoryFixture fixture(0, /* visEnabled */ false);
+
+	sim::EntityPtr entity = fixture.factory->createEntity("SkyboltTestTemplate", "a");
+	CHECK(entity->getFirstComponent<CountedComponent>());
+	CHECK(entity->getFirstComponentRequired<VisObjectsComponent>()->getObjects().empty());
+
+	// Builtin templates are purely visual, so only have a node
+	sim::EntityPtr stars = fixture.factory->createEntity("Stars");
+	CHECK(stars->getComponents().size() == 1);
+	CHECK(stars->getFirstComponent<sim::Node>());
+}
+
+static std::string writeTestModel(const std::string& name, int vertexCount)
+{
+	osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+	geometry->setVertexArray(new osg::Vec3Array(vertexCount));
+	geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertexCount));
+
+	osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+	geode->addDrawable(geometry);
+
+	std::string filename = (std::filesystem::temp_directory_path() / (name + ".osgt")).string();
+	REQUIRE(osgDB::writeNodeFile(*geode, filename));
+	return filename;
+}
+
+TEST_CASE("Models of spawned entities can be evicted once the entities are destroyed")
+{
+	std::string filenameA = writeTestModel("EntityFactoryTestsEvictA", 1000);
+	std::string filenameB = writeTestModel("EntityFactoryTestsEvictB", 1000);
+	std::string filenameC = writeTestModel("EntityFactoryTestsEvictC", 1000);
+
+	vis::ModelFactoryConfig config;
+	config.defaultProgram = new osg::Program;
+	config.cacheCapacityBytes = 1000 * sizeof(osg::Vec3) + 100; // Room for one model
+	auto modelFactory = std::make_shared<vis::ModelFactory>(config);
+
+	EntityFactoryFixture fixture(0, /* visEnabled */ true, modelFactory, filenameA);
+
+	sim::EntityPtr entity = fixture.factory->createEntity("SkyboltTestModelTemplate");
+	REQUIRE(entity->getFirstComponentRequired<VisObjectsComponent>()->getObjects().size() == 1);
+
+	// Model A is in use by the entity, so is not evicted when model B is loaded
+	modelFactory->createModel(filenameB);
+	CHECK(modelFactory->getCacheSizeBytes() > config.cacheCapacityBytes);
+
+	// Model A is no longer used once the entity is destroyed, so is evicted along with model B when model C is loaded.
+	// The template's prefab must not keep the model alive.
+	entity.reset();
+	osg::ref_ptr<osg::Node> modelC = modelFactory->createModel(filenameC);
+	CHECK(modelFactory->getCacheSizeBytes() <= config.cacheCapacityBytes);
+
+	std::filesystem::remove(filenameA);
+	std::filesystem::remove(filenameB);
+	std::filesystem::remove(filenameC);
+}
+
+TEST_CASE("Benchmark entity spawn rate", "[.][benchmark]")
+{
+	EntityFactoryFixture fixture(0);
+
+	BENCHMARK_ADVANCED("Spawn entity")(Catch::Benchmark::Chronometer meter)
+	{
+		// Destroy entities outside of the measurement
+		std::vector<sim::EntityPtr> entities(meter.runs());
+		meter.measure([&] (int i) {
+			entities[i] = fixture.factory->createEntity("SkyboltTestTemplate");
+		});
+	};
+}
@@ -0,0 +1,120 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltEngine/TimeSource.h>
+#include <SkyboltEngine/UpdateLoop/HeadlessRunner.h>
+#include <SkyboltSim/System/SimStepper.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <mutex>
+#include <stdexcept>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+class StepCountingSystem : public System
+{
+public:
+	void updatePreDynamics(const StepArgs& args) override
+	{
+		++stepCount;
+		totalTime += args.dtSim;
+	}
+
+	int stepCount = 0;
+	double totalTime = 0;
+};
+
+static SimStepper createStepper(const std::shared_ptr<System>& system)
+{
+	return SimStepper(std::make_shared<SystemRegistry>(SystemRegistry({system})));
+}
+
+TEST_CASE("Headless run steps with fixed time step for the requested duration")
+{
+	auto system = std::make_shared<StepCountingSystem>();
+	SimStepper stepper = createStepper(system);
+	TimeSource timeSource(TimeRange(0, 1));
+
+	HeadlessRunConfig config;
+	config.dt = 0.1;
+	config.duration = 2;
+	HeadlessRunStats stats = runHeadless(stepper, timeSource, config);
+
+	CHECK(stats.stepCount == 20);
+	CHECK(system->stepCount == 20);
+	CHECK(system->totalTime == Approx(2.0));
+	CHECK(stats.simDuration == Approx(2.0));
+	CHECK(timeSource.getTime() == Approx(2.0)); // Time range is extended to cover the run
+}
+
+TEST_CASE("Headless run stops when requested")
+{
+	auto system = std::make_shared<StepCountingSystem>();
+	SimStepper stepper = createStepper(system);
+	TimeSource timeSource(TimeRange(0, 10));
+
+	HeadlessRunConfig config;
+	config.dt = 0.1;
+	config.duration = 10;
+	HeadlessRunStats stats = runHeadless(stepper, timeSource, config, [&] { return system->stepCount == 5; });
+
+	CHECK(stats.stepCount == 5);
+	CHECK(stats.simDuration == Approx(0.5));
+}
+
+TEST_CASE("Headless run rejects invalid time step")
+{
+	auto system = std::make_shared<StepCountingSystem>();
+	SimStepper stepper = createStepper(system);
+	TimeSource timeSource(TimeRange(0, 10));
+
+	HeadlessRunConfig config;
+	config.dt = 0;
+	CHECK_THROWS_AS(runHeadless(stepper, timeSource, config), skybolt::Exception);
+}
+
+TEST_CASE("Batch runs are executed in parallel with per run seeds")
+{
+	BatchRunConfig config;
+	config.runCount = 20;
+	config.threadCount = 4;
+	config.baseSeed = 100;
+
+	std::mutex mutex;
+	std::vector<int> executionCounts(config.runCount, 0);
+
+	BatchRunStats stats = runBatch(config, [&] (const BatchRun& run) {
+		{
+			// Catch assertions are not thread safe, so results are checked after the batch
+			std::scoped_lock lock(mutex);
+			++executionCounts[run.index];
+		}
+
+		if (run.index == 3)
+		{
+			throw std::runtime_error("Test failure");
+		}
+
+		HeadlessRunStats runStats;
+		runStats.simDuration = 1.0;
+		runStats.wallDuration = 0.5;
+		return runStats;
+	});
+
+	CHECK(executionCounts == std::vector<int>(config.runCount, 1));
+	REQUIRE(stats.runs.size() == 20);
+	for (int i = 0; i < 20; ++i)
+	{
+		CHECK(stats.runs[i].seed == 100 + i);
+	}
+
+	CHECK(stats.runs[3].error == "Test failure");
+	CHECK(stats.getFailedRunCount() == 1);
+	CHECK(stats.getSimDuration() == Approx(19.0));
+	CHECK(stats.wallDuration >= 0);
+}
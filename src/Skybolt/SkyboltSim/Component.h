@@ -12,18 +12,41 @@
 namespace skybolt {
 namespace sim {
 
+//! Identifies a Component update hook
+enum class UpdatePhase
+{
+	PreDynamics, //!< Component::updatePreDynamics
+	PreDynamicsSubstep, //!< Component::updatePreDynamicsSubstep
+	PostDynamics, //!< Component::updatePostDynamics
+	Attachments //!< Component::updateAttachments
+};
+
+constexpr size_t updatePhaseCount = 4;
+
 class Component
 {
 public:
 	virtual ~Component() {}
 
-	// TODO: these update hooks should be made more generic. Components should register when they want to be updated.
+	//! A component's update hooks are only called for the phases returned by getUpdatePhases().
+	//! Components which override a hook must also override getUpdatePhases() to include the hook's phase,
+	//! otherwise the hook is never called.
 	virtual void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) {};
 	virtual void updatePreDynamicsSubstep(TimeReal dtSubstep) {}
 	virtual void updatePostDynamics() {};
 	virtual void updateAttachments(TimeReal dt, TimeReal dtWallClock) {};
 
 	virtual void setDynamicsEnabled(bool enabled) {};
+
+	//! @returns the phases this component will be registered for when added to an entity.
+	//! Defaults to no phases, so that components without update hooks are skipped by updates.
+	//! The result must not change over the lifetime of the component.
+	virtual std::vector<UpdatePhase> getUpdatePhases() const { return {}; }
+
+	//! @returns true if the update hooks only access state owned by this component's entity,
+	//! which allows the entity to be updated concurrently with other entities.
+	//! The result must not change over the lifetime of the component.
+	virtual bool isThreadSafePerEntity() const { return false; }
 
 	//! @returns types this component will be registered as in the type system, used by TypedItemContainer
 	virtual std::vector<std::type_index> getExposedTypes() const { return { typeid(*this) }; }
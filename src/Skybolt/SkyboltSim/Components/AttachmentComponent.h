@@ -35,6 +35,7 @@ public:
 	const std::string& getEntityTemplate() const { return mParams.entityTemplate; }
 
 	void updatePostDynamics() override;
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PostDynamics }; }
 
 	void setPositionRelBody(const Vector3& positionRelBody) { mParams.positionRelBody = positionRelBody; }
 	void setOrientationRelBody(const Quaternion& orientationRelBody) { mParams.orientationRelBody = orientationRelBody; }
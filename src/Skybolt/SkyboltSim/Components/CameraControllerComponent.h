@@ -26,6 +26,7 @@ public:
 	CameraControllerComponent(const CameraControllerPtr& cameraController);
 
 	void updateAttachments(TimeReal dt, TimeReal dtWallClock) override;
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::Attachments }; }
 
 	CameraControllerPtr cameraController;
 };
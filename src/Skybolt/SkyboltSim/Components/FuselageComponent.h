@@ -58,6 +58,8 @@ public:
 	FuselageComponent(const FuselageComponentConfig& config);
 
 	void updatePreDynamicsSubstep(TimeReal dt);
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamicsSubstep }; }
+	bool isThreadSafePerEntity() const override { return true; }
 
 	float getAngleOfAttack() const { return mAngleOfAttack; }
 	float getSideSlipAngle() const { return mSideSlipAngle; }
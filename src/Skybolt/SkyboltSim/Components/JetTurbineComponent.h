@@ -25,6 +25,8 @@ public:
 	JetTurbineComponent(const JetTurbineParams& params, const ControlInputFloatPtr &input);
 
 	void updatePreDynamicsSubstep(TimeReal dt);
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamicsSubstep }; }
+	bool isThreadSafePerEntity() const override { return true; }
 	float getRpm() const {return mEngineRpm;}
 
 private:
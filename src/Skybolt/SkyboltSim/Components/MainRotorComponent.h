@@ -54,6 +54,8 @@ public:
 	MainRotorComponent(const MainRotorComponentConfig& config);
 
 	void updatePreDynamicsSubstep(TimeReal dt);
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamicsSubstep }; }
+	bool isThreadSafePerEntity() const override { return true; }
 
 	void setNormalizedRpm(float rpm) { mDriverRpm = rpm; }
 
@@ -7,6 +7,8 @@
 #include "NameComponent.h"
 #include "SkyboltSim/Entity.h"
 #include "SkyboltSimFwd.h"
+#include <SkyboltCommon/Exception.h>
+#include <climits>
 #include <vector>
 
 namespace skybolt {
@@ -14,7 +16,17 @@ namespace sim {
 
 void NamedObjectRegistry::add(const std::string& name, sim::Entity* entity)
 {
-	namedObjects[name] = entity;
+	auto it = namedObjects.find(name);
+	if (it != namedObjects.end())
+	{
+		it->second.entity = entity;
+	}
+	else
+	{
+		auto ownedName = std::make_unique<const std::string>(name);
+		std::string_view key = *ownedName;
+		namedObjects.emplace(key, NamedObject{std::move(ownedName), entity});
+	}
 	CALL_LISTENERS(objectAdded(name, entity));
 }
 
@@ -23,24 +35,42 @@ void NamedObjectRegistry::remove(const std::string& name)
 	auto it = namedObjects.find(name);
 	if (it != namedObjects.end())
 	{
-		sim::Entity* entity = it->second;
+		sim::Entity* entity = it->second.entity;
 		namedObjects.erase(it);
 		CALL_LISTENERS(objectRemoved(name, entity));
 	}
 }
 
-sim::Entity* NamedObjectRegistry::getObjectByName(const std::string& name) const
+sim::Entity* NamedObjectRegistry::getObjectByName(std::string_view name) const
 {
 	auto it = namedObjects.find(name);
-	return (it != namedObjects.end()) ? it->second : nullptr;
+	return (it != namedObjects.end()) ? it->second.entity : nullptr;
+}
+
+std::string NamedObjectRegistry::createUniqueName(const std::string& baseName)
+{
+	int& suffix = nextNameSuffixes.try_emplace(baseName, 1).first->second;
+
+	std::string name = baseName;
+	for (; suffix < INT_MAX; ++suffix)
+	{
+		name.resize(baseName.size());
+		name += std::to_string(suffix);
+		if (namedObjects.find(name) == namedObjects.end())
+		{
+			++suffix;
+			return name;
+		}
+	}
+	throw skybolt::Exception("Could not create unique object name from base name: " + baseName);
 }
 
 const std::string& getName(const sim::Entity& entity)
 {
-	std::vector<NameComponentPtr> comp = entity.getComponentsOfType<NameComponent>();
-	if (!comp.empty())
+	const NameComponent* comp = entity.getFirstComponent<NameComponent>().get();
+	if (comp)
 	{
-		return comp.front()->getName();
+		return comp->getName();
 	}
 	static const std::string empty = "";
 	return empty;
@@ -9,8 +9,10 @@
 #include "SkyboltSim/Component.h"
 #include "SkyboltSim/SkyboltSimFwd.h"
 #include <SkyboltCommon/Listenable.h>
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace skybolt {
 namespace sim {
@@ -27,10 +29,23 @@ public:
 	void add(const std::string& name, sim::Entity* entity);
 	void remove(const std::string& name);
 
-	sim::Entity* getObjectByName(const std::string& name) const;
+	sim::Entity* getObjectByName(std::string_view name) const;
+
+	//! @returns a name which is not in the registry, made by appending a number to the base name.
+	//! Numbers are allocated from a counter per base name, so the cost is amortized constant time.
+	//! Numbers of removed names are not reused.
+	std::string createUniqueName(const std::string& baseName);
 
 private:
-	std::map<std::string, sim::Entity*> namedObjects;
+	struct NamedObject
+	{
+		std::unique_ptr<const std::string> name; //!< Heap allocated so that the map's key can view it
+		sim::Entity* entity;
+	};
+
+	//! Keys view the NamedObject's name, so that objects can be found by std::string_view without allocating a std::string
+	std::unordered_map<std::string_view, NamedObject> namedObjects;
+	std::unordered_map<std::string, int> nextNameSuffixes; //!< Next number to try appending to each base name
 };
 
 class NameComponent : public sim::Component
@@ -39,6 +39,8 @@ public:
 	PropellerComponent(const PropellerComponentConfig& config);
 
 	void updatePreDynamicsSubstep(TimeReal dt);
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamicsSubstep }; }
+	bool isThreadSafePerEntity() const override { return true; }
 
 	void setDriverRpm(float rpm) {mDriverRpm = rpm;}
 
@@ -33,6 +33,8 @@ public:
 	ReactionControlSystemComponent(const ReactionControlSystemComponentConfig& config);
 
 	void updatePreDynamicsSubstep(TimeReal dt) override;
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamicsSubstep }; }
+	bool isThreadSafePerEntity() const override { return true; }
 
 private:
 	const ReactionControlSystemParams mParams;
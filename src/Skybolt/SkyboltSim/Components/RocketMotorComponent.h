@@ -24,6 +24,8 @@ public:
 	RocketMotorComponent(const RocketMotorComponentParams& params, Node* node, DynamicBodyComponent* body, const ControlInputFloatPtr& input);
 
 	void updatePreDynamicsSubstep(TimeReal dt);
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamicsSubstep }; }
+	bool isThreadSafePerEntity() const override { return true; }
 
 private:
 	const RocketMotorComponentParams mParams;
@@ -11,6 +11,7 @@
 #include "Components/DynamicBodyComponent.h"
 #include "Components/Node.h"
 #include <boost/foreach.hpp>
+#include <algorithm>
 
 namespace skybolt {
 namespace sim {
@@ -27,37 +28,111 @@ Entity::~Entity()
 void Entity::addComponent(const ComponentPtr& c)
 {
 	mComponents.addItem(c);
+
+	bool threadSafe = c->isThreadSafePerEntity();
+	for (UpdatePhase phase : c->getUpdatePhases())
+	{
+		PhaseComponents& phaseComponents = mPhaseComponents[size_t(phase)];
+		phaseComponents.components.push_back(c.get());
+		if (!threadSafe)
+		{
+			++phaseComponents.threadUnsafeCount;
+		}
+	}
 	CALL_LISTENERS(onComponentAdded(this, c.get()));
 }
 
 void Entity::removeComponent(const ComponentPtr& c)
 {
 	CALL_LISTENERS(onComponentRemove(this, c.get()));
+	bool threadSafe = c->isThreadSafePerEntity();
+	for (PhaseComponents& phaseComponents : mPhaseComponents)
+	{
+		auto it = std::find(phaseComponents.components.begin(), phaseComponents.components.end(), c.get());
+		if (it != phaseComponents.components.end())
+		{
+			if (mUpdateDepth > 0)
+			{
+				// Null the entry rather than erasing it so that indices of the update loop in progress remain valid.
+				// Null entries are removed when the loop completes.
+				*it = nullptr;
+			}
+			else
+			{
+				phaseComponents.components.erase(it);
+			}
+			if (!threadSafe)
+			{
+				--phaseComponents.threadUnsafeCount;
+			}
+		}
+	}
+	if (mUpdateDepth > 0)
+	{
+		// Keep the component alive in case it removed itself from within its own update
+		mComponentsRemovedDuringUpdate.push_back(c);
+	}
 	mComponents.removeItem(c);
 }
 
+void Entity::removeNullPhaseComponents()
+{
+	for (PhaseComponents& phaseComponents : mPhaseComponents)
+	{
+		auto& components = phaseComponents.components;
+		components.erase(std::remove(components.begin(), components.end(), nullptr), components.end());
+	}
+	mComponentsRemovedDuringUpdate.clear();
+}
+
+template <typename Callback>
+void Entity::forEachComponentInPhase(UpdatePhase phase, const Callback& callback)
+{
+	// A component may add or remove components during its update. Rather than copying the component list every update,
+	// we iterate by index and removeComponent() nulls entries while an update is in progress. Components added during the update
+	// are updated from the next update onwards.
+	struct UpdateDepthGuard
+	{
+		UpdateDepthGuard(Entity& entity) : entity(entity) { ++entity.mUpdateDepth; }
+		~UpdateDepthGuard()
+		{
+			if (--entity.mUpdateDepth == 0 && !entity.mComponentsRemovedDuringUpdate.empty())
+			{
+				entity.removeNullPhaseComponents();
+			}
+		}
+		Entity& entity;
+	} guard(*this);
+
+	const std::vector<Component*>& components = mPhaseComponents[size_t(phase)].components;
+	size_t count = components.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (Component* component = components[i])
+		{
+			callback(*component);
+		}
+	}
+}
+
 void Entity::updatePreDynamics(TimeReal dt, TimeReal dtWallClock)
 {
-	for (const ComponentPtr& c : mComponents.getAllItems())
-		c->updatePreDynamics(dt, dtWallClock);
+	forEachComponentInPhase(UpdatePhase::PreDynamics, [&] (Component& c) { c.updatePreDynamics(dt, dtWallClock); });
 }
 
 void Entity::updatePreDynamicsSubstep(TimeReal dtSubstep)
 {
-	for(const ComponentPtr& c : mComponents.getAllItems())
-		c->updatePreDynamicsSubstep(dtSubstep);
+	forEachComponentInPhase(UpdatePhase::PreDynamicsSubstep, [&] (Component& c) { c.updatePreDynamicsSubstep(dtSubstep); });
 }
 
 void Entity::updatePostDynamics()
 {
-	for (const ComponentPtr& c : mComponents.getAllItems())
-		c->updatePostDynamics();
+	forEachComponentInPhase(UpdatePhase::PostDynamics, [&] (Component& c) { c.updatePostDynamics(); });
 }
 
 void Entity::updateAttachments(TimeReal dt, TimeReal dtWallClock)
 {
-	for (const ComponentPtr& c : mComponents.getAllItems())
-		c->updateAttachments(dt, dtWallClock);
+	forEachComponentInPhase(UpdatePhase::Attachments, [&] (Component& c) { c.updateAttachments(dt, dtWallClock); });
 }
 
 void Entity::setDynamicsEnabled(bool enabled)
@@ -66,7 +141,9 @@ void Entity::setDynamicsEnabled(bool enabled)
 	{
 		mDynamicsEnabled = enabled;
 
-		for (const ComponentPtr& c : mComponents.getAllItems())
+		// Copy the list because a component may add or remove components when its dynamics are toggled
+		std::vector<ComponentPtr> components = mComponents.getAllItems();
+		for (const ComponentPtr& c : components)
 			c->setDynamicsEnabled(enabled);
 	}
 }
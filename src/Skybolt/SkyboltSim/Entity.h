@@ -14,6 +14,7 @@
 #include <SkyboltCommon/TypedItemContainer.h>
 
 #include <boost/optional.hpp>
+#include <array>
 
 namespace skybolt {
 namespace sim {
@@ -40,6 +41,10 @@ public:
 
 	void setDynamicsEnabled(bool enabled);
 	bool isDynamicsEnabled() const { return mDynamicsEnabled; }
+
+	//! @returns true if all components registered for the phase are thread safe per entity,
+	//! in which case the entity may be updated in that phase concurrently with other entities.
+	bool isThreadSafePerEntity(UpdatePhase phase) const { return mPhaseComponents[size_t(phase)].threadUnsafeCount == 0; }
 
 	void addComponent(const ComponentPtr& c);
 	void removeComponent(const ComponentPtr& c);
@@ -50,7 +55,8 @@ public:
 		return mComponents.getItemsOfType<DerivedT>();
 	}
 
-	std::vector<ComponentPtr> getComponents() const
+	//! The returned reference is invalidated if components are added or removed
+	const std::vector<ComponentPtr>& getComponents() const
 	{
 		return mComponents.getAllItems();
 	}
@@ -72,9 +78,25 @@ public:
 		return component;
 	}
 
+private:
+	template <typename Callback>
+	void forEachComponentInPhase(UpdatePhase phase, const Callback& callback);
+
+	void removeNullPhaseComponents();
+
 private:
 	TypedItemContainer<Component> mComponents;
 	bool mDynamicsEnabled = true;
+
+	struct PhaseComponents
+	{
+		std::vector<Component*> components; //!< Components registered for the phase, in the order they were added
+		int threadUnsafeCount = 0;
+	};
+	std::array<PhaseComponents, updatePhaseCount> mPhaseComponents;
+
+	int mUpdateDepth = 0; //!< Number of component update loops in progress
+	std::vector<ComponentPtr> mComponentsRemovedDuringUpdate; //!< Kept alive until the update loops complete
 };
 
 boost::optional<Vector3> getPosition(const Entity& entity);
@@ -0,0 +1,171 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "EntityGroup.h"
+#include "Entity.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <limits>
+
+namespace skybolt {
+namespace sim {
+
+static void writeNan(double* out, int count)
+{
+	std::fill(out, out + count, std::numeric_limits<double>::quiet_NaN());
+}
+
+static void writeVector3(double* out, const Vector3& v)
+{
+	out[0] = v.x;
+	out[1] = v.y;
+	out[2] = v.z;
+}
+
+static Vector3 readVector3(const double* in)
+{
+	return Vector3(in[0], in[1], in[2]);
+}
+
+EntityGroup::EntityGroup(const World* world) :
+	mWorld(world)
+{
+	assert(mWorld);
+}
+
+bool EntityGroup::add(const Entity* entity)
+{
+	assert(entity);
+	EntityId id = mWorld->getEntityId(entity);
+	if (id == nullEntityId)
+	{
+		return false;
+	}
+	mEntityIds.push_back(id);
+	return true;
+}
+
+bool EntityGroup::remove(const Entity* entity)
+{
+	return remove(mWorld->getEntityId(entity));
+}
+
+bool EntityGroup::remove(EntityId id)
+{
+	auto i = std::find(mEntityIds.begin(), mEntityIds.end(), id);
+	if (i != mEntityIds.end())
+	{
+		mEntityIds.erase(i);
+		return true;
+	}
+	return false;
+}
+
+std::vector<EntityPtr> EntityGroup::getEntities() const
+{
+	std::vector<EntityPtr> result;
+	result.reserve(mEntityIds.size());
+	for (EntityId id : mEntityIds)
+	{
+		result.push_back(mWorld->getEntityById(id));
+	}
+	return result;
+}
+
+template <typename Function>
+void EntityGroup::forEachRow(const Function& function) const
+{
+	for (EntityId id : mEntityIds)
+	{
+		EntityPtr entity = mWorld->getEntityById(id);
+		function(entity.get());
+	}
+}
+
+void EntityGroup::getPositions(double* out) const
+{
+	forEachRow([&] (const Entity* entity) {
+		if (auto position = entity ? getPosition(*entity) : boost::none)
+		{
+			writeVector3(out, *position);
+		}
+		else
+		{
+			writeNan(out, vector3Stride);
+		}
+		out += vector3Stride;
+	});
+}
+
+void EntityGroup::getOrientations(double* out) const
+{
+	forEachRow([&] (const Entity* entity) {
+		if (auto orientation = entity ? getOrientation(*entity) : boost::none)
+		{
+			out[0] = orientation->x;
+			out[1] = orientation->y;
+			out[2] = orientation->z;
+			out[3] = orientation->w;
+		}
+		else
+		{
+			writeNan(out, quaternionStride);
+		}
+		out += quaternionStride;
+	});
+}
+
+void EntityGroup::getVelocities(double* out) const
+{
+	forEachRow([&] (const Entity* entity) {
+		if (auto velocity = entity ? getVelocity(*entity) : boost::none)
+		{
+			writeVector3(out, *velocity);
+		}
+		else
+		{
+			writeNan(out, vector3Stride);
+		}
+		out += vector3Stride;
+	});
+}
+
+void EntityGroup::setPositions(const double* in) const
+{
+	forEachRow([&] (Entity* entity) {
+		if (entity)
+		{
+			setPosition(*entity, readVector3(in));
+		}
+		in += vector3Stride;
+	});
+}
+
+void EntityGroup::setOrientations(const double* in) const
+{
+	forEachRow([&] (Entity* entity) {
+		if (entity)
+		{
+			setOrientation(*entity, Quaternion(in[3], in[0], in[1], in[2]));
+		}
+		in += quaternionStride;
+	});
+}
+
+void EntityGroup::setVelocities(const double* in) const
+{
+	forEachRow([&] (Entity* entity) {
+		if (entity)
+		{
+			setVelocity(*entity, readVector3(in));
+		}
+		in += vector3Stride;
+	});
+}
+
+} // namespace sim
+} // namespace skybolt
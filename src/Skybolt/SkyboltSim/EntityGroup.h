@@ -0,0 +1,71 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "SkyboltSimFwd.h"
+#include "World.h"
+#include <vector>
+
+namespace skybolt {
+namespace sim {
+
+//! An ordered set of entities whose kinematic state can be read and written in bulk.
+//! State is packed into contiguous arrays of doubles, with one row per entity in the order entities were added.
+//! This avoids the overhead of accessing each entity individually from scripting languages.
+//! Entities are referenced by ID and resolved through the world, so the group remains safe to use after its entities are
+//! removed from the world. Rows of removed entities are treated as rows of entities without state.
+class EntityGroup
+{
+public:
+	static constexpr int vector3Stride = 3; //!< x, y, z
+	static constexpr int quaternionStride = 4; //!< x, y, z, w
+
+	//! @param world must outlive the group
+	explicit EntityGroup(const World* world);
+
+	//! @returns false if the entity is not in the world, in which case it is not added
+	bool add(const Entity* entity);
+
+	//! @returns true if the entity was in the group
+	bool remove(const Entity* entity);
+
+	//! Removes by ID, which also works for entities that have been removed from the world
+	//! @returns true if the entity was in the group
+	bool remove(EntityId id);
+
+	void clear() { mEntityIds.clear(); }
+
+	size_t size() const { return mEntityIds.size(); }
+	const std::vector<EntityId>& getEntityIds() const { return mEntityIds; }
+
+	//! @returns one item per row. Items are null for entities which have been removed from the world.
+	std::vector<EntityPtr> getEntities() const;
+
+	//! Array getters write size() rows to the output array.
+	//! Rows for entities without the required component, or which have been removed from the world, are filled with NaN.
+	void getPositions(double* out) const;
+	void getOrientations(double* out) const;
+	void getVelocities(double* out) const;
+
+	//! Array setters read size() rows from the input array.
+	//! Rows for entities without the required component, or which have been removed from the world, are ignored.
+	void setPositions(const double* in) const;
+	void setOrientations(const double* in) const;
+	void setVelocities(const double* in) const;
+
+private:
+	//! Calls the function with the entity of each row, or null if the entity has been removed from the world
+	template <typename Function>
+	void forEachRow(const Function& function) const;
+
+private:
+	const World* mWorld;
+	std::vector<EntityId> mEntityIds;
+};
+
+} // namespace sim
+} // namespace skybolt
@@ -8,6 +8,7 @@
 
 #include <SkyboltSim/Spatial/LatLon.h>
 #include <boost/optional.hpp>
+#include <vector>
 
 namespace skybolt {
 namespace sim {
@@ -15,13 +16,29 @@ namespace sim {
 class PlanetAltitudeProvider
 {
 public:
+	virtual ~PlanetAltitudeProvider() = default;
+
 	//! Get altitude above sea level, positive is up.
 	virtual double getAltitude(const sim::LatLon& position) const = 0;
+
+	//! Get altitudes above sea level for many positions at once, positive is up.
+	//! Implementations may override this to amortize per-query costs over the batch.
+	//! @param altitudes is resized to the number of positions
+	virtual void getAltitudes(const std::vector<sim::LatLon>& positions, std::vector<double>& altitudes) const
+	{
+		altitudes.resize(positions.size());
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			altitudes[i] = getAltitude(positions[i]);
+		}
+	}
 };
 
 class AsyncPlanetAltitudeProvider
 {
 public:
+	virtual ~AsyncPlanetAltitudeProvider() = default;
+
 	//! Get altitude above sea level, positive is up.
 	//! If tile is not immediately available, requests to load tile on a background thread
 	//! and immediately returns empty optional.
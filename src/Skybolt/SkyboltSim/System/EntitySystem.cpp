@@ -9,6 +9,9 @@
 #include "SkyboltSim/World.h"
 #include "SkyboltSim/Components/DynamicBodyComponent.h"
 
+#include <algorithm>
+#include <assert.h>
+
 namespace skybolt {
 namespace sim {
 
@@ -18,56 +21,148 @@ EntitySystem::EntitySystem(World* world) :
 	assert(mWorld);
 }
 
-void EntitySystem::updatePreDynamics(const System::StepArgs& args)
+void EntitySystem::setParallelFor(const ParallelFor& parallelFor, size_t chunkSize)
+{
+	assert(chunkSize > 0);
+	mParallelFor = parallelFor;
+	mChunkSize = chunkSize;
+}
+
+void EntitySystem::updateDynamicsEnabledEntities(UpdatePhase phase, const std::function<void(Entity&)>& update)
 {
-	// Take a copy of the entities container so that the list doesn't change during timestep,
-	// even if entities are added to or removed from the world.
-	mEntities = mWorld->getEntities();
+	if (!mParallelFor)
+	{
+		for (Entity* entity : mEntities)
+		{
+			if (entity->isDynamicsEnabled())
+			{
+				update(*entity);
+			}
+		}
+		return;
+	}
 
-	for (const EntityPtr& entity : mEntities)
+	mParallelEntities.clear();
+	mSerialEntities.clear();
+	for (Entity* entity : mEntities)
 	{
 		if (entity->isDynamicsEnabled())
 		{
-			entity->updatePreDynamics(args.dtSim, args.dtWallClock);
+			auto& entities = entity->isThreadSafePerEntity(phase) ? mParallelEntities : mSerialEntities;
+			entities.push_back(entity);
 		}
 	}
+
+	size_t chunkCount = (mParallelEntities.size() + mChunkSize - 1) / mChunkSize;
+	mParallelFor(chunkCount, [&] (size_t chunk) {
+		size_t begin = chunk * mChunkSize;
+		size_t end = std::min(begin + mChunkSize, mParallelEntities.size());
+		for (size_t i = begin; i < end; ++i)
+		{
+			update(*mParallelEntities[i]);
+		}
+	});
+
+	for (Entity* entity : mSerialEntities)
+	{
+		update(*entity);
+	}
 }
 
-void EntitySystem::updatePreDynamicsSubstep(double dtSubstep)
+void EntitySystem::endDeferredChanges()
 {
-	for (const EntityPtr& entity : mEntities)
+	if (mDeferringChanges)
 	{
-		if (entity->isDynamicsEnabled())
+		mDeferringChanges = false;
+		mWorld->endDeferredChanges();
+	}
+}
+
+void EntitySystem::updatePreDynamics(const System::StepArgs& args)
+{
+	// End deferral left over from a step which was aborted by an exception thrown by another system
+	endDeferredChanges();
+
+	// Defer entity removals until the end of the step so that the entity snapshot stays valid,
+	// even if entities are removed from the world during the step.
+	mWorld->beginDeferredChanges();
+	mDeferringChanges = true;
+
+	try
+	{
+		if (mEntitiesGeneration != mWorld->getGeneration())
 		{
-			entity->updatePreDynamicsSubstep(dtSubstep);
+			mEntitiesGeneration = mWorld->getGeneration();
+			mEntities.clear();
+			for (const EntityPtr& entity : mWorld->getEntities())
+			{
+				mEntities.push_back(entity.get());
+			}
+		}
+
+		updateDynamicsEnabledEntities(UpdatePhase::PreDynamics, [&] (Entity& entity) {
+			entity.updatePreDynamics(args.dtSim, args.dtWallClock);
+		});
+	}
+	catch (...)
+	{
+		endDeferredChanges();
+		throw;
+	}
+}
+
+void EntitySystem::updatePreDynamicsSubstep(double dtSubstep)
+{
+	try
+	{
+		updateDynamicsEnabledEntities(UpdatePhase::PreDynamicsSubstep, [&] (Entity& entity) {
+			entity.updatePreDynamicsSubstep(dtSubstep);
+		});
 
-			// Apply gravity
-			auto position = getPosition(*entity);
-			auto body = entity->getFirstComponent<DynamicBodyComponent>();
-			if (body)
+		// Apply gravity
+		for (Entity* entity : mEntities)
+		{
+			if (entity->isDynamicsEnabled())
 			{
-				Vector3 force = mWorld->calcGravity(*position, body->getMass());
-				body->applyCentralForce(force);
+				auto position = getPosition(*entity);
+				auto body = entity->getFirstComponent<DynamicBodyComponent>();
+				if (body)
+				{
+					Vector3 force = mWorld->calcGravity(*position, body->getMass());
+					body->applyCentralForce(force);
+				}
 			}
 		}
 	}
+	catch (...)
+	{
+		endDeferredChanges();
+		throw;
+	}
 }
 
 void EntitySystem::updatePostDynamics(const System::StepArgs& args)
 {
-	for (const EntityPtr& entity : mEntities)
+	try
 	{
-		if (entity->isDynamicsEnabled())
+		updateDynamicsEnabledEntities(UpdatePhase::PostDynamics, [&] (Entity& entity) {
+			entity.updatePostDynamics();
+		});
+
+		for (Entity* entity : mEntities)
 		{
-			entity->updatePostDynamics();
+			entity->updateAttachments(args.dtSim, args.dtWallClock);
 		}
 	}
-	for (const EntityPtr& entity : mEntities)
+	catch (...)
 	{
-		entity->updateAttachments(args.dtSim, args.dtWallClock);
+		endDeferredChanges();
+		throw;
 	}
-	mEntities.clear(); // clear container so that ownership is not held
+
+	// Apply entity removals deferred during the step. The snapshot will be rebuilt next step if the world changed.
+	endDeferredChanges();
 }
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
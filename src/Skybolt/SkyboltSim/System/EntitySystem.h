@@ -7,25 +7,56 @@
 #pragma once
 
 #include "SkyboltSim/SkyboltSimFwd.h"
+#include "SkyboltSim/Component.h"
 #include "System.h"
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 namespace skybolt {
 namespace sim {
 
+//! Calls body(i) for each i in [0, count), possibly concurrently. Returns once all calls have completed.
+typedef std::function<void(size_t count, const std::function<void(size_t)>& body)> ParallelFor;
+
 class EntitySystem : public System
 {
 public:
 	EntitySystem(World* world);
 
+	//! Enables parallel entity updates when parallelFor is not null.
+	//! Entities which are thread safe for the phase being updated (see Entity::isThreadSafePerEntity) are updated in chunks of chunkSize using parallelFor.
+	//! Other entities, gravity and attachments are updated serially on the calling thread.
+	void setParallelFor(const ParallelFor& parallelFor, size_t chunkSize = 64);
+
 	void updatePreDynamics(const StepArgs& args) override;
 	void updatePreDynamicsSubstep(double dtSubstep) override;
 	void updatePostDynamics(const StepArgs& args) override;
 
+private:
+	//! Calls update for each entity with dynamics enabled
+	void updateDynamicsEnabledEntities(UpdatePhase phase, const std::function<void(Entity&)>& update);
+
+	//! Ends the world's deferred changes if they were begun by this system and have not yet been ended
+	void endDeferredChanges();
+
 private:
 	World* mWorld;
-	std::vector<EntityPtr> mEntities;
+
+	//! Snapshot of the world's entities, reused until the world's generation changes.
+	//! Entity removals are deferred during the step, so the pointers remain valid until updatePostDynamics completes.
+	std::vector<Entity*> mEntities;
+	std::uint64_t mEntitiesGeneration = ~std::uint64_t(0);
+
+	//! True between updatePreDynamics and updatePostDynamics, while the world's changes are deferred.
+	//! The deferral is ended early if an update throws, so that the world is not left deferring changes forever.
+	bool mDeferringChanges = false;
+
+	ParallelFor mParallelFor;
+	size_t mChunkSize = 64;
+	std::vector<Entity*> mParallelEntities; //!< Reused between updates to avoid reallocation
+	std::vector<Entity*> mSerialEntities; //!< Reused between updates to avoid reallocation
 };
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
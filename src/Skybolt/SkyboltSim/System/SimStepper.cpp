@@ -6,17 +6,20 @@
 
 #include "SimStepper.h"
 #include "SkyboltSim/System/System.h"
+#include <algorithm>
 #include <assert.h>
 
 namespace skybolt {
 namespace sim {
 
-const double SimStepper::msDynamicsStepSize = 1.0 / 60.0;
-
-SimStepper::SimStepper(const SystemRegistryPtr& systems) :
-	mSystems(systems)
+SimStepper::SimStepper(const SystemRegistryPtr& systems, const SimStepperConfig& config) :
+	mSystems(systems),
+	mConfig(config)
 {
 	assert(mSystems);
+	assert(mConfig.dynamicsStepSize > 0);
+	assert(mConfig.maxDynamicsSubsteps > 0);
+	assert(mConfig.maxCatchUpTime >= 0);
 }
 
 SimStepper::~SimStepper()
@@ -25,7 +28,9 @@ SimStepper::~SimStepper()
 
 void SimStepper::step(const System::StepArgs& args)
 {
-	auto systems = *mSystems; // Take copy in case a system adds/removes another system during step
+	// Iterate over a snapshot in case a system adds/removes another system during step
+	updateSystemsSnapshot();
+	const SystemRegistry& systems = mSystemsSnapshot;
 
 	for (const SystemPtr& system : systems)
 	{
@@ -34,46 +39,87 @@ void SimStepper::step(const System::StepArgs& args)
 
 	updateDynamicsStep(args);
 
+	System::StepArgs postDynamicsArgs = args;
+	postDynamicsArgs.interpolationAlpha = getInterpolationAlpha();
+
 	for (const SystemPtr& system : systems)
 	{
-		system->updatePostDynamics(args);
+		system->updatePostDynamics(postDynamicsArgs);
 	}
 }
 
+void SimStepper::updateSystemsSnapshot()
+{
+	// Comparing is cheaper than copying because it does not allocate or modify reference counts
+	if (mSystemsSnapshot != *mSystems)
+	{
+		mSystemsSnapshot = *mSystems;
+	}
+}
+
+double SimStepper::getInterpolationAlpha() const
+{
+	return std::min(1.0, mStepTimer / mConfig.dynamicsStepSize);
+}
+
 void SimStepper::updateDynamicsStep(const System::StepArgs& args)
 {
+	const double stepSize = mConfig.dynamicsStepSize;
+
 	// Calculate required number of substeps
 	double newStepTimer = mStepTimer + (double)args.dtSim;
 
-	int requiredSteps = int(newStepTimer / msDynamicsStepSize);
-	if (requiredSteps > msMaxDynamicsSubsteps)
+	int requiredSteps = int(newStepTimer / stepSize);
+	if (requiredSteps > mConfig.maxDynamicsSubsteps)
 	{
-		requiredSteps = msMaxDynamicsSubsteps;
-		double dt = (double)msMaxDynamicsSubsteps * msDynamicsStepSize;
-		newStepTimer = mStepTimer + dt;
+		++mStats.overrunCount;
+
+		if (mConfig.overrunPolicy == OverrunPolicy::DropTime)
+		{
+			double maxStepTimer = mStepTimer + (double)mConfig.maxDynamicsSubsteps * stepSize;
+			mStats.droppedTime += newStepTimer - maxStepTimer;
+			newStepTimer = maxStepTimer;
+			requiredSteps = mConfig.maxDynamicsSubsteps;
+		}
+		else if (mConfig.overrunPolicy == OverrunPolicy::CatchUp)
+		{
+			requiredSteps = mConfig.maxDynamicsSubsteps;
+
+			// Bound the backlog carried over to later steps
+			double maxStepTimer = requiredSteps * stepSize + mConfig.maxCatchUpTime;
+			if (newStepTimer > maxStepTimer)
+			{
+				mStats.droppedTime += newStepTimer - maxStepTimer;
+				newStepTimer = maxStepTimer;
+			}
+		}
 	}
 
-	mStepTimer = newStepTimer - requiredSteps * msDynamicsStepSize;
+	mStepTimer = newStepTimer - requiredSteps * stepSize;
+
+	++mStats.stepCount;
+	mStats.substepCount += requiredSteps;
+	mStats.pendingTime = mStepTimer;
 
 	// Perform substeps
 	for (int i = 0; i < requiredSteps; i++)
 	{
 		for (const SystemPtr& system : *mSystems)
 		{
-			system->updatePreDynamicsSubstep(msDynamicsStepSize);
+			system->updatePreDynamicsSubstep(stepSize);
 		}
 
 		for (const SystemPtr& system : *mSystems)
 		{
-			system->updateDynamicsSubstep(msDynamicsStepSize);
+			system->updateDynamicsSubstep(stepSize);
 		}
 
 		for (const SystemPtr& system : *mSystems)
 		{
-			system->updatePostDynamicsSubstep(msDynamicsStepSize);
+			system->updatePostDynamicsSubstep(stepSize);
 		}
 	}
 }
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
@@ -9,28 +9,65 @@
 #include "SkyboltSim/SkyboltSimFwd.h"
 #include "SkyboltSim/System/SystemRegistry.h"
 #include "System.h"
+#include <cstdint>
 #include <vector>
 
 namespace skybolt {
 namespace sim {
 
+//! Determines what happens when a step requires more dynamics substeps than SimStepperConfig::maxDynamicsSubsteps
+enum class OverrunPolicy
+{
+	DropTime, //!< Discard the time that could not be simulated. Simulation time falls behind the requested time.
+	CatchUp, //!< Carry the time that could not be simulated over to later steps, which catch up when load allows.
+	RunAllSubsteps //!< Ignore the limit and perform every required substep. Overruns are still counted.
+};
+
+struct SimStepperConfig
+{
+	double dynamicsStepSize = 1.0 / 60.0; //!< Fixed duration of each dynamics substep
+	int maxDynamicsSubsteps = 10; //!< Maximum dynamics substeps per step
+	OverrunPolicy overrunPolicy = OverrunPolicy::DropTime;
+	//! Maximum simulation time carried over to later steps by OverrunPolicy::CatchUp. Time beyond this is dropped,
+	//! which stops a sustained overrun from building an ever growing backlog that can never be caught up.
+	double maxCatchUpTime = 1.0;
+};
+
+struct SimStepperStats
+{
+	std::uint64_t stepCount = 0;
+	std::uint64_t substepCount = 0;
+	std::uint64_t overrunCount = 0; //!< Number of steps which required more than maxDynamicsSubsteps
+	double droppedTime = 0; //!< Total simulation time discarded due to overruns, including CatchUp backlog beyond maxCatchUpTime
+	double pendingTime = 0; //!< Simulation time accumulated but not yet simulated
+};
+
 class SimStepper
 {
 public:
-	SimStepper(const SystemRegistryPtr& systems);
+	SimStepper(const SystemRegistryPtr& systems, const SimStepperConfig& config = SimStepperConfig());
 	~SimStepper();
 
 	void step(const System::StepArgs& args);
 
+	const SimStepperConfig& getConfig() const { return mConfig; }
+	const SimStepperStats& getStats() const { return mStats; }
+
+	//! @returns fraction of a dynamics substep that has accumulated but not yet been simulated, in range [0, 1].
+	//! Can be used to interpolate between the previous and current dynamics state.
+	double getInterpolationAlpha() const;
+
 private:
+	void updateSystemsSnapshot();
 	void updateDynamicsStep(const System::StepArgs& args);
 
 private:
 	SystemRegistryPtr mSystems;
+	SystemRegistry mSystemsSnapshot; //!< Copy of mSystems, refreshed only when the registry changes
+	const SimStepperConfig mConfig;
+	SimStepperStats mStats;
 	double mStepTimer = 0;
-	static const double msDynamicsStepSize;
-	static const int msMaxDynamicsSubsteps = 10;
 };
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
@@ -18,6 +18,10 @@ public:
 	{
 		double dtSim;
 		double dtWallClock;
+
+		//! Fraction of a dynamics substep accumulated but not yet simulated, in range [0, 1].
+		//! Set by SimStepper before updatePostDynamics.
+		double interpolationAlpha = 1.0;
 	};
 
 	virtual void updatePreDynamics(const StepArgs& args) {};
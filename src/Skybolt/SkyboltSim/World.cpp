@@ -8,6 +8,9 @@
 #include "SkyboltSim/World.h"
 #include "SkyboltSim/Components/NameComponent.h"
 
+#include <algorithm>
+#include <assert.h>
+
 namespace skybolt {
 namespace sim {
 
@@ -21,6 +24,11 @@ World::~World()
 	// This could happen if an entity removes its child from the world when it is destroyed.
 	// TODO: Investigate cleaner solutions.
 	mDestructing = true;
+	for (const EntityPtr& entity : mEntities)
+	{
+		entity->removeListener(this);
+	}
+	mEntitiesById.clear();
 	mEntities.clear();
 }
 
@@ -31,7 +39,27 @@ void World::addEntity(const EntityPtr& entity)
 		return;
 	}
 
+	if (mEntityIdsByEntity.find(entity.get()) != mEntityIdsByEntity.end())
+	{
+		// Cancel deferred removal if the entity is re-added
+		mDeferredRemovals.erase(std::remove(mDeferredRemovals.begin(), mDeferredRemovals.end(), entity.get()), mDeferredRemovals.end());
+		return;
+	}
+
+	EntityId id = mNextEntityId++;
 	mEntities.push_back(entity);
+	mEntityIds.push_back(id);
+	mEntityIdsByEntity[entity.get()] = id;
+	mEntitiesById[id] = entity;
+	++mGeneration;
+
+	const std::string& name = getName(*entity);
+	if (!name.empty())
+	{
+		addToNameIndex(entity.get(), name);
+	}
+	entity->addListener(this);
+
 	CALL_LISTENERS(entityAdded(entity));
 }
 
@@ -42,24 +70,198 @@ void World::removeEntity(Entity* entity)
 		return;
 	}
 
-	auto it = std::find_if(mEntities.begin(), mEntities.end(), [entity](const EntityPtr& item) {
-		return item.get() == entity;
-	});
+	if (mDeferDepth > 0)
+	{
+		// Duplicates are harmless because removing an entity which is not in the world has no effect
+		mDeferredRemovals.push_back(entity);
+		return;
+	}
+
+	removeEntitiesNow({entity});
+}
+
+void World::removeEntitiesNow(std::vector<Entity*> entities)
+{
+	std::vector<EntityPtr> removedEntities;
 
-	if (it != mEntities.end())
+	// Defer removals requested by listeners so that they are applied in the same pass
+	++mDeferDepth;
+	try
 	{
-		EntityPtr objectPtr = *it;
-		CALL_LISTENERS(entityAboutToBeRemoved(objectPtr));
-		mEntities.erase(it);
-		CALL_LISTENERS(entityRemoved(objectPtr));
+		while (!entities.empty())
+		{
+			for (Entity* entity : entities)
+			{
+				auto it = mEntityIdsByEntity.find(entity);
+				if (it == mEntityIdsByEntity.end())
+				{
+					continue;
+				}
+
+				EntityPtr objectPtr = mEntitiesById[it->second];
+				CALL_LISTENERS(entityAboutToBeRemoved(objectPtr));
+
+				// Look up the entity again because listeners may have changed the world
+				it = mEntityIdsByEntity.find(entity);
+				if (it != mEntityIdsByEntity.end())
+				{
+					mEntitiesById.erase(it->second);
+					mEntityIdsByEntity.erase(it);
+
+					const std::string& name = getName(*objectPtr);
+					if (!name.empty())
+					{
+						removeFromNameIndex(entity, name);
+					}
+					entity->removeListener(this);
+
+					removedEntities.push_back(objectPtr);
+				}
+			}
+			entities.clear();
+			std::swap(entities, mDeferredRemovals);
+		}
+	}
+	catch (...)
+	{
+		--mDeferDepth;
+		eraseRemovedEntities();
+		throw;
+	}
+	--mDeferDepth;
+
+	if (!removedEntities.empty())
+	{
+		eraseRemovedEntities();
+		++mGeneration;
+
+		for (const EntityPtr& entity : removedEntities)
+		{
+			CALL_LISTENERS(entityRemoved(entity));
+		}
+	}
+}
+
+void World::eraseRemovedEntities()
+{
+	// Compact rather than swapping with the last entity, to preserve the order of getEntities().
+	// Entities are identified by ID rather than pointer, because a removed entity may have been re-added by a listener with a new ID.
+	size_t count = 0;
+	for (size_t i = 0; i < mEntities.size(); ++i)
+	{
+		if (mEntitiesById.find(mEntityIds[i]) != mEntitiesById.end())
+		{
+			mEntities[count] = std::move(mEntities[i]);
+			mEntityIds[count] = mEntityIds[i];
+			++count;
+		}
 	}
+	mEntities.resize(count);
+	mEntityIds.resize(count);
 }
 
 void World::removeAllEntities()
 {
+	if (mDeferDepth > 0)
+	{
+		for (const EntityPtr& entity : mEntities)
+		{
+			removeEntity(entity.get());
+		}
+		return;
+	}
+
+	// Repeat in case listeners added entities
 	while (!mEntities.empty())
 	{
-		removeEntity(mEntities.front().get());
+		std::vector<Entity*> entities;
+		entities.reserve(mEntities.size());
+		for (const EntityPtr& entity : mEntities)
+		{
+			entities.push_back(entity.get());
+		}
+		removeEntitiesNow(std::move(entities));
+	}
+}
+
+void World::beginDeferredChanges()
+{
+	++mDeferDepth;
+}
+
+void World::endDeferredChanges()
+{
+	assert(mDeferDepth > 0);
+	if (--mDeferDepth == 0)
+	{
+		std::vector<Entity*> removals;
+		std::swap(removals, mDeferredRemovals);
+		removeEntitiesNow(std::move(removals));
+	}
+}
+
+EntityId World::getEntityId(const Entity* entity) const
+{
+	auto it = mEntityIdsByEntity.find(entity);
+	return (it != mEntityIdsByEntity.end()) ? it->second : nullEntityId;
+}
+
+EntityPtr World::getEntityById(EntityId id) const
+{
+	auto it = mEntitiesById.find(id);
+	return (it != mEntitiesById.end()) ? it->second : nullptr;
+}
+
+EntityPtr World::findEntityByName(const std::string& name) const
+{
+	auto it = mEntitiesByName.find(name);
+	if (it != mEntitiesByName.end())
+	{
+		auto i = mEntityIdsByEntity.find(it->second.front());
+		if (i != mEntityIdsByEntity.end())
+		{
+			return getEntityById(i->second);
+		}
+	}
+	return nullptr;
+}
+
+void World::onComponentAdded(Entity* entity, Component* component)
+{
+	if (auto nameComponent = dynamic_cast<NameComponent*>(component); nameComponent && !nameComponent->getName().empty())
+	{
+		addToNameIndex(entity, nameComponent->getName());
+	}
+}
+
+void World::onComponentRemove(Entity* entity, Component* component)
+{
+	if (auto nameComponent = dynamic_cast<NameComponent*>(component); nameComponent && !nameComponent->getName().empty())
+	{
+		removeFromNameIndex(entity, nameComponent->getName());
+	}
+}
+
+void World::addToNameIndex(Entity* entity, const std::string& name)
+{
+	mEntitiesByName[name].push_back(entity);
+}
+
+void World::removeFromNameIndex(Entity* entity, const std::string& name)
+{
+	auto it = mEntitiesByName.find(name);
+	if (it != mEntitiesByName.end())
+	{
+		std::vector<Entity*>& entities = it->second;
+		auto i = std::find(entities.begin(), entities.end(), entity);
+		if (i != entities.end())
+		{
+			entities.erase(i);
+		}
+		if (entities.empty())
+		{
+			mEntitiesByName.erase(it);
+		}
 	}
 }
 
@@ -80,18 +282,11 @@ EntityPtr findObjectByName(const World& world, const std::string& name)
 {
 	if (!name.empty())
 	{
-		const World::Entities &entities = world.getEntities();
-		for (const EntityPtr& entity : entities)
-		{
-			if (getName(*entity) == name)
-			{
-				return entity;
-			}
-		}
+		return world.findEntityByName(name);
 	}
 
 	return nullptr;
 }
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
@@ -11,6 +11,9 @@
 #include <SkyboltCommon/Event.h>
 #include <SkyboltCommon/Listenable.h>
 
+#include <cstdint>
+#include <unordered_map>
+
 namespace skybolt {
 namespace sim {
 
@@ -24,7 +27,11 @@ public:
 	virtual void entityRemoved(const sim::EntityPtr& entity) {}
 };
 
-class World : public EventEmitter, public skybolt::Listenable<WorldListener>
+//! Identifies an entity in a World. IDs are never reused within a World.
+typedef std::uint64_t EntityId;
+constexpr EntityId nullEntityId = 0;
+
+class World : public EventEmitter, public skybolt::Listenable<WorldListener>, private EntityListener
 {
 public:
 	World();
@@ -32,19 +39,69 @@ public:
 
 	Vector3 calcGravity(const Vector3& position, double mass) const;
 
+	//! Entities are added in constant time. Adding an entity which is already in the world has no effect.
 	void addEntity(const EntityPtr& entity);
+
+	//! Removal is linear in the number of entities, because the order of getEntities() is preserved.
+	//! If changes are deferred, the removal is queued until endDeferredChanges().
 	void removeEntity(Entity* entity);
+
+	//! Removes all entities in a single pass over getEntities()
 	void removeAllEntities();
 
+	//! Defers entity removals until the matching call to endDeferredChanges(), so that entity pointers taken
+	//! before the removal remain valid until then. Calls may be nested.
+	void beginDeferredChanges();
+
+	//! Applies removals queued since the outermost call to beginDeferredChanges() in a single pass over getEntities()
+	void endDeferredChanges();
+
+	//! @returns a number which changes whenever entities are added to or removed from the world.
+	//! Can be used to determine whether a cached copy of the entity list is still valid.
+	std::uint64_t getGeneration() const { return mGeneration; }
+
 	typedef std::vector<EntityPtr> Entities;
+	//! @returns entities in the order they were added
 	inline const Entities &getEntities() const { return mEntities; }
 
+	//! @returns nullEntityId if the entity is not in the world
+	EntityId getEntityId(const Entity* entity) const;
+
+	//! @returns nullptr if not found
+	EntityPtr getEntityById(EntityId id) const;
+
+	//! @returns the first added entity with the given name, or nullptr if not found
+	EntityPtr findEntityByName(const std::string& name) const;
+
+private:
+	// EntityListener interface
+	void onComponentAdded(Entity* entity, Component* component) override;
+	void onComponentRemove(Entity* entity, Component* component) override;
+
+	//! Removes the entities with one pass over mEntities, rather than one erase per entity.
+	//! Removals requested by listeners during the call are applied in the same pass.
+	void removeEntitiesNow(std::vector<Entity*> entities);
+
+	//! Erases entities which are no longer in mEntitiesById from mEntities and mEntityIds, preserving order
+	void eraseRemovedEntities();
+
+	void addToNameIndex(Entity* entity, const std::string& name);
+	void removeFromNameIndex(Entity* entity, const std::string& name);
+
 private:
 	Entities mEntities;
+	std::vector<EntityId> mEntityIds; //!< Parallel to mEntities
+	std::unordered_map<const Entity*, EntityId> mEntityIdsByEntity;
+	std::unordered_map<EntityId, EntityPtr> mEntitiesById;
+	std::unordered_map<std::string, std::vector<Entity*>> mEntitiesByName; //!< Entities in the order they were added
+	EntityId mNextEntityId = nullEntityId + 1;
+	std::uint64_t mGeneration = 0;
+	int mDeferDepth = 0;
+	std::vector<Entity*> mDeferredRemovals;
 	bool mDestructing = false;
 };
 
 EntityPtr findObjectByName(const World& world, const std::string& name);
 
 } // namespace sim
-} // namespace skybolt
\ No newline at end of file
+} // namespace skybolt
@@ -0,0 +1,167 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/EntityGroup.h>
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/DynamicBodyComponent.h>
+#include <SkyboltSim/Components/Node.h>
+
+#include <cmath>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+class VelocityComponent : public DynamicBodyComponent
+{
+public:
+	void setLinearVelocity(const Vector3& v) override { velocity = v; }
+	Vector3 getLinearVelocity() const override { return velocity; }
+	void setAngularVelocity(const Vector3& v) override {}
+	Vector3 getAngularVelocity() const override { return Vector3(); }
+	void setMass(Real mass) override {}
+	Real getMass() const override { return 0; }
+	void setCenterOfMass(const Vector3& relPosition) override {}
+	void applyCentralForce(const Vector3& force) override {}
+	void applyForce(const Vector3& force, const Vector3& relPosition) override {}
+	void applyTorque(const Vector3& torque) override {}
+	void setCollisionsEnabled(bool enabled) override {}
+
+	Vector3 velocity = Vector3(0, 0, 0);
+};
+
+static EntityPtr createEntity(World& world, const Vector3& position)
+{
+	auto entity = std::make_shared<Entity>();
+	entity->addComponent(std::make_shared<Node>(position));
+	entity->addComponent(std::make_shared<VelocityComponent>());
+	world.addEntity(entity);
+	return entity;
+}
+
+TEST_CASE("EntityGroup reads and writes positions in entity order")
+{
+	World world;
+	EntityGroup group(&world);
+	EntityPtr a = createEntity(world, Vector3(1, 2, 3));
+	EntityPtr b = createEntity(world, Vector3(4, 5, 6));
+	group.add(a.get());
+	group.add(b.get());
+
+	std::vector<double> positions(group.size() * EntityGroup::vector3Stride);
+	group.getPositions(positions.data());
+	CHECK(positions == std::vector<double>({1, 2, 3, 4, 5, 6}));
+
+	std::vector<double> newPositions = {7, 8, 9, 10, 11, 12};
+	group.setPositions(newPositions.data());
+	CHECK(*getPosition(*a) == Vector3(7, 8, 9));
+	CHECK(*getPosition(*b) == Vector3(10, 11, 12));
+}
+
+TEST_CASE("EntityGroup reads and writes orientations as x, y, z, w")
+{
+	World world;
+	EntityGroup group(&world);
+	EntityPtr entity = createEntity(world, Vector3(0, 0, 0));
+	group.add(entity.get());
+
+	std::vector<double> orientation = {0, 0, 1, 0};
+	group.setOrientations(orientation.data());
+	CHECK(*getOrientation(*entity) == Quaternion(0, 0, 0, 1)); // Quaternion constructor takes w first
+
+	std::vector<double> result(EntityGroup::quaternionStride);
+	group.getOrientations(result.data());
+	CHECK(result == orientation);
+}
+
+TEST_CASE("EntityGroup reads and writes velocities")
+{
+	World world;
+	EntityGroup group(&world);
+	EntityPtr entity = createEntity(world, Vector3(0, 0, 0));
+	group.add(entity.get());
+
+	std::vector<double> velocity = {1, 2, 3};
+	group.setVelocities(velocity.data());
+	CHECK(*getVelocity(*entity) == Vector3(1, 2, 3));
+
+	std::vector<double> result(EntityGroup::vector3Stride);
+	group.getVelocities(result.data());
+	CHECK(result == velocity);
+}
+
+TEST_CASE("EntityGroup returns NaN for entities without state")
+{
+	World world;
+	EntityGroup group(&world);
+	auto entity = std::make_shared<Entity>();
+	world.addEntity(entity);
+	group.add(entity.get());
+
+	std::vector<double> positions(EntityGroup::vector3Stride);
+	group.getPositions(positions.data());
+	CHECK(std::isnan(positions[0]));
+
+	std::vector<double> velocities(EntityGroup::vector3Stride);
+	group.getVelocities(velocities.data());
+	CHECK(std::isnan(velocities[0]));
+
+	// Setting state of entities without state is ignored
+	group.setPositions(std::vector<double>({1, 2, 3}).data());
+}
+
+TEST_CASE("EntityGroup removes entities")
+{
+	World world;
+	EntityGroup group(&world);
+	EntityPtr a = createEntity(world, Vector3(1, 1, 1));
+	EntityPtr b = createEntity(world, Vector3(2, 2, 2));
+	group.add(a.get());
+	group.add(b.get());
+
+	CHECK(group.remove(a.get()));
+	CHECK(!group.remove(a.get()));
+	REQUIRE(group.size() == 1);
+	CHECK(group.getEntities().front() == b);
+}
+
+TEST_CASE("EntityGroup only adds entities in the world")
+{
+	World world;
+	EntityGroup group(&world);
+
+	Entity entity;
+	CHECK(!group.add(&entity));
+	CHECK(group.size() == 0);
+}
+
+TEST_CASE("EntityGroup ignores entities removed from the world")
+{
+	World world;
+	EntityGroup group(&world);
+	EntityPtr a = createEntity(world, Vector3(1, 2, 3));
+	EntityPtr b = createEntity(world, Vector3(4, 5, 6));
+	group.add(a.get());
+	group.add(b.get());
+	EntityId idA = world.getEntityId(a.get());
+
+	world.removeEntity(a.get());
+	a.reset(); // Destroy the entity
+
+	std::vector<double> positions(group.size() * EntityGroup::vector3Stride);
+	group.getPositions(positions.data());
+	CHECK(std::isnan(positions[0]));
+	CHECK(positions[3] == 4);
+
+	group.setPositions(std::vector<double>({7, 8, 9, 10, 11, 12}).data());
+	CHECK(*getPosition(*b) == Vector3(10, 11, 12));
+
+	CHECK(group.getEntities() == std::vector<EntityPtr>({nullptr, b}));
+
+	CHECK(group.remove(idA));
+	CHECK(group.size() == 1);
+}
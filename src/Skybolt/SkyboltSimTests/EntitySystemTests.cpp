@@ -0,0 +1,109 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/System/EntitySystem.h>
+#include <SkyboltSim/System/SimStepper.h>
+#include <catch2/catch.hpp>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+class UpdateCountingComponent : public Component
+{
+public:
+	UpdateCountingComponent(std::shared_ptr<int> postDynamicsCount) : mPostDynamicsCount(std::move(postDynamicsCount)) {}
+
+	void updatePostDynamics() override { ++*mPostDynamicsCount; }
+
+	std::vector<UpdatePhase> getUpdatePhases() const override { return {UpdatePhase::PostDynamics}; }
+
+private:
+	std::shared_ptr<int> mPostDynamicsCount;
+};
+
+class EntityRemovingComponent : public Component
+{
+public:
+	EntityRemovingComponent(World* world, Entity* entityToRemove) : mWorld(world), mEntityToRemove(entityToRemove) {}
+
+	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override
+	{
+		if (mEntityToRemove)
+		{
+			mWorld->removeEntity(mEntityToRemove);
+			mEntityToRemove = nullptr;
+		}
+	}
+
+	std::vector<UpdatePhase> getUpdatePhases() const override { return {UpdatePhase::PreDynamics}; }
+
+private:
+	World* mWorld;
+	Entity* mEntityToRemove;
+};
+
+class ThrowingComponent : public Component
+{
+public:
+	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override
+	{
+		throw std::runtime_error("Update failed");
+	}
+
+	std::vector<UpdatePhase> getUpdatePhases() const override { return {UpdatePhase::PreDynamics}; }
+};
+
+static System::StepArgs createStepArgs(double dt)
+{
+	System::StepArgs args;
+	args.dtSim = dt;
+	args.dtWallClock = dt;
+	return args;
+}
+
+TEST_CASE("EntitySystem defers removal of entities removed by a component during update")
+{
+	World world;
+	auto remover = std::make_shared<Entity>();
+	auto removed = std::make_shared<Entity>();
+	auto removedPostDynamicsCount = std::make_shared<int>(0);
+	removed->addComponent(std::make_shared<UpdateCountingComponent>(removedPostDynamicsCount));
+	remover->addComponent(std::make_shared<EntityRemovingComponent>(&world, removed.get()));
+
+	world.addEntity(remover);
+	world.addEntity(removed);
+	std::weak_ptr<Entity> removedWeak = removed;
+	removed.reset();
+
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({std::make_shared<EntitySystem>(&world)})));
+	stepper.step(createStepArgs(0.1));
+
+	// The removed entity is still updated in the step it was removed in, and removed at the end of the step
+	CHECK(*removedPostDynamicsCount == 1);
+	CHECK(removedWeak.expired());
+	REQUIRE(world.getEntities().size() == 1);
+	CHECK(world.getEntities()[0] == remover);
+
+	stepper.step(createStepArgs(0.1));
+	CHECK(*removedPostDynamicsCount == 1);
+}
+
+TEST_CASE("EntitySystem stops deferring changes when an update throws")
+{
+	World world;
+	auto throwing = std::make_shared<Entity>();
+	throwing->addComponent(std::make_shared<ThrowingComponent>());
+	world.addEntity(throwing);
+
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({std::make_shared<EntitySystem>(&world)})));
+	CHECK_THROWS(stepper.step(createStepArgs(0.1)));
+
+	// Removals must take effect immediately, rather than being deferred forever
+	world.removeEntity(throwing.get());
+	CHECK(world.getEntities().empty());
+}
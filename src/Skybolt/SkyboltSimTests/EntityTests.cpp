@@ -0,0 +1,123 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <SkyboltSim/Entity.h>
+#include <catch2/catch.hpp>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+class PhaseCountingComponent : public Component
+{
+public:
+	PhaseCountingComponent(const std::vector<UpdatePhase>& phases, bool threadSafe = false) :
+		mPhases(phases), mThreadSafe(threadSafe) {}
+
+	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override { ++preDynamicsCount; }
+	void updatePreDynamicsSubstep(TimeReal dtSubstep) override { ++preDynamicsSubstepCount; }
+	void updatePostDynamics() override { ++postDynamicsCount; }
+
+	std::vector<UpdatePhase> getUpdatePhases() const override { return mPhases; }
+	bool isThreadSafePerEntity() const override { return mThreadSafe; }
+
+	int preDynamicsCount = 0;
+	int preDynamicsSubstepCount = 0;
+	int postDynamicsCount = 0;
+
+private:
+	std::vector<UpdatePhase> mPhases;
+	bool mThreadSafe;
+};
+
+TEST_CASE("Entity only updates components in their registered phases")
+{
+	Entity entity;
+	auto unregistered = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>());
+	auto substepOnly = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>({UpdatePhase::PreDynamicsSubstep}));
+	entity.addComponent(unregistered);
+	entity.addComponent(substepOnly);
+
+	entity.updatePreDynamics(0.1f, 0.1f);
+	entity.updatePreDynamicsSubstep(0.1f);
+	entity.updatePostDynamics();
+
+	CHECK(unregistered->preDynamicsCount == 0);
+	CHECK(unregistered->preDynamicsSubstepCount == 0);
+	CHECK(substepOnly->preDynamicsCount == 0);
+	CHECK(substepOnly->preDynamicsSubstepCount == 1);
+	CHECK(substepOnly->postDynamicsCount == 0);
+
+	entity.removeComponent(substepOnly);
+	entity.updatePreDynamicsSubstep(0.1f);
+	CHECK(substepOnly->preDynamicsSubstepCount == 1);
+}
+
+TEST_CASE("Entity thread safety only considers components registered for the phase")
+{
+	Entity entity;
+	auto unsafeUnregistered = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>());
+	auto safeSubstep = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>({UpdatePhase::PreDynamicsSubstep}), true);
+	auto unsafePostDynamics = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>({UpdatePhase::PostDynamics}));
+	entity.addComponent(unsafeUnregistered);
+	entity.addComponent(safeSubstep);
+	entity.addComponent(unsafePostDynamics);
+
+	CHECK(entity.isThreadSafePerEntity(UpdatePhase::PreDynamicsSubstep));
+	CHECK(!entity.isThreadSafePerEntity(UpdatePhase::PostDynamics));
+
+	entity.removeComponent(unsafePostDynamics);
+	CHECK(entity.isThreadSafePerEntity(UpdatePhase::PostDynamics));
+}
+
+class RemovingComponent : public Component
+{
+public:
+	RemovingComponent(Entity* entity) : mEntity(entity) {}
+
+	void updatePreDynamics(TimeReal dt, TimeReal dtWallClock) override
+	{
+		++preDynamicsCount;
+		for (const std::weak_ptr<Component>& component : componentsToRemove)
+		{
+			mEntity->removeComponent(component.lock());
+		}
+		componentsToRemove.clear();
+	}
+
+	std::vector<UpdatePhase> getUpdatePhases() const override { return { UpdatePhase::PreDynamics }; }
+
+	std::vector<std::weak_ptr<Component>> componentsToRemove;
+	int preDynamicsCount = 0;
+
+private:
+	Entity* mEntity;
+};
+
+TEST_CASE("Entity components can remove themselves and siblings during update")
+{
+	Entity entity;
+	auto first = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>({UpdatePhase::PreDynamics}));
+	auto remover = std::make_shared<RemovingComponent>(&entity);
+	auto second = std::make_shared<PhaseCountingComponent>(std::vector<UpdatePhase>({UpdatePhase::PreDynamics}));
+	entity.addComponent(first);
+	entity.addComponent(remover);
+	entity.addComponent(second);
+
+	std::weak_ptr<RemovingComponent> weakRemover = remover;
+	remover->componentsToRemove = { first, remover };
+	remover.reset(); // Entity now holds the only reference to the remover
+
+	entity.updatePreDynamics(0.1f, 0.1f);
+	CHECK(first->preDynamicsCount == 1);
+	CHECK(second->preDynamicsCount == 1); // Not skipped by removal of earlier components
+	CHECK(weakRemover.expired()); // Released after the update completed
+	CHECK(entity.getComponents().size() == 1);
+
+	entity.updatePreDynamics(0.1f, 0.1f);
+	CHECK(first->preDynamicsCount == 1);
+	CHECK(second->preDynamicsCount == 2);
+}
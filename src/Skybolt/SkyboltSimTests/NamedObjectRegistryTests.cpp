@@ -0,0 +1,63 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltSim/Entity.h>
+#include <SkyboltSim/Components/NameComponent.h>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+TEST_CASE("NamedObjectRegistry finds objects by name")
+{
+	NamedObjectRegistry registry;
+	Entity a;
+	Entity b;
+	registry.add("a", &a);
+	registry.add("b", &b);
+
+	CHECK(registry.getObjectByName("a") == &a);
+	CHECK(registry.getObjectByName(std::string_view("b")) == &b);
+	CHECK(registry.getObjectByName("c") == nullptr);
+
+	registry.add("a", &b); // Replace
+	CHECK(registry.getObjectByName("a") == &b);
+
+	registry.remove("a");
+	CHECK(registry.getObjectByName("a") == nullptr);
+	CHECK(registry.getObjectByName("b") == &b);
+}
+
+TEST_CASE("NamedObjectRegistry creates unique names")
+{
+	NamedObjectRegistry registry;
+	Entity entity;
+
+	registry.add("Aircraft2", &entity);
+
+	CHECK(registry.createUniqueName("Aircraft") == "Aircraft1");
+	CHECK(registry.createUniqueName("Aircraft") == "Aircraft3"); // Skips existing name
+	CHECK(registry.createUniqueName("Ship") == "Ship1");
+	CHECK(registry.createUniqueName("Aircraft") == "Aircraft4");
+}
+
+TEST_CASE("Benchmark unique name creation", "[.][benchmark]")
+{
+	const int entityCount = 10000;
+
+	BENCHMARK("Name " + std::to_string(entityCount) + " entities")
+	{
+		NamedObjectRegistry registry;
+		std::vector<std::unique_ptr<Entity>> entities;
+		for (int i = 0; i < entityCount; ++i)
+		{
+			entities.push_back(std::make_unique<Entity>());
+			auto nameComponent = std::make_shared<NameComponent>(registry.createUniqueName("Aircraft"), std::shared_ptr<NamedObjectRegistry>(&registry, [] (auto) {}), entities.back().get());
+			entities.back()->addComponent(nameComponent);
+		}
+		return registry.getObjectByName("Aircraft" + std::to_string(entityCount));
+	};
+}
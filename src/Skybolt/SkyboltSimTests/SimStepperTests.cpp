@@ -0,0 +1,139 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <SkyboltSim/System/SimStepper.h>
+#include <SkyboltCommon/NumericComparison.h>
+#include <catch2/catch.hpp>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+class SubstepCountingSystem : public System
+{
+public:
+	void updateDynamicsSubstep(double dtSubstep) override
+	{
+		++substepCount;
+		totalTime += dtSubstep;
+	}
+
+	void updatePostDynamics(const StepArgs& args) override
+	{
+		interpolationAlpha = args.interpolationAlpha;
+	}
+
+	int substepCount = 0;
+	double totalTime = 0;
+	double interpolationAlpha = -1;
+};
+
+static System::StepArgs createStepArgs(double dt)
+{
+	System::StepArgs args;
+	args.dtSim = dt;
+	args.dtWallClock = dt;
+	return args;
+}
+
+TEST_CASE("SimStepper performs fixed size substeps and reports interpolation alpha")
+{
+	auto system = std::make_shared<SubstepCountingSystem>();
+	SimStepperConfig config;
+	config.dynamicsStepSize = 0.01;
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({system})), config);
+
+	stepper.step(createStepArgs(0.025));
+	CHECK(system->substepCount == 2);
+	CHECK(almostEqual(0.5, stepper.getInterpolationAlpha(), 1e-6));
+	CHECK(almostEqual(0.5, system->interpolationAlpha, 1e-6));
+
+	stepper.step(createStepArgs(0.005));
+	CHECK(system->substepCount == 3);
+	CHECK(almostEqual(0.0, stepper.getInterpolationAlpha(), 1e-6));
+	CHECK(stepper.getStats().overrunCount == 0);
+}
+
+TEST_CASE("SimStepper drops time on overrun")
+{
+	auto system = std::make_shared<SubstepCountingSystem>();
+	SimStepperConfig config;
+	config.dynamicsStepSize = 0.01;
+	config.maxDynamicsSubsteps = 2;
+	config.overrunPolicy = OverrunPolicy::DropTime;
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({system})), config);
+
+	stepper.step(createStepArgs(0.05));
+	CHECK(system->substepCount == 2);
+	CHECK(stepper.getStats().overrunCount == 1);
+	CHECK(almostEqual(0.03, stepper.getStats().droppedTime, 1e-6));
+
+	stepper.step(createStepArgs(0.0));
+	CHECK(system->substepCount == 2);
+}
+
+TEST_CASE("SimStepper catches up on overrun")
+{
+	auto system = std::make_shared<SubstepCountingSystem>();
+	SimStepperConfig config;
+	config.dynamicsStepSize = 0.01;
+	config.maxDynamicsSubsteps = 2;
+	config.overrunPolicy = OverrunPolicy::CatchUp;
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({system})), config);
+
+	stepper.step(createStepArgs(0.05));
+	CHECK(system->substepCount == 2);
+	CHECK(stepper.getStats().overrunCount == 1);
+	CHECK(stepper.getStats().droppedTime == 0.0);
+	CHECK(almostEqual(1.0, stepper.getInterpolationAlpha(), 1e-6));
+
+	stepper.step(createStepArgs(0.0));
+	stepper.step(createStepArgs(0.0));
+	CHECK(system->substepCount == 5);
+	CHECK(almostEqual(0.05, system->totalTime, 1e-6));
+}
+
+TEST_CASE("SimStepper drops catch up time beyond maxCatchUpTime")
+{
+	auto system = std::make_shared<SubstepCountingSystem>();
+	SimStepperConfig config;
+	config.dynamicsStepSize = 0.01;
+	config.maxDynamicsSubsteps = 2;
+	config.overrunPolicy = OverrunPolicy::CatchUp;
+	config.maxCatchUpTime = 0.03;
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({system})), config);
+
+	// Sustained overrun. Backlog must stay bounded rather than grow every step.
+	for (int i = 0; i < 10; ++i)
+	{
+		stepper.step(createStepArgs(0.1));
+		CHECK(stepper.getStats().pendingTime <= config.maxCatchUpTime + 1e-9);
+	}
+	CHECK(system->substepCount == 20);
+	CHECK(almostEqual(0.03, stepper.getStats().pendingTime, 1e-6));
+	CHECK(almostEqual(1.0 - 0.2 - 0.03, stepper.getStats().droppedTime, 1e-6));
+
+	// Once load drops, only the bounded backlog is caught up
+	stepper.step(createStepArgs(0.0));
+	stepper.step(createStepArgs(0.0));
+	CHECK(system->substepCount == 23);
+	CHECK(almostEqual(0.23, system->totalTime, 1e-6));
+	CHECK(stepper.getStats().pendingTime < config.dynamicsStepSize);
+}
+
+TEST_CASE("SimStepper runs all substeps on overrun")
+{
+	auto system = std::make_shared<SubstepCountingSystem>();
+	SimStepperConfig config;
+	config.dynamicsStepSize = 0.01;
+	config.maxDynamicsSubsteps = 2;
+	config.overrunPolicy = OverrunPolicy::RunAllSubsteps;
+	SimStepper stepper(std::make_shared<SystemRegistry>(SystemRegistry({system})), config);
+
+	stepper.step(createStepArgs(0.05));
+	CHECK(system->substepCount == 5);
+	CHECK(stepper.getStats().overrunCount == 1);
+}
@@ -0,0 +1,183 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Components/NameComponent.h>
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+static EntityPtr createNamedEntity(const std::string& name, const NamedObjectRegistryPtr& registry)
+{
+	auto entity = std::make_shared<Entity>();
+	entity->addComponent(std::make_shared<NameComponent>(name, registry, entity.get()));
+	return entity;
+}
+
+TEST_CASE("World add and remove entities")
+{
+	World world;
+	auto a = std::make_shared<Entity>();
+	auto b = std::make_shared<Entity>();
+	auto c = std::make_shared<Entity>();
+	world.addEntity(a);
+	world.addEntity(b);
+	world.addEntity(c);
+	world.addEntity(a); // adding twice has no effect
+	CHECK(world.getEntities().size() == 3);
+
+	EntityId idA = world.getEntityId(a.get());
+	EntityId idC = world.getEntityId(c.get());
+	CHECK(idA != nullEntityId);
+	CHECK(idA != idC);
+
+	world.removeEntity(a.get());
+	REQUIRE(world.getEntities().size() == 2);
+	CHECK(world.getEntities() == World::Entities({b, c})); // Order is preserved
+	CHECK(world.getEntityId(a.get()) == nullEntityId);
+	CHECK(world.getEntityById(idA) == nullptr);
+	CHECK(world.getEntityById(idC) == c);
+	CHECK(world.getEntityId(c.get()) == idC);
+
+	world.removeAllEntities();
+	CHECK(world.getEntities().empty());
+	CHECK(world.getEntityById(idC) == nullptr);
+}
+
+class RemovalRecorder : public WorldListener
+{
+public:
+	void entityRemoved(const sim::EntityPtr& entity) override { removed.push_back(entity); }
+
+	World::Entities removed;
+};
+
+TEST_CASE("World removes all entities in the order they were added")
+{
+	World world;
+	auto a = std::make_shared<Entity>();
+	auto b = std::make_shared<Entity>();
+	auto c = std::make_shared<Entity>();
+	world.addEntity(a);
+	world.addEntity(b);
+	world.addEntity(c);
+
+	world.removeEntity(b.get());
+	world.addEntity(b);
+	CHECK(world.getEntities() == World::Entities({a, c, b}));
+
+	RemovalRecorder recorder;
+	world.addListener(&recorder);
+	world.removeAllEntities();
+	world.removeListener(&recorder);
+
+	CHECK(recorder.removed == World::Entities({a, c, b}));
+}
+
+class DependentRemover : public WorldListener
+{
+public:
+	DependentRemover(World* world, Entity* entity, Entity* dependent) : world(world), entity(entity), dependent(dependent) {}
+
+	void entityAboutToBeRemoved(const sim::EntityPtr& e) override
+	{
+		if (e.get() == entity)
+		{
+			world->removeEntity(dependent);
+		}
+	}
+
+	void entityRemoved(const sim::EntityPtr& e) override
+	{
+		CHECK(std::find(world->getEntities().begin(), world->getEntities().end(), e) == world->getEntities().end());
+	}
+
+	World* world;
+	Entity* entity;
+	Entity* dependent;
+};
+
+TEST_CASE("World applies removals requested by listeners during deferred removal")
+{
+	World world;
+	auto a = std::make_shared<Entity>();
+	auto b = std::make_shared<Entity>();
+	auto c = std::make_shared<Entity>();
+	auto d = std::make_shared<Entity>();
+	world.addEntity(a);
+	world.addEntity(b);
+	world.addEntity(c);
+	world.addEntity(d);
+
+	DependentRemover remover(&world, a.get(), c.get());
+	world.addListener(&remover);
+
+	world.beginDeferredChanges();
+	world.removeEntity(a.get());
+	world.endDeferredChanges();
+
+	CHECK(world.getEntities() == World::Entities({b, d}));
+	CHECK(world.getEntityId(c.get()) == nullEntityId);
+	world.removeListener(&remover);
+}
+
+TEST_CASE("World find entity by name")
+{
+	auto registry = std::make_shared<NamedObjectRegistry>();
+	World world;
+	auto a = createNamedEntity("a", registry);
+	auto b = createNamedEntity("b", registry);
+	world.addEntity(a);
+	world.addEntity(b);
+
+	CHECK(findObjectByName(world, "a") == a);
+	CHECK(findObjectByName(world, "b") == b);
+	CHECK(findObjectByName(world, "c") == nullptr);
+	CHECK(findObjectByName(world, "") == nullptr);
+
+	world.removeEntity(a.get());
+	CHECK(findObjectByName(world, "a") == nullptr);
+	CHECK(findObjectByName(world, "b") == b);
+
+	// Name added after entity was added to world
+	auto c = std::make_shared<Entity>();
+	world.addEntity(c);
+	auto nameComponent = std::make_shared<NameComponent>("c", registry, c.get());
+	c->addComponent(nameComponent);
+	CHECK(findObjectByName(world, "c") == c);
+
+	c->removeComponent(nameComponent);
+	CHECK(findObjectByName(world, "c") == nullptr);
+}
+
+
+TEST_CASE("World defers entity removal until deferred changes end")
+{
+	World world;
+	auto a = std::make_shared<Entity>();
+	auto b = std::make_shared<Entity>();
+	world.addEntity(a);
+	world.addEntity(b);
+	std::uint64_t generation = world.getGeneration();
+
+	world.beginDeferredChanges();
+	world.removeEntity(a.get());
+	CHECK(world.getEntities().size() == 2);
+	CHECK(world.getGeneration() == generation);
+
+	// Adding an entity pending removal cancels the removal
+	world.removeEntity(b.get());
+	world.addEntity(b);
+
+	world.endDeferredChanges();
+	REQUIRE(world.getEntities().size() == 1);
+	CHECK(world.getEntities().front() == b);
+	CHECK(world.getGeneration() != generation);
+}
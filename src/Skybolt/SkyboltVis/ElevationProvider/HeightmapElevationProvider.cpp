@@ -49,5 +49,39 @@ float HeightmapElevationProvider::get(float x, float y) const
 	return heightmapValueToFloat(skybolt::math::lerp(d0, d1, fracV));
 }
 
+void HeightmapElevationProvider::get(const float* x, const float* y, float* result, size_t count) const
+{
+	const int width = image->s();
+	const int sMax = width - 1;
+	const int tMax = image->t() - 1;
+	const float offsetX = offset.x();
+	const float offsetY = offset.y();
+	const float scaleX = scale.x();
+	const float scaleY = scale.y();
+	const uint16_t* ptr = (const uint16_t*)image->getDataPointer();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float u = skybolt::math::clamp((y[i] - offsetX) * scaleX, 0.0f, float(sMax));
+		float v = skybolt::math::clamp((x[i] - offsetY) * scaleY, 0.0f, float(tMax));
+
+		int u0 = (int)u;
+		int u1 = std::min(u0 + 1, sMax);
+		int v0 = (int)v;
+		int v1 = std::min(v0 + 1, tMax);
+
+		float fracU = u - u0;
+		float fracV = v - v0;
+
+		const uint16_t* row0 = ptr + width * v0;
+		const uint16_t* row1 = ptr + width * v1;
+
+		float d0 = skybolt::math::lerp(float(row0[u0]), float(row0[u1]), fracU);
+		float d1 = skybolt::math::lerp(float(row1[u0]), float(row1[u1]), fracU);
+
+		result[i] = heightmapValueToFloat(skybolt::math::lerp(d0, d1, fracV));
+	}
+}
+
 } // namespace vis
 } // namespace skybolt
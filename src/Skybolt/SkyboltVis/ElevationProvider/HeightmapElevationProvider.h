@@ -33,6 +33,12 @@ public:
 	//! @param y is longitude in radians
 	float get(float x, float y) const;
 
+	//! Samples count points. Equivalent to calling get() for each point, but avoids per-point overhead.
+	//! @param x is array of latitudes in radians
+	//! @param y is array of longitudes in radians
+	//! @param result is array of count elevations to write to
+	void get(const float* x, const float* y, float* result, size_t count) const;
+
 private:
 	osg::ref_ptr<const osg::Image> image;
 	const osg::Vec2f offset;
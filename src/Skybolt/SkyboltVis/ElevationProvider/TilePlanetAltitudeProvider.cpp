@@ -11,6 +11,9 @@
 #include "SkyboltVis/GeoImageHelpers.h"
 #include <SkyboltSim/Spatial/GreatCircle.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace skybolt {
 namespace vis {
 
@@ -19,10 +22,12 @@ static vis::Box2f toBox2f(const TilePlanetAltitudeProvider::LatLonBounds& b)
 	return vis::Box2f(osg::Vec2f(b.minimum.x(), b.minimum.y()), osg::Vec2f(b.maximum.x(), b.maximum.y()));
 }
 
-TilePlanetAltitudeProvider::TilePlanetAltitudeProvider(const TileSourcePtr& tileSource, int maxLod) :
+TilePlanetAltitudeProvider::TilePlanetAltitudeProvider(const TileSourcePtr& tileSource, int maxLod, size_t cacheCapacityBytes) :
 	mTileSource(tileSource),
 	mMaxLod(maxLod),
-	mTileImageCache(1024)
+	mTileImageCache(cacheCapacityBytes, [](const TileImage& tile) {
+		return size_t(tile.image ? tile.image->getTotalSizeInBytes() : 0);
+	})
 {
 	assert(mTileSource);
 }
@@ -40,17 +45,70 @@ double TilePlanetAltitudeProvider::getAltitude(const sim::LatLon& position) cons
 	return -provider.get(position.lat, position.lon);
 }
 
+void TilePlanetAltitudeProvider::getAltitudes(const std::vector<sim::LatLon>& positions, std::vector<double>& altitudes) const
+{
+	altitudes.resize(positions.size());
+
+	// Sort position indices by tile so that positions in the same tile are contiguous
+	std::vector<std::pair<QuadTreeTileKey, size_t>> keyIndices(positions.size());
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		keyIndices[i] = std::make_pair(getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(positions[i])), i);
+	}
+	std::sort(keyIndices.begin(), keyIndices.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::vector<float> lats;
+	std::vector<float> lons;
+	std::vector<float> elevations;
+
+	// Sample each group of positions sharing the same tile
+	for (size_t begin = 0; begin < keyIndices.size();)
+	{
+		size_t end = begin + 1;
+		while (end < keyIndices.size() && keyIndices[end].first == keyIndices[begin].first)
+		{
+			++end;
+		}
+
+		boost::optional<TileImage> tile = findHighestLodTile(keyIndices[begin].first);
+		if (!tile)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				altitudes[keyIndices[i].second] = 0.0;
+			}
+			begin = end;
+			continue;
+		}
+
+		size_t count = end - begin;
+		lats.resize(count);
+		lons.resize(count);
+		elevations.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const sim::LatLon& position = positions[keyIndices[begin + i].second];
+			lats[i] = position.lat;
+			lons[i] = position.lon;
+		}
+
+		vis::HeightmapElevationProvider provider(tile->image, toBox2f(getKeyLatLonBounds<LatLonVec2Adapter>(tile->key)));
+		provider.get(lats.data(), lons.data(), elevations.data(), count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			altitudes[keyIndices[begin + i].second] = -elevations[i];
+		}
+		begin = end;
+	}
+}
+
 boost::optional<double> TilePlanetAltitudeProvider::tryGetAltitude(const sim::LatLon& position) const
 {
 	QuadTreeTileKey highestLodKey = getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(position));
 
 	TileImage result;
-	bool success;
-	{
-		std::scoped_lock<std::mutex> lock(mTileImageCacheMutex);
-		success = mTileImageCache.get(highestLodKey, result);
-	}
-	if (success)
+	if (mTileImageCache.get(highestLodKey, result))
 	{
 		vis::HeightmapElevationProvider provider(result.image, toBox2f(getKeyLatLonBounds<LatLonVec2Adapter>(result.key)));
 		return -provider.get(position.lat, position.lon);
@@ -63,12 +121,9 @@ boost::optional<TilePlanetAltitudeProvider::TileImage> TilePlanetAltitudeProvide
 {
 	// If tile image exists in the cache, use it
 	TileImage result;
+	if (mTileImageCache.get(highestLodKey, result))
 	{
-		std::scoped_lock<std::mutex> lock(mTileImageCacheMutex);
-		if (mTileImageCache.get(highestLodKey, result))
-		{
-			return result;
-		}
+		return result;
 	}
 
 	int level = highestLodKey.level;
@@ -84,16 +139,13 @@ boost::optional<TilePlanetAltitudeProvider::TileImage> TilePlanetAltitudeProvide
 			result.key = key;
 
 			// Add to cache at highest LOD level
+			mTileImageCache.putSafe(highestLodKey, result);
+
+			// Add to cache at lower LOD level so if the highest level has a cache miss
+			// we can still potentially avoid reloading the image
+			if (level != highestLodKey.level)
 			{
-				std::scoped_lock<std::mutex> lock(mTileImageCacheMutex);
-				mTileImageCache.putSafe(highestLodKey, result);
-
-				// Add to cache at lower LOD level so if the highest level has a cache miss
-				// we can still potentially avoid reloading the image
-				if (level != highestLodKey.level)
-				{
-					mTileImageCache.putSafe(key, result);
-				}
+				mTileImageCache.putSafe(key, result);
 			}
 
 			return result;
@@ -105,11 +157,24 @@ boost::optional<TilePlanetAltitudeProvider::TileImage> TilePlanetAltitudeProvide
 	return boost::none;
 }
 
-TileAsyncPlanetAltitudeProvider::TileAsyncPlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod) :
+TileAsyncPlanetAltitudeProvider::TileAsyncPlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod, size_t cacheCapacityBytes, int maxConcurrentLoads) :
 	mScheduler(scheduler),
-	mProvider(std::make_unique<TilePlanetAltitudeProvider>(tileSource, maxLod))
+	mProvider(std::make_unique<TilePlanetAltitudeProvider>(tileSource, maxLod, cacheCapacityBytes)),
+	mMaxLod(maxLod),
+	mMaxConcurrentLoads(maxConcurrentLoads)
 {
 	assert(mScheduler);
+	assert(mMaxConcurrentLoads > 0);
+}
+
+TileAsyncPlanetAltitudeProvider::~TileAsyncPlanetAltitudeProvider()
+{
+	{
+		// Stop queued loads from starting
+		std::scoped_lock<std::mutex> lock(mPendingLoadsMutex);
+		mShuttingDown = true;
+	}
+	mScheduler->waitFor(mLoadingTaskSync);
 }
 
 boost::optional<double> TileAsyncPlanetAltitudeProvider::getAltitudeOrRequestLoad(const sim::LatLon& position) const
@@ -117,14 +182,120 @@ boost::optional<double> TileAsyncPlanetAltitudeProvider::getAltitudeOrRequestLoa
 	auto result = mProvider->tryGetAltitude(position);
 	if (!result)
 	{
-		if (mScheduler->hasFinished(mLoadingTaskSync))
+		requestLoad(position, nullptr);
+	}
+	return result;
+}
+
+void TileAsyncPlanetAltitudeProvider::requestAltitude(const sim::LatLon& position, const AltitudeCallback& callback) const
+{
+	auto result = mProvider->tryGetAltitude(position);
+	if (result)
+	{
+		callback(*result);
+	}
+	else
+	{
+		requestLoad(position, callback);
+	}
+}
+
+void TileAsyncPlanetAltitudeProvider::setPriorityOrigin(const sim::LatLon& origin)
+{
+	std::scoped_lock<std::mutex> lock(mPendingLoadsMutex);
+	mPriorityOrigin = origin;
+}
+
+size_t TileAsyncPlanetAltitudeProvider::getPendingLoadCount() const
+{
+	std::scoped_lock<std::mutex> lock(mPendingLoadsMutex);
+	return mPendingLoads.size();
+}
+
+void TileAsyncPlanetAltitudeProvider::requestLoad(const sim::LatLon& position, const AltitudeCallback& callback) const
+{
+	QuadTreeTileKey key = getKeyAtLevelIntersectingLonLatPoint(mMaxLod, LatLonVec2Adapter(position));
+
+	std::scoped_lock<std::mutex> lock(mPendingLoadsMutex);
+	auto [it, inserted] = mPendingLoads.try_emplace(key);
+	if (inserted)
+	{
+		it->second.position = position;
+	}
+	if (callback)
+	{
+		it->second.callbacks.push_back(std::make_pair(position, callback));
+	}
+
+	if (inserted)
+	{
+		startQueuedLoads();
+	}
+}
+
+void TileAsyncPlanetAltitudeProvider::startQueuedLoads() const
+{
+	while (!mShuttingDown && mActiveLoadCount < mMaxConcurrentLoads)
+	{
+		// Find highest priority queued tile
+		PendingLoad* best = nullptr;
+		QuadTreeTileKey bestKey;
+		double bestDistance = std::numeric_limits<double>::max();
+		for (auto& [key, load] : mPendingLoads)
 		{
-			mScheduler->run([=]() {
-				mProvider->getAltitude(position);
-			}, &mLoadingTaskSync);
+			if (load.loading)
+			{
+				continue;
+			}
+
+			double distance = mPriorityOrigin ? sim::calcDistance(*mPriorityOrigin, load.position) : 0.0;
+			if (!best || distance < bestDistance)
+			{
+				best = &load;
+				bestKey = key;
+				bestDistance = distance;
+			}
 		}
+
+		if (!best)
+		{
+			return;
+		}
+
+		best->loading = true;
+		++mActiveLoadCount;
+		mScheduler->run([this, bestKey]() {
+			loadTile(bestKey);
+		}, &mLoadingTaskSync);
+	}
+}
+
+void TileAsyncPlanetAltitudeProvider::loadTile(const QuadTreeTileKey& key) const
+{
+	sim::LatLon position;
+	{
+		std::scoped_lock<std::mutex> lock(mPendingLoadsMutex);
+		position = mPendingLoads[key].position;
+	}
+
+	// Load tile into the cache
+	mProvider->getAltitude(position);
+
+	std::vector<std::pair<sim::LatLon, AltitudeCallback>> callbacks;
+	{
+		std::scoped_lock<std::mutex> lock(mPendingLoadsMutex);
+		auto it = mPendingLoads.find(key);
+		callbacks = std::move(it->second.callbacks);
+		mPendingLoads.erase(it);
+		--mActiveLoadCount;
+
+		startQueuedLoads();
+	}
+
+	for (const auto& [callbackPosition, callback] : callbacks)
+	{
+		callback(mProvider->getAltitude(callbackPosition));
 	}
-	return result;
 }
 
 } // namespace vis
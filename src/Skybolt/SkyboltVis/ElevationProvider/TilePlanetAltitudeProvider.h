@@ -8,13 +8,15 @@
 
 #include "SkyboltVis/SkyboltVisFwd.h"
 #include <SkyboltSim/PlanetAltitudeProvider.h>
-#include <SkyboltCommon/LruCacheMap.h>
-#include <SkyboltCommon/LruCacheSet.h>
+#include <SkyboltCommon/ShardedClockCacheMap.h>
 #include <SkyboltCommon/Math/QuadTree.h>
 
 #include <osg/Image>
 #include <px_sched/px_sched.h>
 #include <boost/optional.hpp>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 
 namespace skybolt {
 namespace vis {
@@ -76,12 +78,20 @@ struct LatLonVec2Adapter : public sim::LatLon
 class TilePlanetAltitudeProvider : public sim::PlanetAltitudeProvider
 {
 public:
-	TilePlanetAltitudeProvider(const TileSourcePtr& tileSource, int maxLod);
+	static constexpr size_t defaultCacheCapacityBytes = 128 * 1024 * 1024;
+
+	//! @param cacheCapacityBytes is the approximate memory budget for cached tile images
+	TilePlanetAltitudeProvider(const TileSourcePtr& tileSource, int maxLod, size_t cacheCapacityBytes = defaultCacheCapacityBytes);
 
 	//! Get altitude above sea level, positive is up.
 	//! @ThreadSafe
 	double getAltitude(const sim::LatLon& position) const override;
 
+	//! Get altitudes above sea level for many positions at once, positive is up.
+	//! Positions are grouped by tile so that each tile is looked up once per batch.
+	//! @ThreadSafe
+	void getAltitudes(const std::vector<sim::LatLon>& positions, std::vector<double>& altitudes) const override;
+
 	//! Get altitude above sea level, positive is up.
 	//! If tile is not loaded, returns immedatly with empty.
 	//! @ThreadSafe
@@ -89,6 +99,9 @@ public:
 
 	typedef skybolt::Box2T<LatLonVec2Adapter> LatLonBounds;
 
+	//! @ThreadSafe
+	CacheStats getCacheStats() const { return mTileImageCache.getStats(); }
+
 private:
 	struct TileImage
 	{
@@ -105,24 +118,74 @@ private:
 	// Note: By design, the TileImage key does not necessarily equal the cache key,
 	// because lower lods will be used (and put in the cache) if the requested lod (the cache key)
 	// is unavailable.
-	mutable LruCacheMap<QuadTreeTileKey, TileImage> mTileImageCache;
-	mutable std::mutex mTileImageCacheMutex;
+	// Cache is internally synchronized, so can be filled from const lookups.
+	mutable ShardedClockCacheMap<QuadTreeTileKey, TileImage> mTileImageCache;
 };
 
 class TileAsyncPlanetAltitudeProvider : public sim::AsyncPlanetAltitudeProvider
 {
 public:
-	TileAsyncPlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod);
+	static constexpr int defaultMaxConcurrentLoads = 4;
+
+	//! @param maxConcurrentLoads is the maximum number of tiles loaded in parallel. Further requests are queued.
+	TileAsyncPlanetAltitudeProvider(px_sched::Scheduler* scheduler, const TileSourcePtr& tileSource, int maxLod,
+		size_t cacheCapacityBytes = TilePlanetAltitudeProvider::defaultCacheCapacityBytes,
+		int maxConcurrentLoads = defaultMaxConcurrentLoads);
+
+	~TileAsyncPlanetAltitudeProvider() override;
 
 	//! Get altitude above sea level, positive is up.
 	//! If tile is not immediately available, requests to load tile on a background thread
 	//! and immediately returns empty optional.
+	//! Requests for a tile that is already pending are coalesced into the pending load.
+	//! @ThreadSafe
 	boost::optional<double> getAltitudeOrRequestLoad(const sim::LatLon& position) const override;
 
+	typedef std::function<void(double altitude)> AltitudeCallback;
+
+	//! Calls the callback with the altitude above sea level once it is available.
+	//! If the tile is already loaded, the callback is called immediately on the calling thread,
+	//! otherwise it is called on a background thread when the tile has loaded.
+	//! @ThreadSafe
+	void requestAltitude(const sim::LatLon& position, const AltitudeCallback& callback) const;
+
+	//! Sets the position used to prioritize queued loads, typically the camera position.
+	//! Queued tiles nearest the origin are loaded first.
+	//! @ThreadSafe
+	void setPriorityOrigin(const sim::LatLon& origin);
+
+	//! @returns the number of tiles that are loading or queued to load
+	//! @ThreadSafe
+	size_t getPendingLoadCount() const;
+
+private:
+	struct PendingLoad
+	{
+		sim::LatLon position; //!< A position within the tile, used to load the tile and calculate priority
+		std::vector<std::pair<sim::LatLon, AltitudeCallback>> callbacks;
+		bool loading = false;
+	};
+
+	void requestLoad(const sim::LatLon& position, const AltitudeCallback& callback) const;
+
+	//! Starts loading queued tiles, highest priority first, up to the concurrent load limit.
+	//! Must be called with mPendingLoadsMutex locked.
+	void startQueuedLoads() const;
+
+	void loadTile(const QuadTreeTileKey& key) const;
+
 private:
 	px_sched::Scheduler* mScheduler;
 	mutable px_sched::Sync mLoadingTaskSync;
 	std::unique_ptr<TilePlanetAltitudeProvider> mProvider;
+	const int mMaxLod;
+	const int mMaxConcurrentLoads;
+
+	mutable std::mutex mPendingLoadsMutex;
+	mutable std::unordered_map<QuadTreeTileKey, PendingLoad> mPendingLoads; //!< Tiles loading or queued to load
+	mutable int mActiveLoadCount = 0;
+	boost::optional<sim::LatLon> mPriorityOrigin;
+	bool mShuttingDown = false;
 };
 
 } // namespace vis
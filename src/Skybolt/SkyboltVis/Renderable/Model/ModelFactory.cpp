@@ -8,9 +8,15 @@
 #include "ModelFactory.h"
 #include "ModelPreparer.h"
 #include "OsgImageHelpers.h"
+#include <SkyboltCommon/Exception.h>
 #include <SkyboltCommon/MapUtility.h>
+#include <osg/Geometry>
+#include <osg/Texture>
 #include <osgDB/ReadFile>
 
+#include <boost/log/trivial.hpp>
+#include <atomic>
+
 using namespace skybolt::vis;
 
 // Traverses node hierarchy and sets internal format of textures to an equivalent sRGB format
@@ -101,44 +107,306 @@ private:
 	NamedStateSetModifiers mModifiers;
 };
 
+//! Estimates the memory used by a model's geometry and texture images
+class ModelSizeCalculator : public StateSetVisitor
+{
+public:
+	void apply(osg::Drawable& drawable) override
+	{
+		if (const osg::Geometry* geometry = drawable.asGeometry())
+		{
+			osg::Geometry::ArrayList arrays;
+			geometry->getArrayList(arrays);
+			for (const auto& array : arrays)
+			{
+				sizeBytes += array->getTotalDataSize();
+			}
+
+			for (const auto& primitiveSet : geometry->getPrimitiveSetList())
+			{
+				sizeBytes += primitiveSet->getTotalDataSize();
+			}
+		}
+
+		StateSetVisitor::apply(drawable);
+	}
+
+	void apply(osg::StateSet& stateSet) override
+	{
+		for (unsigned int i = 0; i < stateSet.getTextureAttributeList().size(); ++i)
+		{
+			const osg::Texture* texture = dynamic_cast<const osg::Texture*>(stateSet.getTextureAttribute(i, osg::StateAttribute::TEXTURE));
+			if (texture)
+			{
+				for (unsigned int j = 0; j < texture->getNumImages(); ++j)
+				{
+					if (const osg::Image* image = texture->getImage(j))
+					{
+						sizeBytes += image->getTotalSizeInBytesIncludingMipmaps();
+					}
+				}
+			}
+		}
+	}
+
+	size_t sizeBytes = 0;
+};
+
+struct ModelFactory::CacheEntry
+{
+	enum class State
+	{
+		Loading,
+		Loaded,
+		Failed
+	};
+
+	std::atomic<State> state = State::Loading;
+	std::atomic<bool> loadClaimed = false; //!< Set by the thread which loads the model
+
+	// Written before state changes from Loading
+	osg::ref_ptr<osg::Node> model;
+	std::string error;
+
+	// Guarded by ModelFactory::mMutex
+	size_t sizeBytes = 0;
+	uint64_t lastUsed = 0;
+};
+
+//! Adds a model to its placeholder once the model has loaded
+class ModelPlaceholderCallback : public osg::NodeCallback
+{
+public:
+	ModelPlaceholderCallback(const std::function<osg::ref_ptr<osg::Node>(bool& complete)>& getModel) :
+		mGetModel(getModel)
+	{
+	}
+
+	void operator()(osg::Node* node, osg::NodeVisitor* nv) override
+	{
+		bool complete = false;
+		osg::ref_ptr<osg::Node> model = mGetModel(complete);
+		if (complete)
+		{
+			if (model)
+			{
+				node->asGroup()->addChild(model);
+			}
+
+			osg::ref_ptr<osg::NodeCallback> self = this; // Keep this alive until the end of the function
+			node->removeUpdateCallback(this);
+			return;
+		}
+		traverse(node, nv);
+	}
+
+private:
+	std::function<osg::ref_ptr<osg::Node>(bool& complete)> mGetModel;
+};
+
 ModelFactory::ModelFactory(const ModelFactoryConfig &config) :
 	mStateSetModifiers(config.stateSetModifiers),
-	mDefaultProgram(config.defaultProgram)
+	mDefaultProgram(config.defaultProgram),
+	mScheduler(config.scheduler),
+	mCacheCapacityBytes(config.cacheCapacityBytes)
 {
 	assert(mDefaultProgram);
 }
 
+ModelFactory::~ModelFactory()
+{
+	waitForLoads();
+}
+
 osg::ref_ptr<osg::Node> ModelFactory::createModel(const std::string& filename)
 {
-	static std::map<std::string, osg::ref_ptr<osg::Node>> modelCache;
-	auto it = modelCache.find(filename);
-	if (it == modelCache.end())
+	bool loadRequired;
+	CacheEntryPtr entry = findOrCreateEntry(filename, loadRequired);
+
+	// If an asynchronous load has not started yet, load on this thread rather than waiting for the scheduler
+	loadEntryIfUnclaimed(filename, *entry);
+
+	if (entry->state.load() == CacheEntry::State::Loading)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mLoadCompleted.wait(lock, [&] { return entry->state.load() != CacheEntry::State::Loading; });
+	}
+
+	if (entry->state.load() == CacheEntry::State::Failed)
+	{
+		throw skybolt::Exception(entry->error);
+	}
+	return entry->model;
+}
+
+osg::ref_ptr<osg::Group> ModelFactory::createModelAsync(const std::string& filename)
+{
+	bool loadRequired;
+	CacheEntryPtr entry = findOrCreateEntry(filename, loadRequired);
+	if (loadRequired)
+	{
+		startAsyncLoad(filename, entry);
+	}
+
+	osg::ref_ptr<osg::Group> placeholder = new osg::Group;
+	if (entry->state.load() == CacheEntry::State::Loaded)
+	{
+		placeholder->addChild(entry->model);
+	}
+	else
+	{
+		placeholder->addUpdateCallback(new ModelPlaceholderCallback([entry] (bool& complete) {
+			CacheEntry::State state = entry->state.load();
+			complete = (state != CacheEntry::State::Loading);
+			return (state == CacheEntry::State::Loaded) ? entry->model : osg::ref_ptr<osg::Node>();
+		}));
+	}
+	return placeholder;
+}
+
+void ModelFactory::prefetch(const std::vector<std::string>& filenames)
+{
+	for (const std::string& filename : filenames)
 	{
-		osg::ref_ptr<osg::Node> model = osgDB::readNodeFile(filename);
-		if (!model)
+		bool loadRequired;
+		CacheEntryPtr entry = findOrCreateEntry(filename, loadRequired);
+		if (loadRequired)
 		{
-			throw skybolt::Exception("Could not load OSG model: " + filename);
+			startAsyncLoad(filename, entry);
 		}
+	}
+}
 
-		ModelPreparer preparer;
-		model->accept(preparer);
+void ModelFactory::waitForLoads()
+{
+	if (mScheduler)
+	{
+		mScheduler->waitFor(mLoadingTaskSync);
+	}
+}
 
+size_t ModelFactory::getCacheSizeBytes() const
+{
+	std::scoped_lock<std::mutex> lock(mMutex);
+	return mCacheSizeBytes;
+}
+
+ModelFactory::CacheEntryPtr ModelFactory::findOrCreateEntry(const std::string& filename, bool& loadRequired)
+{
+	std::scoped_lock<std::mutex> lock(mMutex);
+	CacheEntryPtr& entry = mCache[filename];
+	loadRequired = !entry;
+	if (loadRequired)
+	{
+		entry = std::make_shared<CacheEntry>();
+	}
+	entry->lastUsed = ++mUseCounter;
+	return entry;
+}
+
+void ModelFactory::startAsyncLoad(const std::string& filename, const CacheEntryPtr& entry)
+{
+	if (mScheduler)
+	{
+		mScheduler->run([this, filename, entry] {
+			loadEntryIfUnclaimed(filename, *entry);
+		}, &mLoadingTaskSync);
+	}
+	else
+	{
+		loadEntryIfUnclaimed(filename, *entry);
+	}
+}
+
+void ModelFactory::loadEntryIfUnclaimed(const std::string& filename, CacheEntry& entry)
+{
+	if (entry.loadClaimed.exchange(true))
+	{
+		return;
+	}
+
+	osg::ref_ptr<osg::Node> model;
+	size_t sizeBytes = 0;
+	try
+	{
+		model = loadModel(filename);
+
+		ModelSizeCalculator calculator;
+		model->accept(calculator);
+		sizeBytes = calculator.sizeBytes;
+	}
+	catch (const std::exception& e)
+	{
+		entry.error = e.what();
+		BOOST_LOG_TRIVIAL(error) << e.what();
+	}
+
+	{
+		std::scoped_lock<std::mutex> lock(mMutex);
+		if (model)
 		{
-			TextureSrgbModifier modifier;
-			model->accept(modifier);
+			entry.model = model;
+			entry.sizeBytes = sizeBytes;
+			mCacheSizeBytes += sizeBytes;
+			entry.state = CacheEntry::State::Loaded;
+			evictUnusedModels();
 		}
+		else
 		{
-			MaterialShaderAssignmentsModifier modifier(mStateSetModifiers);
-			model->accept(modifier);
+			// Remove failed loads from the cache so that they are retried by future requests
+			mCache.erase(filename);
+			entry.state = CacheEntry::State::Failed;
 		}
+	}
+	mLoadCompleted.notify_all();
+}
+
+osg::ref_ptr<osg::Node> ModelFactory::loadModel(const std::string& filename) const
+{
+	osg::ref_ptr<osg::Node> model = osgDB::readNodeFile(filename);
+	if (!model)
+	{
+		throw skybolt::Exception("Could not load OSG model: " + filename);
+	}
 
-		model->getOrCreateStateSet()->setAttribute(mDefaultProgram); // set default program at top level
+	ModelPreparer preparer;
+	model->accept(preparer);
 
-		modelCache[filename] = model;
-		return model;
+	{
+		TextureSrgbModifier modifier;
+		model->accept(modifier);
 	}
-	else
 	{
-		return it->second;
+		MaterialShaderAssignmentsModifier modifier(mStateSetModifiers);
+		model->accept(modifier);
+	}
+
+	model->getOrCreateStateSet()->setAttribute(mDefaultProgram); // set default program at top level
+	return model;
+}
+
+void ModelFactory::evictUnusedModels()
+{
+	while (mCacheSizeBytes > mCacheCapacityBytes)
+	{
+		// Find least recently used model which is only referenced by the cache
+		auto lruIt = mCache.end();
+		for (auto it = mCache.begin(); it != mCache.end(); ++it)
+		{
+			const CacheEntry& entry = *it->second;
+			bool unused = entry.state.load() == CacheEntry::State::Loaded && entry.model->referenceCount() == 1 && it->second.use_count() == 1;
+			if (unused && (lruIt == mCache.end() || entry.lastUsed < lruIt->second->lastUsed))
+			{
+				lruIt = it;
+			}
+		}
+
+		if (lruIt == mCache.end())
+		{
+			return; // All models are in use
+		}
+
+		mCacheSizeBytes -= lruIt->second->sizeBytes;
+		mCache.erase(lruIt);
 	}
-}
\ No newline at end of file
+}
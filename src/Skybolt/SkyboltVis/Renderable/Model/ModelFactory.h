@@ -8,9 +8,16 @@
 #pragma once
 
 #include "SkyboltVis/DefaultRootNode.h"
+#include <osg/Group>
 #include <osg/Material>
 #include <osg/Program>
+#include <px_sched/px_sched.h>
+
+#include <condition_variable>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace skybolt {
 namespace vis {
@@ -22,18 +29,65 @@ struct ModelFactoryConfig
 {
 	NamedStateSetModifiers stateSetModifiers;
 	osg::ref_ptr<osg::Program> defaultProgram;
+	px_sched::Scheduler* scheduler = nullptr; //!< Runs asynchronous loads. If null, asynchronous loads run on the calling thread.
+	size_t cacheCapacityBytes = 512 * 1024 * 1024; //!< Unused models are evicted, least recently used first, while the estimated size of cached models exceeds this
 };
 
+//! Loads models and caches them by filename. Cached models are shared, so must not be modified by users.
+//! All methods are thread safe.
 class ModelFactory : public DefaultRootNode
 {
 public:
 	ModelFactory(const ModelFactoryConfig &config);
-	
+	~ModelFactory() override;
+
+	//! Returns the cached model, loading it on the calling thread if it is not cached or its asynchronous load has not started yet.
+	//! @throws skybolt::Exception if the model could not be loaded
 	osg::ref_ptr<osg::Node> createModel(const std::string& filename);
 
+	//! Returns a placeholder immediately, and loads the model on the scheduler if it is not cached.
+	//! The model is added to the placeholder in the scene graph's update traversal once loaded.
+	//! The placeholder remains empty if the model could not be loaded.
+	osg::ref_ptr<osg::Group> createModelAsync(const std::string& filename);
+
+	//! Starts loading models on the scheduler, so that they are cached before they are needed
+	void prefetch(const std::vector<std::string>& filenames);
+
+	//! Blocks until all asynchronous loads have completed
+	void waitForLoads();
+
+	//! @returns the estimated memory used by cached models
+	size_t getCacheSizeBytes() const;
+
+private:
+	struct CacheEntry;
+	typedef std::shared_ptr<CacheEntry> CacheEntryPtr;
+
+	//! @param loadRequired is set to true if the entry was created by this call, in which case the caller must start loading it
+	CacheEntryPtr findOrCreateEntry(const std::string& filename, bool& loadRequired);
+
+	void startAsyncLoad(const std::string& filename, const CacheEntryPtr& entry);
+
+	//! Loads the entry if no other thread has claimed the load yet
+	void loadEntryIfUnclaimed(const std::string& filename, CacheEntry& entry);
+
+	osg::ref_ptr<osg::Node> loadModel(const std::string& filename) const;
+
+	//! Must be called with mMutex locked
+	void evictUnusedModels();
+
 private:
 	NamedStateSetModifiers mStateSetModifiers;
 	osg::ref_ptr<osg::Program> mDefaultProgram;
+	px_sched::Scheduler* mScheduler;
+	size_t mCacheCapacityBytes;
+	px_sched::Sync mLoadingTaskSync;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mLoadCompleted;
+	std::map<std::string, CacheEntryPtr> mCache;
+	size_t mCacheSizeBytes = 0;
+	uint64_t mUseCounter = 0; //!< Incremented each time a model is requested, for least recently used eviction
 };
 
 } // namespace vis
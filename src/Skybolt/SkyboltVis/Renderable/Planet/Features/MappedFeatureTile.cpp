@@ -0,0 +1,417 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "MappedFeatureTile.h"
+#include <SkyboltCommon/Exception.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/streams/bufferstream.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+using skybolt::Exception;
+using skybolt::sim::LatLonAlt;
+
+namespace skybolt {
+namespace mapfeatures {
+
+static_assert(sizeof(LatLonAlt) == 3 * sizeof(double), "LatLonAlt must be tightly packed to be read in place");
+static_assert(std::is_trivially_copyable<LatLonAlt>::value, "LatLonAlt must be trivially copyable to be read in place");
+
+enum ArrayId
+{
+	RoadPointOffsets,
+	RoadPoints,
+	RoadWidths,
+	RoadLaneCounts,
+	BuildingPointOffsets,
+	BuildingPoints,
+	BuildingHeights,
+	WaterPointOffsets,
+	WaterPoints,
+	AirportData, //!< Airports serialized in the version 1 format
+	ArrayIdCount
+};
+
+//! All arrays start on this byte boundary so that they can be accessed in place
+static const size_t arrayAlignment = 8;
+
+#pragma pack(push, 1)
+struct ArrayRange
+{
+	std::uint64_t offset; //!< Byte offset from the start of the file
+	std::uint64_t count; //!< Number of elements
+};
+
+struct TileHeaderV2
+{
+	std::uint32_t version;
+	std::uint32_t arrayCount;
+	ArrayRange arrays[ArrayIdCount];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TileHeaderV2) % arrayAlignment == 0, "Header size must preserve array alignment");
+
+namespace {
+
+struct PolyFeatureArrays
+{
+	std::vector<std::uint32_t> pointOffsets;
+	std::vector<LatLonAlt> points;
+
+	void add(const PolyFeature& feature)
+	{
+		if (pointOffsets.empty())
+		{
+			pointOffsets.push_back(0);
+		}
+		points.insert(points.end(), feature.points.begin(), feature.points.end());
+		if (points.size() > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw Exception("Too many points in feature tile");
+		}
+		pointOffsets.push_back(std::uint32_t(points.size()));
+	}
+};
+
+class TileWriterV2
+{
+public:
+	TileWriterV2()
+	{
+		std::memset(&mHeader, 0, sizeof(mHeader));
+		mHeader.version = featureTileVersionV2;
+		mHeader.arrayCount = ArrayIdCount;
+		mData.resize(sizeof(TileHeaderV2));
+	}
+
+	template <typename T>
+	void addArray(ArrayId id, const std::vector<T>& values)
+	{
+		static_assert(alignof(T) <= arrayAlignment, "Array element alignment not supported");
+		mData.resize((mData.size() + arrayAlignment - 1) / arrayAlignment * arrayAlignment, 0);
+		mHeader.arrays[id] = {mData.size(), values.size()};
+
+		const std::uint8_t* begin = reinterpret_cast<const std::uint8_t*>(values.data());
+		mData.insert(mData.end(), begin, begin + values.size() * sizeof(T));
+	}
+
+	std::vector<std::uint8_t> finish()
+	{
+		std::memcpy(mData.data(), &mHeader, sizeof(mHeader));
+		return std::move(mData);
+	}
+
+private:
+	TileHeaderV2 mHeader;
+	std::vector<std::uint8_t> mData;
+};
+
+} // namespace
+
+static std::vector<std::uint8_t> serializeTileV2(const std::vector<FeaturePtr>& features)
+{
+	PolyFeatureArrays roads;
+	std::vector<float> roadWidths;
+	std::vector<std::int32_t> roadLaneCounts;
+
+	PolyFeatureArrays buildings;
+	std::vector<float> buildingHeights;
+
+	PolyFeatureArrays waters;
+
+	std::ostringstream airportStream(std::ios::binary);
+	std::uint32_t airportCount = 0;
+	for (const FeaturePtr& feature : features)
+	{
+		if (feature->type() == FeatureAirport)
+		{
+			++airportCount;
+		}
+	}
+	airportStream.write(reinterpret_cast<const char*>(&airportCount), sizeof(airportCount));
+
+	for (const FeaturePtr& feature : features)
+	{
+		switch (feature->type())
+		{
+		case FeatureRoad:
+		{
+			const Road& road = static_cast<const Road&>(*feature);
+			roads.add(road);
+			roadWidths.push_back(road.width);
+			roadLaneCounts.push_back(road.laneCount);
+			break;
+		}
+		case FeatureBuilding:
+		{
+			const Building& building = static_cast<const Building&>(*feature);
+			buildings.add(building);
+			buildingHeights.push_back(building.height);
+			break;
+		}
+		case FeatureWater:
+			waters.add(static_cast<const Water&>(*feature));
+			break;
+		case FeatureAirport:
+			feature->save(airportStream);
+			break;
+		default:
+			assert(!"Not implemented");
+		}
+	}
+
+	std::string airportData = airportStream.str();
+
+	TileWriterV2 writer;
+	writer.addArray(RoadPointOffsets, roads.pointOffsets);
+	writer.addArray(RoadPoints, roads.points);
+	writer.addArray(RoadWidths, roadWidths);
+	writer.addArray(RoadLaneCounts, roadLaneCounts);
+	writer.addArray(BuildingPointOffsets, buildings.pointOffsets);
+	writer.addArray(BuildingPoints, buildings.points);
+	writer.addArray(BuildingHeights, buildingHeights);
+	writer.addArray(WaterPointOffsets, waters.pointOffsets);
+	writer.addArray(WaterPoints, waters.points);
+	writer.addArray(AirportData, std::vector<char>(airportData.begin(), airportData.end()));
+	return writer.finish();
+}
+
+void saveTileV2(const std::vector<FeaturePtr>& features, std::ostream& f)
+{
+	std::vector<std::uint8_t> data = serializeTileV2(features);
+	f.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+static std::uint32_t readTileVersion(const std::string& filename)
+{
+	std::ifstream f(filename, std::ios::binary);
+	if (!f.is_open())
+	{
+		throw Exception("Could not open file: " + filename);
+	}
+
+	std::uint32_t version = 0;
+	f.read(reinterpret_cast<char*>(&version), sizeof(version));
+	return version;
+}
+
+MappedFeatureTile::MappedFeatureTile(const std::string& filename)
+{
+	std::uint32_t version = readTileVersion(filename);
+	if (version == featureTileVersionV2)
+	{
+		try
+		{
+			boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+			mMappedRegion = std::make_unique<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+		}
+		catch (const boost::interprocess::interprocess_exception& e)
+		{
+			throw Exception("Could not map feature tile '" + filename + "': " + e.what());
+		}
+		readViews(static_cast<const std::uint8_t*>(mMappedRegion->get_address()), mMappedRegion->get_size(), filename);
+	}
+	else if (version == featureTileVersionV1)
+	{
+		std::vector<FeaturePtr> features;
+		loadTile(filename, features);
+		mConvertedData = serializeTileV2(features);
+		readViews(mConvertedData.data(), mConvertedData.size(), filename);
+	}
+	else
+	{
+		throw Exception("Invalid feature tile version " + std::to_string(version) + " in file: " + filename);
+	}
+}
+
+MappedFeatureTile::~MappedFeatureTile() = default;
+
+template <typename T>
+static ArrayView<T> getArray(const std::uint8_t* data, size_t size, const ArrayRange& range, const std::string& filename)
+{
+	if (range.count == 0)
+	{
+		return ArrayView<T>();
+	}
+
+	if (range.offset % alignof(T) != 0 || range.offset > size || range.count > (size - range.offset) / sizeof(T))
+	{
+		throw Exception("Corrupt feature tile: " + filename);
+	}
+	return ArrayView<T>(reinterpret_cast<const T*>(data + range.offset), range.count);
+}
+
+static void validatePolyFeatures(const PolyFeaturesView& view, std::initializer_list<size_t> attributeSizes, const std::string& filename)
+{
+	bool valid = true;
+	if (view.pointOffsets.empty())
+	{
+		valid = view.points.empty();
+	}
+	else
+	{
+		valid = view.pointOffsets[0] == 0 && view.pointOffsets[view.size()] == view.points.size();
+		for (size_t i = 0; valid && i < view.size(); ++i)
+		{
+			valid = view.pointOffsets[i] <= view.pointOffsets[i + 1];
+		}
+	}
+
+	for (size_t size : attributeSizes)
+	{
+		valid = valid && size == view.size();
+	}
+
+	if (!valid)
+	{
+		throw Exception("Corrupt feature tile: " + filename);
+	}
+}
+
+void MappedFeatureTile::readViews(const std::uint8_t* data, size_t size, const std::string& filename)
+{
+	if (size < sizeof(TileHeaderV2))
+	{
+		throw Exception("Corrupt feature tile: " + filename);
+	}
+
+	TileHeaderV2 header;
+	std::memcpy(&header, data, sizeof(header));
+	if (header.arrayCount != ArrayIdCount)
+	{
+		throw Exception("Corrupt feature tile: " + filename);
+	}
+
+	const ArrayRange* arrays = header.arrays;
+	mRoads.pointOffsets = getArray<std::uint32_t>(data, size, arrays[RoadPointOffsets], filename);
+	mRoads.points = getArray<LatLonAlt>(data, size, arrays[RoadPoints], filename);
+	mRoads.widths = getArray<float>(data, size, arrays[RoadWidths], filename);
+	mRoads.laneCounts = getArray<std::int32_t>(data, size, arrays[RoadLaneCounts], filename);
+	validatePolyFeatures(mRoads, {mRoads.widths.size(), mRoads.laneCounts.size()}, filename);
+
+	mBuildings.pointOffsets = getArray<std::uint32_t>(data, size, arrays[BuildingPointOffsets], filename);
+	mBuildings.points = getArray<LatLonAlt>(data, size, arrays[BuildingPoints], filename);
+	mBuildings.heights = getArray<float>(data, size, arrays[BuildingHeights], filename);
+	validatePolyFeatures(mBuildings, {mBuildings.heights.size()}, filename);
+
+	mWaters.pointOffsets = getArray<std::uint32_t>(data, size, arrays[WaterPointOffsets], filename);
+	mWaters.points = getArray<LatLonAlt>(data, size, arrays[WaterPoints], filename);
+	validatePolyFeatures(mWaters, {}, filename);
+
+	ArrayView<char> airportData = getArray<char>(data, size, arrays[AirportData], filename);
+	if (!airportData.empty())
+	{
+		boost::interprocess::ibufferstream stream(airportData.data(), airportData.size(), std::ios::binary);
+		std::uint32_t airportCount = 0;
+		stream.read(reinterpret_cast<char*>(&airportCount), sizeof(airportCount));
+		for (std::uint32_t i = 0; stream && i < airportCount; ++i)
+		{
+			AirportPtr airport = std::make_shared<Airport>();
+			airport->load(stream);
+			mAirports.push_back(airport);
+		}
+
+		if (!stream)
+		{
+			throw Exception("Corrupt feature tile: " + filename);
+		}
+	}
+}
+
+template <typename FeatureT>
+static std::shared_ptr<FeatureT> createPolyFeature(const PolyFeaturesView& view, size_t i)
+{
+	auto feature = std::make_shared<FeatureT>();
+	LatLonAltPointsView points = view.getPoints(i);
+	feature->points.assign(points.begin(), points.end());
+	return feature;
+}
+
+std::vector<FeaturePtr> MappedFeatureTile::toFeatures() const
+{
+	std::vector<FeaturePtr> features;
+	features.reserve(mRoads.size() + mBuildings.size() + mWaters.size() + mAirports.size());
+
+	for (size_t i = 0; i < mRoads.size(); ++i)
+	{
+		auto road = createPolyFeature<Road>(mRoads, i);
+		road->width = mRoads.widths[i];
+		road->laneCount = mRoads.laneCounts[i];
+		features.push_back(road);
+	}
+
+	for (size_t i = 0; i < mBuildings.size(); ++i)
+	{
+		auto building = createPolyFeature<Building>(mBuildings, i);
+		building->height = mBuildings.heights[i];
+		features.push_back(building);
+	}
+
+	for (size_t i = 0; i < mWaters.size(); ++i)
+	{
+		features.push_back(createPolyFeature<Water>(mWaters, i));
+	}
+
+	features.insert(features.end(), mAirports.begin(), mAirports.end());
+	return features;
+}
+
+bool convertTileToV2(const std::string& filename)
+{
+	if (readTileVersion(filename) == featureTileVersionV2)
+	{
+		return false;
+	}
+
+	std::vector<FeaturePtr> features;
+	loadTile(filename, features);
+
+	std::string tempFilename = filename + ".tmp";
+	{
+		std::ofstream f(tempFilename, std::ios::binary);
+		saveTileV2(features, f);
+		if (!f)
+		{
+			throw Exception("Could not write file: " + tempFilename);
+		}
+	}
+	std::filesystem::rename(tempFilename, filename);
+	return true;
+}
+
+size_t convertTilesToV2(const std::string& directory)
+{
+	// Find tiles before converting, since conversion adds and renames files in the directory
+	std::vector<std::filesystem::path> paths;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".ftr")
+		{
+			paths.push_back(entry.path());
+		}
+	}
+
+	size_t convertedCount = 0;
+	for (const std::filesystem::path& path : paths)
+	{
+		if (convertTileToV2(path.string()))
+		{
+			++convertedCount;
+		}
+	}
+	return convertedCount;
+}
+
+} // namespace mapfeatures
+} // namespace skybolt
@@ -0,0 +1,135 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "PlanetFeaturesSource.h"
+
+#include <assert.h>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace boost {
+namespace interprocess {
+class mapped_region;
+} // namespace interprocess
+} // namespace boost
+
+namespace skybolt {
+namespace mapfeatures {
+
+static const std::uint32_t featureTileVersionV1 = 1;
+static const std::uint32_t featureTileVersionV2 = 2;
+
+//! Non-owning view of a contiguous array
+template <typename T>
+class ArrayView
+{
+public:
+	ArrayView() {}
+	ArrayView(const T* data, size_t size) : mData(data), mSize(size) {}
+
+	const T* begin() const { return mData; }
+	const T* end() const { return mData + mSize; }
+	const T* data() const { return mData; }
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+
+	const T& operator[](size_t i) const
+	{
+		assert(i < mSize);
+		return mData[i];
+	}
+
+private:
+	const T* mData = nullptr;
+	size_t mSize = 0;
+};
+
+typedef ArrayView<sim::LatLonAlt> LatLonAltPointsView;
+
+//! View of all features of one PolyFeature type.
+//! Points of all features are stored contiguously. The points of feature i are in the range [pointOffsets[i], pointOffsets[i+1]).
+struct PolyFeaturesView
+{
+	ArrayView<std::uint32_t> pointOffsets; //!< Has size feature count + 1, or is empty if there are no features
+	LatLonAltPointsView points;
+
+	size_t size() const { return pointOffsets.empty() ? 0 : pointOffsets.size() - 1; }
+
+	LatLonAltPointsView getPoints(size_t featureIndex) const
+	{
+		std::uint32_t begin = pointOffsets[featureIndex];
+		return LatLonAltPointsView(points.data() + begin, pointOffsets[featureIndex + 1] - begin);
+	}
+};
+
+struct RoadsView : PolyFeaturesView
+{
+	ArrayView<float> widths;
+	ArrayView<std::int32_t> laneCounts;
+};
+
+struct BuildingsView : PolyFeaturesView
+{
+	ArrayView<float> heights;
+};
+
+typedef PolyFeaturesView WatersView;
+
+//! A feature tile which is read in place from a memory mapped file.
+//! Version 2 tiles consist of a header followed by flat, 8 byte aligned arrays, with one set of arrays per feature type,
+//! so features can be accessed through views without per-value deserialization.
+//! Version 1 tiles are converted to version 2 in memory when opened.
+//! Views are valid for the lifetime of the MappedFeatureTile.
+class MappedFeatureTile
+{
+public:
+	//! @throws skybolt::Exception if the file could not be read
+	explicit MappedFeatureTile(const std::string& filename);
+	~MappedFeatureTile();
+
+	const RoadsView& getRoads() const { return mRoads; }
+	const BuildingsView& getBuildings() const { return mBuildings; }
+	const WatersView& getWaters() const { return mWaters; }
+
+	//! Airports have variable length fields and are few in number, so they are deserialized when the tile is opened
+	const std::vector<AirportPtr>& getAirports() const { return mAirports; }
+
+	//! @returns the features as Feature objects, which is slower than using the views
+	std::vector<FeaturePtr> toFeatures() const;
+
+private:
+	//! @throws skybolt::Exception if the data is not a valid version 2 tile
+	void readViews(const std::uint8_t* data, size_t size, const std::string& filename);
+
+private:
+	std::unique_ptr<boost::interprocess::mapped_region> mMappedRegion;
+	std::vector<std::uint8_t> mConvertedData; //!< Holds the tile's data if it was converted from version 1
+
+	RoadsView mRoads;
+	BuildingsView mBuildings;
+	WatersView mWaters;
+	std::vector<AirportPtr> mAirports;
+};
+
+//! Saves features in the version 2 format
+void saveTileV2(const std::vector<FeaturePtr>& features, std::ostream& f);
+
+//! Converts a tile file to the version 2 format, writing to a temporary file and renaming it over the original.
+//! @returns false if the tile was already version 2
+//! @throws skybolt::Exception on error
+bool convertTileToV2(const std::string& filename);
+
+//! Converts all feature tiles in a directory tree to the version 2 format
+//! @returns number of tiles converted
+size_t convertTilesToV2(const std::string& directory);
+
+} // namespace mapfeatures
+} // namespace skybolt
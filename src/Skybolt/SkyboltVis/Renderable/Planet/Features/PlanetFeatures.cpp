@@ -5,6 +5,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PlanetFeatures.h"
+#include "MappedFeatureTile.h"
 #include "SkyboltSim/Spatial/GreatCircle.h"
 #include "SkyboltVis/LlaToNedConverter.h"
 #include "SkyboltVis/OsgGeocentric.h"
@@ -46,7 +47,7 @@ public:
 	}
 
 	//! May be called on multiple threads concurrently
-	std::unique_ptr<LoadedVisObjects> loadVisObjects(const std::vector<mapfeatures::FeaturePtr>& features, const sim::LatLon& latLonOrigin, double planetRadius) const
+	std::unique_ptr<LoadedVisObjects> loadVisObjects(const mapfeatures::MappedFeatureTile& tile, const sim::LatLon& latLonOrigin, double planetRadius) const
 	{
 		std::unique_ptr<LoadedVisObjects> objectsPtr = std::make_unique<LoadedVisObjects>();
 		LoadedVisObjects& objects = *objectsPtr;
@@ -61,86 +62,71 @@ public:
 		Lakes lakes;
 		PolyRegions polyRegions;
 
-		for (const mapfeatures::FeaturePtr& feature : features)
-		{
-			switch (feature->type())
-			{
-			case mapfeatures::FeatureRoad:
-			{
-				const mapfeatures::Road& srcRoad = static_cast<const mapfeatures::Road&>(*feature);
-
-				Road road;
-				for (int j = 0; j < srcRoad.points.size(); ++j)
-				{
-					osg::Vec3f pos = converter.latLonAltToCartesianNed(srcRoad.points[j]);
-					road.points.push_back(pos);
-				}
-				road.width = srcRoad.width;
-				road.laneCount = srcRoad.laneCount;
-				roads.push_back(road);
-			}
-			break;
-			case mapfeatures::FeatureBuilding:
+		auto toNedPoints = [&](const mapfeatures::LatLonAltPointsView& points, std::vector<osg::Vec3f>& result) {
+			result.reserve(points.size());
+			for (const sim::LatLonAlt& point : points)
 			{
-				Building building;
-				const mapfeatures::Building& srcBuilding = static_cast<const mapfeatures::Building&>(*feature);
-				for (int j = 0; j < srcBuilding.points.size(); ++j)
-				{
-					osg::Vec3f pos = converter.latLonAltToCartesianNed(srcBuilding.points[j]);
-					building.points.push_back(pos);
-				}
-				building.height = srcBuilding.height;
-				buildings.push_back(building);
+				result.push_back(converter.latLonAltToCartesianNed(point));
 			}
-			break;
-			case mapfeatures::FeatureWater:
+		};
+
+		const mapfeatures::RoadsView& srcRoads = tile.getRoads();
+		roads.resize(srcRoads.size());
+		for (size_t i = 0; i < srcRoads.size(); ++i)
+		{
+			Road& road = roads[i];
+			toNedPoints(srcRoads.getPoints(i), road.points);
+			road.width = srcRoads.widths[i];
+			road.laneCount = srcRoads.laneCounts[i];
+		}
+
+		const mapfeatures::BuildingsView& srcBuildings = tile.getBuildings();
+		buildings.resize(srcBuildings.size());
+		for (size_t i = 0; i < srcBuildings.size(); ++i)
+		{
+			Building& building = buildings[i];
+			toNedPoints(srcBuildings.getPoints(i), building.points);
+			building.height = srcBuildings.heights[i];
+		}
+
+		const mapfeatures::WatersView& srcWaters = tile.getWaters();
+		lakes.resize(srcWaters.size());
+		for (size_t i = 0; i < srcWaters.size(); ++i)
+		{
+			toNedPoints(srcWaters.getPoints(i), lakes[i].points);
+		}
+
+		for (const mapfeatures::AirportPtr& srcAirportPtr : tile.getAirports())
+		{
+			const mapfeatures::Airport& srcAirport = *srcAirportPtr;
+			for (const mapfeatures::Airport::Runway& srcRunway : srcAirport.runways)
 			{
-				Lake lake;
-				const mapfeatures::Water& srcWater = static_cast<const mapfeatures::Water&>(*feature);
-				for (int j = 0; j < srcWater.points.size(); ++j)
+				Runway runway;
+				runway.startPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.start, srcAirport.altitude));
+				runway.endPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.end, srcAirport.altitude));
+
+				std::vector<std::string> strs;
+				boost::split(strs, srcRunway.name, boost::is_any_of("\\/"));
+				if (strs.size() == 2)
 				{
-					osg::Vec3f pos = converter.latLonAltToCartesianNed(srcWater.points[j]);
-					lake.points.push_back(pos);
+					runway.startMarking = strs.front();
+					runway.endMarking = strs.back();
 				}
 
-				lakes.push_back(lake);
+				runway.width = srcRunway.width;
+				runways.push_back(runway);
 			}
-			break;
-			case mapfeatures::FeatureAirport:
+			if (0)
 			{
-				const mapfeatures::Airport& srcAirport = static_cast<const mapfeatures::Airport&>(*feature);
-				for (const mapfeatures::Airport::Runway& srcRunway : srcAirport.runways)
+				for (const LatLonPoints& polygon : srcAirport.areaPolygons)
 				{
-					Runway runway;
-					runway.startPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.start, srcAirport.altitude));
-					runway.endPoint = converter.latLonAltToCartesianNed(toLatLonAlt(srcRunway.end, srcAirport.altitude));
-
-					std::vector<std::string> strs;
-					boost::split(strs, srcRunway.name, boost::is_any_of("\\/"));
-					if (strs.size() == 2)
+					PolyRegion region;
+					for (int j = 0; j < polygon.size(); ++j)
 					{
-						runway.startMarking = strs.front();
-						runway.endMarking = strs.back();
+						region.points.push_back(converter.latLonAltToCartesianNed(toLatLonAlt(polygon[j], srcAirport.altitude)));
 					}
-
-					runway.width = srcRunway.width;
-					runways.push_back(runway);
+					polyRegions.push_back(region);
 				}
-				if (0)
-				{
-					for (const LatLonPoints& polygon : srcAirport.areaPolygons)
-					{
-						PolyRegion region;
-						for (int j = 0; j < polygon.size(); ++j)
-						{
-							region.points.push_back(converter.latLonAltToCartesianNed(toLatLonAlt(polygon[j], srcAirport.altitude)));
-						}
-						polyRegions.push_back(region);
-					}
-				}
-			}
-			break;
-			assert(!"Not implemented");
 			}
 		}
 
@@ -308,10 +294,8 @@ void PlanetFeatures::loadTile(VisFeatureTile& tile)
 			{
 				if (!loadingItem->cancel) // if Tile hasn't been canceled by the time the scheduled task runs
 				{
-					std::vector<mapfeatures::FeaturePtr> features;
-					mapfeatures::loadTile(filename, features);
-
-					loadingItem->objects = mVisObjectsLoadTask->loadVisObjects(features, origin, mPlanetRadius);
+					mapfeatures::MappedFeatureTile featureTile(filename);
+					loadingItem->objects = mVisObjectsLoadTask->loadVisObjects(featureTile, origin, mPlanetRadius);
 				}
 			}, &mLoadingTaskSync);
 		}
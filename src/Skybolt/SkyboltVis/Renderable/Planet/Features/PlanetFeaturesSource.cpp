@@ -5,9 +5,11 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "PlanetFeaturesSource.h"
+#include "MappedFeatureTile.h"
 #include <SkyboltCommon/Exception.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <nlohmann/json.hpp>
+#include <px_sched/px_sched.h>
 
 #include <filesystem>
 #include <fstream>
@@ -50,44 +52,44 @@ static LatLonBounds calcPointBounds(const std::vector<sim::LatLonAlt>& points)
 }
 
 template <typename T>
-void readValue(std::ifstream& f, T& value)
+void readValue(std::istream& f, T& value)
 {
 	f.read((char*)&value, sizeof(value));
 }
 
 template <typename T>
-void writeValue(std::ofstream& f, const T& value)
+void writeValue(std::ostream& f, const T& value)
 {
 	f.write((const char*)&value, sizeof(value));
 }
 
-static void readLatLon(std::ifstream& f, sim::LatLon& latLon)
+static void readLatLon(std::istream& f, sim::LatLon& latLon)
 {
 	readValue(f, latLon.lat);
 	readValue(f, latLon.lon);
 }
 
-static void writeLatLon(std::ofstream& f, const sim::LatLon& latLon)
+static void writeLatLon(std::ostream& f, const sim::LatLon& latLon)
 {
 	writeValue(f, latLon.lat);
 	writeValue(f, latLon.lon); 
 }
 
-static void readLatLonAlt(std::ifstream& f, sim::LatLonAlt& latLonAlt)
+static void readLatLonAlt(std::istream& f, sim::LatLonAlt& latLonAlt)
 {
 	readValue(f, latLonAlt.lat);
 	readValue(f, latLonAlt.lon);
 	readValue(f, latLonAlt.alt);
 }
 
-static void writeLatLonAlt(std::ofstream& f, const sim::LatLonAlt& latLonAlt)
+static void writeLatLonAlt(std::ostream& f, const sim::LatLonAlt& latLonAlt)
 {
 	writeValue(f, latLonAlt.lat);
 	writeValue(f, latLonAlt.lon);
 	writeValue(f, latLonAlt.alt);
 }
 
-static void readPoints(std::ifstream& f, LatLonPoints& points)
+static void readPoints(std::istream& f, LatLonPoints& points)
 {
 	int pointCount;
 	readValue(f, pointCount);
@@ -102,7 +104,7 @@ static void readPoints(std::ifstream& f, LatLonPoints& points)
 	}
 }
 
-static void writePoints(std::ofstream& f, const LatLonPoints& points)
+static void writePoints(std::ostream& f, const LatLonPoints& points)
 {
 	int pointCount = (int)points.size();
 	writeValue(f, pointCount);
@@ -112,7 +114,7 @@ static void writePoints(std::ofstream& f, const LatLonPoints& points)
 	}
 }
 
-static void readPoints(std::ifstream& f, LatLonAltPoints& points)
+static void readPoints(std::istream& f, LatLonAltPoints& points)
 {
 	int pointCount;
 	readValue(f, pointCount);
@@ -127,7 +129,7 @@ static void readPoints(std::ifstream& f, LatLonAltPoints& points)
 	}
 }
 
-static void writePoints(std::ofstream& f, const LatLonAltPoints& points)
+static void writePoints(std::ostream& f, const LatLonAltPoints& points)
 {
 	int pointCount = (int)points.size();
 	writeValue(f, pointCount);
@@ -137,12 +139,12 @@ static void writePoints(std::ofstream& f, const LatLonAltPoints& points)
 	}
 }
 
-void PolyFeature::load(std::ifstream& f)
+void PolyFeature::load(std::istream& f)
 {
 	readPoints(f, points);
 }
 
-void PolyFeature::save(std::ofstream& f) const
+void PolyFeature::save(std::ostream& f) const
 {
 	writePoints(f, points);
 }
@@ -152,33 +154,33 @@ LatLonBounds PolyFeature::calcBounds() const
 	return calcPointBounds(points);
 }
 
-void Road::load(std::ifstream& f)
+void Road::load(std::istream& f)
 {
 	readValue(f, width);
 	readValue(f, laneCount);
 	PolyFeature::load(f);
 }
 
-void Road::save(std::ofstream& f) const
+void Road::save(std::ostream& f) const
 {
 	writeValue(f, width);
 	writeValue(f, laneCount);
 	PolyFeature::save(f);
 }
 
-void Building::load(std::ifstream& f)
+void Building::load(std::istream& f)
 {
 	readValue(f, height);
 	PolyFeature::load(f);
 }
 
-void Building::save(std::ofstream& f) const
+void Building::save(std::ostream& f) const
 {
 	writeValue(f, height);
 	PolyFeature::save(f);
 }
 
-static std::string readString(std::ifstream& f)
+static std::string readString(std::istream& f)
 {
 	std::string str;
 	uint16_t size;
@@ -188,14 +190,14 @@ static std::string readString(std::ifstream& f)
 	return str;
 }
 
-static void writeString(std::ofstream& f, const std::string& str)
+static void writeString(std::ostream& f, const std::string& str)
 {
 	uint16_t size = str.size();
 	writeValue(f, size);
 	f.write(&str[0], size);
 }
 
-static void readRunway(std::ifstream& f, Airport::Runway& runway)
+static void readRunway(std::istream& f, Airport::Runway& runway)
 {
 	runway.name = readString(f);
 	readLatLon(f, runway.start);
@@ -203,7 +205,7 @@ static void readRunway(std::ifstream& f, Airport::Runway& runway)
 	readValue(f, runway.width);
 }
 
-static void writeRunway(std::ofstream& f, const Airport::Runway& runway)
+static void writeRunway(std::ostream& f, const Airport::Runway& runway)
 {
 	writeString(f, runway.name);
 	writeLatLon(f, runway.start);
@@ -211,7 +213,7 @@ static void writeRunway(std::ofstream& f, const Airport::Runway& runway)
 	writeValue(f, runway.width);
 }
 
-static void readPolygons(std::ifstream& f, std::vector<LatLonPoints>& polygons)
+static void readPolygons(std::istream& f, std::vector<LatLonPoints>& polygons)
 {
 	uint16_t areaPolygonCount;
 	readValue(f, areaPolygonCount);
@@ -222,7 +224,7 @@ static void readPolygons(std::ifstream& f, std::vector<LatLonPoints>& polygons)
 	}
 }
 
-static void writePolygons(std::ofstream& f, const std::vector<LatLonPoints>& polygons)
+static void writePolygons(std::ostream& f, const std::vector<LatLonPoints>& polygons)
 {
 	uint16_t areaPolygonCount = polygons.size();
 	writeValue(f, areaPolygonCount);
@@ -232,7 +234,7 @@ static void writePolygons(std::ofstream& f, const std::vector<LatLonPoints>& pol
 	}
 }
 
-void Airport::load(std::ifstream& f)
+void Airport::load(std::istream& f)
 {
 	{
 		uint16_t runwayCount;
@@ -247,7 +249,7 @@ void Airport::load(std::ifstream& f)
 	readValue(f, altitude);
 }
 
-void Airport::save(std::ofstream& f) const
+void Airport::save(std::ostream& f) const
 {
 	uint16_t runwayCount = runways.size();
 	writeValue(f, runwayCount);
@@ -295,7 +297,7 @@ static FeaturePtr createFeature(FeatureType type)
 	return nullptr;
 }
 
-static void load(std::ifstream& f, std::vector<FeaturePtr>& features)
+static void load(std::istream& f, std::vector<FeaturePtr>& features)
 {
 	uint32_t typeCount;
 	readValue(f, typeCount);
@@ -328,7 +330,7 @@ static FeatureTypeCounts countFeatureTypes(const std::vector<FeaturePtr>& featur
 	return counts;
 }
 
-static void save(std::ofstream& f, const std::vector<FeaturePtr>& features)
+static void save(std::ostream& f, const std::vector<FeaturePtr>& features)
 {
 	FeatureTypeCounts counts = countFeatureTypes(features);
 	uint32_t countsSize = counts.size();
@@ -351,8 +353,6 @@ static void save(std::ofstream& f, const std::vector<FeaturePtr>& features)
 	}
 }
 
-static const uint32_t fileVersion = 1;
-
 void loadTile(const std::string& filename, std::vector<FeaturePtr>& features)
 {
 	std::ifstream f(filename, std::ios::binary);
@@ -362,27 +362,44 @@ void loadTile(const std::string& filename, std::vector<FeaturePtr>& features)
 		throw Exception("Could not open file: " + filename);
 	}
 
-	uint32_t version;
+	uint32_t version = 0;
 	f.read((char*)&version, sizeof(uint32_t));
 
-	if (version != fileVersion)
+	if (version == featureTileVersionV2)
+	{
+		f.close();
+		std::vector<FeaturePtr> tileFeatures = MappedFeatureTile(filename).toFeatures();
+		features.insert(features.end(), tileFeatures.begin(), tileFeatures.end());
+		return;
+	}
+
+	if (version != featureTileVersionV1)
 	{
-		throw Exception("Invalid file version: " + std::to_string(version) + ". Expected: " + std::to_string(fileVersion));
+		throw Exception("Invalid file version: " + std::to_string(version) + ". Expected: " + std::to_string(featureTileVersionV1) + " or " + std::to_string(featureTileVersionV2));
 	}
 
 	load(f, features);
 }
 
-void saveTile(const FeatureTile& tile, const std::string& filename)
+void saveTileV1(const std::vector<FeaturePtr>& features, std::ostream& f)
 {
-	std::ofstream f(filename, std::ios::binary);
-
 	// Write file version
-	int version = fileVersion;
+	int version = featureTileVersionV1;
 	writeValue(f, version);
 
 	// Write features
-	save(f, tile.features);
+	save(f, features);
+}
+
+void saveTile(const FeatureTile& tile, const std::string& filename)
+{
+	std::ofstream f(filename, std::ios::binary);
+	if (!f.is_open())
+	{
+		throw Exception("Could not open file for writing: " + filename);
+	}
+
+	saveTileV2(tile.features, f);
 
 	f.close();
 }
@@ -444,27 +461,32 @@ std::string getTilePathFromKey(const QuadTreeTileKey& key)
 	return std::to_string(key.level) + "/" + std::to_string(key.x) + "/" + std::to_string(key.y) + ".ftr";
 }
 
-static void saveTileRecursive(const FeatureTile& tile, const std::string& directory)
+static void saveTileToDirectory(const FeatureTile& tile, const std::string& directory)
+{
+	std::string tileDirectory = directory + "/" + std::to_string(tile.key.level) + "/" + std::to_string(tile.key.x);
+	std::filesystem::create_directories(tileDirectory);
+	saveTile(tile, tileDirectory + "/" + std::to_string(tile.key.y) + ".ftr");
+}
+
+static void findTilesWithFeatures(const FeatureTile& tile, std::vector<const FeatureTile*>& tiles)
 {
 	if (!tile.features.empty())
 	{
-		std::string tileDirectory = directory + "/" + std::to_string(tile.key.level) + "/" + std::to_string(tile.key.x);
-		std::filesystem::create_directories(tileDirectory);
-		saveTile(tile, tileDirectory + "/" + std::to_string(tile.key.y) + ".ftr");
+		tiles.push_back(&tile);
 	}
 
 	if (tile.hasChildren())
 	{
 		for (int i = 0; i < 4; ++i)
 		{
-			saveTileRecursive(*tile.children[i], directory);
+			findTilesWithFeatures(*tile.children[i], tiles);
 		}
 	}
 }
 
 static const std::string treeFilename = "tree.json";
 
-void save(const WorldFeatures::DiQuadTree& tree, const std::string& directory)
+void save(const WorldFeatures::DiQuadTree& tree, const std::string& directory, px_sched::Scheduler* scheduler)
 {
 	std::filesystem::create_directories(directory);
 	std::ofstream f(directory + "/" + treeFilename, std::ios::out | std::ios::binary);
@@ -477,8 +499,27 @@ void save(const WorldFeatures::DiQuadTree& tree, const std::string& directory)
 
 	f.close();
 
-	saveTileRecursive(tree.leftTree.getRoot(), directory);
-	saveTileRecursive(tree.rightTree.getRoot(), directory);
+	std::vector<const FeatureTile*> tiles;
+	findTilesWithFeatures(tree.leftTree.getRoot(), tiles);
+	findTilesWithFeatures(tree.rightTree.getRoot(), tiles);
+
+	if (!scheduler)
+	{
+		for (const FeatureTile* tile : tiles)
+		{
+			saveTileToDirectory(*tile, directory);
+		}
+		return;
+	}
+
+	px_sched::Sync sync;
+	for (const FeatureTile* tile : tiles)
+	{
+		scheduler->run([tile, &directory] {
+			saveTileToDirectory(*tile, directory);
+		}, &sync);
+	}
+	scheduler->waitFor(sync);
 }
 
 void addJsonFileTilesToTree(WorldFeatures& features, const std::string& filename)
@@ -513,26 +554,56 @@ static double maxSize(const LatLonBounds& box)
 	return std::max(size.x(), size.y());
 }
 
-static void addToTile(WorldFeatures::QuadTree& tree, FeatureTile& tile, const TreeCreatorParams& params, const BoundedFeature& feature)
+typedef std::vector<const BoundedFeature*> BoundedFeaturePtrs;
+
+//! Subtrees with at least this many features are built in their own job
+static const size_t minFeaturesPerJob = 10000;
+
+//! Adds features to the tile or its descendants, preserving the order of features within each tile.
+//! Each subtree is modified by only one job, so subtrees can be built concurrently.
+static void addToTile(WorldFeatures::QuadTree& tree, FeatureTile& tile, const TreeCreatorParams& params, const BoundedFeaturePtrs& features,
+	px_sched::Scheduler* scheduler, px_sched::Sync* sync)
 {
-	if (tile.bounds.intersects(feature.bounds.center()))
-	{
-		double minAllowedSize = maxSize(tile.bounds) * params.minFeatureSizeFraction;
+	auto descendantFeatures = std::make_shared<BoundedFeaturePtrs>();
+	double minAllowedSize = maxSize(tile.bounds) * params.minFeatureSizeFraction;
 
-		if (tile.key.level <= params.maxLodLevel && maxSize(feature.bounds) < minAllowedSize)
+	for (const BoundedFeature* feature : features)
+	{
+		if (tile.bounds.intersects(feature->bounds.center()))
 		{
-			if (!tile.hasChildren())
+			if (tile.key.level <= params.maxLodLevel && maxSize(feature->bounds) < minAllowedSize)
 			{
-				tree.subdivide(tile);
+				descendantFeatures->push_back(feature);
 			}
-			for (int i = 0; i < 4; ++i)
+			else
 			{
-				addToTile(tree, *tile.children[i], params, feature);
+				tile.features.push_back(feature->feature);
 			}
 		}
+	}
+
+	if (descendantFeatures->empty())
+	{
+		return;
+	}
+
+	if (!tile.hasChildren())
+	{
+		tree.subdivide(tile);
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		FeatureTile& child = *tile.children[i];
+		if (scheduler && descendantFeatures->size() >= minFeaturesPerJob)
+		{
+			scheduler->run([&tree, &child, &params, descendantFeatures, scheduler, sync] {
+				addToTile(tree, child, params, *descendantFeatures, scheduler, sync);
+			}, sync);
+		}
 		else
 		{
-			tile.features.push_back(feature.feature);
+			addToTile(tree, child, params, *descendantFeatures, scheduler, sync);
 		}
 	}
 }
@@ -550,18 +621,47 @@ std::unique_ptr<FeatureTile> WorldFeatures::createTile(const QuadTreeTileKey& ke
 	return std::unique_ptr<FeatureTile>(tile);
 };
 
-WorldFeatures createWorldFeatures(const TreeCreatorParams& params, const std::vector<FeaturePtr>& features)
+WorldFeatures createWorldFeatures(const TreeCreatorParams& params, const std::vector<FeaturePtr>& features, px_sched::Scheduler* scheduler)
 {
+	std::vector<BoundedFeature> boundedFeatures(features.size());
+	auto calcBounds = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			boundedFeatures[i].feature = features[i];
+			boundedFeatures[i].bounds = features[i]->calcBounds();
+		}
+	};
+
+	px_sched::Sync sync;
+	if (scheduler)
+	{
+		for (size_t begin = 0; begin < features.size(); begin += minFeaturesPerJob)
+		{
+			scheduler->run([&calcBounds, begin, &features] {
+				calcBounds(begin, std::min(begin + minFeaturesPerJob, features.size()));
+			}, &sync);
+		}
+		scheduler->waitFor(sync);
+	}
+	else
+	{
+		calcBounds(0, features.size());
+	}
+
+	BoundedFeaturePtrs featurePtrs(boundedFeatures.size());
+	for (size_t i = 0; i < boundedFeatures.size(); ++i)
+	{
+		featurePtrs[i] = &boundedFeatures[i];
+	}
+
 	WorldFeatures worldFeatures;
-	for (const FeaturePtr& feature : features)
+	addToTile(worldFeatures.tree.leftTree, worldFeatures.tree.leftTree.getRoot(), params, featurePtrs, scheduler, &sync);
+	addToTile(worldFeatures.tree.rightTree, worldFeatures.tree.rightTree.getRoot(), params, featurePtrs, scheduler, &sync);
+	if (scheduler)
 	{
-		BoundedFeature boundedFeature;
-		boundedFeature.feature = feature;
-		boundedFeature.bounds = feature->calcBounds();
-		addToTile(worldFeatures.tree.leftTree, worldFeatures.tree.leftTree.getRoot(), params, boundedFeature);
-		addToTile(worldFeatures.tree.rightTree, worldFeatures.tree.rightTree.getRoot(), params, boundedFeature);
+		scheduler->waitFor(sync);
 	}
-	
+
 	return worldFeatures;
 }
 
@@ -14,6 +14,7 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <iosfwd>
 #include <map>
 #include <memory>
 #include <string>
@@ -40,8 +41,8 @@ struct Feature
 	virtual ~Feature() {}
 	virtual FeatureType type() const = 0;
 
-	virtual void load(std::ifstream& f) = 0;
-	virtual void save(std::ofstream& f) const = 0;
+	virtual void load(std::istream& f) = 0;
+	virtual void save(std::ostream& f) const = 0;
 	virtual LatLonBounds calcBounds() const = 0;
 };
 
@@ -49,8 +50,8 @@ struct PolyFeature : public Feature
 {
 	std::vector<sim::LatLonAlt> points;
 
-	void load(std::ifstream& f) override;
-	void save(std::ofstream& f) const override;
+	void load(std::istream& f) override;
+	void save(std::ostream& f) const override;
 	LatLonBounds calcBounds() const override;
 };
 
@@ -61,8 +62,8 @@ struct Road : public PolyFeature
 	float width;
 	int laneCount;
 	
-	void load(std::ifstream& f) override;
-	void save(std::ofstream& f) const override;
+	void load(std::istream& f) override;
+	void save(std::ostream& f) const override;
 };
 
 struct Building : public PolyFeature
@@ -71,8 +72,8 @@ struct Building : public PolyFeature
 
 	float height;
 	
-	void load(std::ifstream& f) override;
-	void save(std::ofstream& f) const override;
+	void load(std::istream& f) override;
+	void save(std::ostream& f) const override;
 };
 
 struct Water : public PolyFeature
@@ -99,8 +100,8 @@ struct Airport : public Feature
 	std::vector<LatLonPoints> areaPolygons; //!< Polygons that define the airport area
 	double altitude = 0;
 
-	void load(std::ifstream& f) override;
-	void save(std::ofstream& f) const override;
+	void load(std::istream& f) override;
+	void save(std::ostream& f) const override;
 	LatLonBounds calcBounds() const override;
 };
 
@@ -130,12 +131,21 @@ struct TreeCreatorParams
 	int maxLodLevel;
 };
 
-WorldFeatures createWorldFeatures(const TreeCreatorParams& params, const std::vector<FeaturePtr>& features);
+//! @param scheduler is used to build the tree in parallel. May be null.
+WorldFeatures createWorldFeatures(const TreeCreatorParams& params, const std::vector<FeaturePtr>& features, px_sched::Scheduler* scheduler = nullptr);
 
+//! Saves the tile in the version 2 format. See MappedFeatureTile.
 void saveTile(const FeatureTile& tile, const std::string& filename);
+
+//! Loads a tile in either the version 1 or version 2 format.
+//! For rendering, prefer MappedFeatureTile which reads version 2 tiles without deserializing them.
 void loadTile(const std::string& filename, std::vector<FeaturePtr>& features);
 
-void save(const WorldFeatures::DiQuadTree& tree, const std::string& directory);
+//! Saves features in the legacy version 1 format, which is read with one stream read per value
+void saveTileV1(const std::vector<FeaturePtr>& features, std::ostream& f);
+
+//! @param scheduler is used to write tiles in parallel. May be null.
+void save(const WorldFeatures::DiQuadTree& tree, const std::string& directory, px_sched::Scheduler* scheduler = nullptr);
 void addJsonFileTilesToTree(WorldFeatures& features, const std::string& filename);
 
 void saveAirports(const std::map<std::string, AirportPtr>& airports, const std::string& filename);
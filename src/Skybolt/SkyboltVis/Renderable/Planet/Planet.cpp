@@ -580,6 +580,7 @@ Planet::Planet(const PlanetConfig& config) :
 
 		PlanetSurfaceConfig surfaceConfig;
 		surfaceConfig.scheduler = config.scheduler;
+		surfaceConfig.schedulerThreadCount = config.schedulerThreadCount;
 		surfaceConfig.programs = config.programs;
 		surfaceConfig.radius = mInnerRadius;
 		surfaceConfig.osgTileFactory = osgTileFactory;
@@ -32,6 +32,7 @@ namespace vis {
 struct PlanetConfig
 {
 	px_sched::Scheduler* scheduler;
+	int schedulerThreadCount = 1; //!< Number of threads the scheduler runs tasks on
 	const ShaderPrograms* programs;
 	Scene* scene;
 	sim::LatLon latLonOrigin;
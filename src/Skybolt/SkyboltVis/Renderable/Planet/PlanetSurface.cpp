@@ -112,7 +112,7 @@ PlanetSurface::PlanetSurface(const PlanetSurfaceConfig& config) :
 	imageLoader->minAttributeLod = config.attributeMinLodLevel;
 	imageLoader->maxAttributeLod = config.attributeMaxLodLevel;
 
-	AsyncTileLoaderPtr loader(new AsyncTileLoader(imageLoader, config.scheduler));
+	AsyncTileLoaderPtr loader(new AsyncTileLoader(imageLoader, config.scheduler, config.schedulerThreadCount));
 
 	mTileSource.reset(new QuadTreeTileLoader(loader, mPredicate));
 }
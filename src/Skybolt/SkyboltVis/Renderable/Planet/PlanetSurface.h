@@ -39,6 +39,7 @@ struct PlanetTileSources
 struct PlanetSurfaceConfig
 {
 	px_sched::Scheduler* scheduler;
+	int schedulerThreadCount = 1; //!< Number of threads the scheduler runs tasks on
 	const ShaderPrograms* programs;
 	osg::ref_ptr<osg::MatrixTransform> parentTransform; //!< Planet transform
 	PlanetTileSources planetTileSources;
@@ -7,18 +7,34 @@
 #include "AsyncTileLoader.h"
 #include "TileImagesLoader.h"
 
+#include <algorithm>
+
 using namespace skybolt;
 
 namespace skybolt {
 namespace vis {
 
-AsyncTileLoader::AsyncTileLoader(const TileImagesLoaderPtr& tileImageLoader, px_sched::Scheduler* scheduler) :
-	mTileImageLoader(tileImageLoader), mScheduler(scheduler)
+static const int minRunningLoads = 2;
+
+//! Number of saturated updates over which the load completion rate is measured.
+//! Loads typically take several updates to complete, so the rate of a single update is too noisy to act on.
+static const int measurementUpdateCount = 30;
+
+AsyncTileLoader::AsyncTileLoader(const TileImagesLoaderPtr& tileImageLoader, px_sched::Scheduler* scheduler, int schedulerThreadCount) :
+	mTileImageLoader(tileImageLoader),
+	mScheduler(scheduler),
+	mMaxRunningLoadsCap(std::max(1, schedulerThreadCount)),
+	mMaxRunningLoads(mMaxRunningLoadsCap)
 {
 }
 
 AsyncTileLoader::~AsyncTileLoader()
 {
+	for (const Request& request : mPendingRequests)
+	{
+		request.progressCallback->state = TileProgressCallback::State::FailedOrCanceled;
+	}
+
 	for (const Request& request : mRequests)
 	{
 		request.progressCallback->requestCancel();
@@ -33,17 +49,104 @@ void AsyncTileLoader::load(const QuadTreeTileKey& key, const TileImagesPtrPtr& r
 	request.result = result;
 	request.progressCallback = progress;
 
-	typedef std::shared_ptr<TileProgressCallback> TileProgressCallbackPtr;
 	request.progressCallback->state = TileProgressCallback::State::Loading;
 
+	if ((int)mRequests.size() < mMaxRunningLoads)
+	{
+		startLoad(request);
+	}
+	else
+	{
+		mPendingRequests.push_back(request);
+	}
+}
+
+void AsyncTileLoader::startLoad(const Request& request)
+{
 	mRequests.push_back(request);
 
 	mScheduler->run([=]() {
-		*request.result = mTileImageLoader->load(key, [=] {return progress->isCancelRequested(); });
-		request.progressCallback->state = *request.result ? TileProgressCallback::State::Loaded : TileProgressCallback::State::FailedOrCanceled;
+		const ProgressCallbackPtr& progress = request.progressCallback;
+		*request.result = mTileImageLoader->load(request.key, [=] {return progress->isCancelRequested(); });
+		progress->state = *request.result ? TileProgressCallback::State::Loaded : TileProgressCallback::State::FailedOrCanceled;
 	}, &mLoadingTaskSync);
 }
 
+void AsyncTileLoader::startPendingLoads()
+{
+	// Discard stale requests which were canceled before they started
+	mPendingRequests.erase(std::remove_if(mPendingRequests.begin(), mPendingRequests.end(), [](const Request& request) {
+		if (request.progressCallback->isCancelRequested())
+		{
+			request.progressCallback->state = TileProgressCallback::State::FailedOrCanceled;
+			return true;
+		}
+		return false;
+	}), mPendingRequests.end());
+
+	int startCount = std::min((int)mPendingRequests.size(), mMaxRunningLoads - (int)mRequests.size());
+	if (startCount <= 0)
+	{
+		return;
+	}
+
+	// Priorities may have changed since the requests were made, so sort every update
+	std::partial_sort(mPendingRequests.begin(), mPendingRequests.begin() + startCount, mPendingRequests.end(), [](const Request& a, const Request& b) {
+		return a.progressCallback->priority.load() > b.progressCallback->priority.load();
+	});
+
+	for (int i = 0; i < startCount; ++i)
+	{
+		startLoad(mPendingRequests[i]);
+	}
+	mPendingRequests.erase(mPendingRequests.begin(), mPendingRequests.begin() + startCount);
+}
+
+void AsyncTileLoader::adaptMaxRunningLoads(int completedLoadCount)
+{
+	bool saturated = !mPendingRequests.empty();
+	if (!saturated)
+	{
+		// Throughput is limited by demand rather than the running load limit, so the rate says nothing about the limit
+		mMeasurement = Measurement();
+		return;
+	}
+
+	mMeasurement.completedLoadCount += completedLoadCount;
+	if (++mMeasurement.updateCount < measurementUpdateCount)
+	{
+		return;
+	}
+
+	double rate = double(mMeasurement.completedLoadCount) / double(mMeasurement.updateCount);
+	mMeasurement = Measurement();
+
+	// Loads beyond the scheduler's thread count would wait in the scheduler's FIFO queue,
+	// where they can not be reprioritized, so the limit never exceeds the thread count.
+	int minLimit = std::min(minRunningLoads, mMaxRunningLoadsCap);
+	int previousMaxRunningLoads = mMaxRunningLoads;
+
+	if (rate == 0)
+	{
+		// Loads have stalled, e.g. on a slow source. Running loads can not be reprioritized,
+		// so running fewer lets higher priority requests made later start sooner once loads resume.
+		mMaxRunningLoads = std::max(mMaxRunningLoads - 1, minLimit);
+	}
+	else if (mLastLimitChange > 0 && rate <= mPreviousRate)
+	{
+		// The last increase did not improve throughput, so revert it
+		mMaxRunningLoads = std::max(mMaxRunningLoads - 1, minLimit);
+	}
+	else
+	{
+		// Probe whether running another load improves throughput
+		mMaxRunningLoads = std::min(mMaxRunningLoads + 1, mMaxRunningLoadsCap);
+	}
+
+	mLastLimitChange = mMaxRunningLoads - previousMaxRunningLoads;
+	mPreviousRate = rate;
+}
+
 void AsyncTileLoader::waitForLoads()
 {
 	mScheduler->waitFor(mLoadingTaskSync);
@@ -54,6 +157,7 @@ void AsyncTileLoader::update()
 	// Update requests
 	static const int maxTileLoadsPerUpdate = 16; // tweek to give best performance. Smaller numbers give less frame stutters but potentially longer load delays.
 	int tileLoads = 0;
+	int completedLoadCount = 0;
 
 	for (int i = 0; i < (int)mRequests.size(); ++i)
 	{
@@ -62,6 +166,7 @@ void AsyncTileLoader::update()
 		if (state == TileProgressCallback::State::FailedOrCanceled)
 		{
 			mRequests.erase(mRequests.begin() + i);
+			++completedLoadCount;
 			--i;
 		}
 		else if (request.result->get() && tileLoads < maxTileLoadsPerUpdate)
@@ -69,9 +174,13 @@ void AsyncTileLoader::update()
 			mRequests.erase(mRequests.begin() + i);
 
 			++tileLoads;
+			++completedLoadCount;
 			--i;
 		}
 	}
+
+	adaptMaxRunningLoads(completedLoadCount);
+	startPendingLoads();
 }
 
 } // namespace vis
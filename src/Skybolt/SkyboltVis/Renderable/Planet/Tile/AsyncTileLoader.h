@@ -26,6 +26,7 @@ struct TileProgressCallback
 	};
 
 	std::atomic<State> state = State::Loading;
+	std::atomic<double> priority = 0.0; //!< Loads with higher priority are started first. May be changed while the load is pending.
 
 	bool isCancelRequested() const { return canceledRequested; }
 	void requestCancel() { canceledRequested = true; }
@@ -34,10 +35,16 @@ private:
 	std::atomic<bool> canceledRequested = false;
 };
 
+//! Loads tiles on background threads.
+//! Only a limited number of loads run on the scheduler at once. Remaining loads wait in a pending queue,
+//! and are started in order of their progress callback's priority as running loads complete.
+//! Pending loads which are canceled are discarded without being started.
+//! The number of concurrent loads adapts to the measured load throughput, up to the scheduler's thread count.
 class AsyncTileLoader
 {
 public:
-	AsyncTileLoader(const TileImagesLoaderPtr& tileImageLoader, px_sched::Scheduler* scheduler);
+	//! @param schedulerThreadCount is the number of threads the scheduler runs tasks on
+	AsyncTileLoader(const TileImagesLoaderPtr& tileImageLoader, px_sched::Scheduler* scheduler, int schedulerThreadCount);
 
 	~AsyncTileLoader();
 
@@ -45,15 +52,21 @@ public:
 
 	void load(const skybolt::QuadTreeTileKey& key, const TileImagesPtrPtr& result, const ProgressCallbackPtr& progress);
 
+	//! Waits for running loads to complete. Pending loads are not started.
 	void waitForLoads();
 
 	void update();
 
-private:
-	TileImagesLoaderPtr mTileImageLoader;
-	px_sched::Scheduler* mScheduler;
-	px_sched::Sync mLoadingTaskSync;
+	size_t getPendingLoadCount() const { return mPendingRequests.size(); }
+	int getMaxRunningLoads() const { return mMaxRunningLoads; }
+
+	//! @returns the maximum number of unfinished loads that clients should have requested.
+	//! This is more than the running load limit, so that there are always pending loads to start in priority order,
+	//! and so that the running load limit can adapt upwards. It follows the running load limit,
+	//! so that clients do not queue loads which would become stale before they could start.
+	int getMaxRequestedLoads() const { return mMaxRunningLoads * 2; }
 
+private:
 	struct Request
 	{
 		skybolt::QuadTreeTileKey key;
@@ -61,7 +74,33 @@ private:
 		ProgressCallbackPtr progressCallback;
 	};
 
-	std::vector<Request> mRequests;
+	void startLoad(const Request& request);
+
+	//! Starts highest priority pending loads until the running load limit is reached
+	void startPendingLoads();
+
+	//! Adjusts the running load limit based on the measured rate at which loads complete.
+	//! The limit is increased while doing so increases the rate, and decreased if loads stall.
+	void adaptMaxRunningLoads(int completedLoadCount);
+
+private:
+	TileImagesLoaderPtr mTileImageLoader;
+	px_sched::Scheduler* mScheduler;
+	px_sched::Sync mLoadingTaskSync;
+
+	std::vector<Request> mRequests; //!< Running requests
+	std::vector<Request> mPendingRequests; //!< Requests not yet started
+	const int mMaxRunningLoadsCap;
+	int mMaxRunningLoads;
+
+	struct Measurement
+	{
+		int updateCount = 0; //!< Number of consecutive saturated updates measured
+		int completedLoadCount = 0;
+	};
+	Measurement mMeasurement;
+	double mPreviousRate = 0; //!< Loads completed per update in the previous measurement
+	int mLastLimitChange = 0; //!< Change made to mMaxRunningLoads after the previous measurement
 };
 
 } // namespace vis
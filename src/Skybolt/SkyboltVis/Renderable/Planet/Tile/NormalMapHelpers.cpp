@@ -8,47 +8,161 @@
 #include <algorithm>
 #include <assert.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKYBOLT_NORMAL_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace skybolt {
 namespace vis {
 
-osg::ref_ptr<osg::Image> createNormalmapFromHeightmap(const osg::Image& heightmap, const osg::Vec2f& texelWorldSize)
+static osg::ref_ptr<osg::Image> allocateNormalMap(int width, int height)
+{
+	osg::Image* image = new osg::Image;
+	image->allocateImage(width, height, 1, GL_RGB, GL_UNSIGNED_BYTE);
+	image->setInternalTextureFormat(GL_RGB8);
+	return image;
+}
+
+//! Calculates normal for pixel x from rows of heights, where row1 is the row below row0
+static void writeNormal(const uint16_t* row0, const uint16_t* row1, int x, const osg::Vec2f& texelWorldSize, unsigned char* p)
+{
+	uint16_t h00 = row0[x];
+	uint16_t h10 = row0[x + 1];
+	uint16_t h01 = row1[x];
+	uint16_t h11 = row1[x + 1];
+
+	float dhx = 0.5f * ((h10 + h11) - (h00 + h01));
+	float dhy = 0.5f * ((h01 + h11) - (h00 + h10));
+
+	osg::Vec3f normal = osg::Vec3f(texelWorldSize.x(), 0, dhx) ^ osg::Vec3f(0, texelWorldSize.y(), dhy);
+	normal.normalize();
+
+	// Clamp to avoid overflow when a component is exactly 1
+	p[0] = std::min(255.0f, normal.x() * 128.0f + 128.0f);
+	p[1] = std::min(255.0f, normal.y() * 128.0f + 128.0f);
+}
+
+osg::ref_ptr<osg::Image> createNormalmapFromHeightmapScalar(const osg::Image& heightmap, const osg::Vec2f& texelWorldSize)
 {
 	assert(heightmap.getInternalTextureFormat() == GL_R16);
 
 	const int width = heightmap.s();
 	const int height = heightmap.t();
 
-	osg::Image* image = new osg::Image;
-	image->allocateImage(width, height, 1, GL_RGB, GL_UNSIGNED_BYTE);
-	image->setInternalTextureFormat(GL_RGB8);
-
+	osg::ref_ptr<osg::Image> image = allocateNormalMap(width, height);
 	unsigned char* p = image->data();
+	const uint16_t* heights = reinterpret_cast<const uint16_t*>(heightmap.data());
 
 	for (int y = 0; y < height; ++y)
 	{
+		int py = std::min(y, height - 2);
+		const uint16_t* row0 = heights + width * py;
+		const uint16_t* row1 = row0 + width;
+
 		for (int x = 0; x < width; ++x)
 		{
-			int px = std::min(x, width - 2);
-			int py = std::min(y, height - 2);
+			writeNormal(row0, row1, std::min(x, width - 2), texelWorldSize, p);
+			p += 3;
+		}
+	}
+	return image;
+}
+
+#ifdef SKYBOLT_NORMAL_MAP_SSE2
+
+//! Loads 4 consecutive heights and converts them to floats
+static inline __m128 loadHeights(const uint16_t* heights)
+{
+	__m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(heights));
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(h, _mm_setzero_si128()));
+}
+
+//! Calculates normals for pixels x to x+3 of a row. Requires x + 4 < width.
+static inline void writeNormals4(const uint16_t* row0, const uint16_t* row1, int x, __m128 tx, __m128 ty, __m128 nz2, unsigned char* p)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 scale = _mm_set1_ps(128.0f);
 
-			uint16_t h00 = *(const uint16_t*)&heightmap.data()[2 * (px + heightmap.s() * py)];
-			uint16_t h10 = *(const uint16_t*)&heightmap.data()[2 * ((px + 1) + heightmap.s() * py)];
-			uint16_t h01 = *(const uint16_t*)&heightmap.data()[2 * (px + heightmap.s() * (py + 1))];
-			uint16_t h11 = *(const uint16_t*)&heightmap.data()[2 * ((px + 1) + heightmap.s() * (py + 1))];
+	__m128 h00 = loadHeights(row0 + x);
+	__m128 h10 = loadHeights(row0 + x + 1);
+	__m128 h01 = loadHeights(row1 + x);
+	__m128 h11 = loadHeights(row1 + x + 1);
 
-			float dhx = 0.5f * ((h10 + h11) - (h00 + h01));
-			float dhy = 0.5f * ((h01 + h11) - (h00 + h10));
+	__m128 dhx = _mm_mul_ps(half, _mm_sub_ps(_mm_add_ps(h10, h11), _mm_add_ps(h00, h01)));
+	__m128 dhy = _mm_mul_ps(half, _mm_sub_ps(_mm_add_ps(h01, h11), _mm_add_ps(h00, h10)));
 
-			osg::Vec3f normal = osg::Vec3f(texelWorldSize.x(), 0, dhx) ^ osg::Vec3f(0, texelWorldSize.y(), dhy);
-			normal.normalize();
+	// Cross product of (tx, 0, dhx) and (0, ty, dhy)
+	__m128 nx = _mm_mul_ps(dhx, ty);
+	__m128 ny = _mm_mul_ps(tx, dhy);
 
-			*p++ = normal.x() * 128.0f + 128.0f;
-			*p++ = normal.y() * 128.0f + 128.0f;
-			p++;
+	// Reciprocal square root with one Newton-Raphson iteration for near full float precision
+	__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), nz2);
+	__m128 r = _mm_rsqrt_ps(lengthSq);
+	r = _mm_mul_ps(_mm_mul_ps(half, r), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(lengthSq, r), r)));
+
+	// nx and ny are negated by subtracting from the offset
+	__m128i outX = _mm_cvttps_epi32(_mm_sub_ps(scale, _mm_mul_ps(_mm_mul_ps(nx, r), scale)));
+	__m128i outY = _mm_cvttps_epi32(_mm_sub_ps(scale, _mm_mul_ps(_mm_mul_ps(ny, r), scale)));
+
+	// Pack to bytes with saturation. Bytes 0-3 hold x components and bytes 4-7 hold y components.
+	alignas(16) unsigned char bytes[16];
+	__m128i packed = _mm_packs_epi32(outX, outY);
+	_mm_store_si128(reinterpret_cast<__m128i*>(bytes), _mm_packus_epi16(packed, packed));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		p[3 * i] = bytes[i];
+		p[3 * i + 1] = bytes[4 + i];
+	}
+}
+
+osg::ref_ptr<osg::Image> createNormalmapFromHeightmap(const osg::Image& heightmap, const osg::Vec2f& texelWorldSize)
+{
+	assert(heightmap.getInternalTextureFormat() == GL_R16);
+
+	const int width = heightmap.s();
+	const int height = heightmap.t();
+
+	osg::ref_ptr<osg::Image> image = allocateNormalMap(width, height);
+	const uint16_t* heights = reinterpret_cast<const uint16_t*>(heightmap.data());
+
+	const __m128 tx = _mm_set1_ps(texelWorldSize.x());
+	const __m128 ty = _mm_set1_ps(texelWorldSize.y());
+	const __m128 nz = _mm_mul_ps(tx, ty); // z component of normal before normalization
+	const __m128 nz2 = _mm_mul_ps(nz, nz);
+
+	for (int y = 0; y < height; ++y)
+	{
+		int py = std::min(y, height - 2);
+		const uint16_t* row0 = heights + width * py;
+		const uint16_t* row1 = row0 + width;
+		unsigned char* p = image->data() + 3 * width * y;
+
+		// Main loop, reading heights at x to x+4
+		int x = 0;
+		for (; x + 4 < width; x += 4)
+		{
+			writeNormals4(row0, row1, x, tx, ty, nz2, p + 3 * x);
+		}
+
+		// Remaining pixels, including the last column which reuses the gradient of the second last column
+		for (; x < width; ++x)
+		{
+			writeNormal(row0, row1, std::min(x, width - 2), texelWorldSize, p + 3 * x);
 		}
 	}
 	return image;
 }
 
+#else
+
+osg::ref_ptr<osg::Image> createNormalmapFromHeightmap(const osg::Image& heightmap, const osg::Vec2f& texelWorldSize)
+{
+	return createNormalmapFromHeightmapScalar(heightmap, texelWorldSize);
+}
+
+#endif // SKYBOLT_NORMAL_MAP_SSE2
+
 } // namespace vis
 } // namespace skybolt
@@ -11,7 +11,12 @@
 namespace skybolt {
 namespace vis {
 
+//! Creates an RGB8 tangent space normal map from a GL_R16 heightmap.
+//! Uses SSE2 where available, otherwise falls back to createNormalmapFromHeightmapScalar.
 osg::ref_ptr<osg::Image> createNormalmapFromHeightmap(const osg::Image& heightmap, const osg::Vec2f& texelWorldSize);
 
+//! Non-vectorized reference implementation of createNormalmapFromHeightmap
+osg::ref_ptr<osg::Image> createNormalmapFromHeightmapScalar(const osg::Image& heightmap, const osg::Vec2f& texelWorldSize);
+
 } // namespace vis
 } // namespace skybolt
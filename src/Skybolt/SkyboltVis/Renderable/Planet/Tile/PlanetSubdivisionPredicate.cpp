@@ -22,6 +22,16 @@ bool PlanetSubdivisionPredicate::operator()(const Box2d& bounds, const QuadTreeT
 		return false;
 	}
 
+	return calcProjectedSizeRatio(bounds, key) > 1.0;
+}
+
+double PlanetSubdivisionPredicate::getLoadPriority(const Box2d& bounds, const QuadTreeTileKey& key)
+{
+	return calcProjectedSizeRatio(bounds, key);
+}
+
+double PlanetSubdivisionPredicate::calcProjectedSizeRatio(const Box2d& bounds, const QuadTreeTileKey& key) const
+{
 	Box2d latLonBounds(math::vec2SwapComponents(bounds.minimum), math::vec2SwapComponents(bounds.maximum));
 
 	osg::Vec2d latLon = nearestPointInSolidBox(observerLatLon, latLonBounds);
@@ -40,10 +50,10 @@ bool PlanetSubdivisionPredicate::operator()(const Box2d& bounds, const QuadTreeT
 	{
 		double tileSize = planetRadius / std::pow(2, key.level);
 		double projectedSize = tileSize / std::max(0.01, distance);
-		return projectedSize > glm::mix(0.4f, 0.1f, cosElevation); // TODO: tune
+		return projectedSize / glm::mix(0.4f, 0.1f, cosElevation); // TODO: tune
 	}
 
-	return false;
+	return 0.0;
 }
 
 osg::Vec2d PlanetSubdivisionPredicate::nearestPointInSolidBox(const osg::Vec2d& point, const Box2d& bounds) const
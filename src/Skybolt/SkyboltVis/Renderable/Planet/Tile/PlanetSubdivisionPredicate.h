@@ -21,12 +21,20 @@ struct PlanetSubdivisionPredicate : public QuadTreeSubdivisionPredicate
 
 	bool operator()(const Box2d& bounds, const skybolt::QuadTreeTileKey& key) override;
 
+	//! Priority is the tile's projected size relative to the subdivision threshold, i.e. a measure of its screen-space error.
+	//! Tiles that are large on screen and close to the observer have the highest priority.
+	double getLoadPriority(const Box2d& bounds, const skybolt::QuadTreeTileKey& key) override;
+
 	osg::Vec2d observerLatLon;
 	double observerAltitude;
 	double planetRadius;
 	int maxLevel;
 
 private:
+	//! @returns projected size of tile divided by the size above which the tile should be subdivided,
+	//! or zero if the tile is not visible.
+	double calcProjectedSizeRatio(const Box2d& bounds, const skybolt::QuadTreeTileKey& key) const;
+
 	// TODO: handle longitude wrap around
 	osg::Vec2d nearestPointInSolidBox(const osg::Vec2d& point, const Box2d& bounds) const;
 };
@@ -75,6 +75,37 @@ static void fillBathymetryInHeightmap(osg::Image& src)
 	}
 }
 
+//! Images derived from a height map, attached to the height map as user data
+//! so that they are cached and evicted together with the height map.
+struct DerivedHeightMapImages : public DerivedTileImages
+{
+	osg::ref_ptr<osg::Image> normalMap;
+	osg::ref_ptr<osg::Image> landMask;
+
+	size_t getSizeInBytes() const override
+	{
+		return normalMap->getTotalSizeInBytes() + landMask->getTotalSizeInBytes();
+	}
+};
+
+//! Calculates derived images from the unmodified height map, then fills bathymetry in the height map.
+//! This must happen once when the height map is loaded, because filling bathymetry modifies the height map in place.
+static void attachDerivedImagesToHeightMap(osg::Image& heightImage, const QuadTreeTileKey& key, double planetRadius)
+{
+	auto bounds = getKeyLonLatBounds<osg::Vec2>(key);
+	osg::Vec2 heightImageLonLatDelta = bounds.size();
+	osg::Vec2 texelWorldSize = osg::Vec2f(
+		heightImageLonLatDelta.x() * planetRadius * std::cos(bounds.center().y()) / heightImage.s(),
+		heightImageLonLatDelta.y() * planetRadius / heightImage.t()
+	);
+
+	osg::ref_ptr<DerivedHeightMapImages> derivedImages = new DerivedHeightMapImages;
+	derivedImages->normalMap = createNormalmapFromHeightmap(heightImage, texelWorldSize);
+	derivedImages->landMask = convertHeightmapToLandMask(heightImage);
+	fillBathymetryInHeightmap(heightImage); // TODO: Remove this hack of modifying the height map
+	heightImage.setUserData(derivedImages);
+}
+
 //! May be called from multiple threads
 TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const
 {
@@ -97,10 +128,11 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 			if (image)
 			{
 				image->setInternalTextureFormat(GL_R16);
+				attachDerivedImagesToHeightMap(*image, key, mPlanetRadius);
 			}
 
 			return image;
-		});
+		}, 0, cancelSupplier);
 
 #ifdef ENABLE_TILE_IMAGE_LOADER_PROFILING
 		std::cout << "Height," << key.level << "," << timer.count() << std::endl;
@@ -110,28 +142,19 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 
 		static osg::ref_ptr<osg::Image> defaultImage = createDefaultImage();
 		static osg::ref_ptr<osg::Image> defaultNormalMap = createNormalmapFromHeightmap(*defaultImage, osg::Vec2(1,1));
-		static osg::ref_ptr<osg::Image> defaultLandMask = convertHeightmapToLandMask(*defaultImage);
 
 		osg::ref_ptr<osg::Image> heightImage = images->heightMapImage.image;
 		if (heightImage)
 		{
-			auto bounds = getKeyLonLatBounds<osg::Vec2>(images->heightMapImage.key);
-			osg::Vec2 heightImageLonLatDelta = bounds.size();
-			osg::Vec2 texelWorldSize = osg::Vec2f(
-				heightImageLonLatDelta.x() * mPlanetRadius * std::cos(bounds.center().y()) / heightImage->s(),
-				heightImageLonLatDelta.y() * mPlanetRadius / heightImage->t()
-			);
-			images->normalMapImage = createNormalmapFromHeightmap(*heightImage, texelWorldSize);
-
-			images->landMaskImage = getOrCreateImage(images->heightMapImage.key, size_t(CacheIndex::LandMask), [heightImage](const QuadTreeTileKey& key) {
-				if (heightImage == defaultImage)
-				{
-					return defaultLandMask;
-				}
-				osg::ref_ptr<osg::Image> image = convertHeightmapToLandMask(*heightImage);
-				fillBathymetryInHeightmap(*heightImage); // TODO: Remove this hack of modifying the heightImage in the factory for the land mask.
-				return image;
-			}).image;
+			auto derivedImages = dynamic_cast<const DerivedHeightMapImages*>(heightImage->getUserData());
+			if (!derivedImages)
+			{
+				// The height map was not created by this loader. Derived images can not be regenerated from it
+				// because bathymetry may already have been filled in, so skip the tile.
+				return nullptr;
+			}
+			images->normalMapImage = derivedImages->normalMap;
+			images->landMaskImage = derivedImages->landMask;
 		}
 		else
 		{
@@ -149,7 +172,7 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 	images->albedoMapImage = getOrCreateImage(key, size_t(CacheIndex::Albedo), [this, cancelSupplier](const QuadTreeTileKey& key) {
 		osg::ref_ptr<osg::Image> image = albedoLayer->createImage(key, cancelSupplier);
 		return image;
-	});
+	}, 0, cancelSupplier);
 
 #ifdef ENABLE_TILE_IMAGE_LOADER_PROFILING
 	std::cout << "Albedo," << key.level << "," << timer.count() << std::endl;
@@ -170,7 +193,7 @@ TileImagesPtr PlanetTileImagesLoader::load(const QuadTreeTileKey& key, std::func
 					image = convertAttributeMap(*image, getNlcdAttributeColors());
 				}
 				return image;
-			}, minAttributeLod);
+			}, minAttributeLod, cancelSupplier);
 			if (!images->attributeMapImage->image)
 			{
 				images->attributeMapImage = std::nullopt;
@@ -35,13 +35,13 @@ public:
 
 	enum class CacheIndex
 	{
-		Elevation,
-		LandMask,
+		Elevation, //!< Height maps, with derived normal map and land mask images attached
 		Albedo,
-		Attribute
+		Attribute,
+		Count
 	};
 
-	PlanetTileImagesLoader(double planetRadius) : TileImagesLoader(4), mPlanetRadius(planetRadius) {}
+	PlanetTileImagesLoader(double planetRadius) : TileImagesLoader(size_t(CacheIndex::Count)), mPlanetRadius(planetRadius) {}
 
 	//! May be called from multiple threads
 	TileImagesPtr load(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override;
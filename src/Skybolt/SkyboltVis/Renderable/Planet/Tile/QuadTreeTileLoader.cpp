@@ -12,6 +12,8 @@
 #include <SkyboltCommon/Listenable.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 
+#include <algorithm>
+
 using namespace skybolt;
 
 namespace skybolt {
@@ -110,6 +112,7 @@ void QuadTreeTileLoader::update(std::vector<AsyncQuadTreeTile*>& addedTiles, std
 {
 	traveseToLoadAndUnload(mWorldTree->leftTree, mWorldTree->leftTree.getRoot(), false);
 	traveseToLoadAndUnload(mWorldTree->rightTree, mWorldTree->rightTree.getRoot(), false);
+	loadHighestPriorityCandidates();
 
 	mAsyncTileLoader->update();
 
@@ -135,19 +138,19 @@ void QuadTreeTileLoader::update(std::vector<AsyncQuadTreeTile*>& addedTiles, std
 		}
 	}
 
-	std::set<QuadTreeTileKey> tiles;
+	QuadTreeTileKeySet& tiles = mNextVisibleTiles;
+	tiles.clear();
 	traveseToCollectVisibleTiles(mWorldTree->leftTree, mWorldTree->leftTree.getRoot(), tiles, addedTiles);
 	traveseToCollectVisibleTiles(mWorldTree->rightTree, mWorldTree->rightTree.getRoot(), tiles, addedTiles);
 
-	for (const QuadTreeTileKey& key : mVisibleTiles)
-	{
-		if (tiles.find(key) == tiles.end())
+	mVisibleTiles.forEach([&](const QuadTreeTileKey& key) {
+		if (!tiles.contains(key))
 		{
 			removedTiles.push_back(key);
 		}
-	}
+	});
 
-	std::swap(tiles, mVisibleTiles);
+	mVisibleTiles.swap(tiles);
 }
 
 void QuadTreeTileLoader::traveseToLoadAndUnload(QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile, bool parentIsSufficient)
@@ -162,7 +165,12 @@ void QuadTreeTileLoader::traveseToLoadAndUnload(QuadTree<AsyncQuadTreeTile>& tre
 	{
 		if (state == AsyncQuadTreeTile::State::NotLoaded)
 		{
-			loadTile(tile);
+			mLoadCandidates.push_back({ &tile, mSubdivisionPredicate->getLoadPriority(tile.bounds, tile.key) });
+		}
+		else if (state == AsyncQuadTreeTile::State::Loading)
+		{
+			// Re-prioritize because the observer may have moved since the load was requested
+			tile.progressCallback->priority = mSubdivisionPredicate->getLoadPriority(tile.bounds, tile.key);
 		}
 	}
 	else if (state != AsyncQuadTreeTile::State::Loaded) // cancel loading if tile should not be loaded
@@ -197,7 +205,7 @@ void QuadTreeTileLoader::traveseToLoadAndUnload(QuadTree<AsyncQuadTreeTile>& tre
 	}
 }
 
-void QuadTreeTileLoader::traveseToCollectVisibleTiles(QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile, std::set<QuadTreeTileKey>& tiles, std::vector<AsyncQuadTreeTile*>& addedTiles)
+void QuadTreeTileLoader::traveseToCollectVisibleTiles(QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile, QuadTreeTileKeySet& tiles, std::vector<AsyncQuadTreeTile*>& addedTiles)
 {
 	if (tile.getData())
 	{
@@ -225,8 +233,7 @@ void QuadTreeTileLoader::traveseToCollectVisibleTiles(QuadTree<AsyncQuadTreeTile
 		// If tile is a laf node, make sure it's in the visible set
 		if (leaf)
 		{
-			auto it = mVisibleTiles.find(tile.key);
-			if (it == mVisibleTiles.end())
+			if (!mVisibleTiles.contains(tile.key))
 			{
 				addedTiles.push_back(&tile);
 			}
@@ -244,14 +251,31 @@ void QuadTreeTileLoader::traveseToCollectVisibleTiles(QuadTree<AsyncQuadTreeTile
 	}
 }
 
-void QuadTreeTileLoader::loadTile(AsyncQuadTreeTile& tile)
+void QuadTreeTileLoader::loadHighestPriorityCandidates()
 {
-	assert(tile.getState() == AsyncQuadTreeTile::State::NotLoaded);
+	// Follow the async loader's limit, so that requests are not capped below the number of loads it can run
+	const size_t maxLoadQueueSize = mAsyncTileLoader->getMaxRequestedLoads();
+	if (mLoadQueue.size() < maxLoadQueueSize)
+	{
+		size_t count = std::min(mLoadCandidates.size(), maxLoadQueueSize - mLoadQueue.size());
+		std::partial_sort(mLoadCandidates.begin(), mLoadCandidates.begin() + count, mLoadCandidates.end(), [](const LoadCandidate& a, const LoadCandidate& b) {
+			return a.priority > b.priority;
+		});
 
-	if (mLoadQueue.size() > 32)
-		return;
+		for (size_t i = 0; i < count; ++i)
+		{
+			loadTile(*mLoadCandidates[i].tile, mLoadCandidates[i].priority);
+		}
+	}
+	mLoadCandidates.clear();
+}
+
+void QuadTreeTileLoader::loadTile(AsyncQuadTreeTile& tile, double priority)
+{
+	assert(tile.getState() == AsyncQuadTreeTile::State::NotLoaded);
 
 	tile.progressCallback = std::make_shared<TileProgressCallback>();
+	tile.progressCallback->priority = priority;
 	mAsyncTileLoader->load(tile.key, tile.dataPtr, tile.progressCallback);
 	CALL_LISTENERS(tileLoadRequested());
 	mLoadQueue.push_back({ tile.progressCallback });
@@ -10,11 +10,11 @@
 #include "SkyboltVis/SkyboltVisFwd.h"
 #include <SkyboltCommon/Listenable.h>
 #include <SkyboltCommon/Math/QuadTree.h>
+#include <SkyboltCommon/Math/QuadTreeTileKeySet.h>
 
 #include <osg/Vec2d>
 
 #include <assert.h>
-#include <set>
 
 namespace skybolt {
 namespace vis {
@@ -61,6 +61,9 @@ struct QuadTreeSubdivisionPredicate
 	virtual ~QuadTreeSubdivisionPredicate() = default;
 
 	virtual bool operator()(const Box2d& bounds, const QuadTreeTileKey& key) = 0;
+
+	//! @returns relative importance of loading the tile. Tiles with higher priority are loaded first.
+	virtual double getLoadPriority(const Box2d& bounds, const QuadTreeTileKey& key) { return 0.0; }
 };
 
 using QuadTreeSubdivisionPredicatePtr = std::shared_ptr<QuadTreeSubdivisionPredicate>;
@@ -71,6 +74,7 @@ using QuadTreeSubdivisionPredicatePtr = std::shared_ptr<QuadTreeSubdivisionPredi
 //! This strategy causes tiles to appear in sequential increments of detail, i.e first level 0, then level 1 etc.
 //! This was found to give the appearance of faster map loading because the 'next-best' resolution tile is available
 //! while the best resolution tile is still loading.
+//! Tile loads are prioritized by the predicate's load priority, which is re-evaluated every update for tiles still loading.
 class QuadTreeTileLoader : public skybolt::Listenable<QuadTreeTileLoaderListener>
 {
 public:
@@ -85,9 +89,12 @@ public:
 private:
 	void traveseToLoadAndUnload(skybolt::QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile, bool parentIsSufficient);
 
-	void traveseToCollectVisibleTiles(skybolt::QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile, std::set<skybolt::QuadTreeTileKey>& tiles, std::vector<AsyncQuadTreeTile*>& addedTiles);
+	void traveseToCollectVisibleTiles(skybolt::QuadTree<AsyncQuadTreeTile>& tree, AsyncQuadTreeTile& tile, skybolt::QuadTreeTileKeySet& tiles, std::vector<AsyncQuadTreeTile*>& addedTiles);
+
+	//! Starts loading the highest priority tiles in mLoadCandidates, up to the load queue limit.
+	void loadHighestPriorityCandidates();
 
-	void loadTile(AsyncQuadTreeTile& tile);
+	void loadTile(AsyncQuadTreeTile& tile, double priority);
 
 private:
 	AsyncTileLoaderPtr mAsyncTileLoader;
@@ -100,7 +107,16 @@ private:
 	};
 
 	std::vector<LoadRequest> mLoadQueue;
-	std::set<skybolt::QuadTreeTileKey> mVisibleTiles;
+	skybolt::QuadTreeTileKeySet mVisibleTiles;
+	skybolt::QuadTreeTileKeySet mNextVisibleTiles; //!< Reused every update to avoid reallocation
+
+	struct LoadCandidate
+	{
+		AsyncQuadTreeTile* tile;
+		double priority;
+	};
+
+	std::vector<LoadCandidate> mLoadCandidates; //!< Tiles that should be loaded but are not yet loading, collected during traversal
 };
 
 } // namespace vis
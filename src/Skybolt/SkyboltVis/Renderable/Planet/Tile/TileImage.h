@@ -13,6 +13,13 @@
 namespace skybolt {
 namespace vis {
 
+//! Images derived from a tile image, attached to it as user data so that they are cached and evicted together with it
+struct DerivedTileImages : public osg::Referenced
+{
+	//! @returns total size of the derived images, which is counted towards the tile image cache budget
+	virtual size_t getSizeInBytes() const = 0;
+};
+
 struct TileImage
 {
 	osg::ref_ptr<osg::Image> image;
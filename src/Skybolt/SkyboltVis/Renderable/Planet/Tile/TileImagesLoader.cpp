@@ -9,43 +9,111 @@
 namespace skybolt {
 namespace vis {
 
-TileImage TileImagesLoader::getOrCreateImage(const QuadTreeTileKey& requestedKey, size_t cacheIndex, Factory factory, int minLevel) const
+static size_t getTileImageSizeBytes(const TileImage& image)
 {
-	TileCache& cache = mImageCache[cacheIndex];
+	constexpr size_t entryOverheadBytes = 64; // Approximate size of cache bookkeeping, so that entries without images are still bounded
+	size_t size = entryOverheadBytes;
+	if (image.image)
+	{
+		size += image.image->getTotalSizeInBytes();
+		if (auto derivedImages = dynamic_cast<const DerivedTileImages*>(image.image->getUserData()); derivedImages)
+		{
+			size += derivedImages->getSizeInBytes();
+		}
+	}
+	return size;
+}
+
+TileImagesLoader::ImageCache::ImageCache(size_t capacityBytes) :
+	images(capacityBytes, &getTileImageSizeBytes)
+{
+}
+
+TileImagesLoader::TileImagesLoader(size_t imageCount, size_t cacheCapacityBytes)
+{
+	for (size_t i = 0; i < imageCount; ++i)
+	{
+		mImageCaches.push_back(std::make_unique<ImageCache>(cacheCapacityBytes));
+	}
+}
+
+CacheStats TileImagesLoader::getCacheStats(size_t cacheIndex) const
+{
+	return mImageCaches[cacheIndex]->images.getStats();
+}
+
+TileImage TileImagesLoader::getOrCreateImage(const QuadTreeTileKey& requestedKey, size_t cacheIndex, Factory factory, int minLevel, const std::function<bool()>& cancelSupplier) const
+{
+	ImageCache& cache = *mImageCaches[cacheIndex];
 
-	bool added = false;
-	CacheEntryPtr entry;
+	TileImage result;
+	if (cache.images.get(requestedKey, result))
 	{
+		return result;
+	}
+
+	std::shared_ptr<PendingImage> pending;
+	std::unique_lock<std::mutex> pendingLock;
+	{
+		std::scoped_lock<std::mutex> lock(cache.pendingImagesMutex);
+
+		// Check cache again in case another thread created the image since the check above
+		if (cache.images.get(requestedKey, result))
 		{
-			std::lock_guard<std::mutex> lock(mCacheMutex[cacheIndex]);
-			entry = cache[requestedKey];
+			return result;
 		}
+
+		std::shared_ptr<PendingImage>& entry = cache.pendingImages[requestedKey];
 		if (!entry)
 		{
-			entry = std::make_shared<CacheEntry>();
-			added = true;
+			// This thread will create the image. Lock the pending image so that other threads wait for it.
+			entry = std::make_shared<PendingImage>();
+			pendingLock = std::unique_lock<std::mutex>(entry->mutex);
 		}
+		pending = entry;
 	}
 
-	if (added)
+	if (!pendingLock.owns_lock())
+	{
+		// Wait for another thread to create the image
+		std::scoped_lock<std::mutex> lock(pending->mutex);
+		if (!pending->canceled)
+		{
+			return pending->image;
+		}
+		// The other thread's load was canceled, so retry.
+	}
+	else
 	{
-		std::lock_guard<std::mutex> lock(entry->mImageMutex);
-
 		int level = requestedKey.level;
 		QuadTreeTileKey key = requestedKey;
 		while (level >= minLevel)
 		{
-			entry->image.image = factory(key);
-			if (entry->image.image)
+			pending->image.image = factory(key);
+			if (pending->image.image)
 			{
-				entry->image.key = key;
+				pending->image.key = key;
 				break;
 			}
 			--level;
 			key = createAncestorKey(requestedKey, level);
 		}
+
+		pending->canceled = cancelSupplier && cancelSupplier();
+		{
+			std::scoped_lock<std::mutex> lock(cache.pendingImagesMutex);
+			if (!pending->canceled)
+			{
+				cache.images.putSafe(requestedKey, pending->image);
+			}
+			cache.pendingImages.erase(requestedKey);
+		}
+
+		// Return the image even if canceled, since the caller may still be able to use it
+		return pending->image;
 	}
-	return entry->image;
+
+	return getOrCreateImage(requestedKey, cacheIndex, factory, minLevel, cancelSupplier);
 }
 
 } // namespace vis
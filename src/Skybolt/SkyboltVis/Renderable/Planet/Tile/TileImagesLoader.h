@@ -8,6 +8,9 @@
 
 #include "TileImage.h"
 #include <SkyboltVis/SkyboltVisFwd.h>
+#include <SkyboltCommon/ShardedClockCacheMap.h>
+
+#include <unordered_map>
 
 namespace skybolt {
 namespace vis {
@@ -22,11 +25,12 @@ using TileImagesPtr = std::shared_ptr<TileImages>;
 class TileImagesLoader
 {
 public:
-	TileImagesLoader(size_t imageCount) :
-		mImageCache(imageCount),
-		mCacheMutex(imageCount)
-	{
-	}
+	static constexpr size_t defaultCacheCapacityBytes = 128 * 1024 * 1024;
+
+	//! @param imageCount is the number of image caches
+	//! @param cacheCapacityBytes is the approximate memory budget of each image cache.
+	//! Least recently used images are evicted when the budget is exceeded.
+	TileImagesLoader(size_t imageCount, size_t cacheCapacityBytes = defaultCacheCapacityBytes);
 
 	virtual ~TileImagesLoader() = default;
 
@@ -36,25 +40,37 @@ public:
 	//! Returns nullptr on cancel.
 	virtual TileImagesPtr load(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const = 0;
 
+	CacheStats getCacheStats(size_t cacheIndex) const;
+
 protected:
-	struct CacheEntry
+	typedef std::function<osg::ref_ptr<osg::Image>(const skybolt::QuadTreeTileKey& key)> Factory;
+
+	//! @param minLevel is the minimum level of the image allowed to be returned as a fallback if the requested key level is not found.
+	//! If no image was found at an allowed level, nullptr is returned.
+	//! @param cancelSupplier returns true if the load was canceled, in which case the result is not cached. May be null.
+	TileImage getOrCreateImage(const skybolt::QuadTreeTileKey& requestedKey, size_t cacheIndex, Factory factory, int minLevel = 0, const std::function<bool()>& cancelSupplier = nullptr) const;
+
+private:
+	//! An image being created by one thread, which other threads requesting the same key wait on
+	struct PendingImage
 	{
 		TileImage image;
-		std::mutex mImageMutex;
+		std::mutex mutex; //!< Locked by the creating thread until the image is created
+		bool canceled = false;
 	};
 
-	typedef std::shared_ptr<CacheEntry> CacheEntryPtr;
-	typedef std::map<skybolt::QuadTreeTileKey, CacheEntryPtr> TileCache; //!< Maps a requested tile key to an image. The image may be at a lower key level than the request e.g if no high res image is available.
-	typedef std::function<osg::ref_ptr<osg::Image>(const skybolt::QuadTreeTileKey& key)> Factory;
+	struct ImageCache
+	{
+		ImageCache(size_t capacityBytes);
 
-	//! @param minLevel is the minimum level of the image allowed to be returned as a fallback if the requested key level is not found.
-	//! If no image was found at an allowed level, nullptr is returned.
-	TileImage getOrCreateImage(const skybolt::QuadTreeTileKey& requestedKey, size_t cacheIndex, Factory factory, int minLevel = 0) const;
+		//! Maps a requested tile key to an image. The image may be at a lower key level than the request e.g if no high res image is available.
+		ShardedClockCacheMap<skybolt::QuadTreeTileKey, TileImage> images;
 
+		std::mutex pendingImagesMutex;
+		std::unordered_map<skybolt::QuadTreeTileKey, std::shared_ptr<PendingImage>> pendingImages;
+	};
 
-private:
-	mutable std::vector<TileCache> mImageCache;
-	mutable std::vector<std::mutex> mCacheMutex;
+	std::vector<std::unique_ptr<ImageCache>> mImageCaches;
 };
 
 } // namespace vis
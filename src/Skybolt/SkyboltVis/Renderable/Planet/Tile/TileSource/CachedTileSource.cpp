@@ -10,6 +10,7 @@
 #include <osgDB/WriteFile>
 
 #include <filesystem>
+#include <thread>
 
 namespace skybolt {
 namespace vis {
@@ -37,7 +38,19 @@ osg::ref_ptr<osg::Image> CachedTileSource::createImage(const skybolt::QuadTreeTi
 		if (image)
 		{
 			std::filesystem::create_directories(imageDirectory);
-			osgDB::writeImageFile(*image, filename);
+
+			// Write to a temporary file and then rename, so that concurrent readers and writers of the same tile
+			// never see a partially written file. The temporary file keeps the extension so osgDB selects the right writer.
+			std::string tempFilename = imageDirectory + std::to_string(key.y) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp.png";
+			if (osgDB::writeImageFile(*image, tempFilename))
+			{
+				std::error_code error;
+				std::filesystem::rename(tempFilename, filename, error);
+				if (error)
+				{
+					std::filesystem::remove(tempFilename, error);
+				}
+			}
 		}
 		return image;
 	}
@@ -10,6 +10,7 @@
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/CachedTileSource.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/MapboxElevationTileSource.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/SphericalMercatorToPlateCarreeTileSource.h"
+#include "SkyboltVis/Renderable/Planet/Tile/TileSource/TilePackTileSource.h"
 #include "SkyboltVis/Renderable/Planet/Tile/TileSource/XyzTileSource.h"
 #include <SkyboltCommon/ShaUtility.h>
 #include <SkyboltCommon/Json/JsonHelpers.h>
@@ -59,6 +60,11 @@ TileSourcePtr JsonTileSourceFactory::createTileSourceFromJson(const nlohmann::js
 		config.apiKey = getApiKey("mapbox");
 		tileSource = std::make_shared<MapboxElevationTileSource>(config);
 	}
+	else if (format == "tilePack")
+	{
+		// URL is the path of an existing tile pack file, which is opened read only
+		tileSource = std::make_shared<TilePackTileSource>(nullptr, url);
+	}
 	else
 	{
 		throw std::runtime_error("Unsupported tile source format: " + format);
@@ -74,8 +80,20 @@ TileSourcePtr JsonTileSourceFactory::createTileSourceFromJson(const nlohmann::js
 	{
 		if (it->get<bool>())
 		{
-			std::string directory = mCacheDirectory + "/" + calcSha1(url);
-			tileSource = std::make_shared<CachedTileSource>(tileSource, directory);
+			std::string cacheFormat = readOptionalOrDefault<std::string>(json, "cacheFormat", "directory");
+			std::string path = mCacheDirectory + "/" + calcSha1(url);
+			if (cacheFormat == "directory")
+			{
+				tileSource = std::make_shared<CachedTileSource>(tileSource, path);
+			}
+			else if (cacheFormat == "tilePack")
+			{
+				tileSource = std::make_shared<TilePackTileSource>(tileSource, path + TilePackTileSource::getFileExtension());
+			}
+			else
+			{
+				throw std::runtime_error("Unsupported tile cache format: " + cacheFormat);
+			}
 		}
 	}
 	return tileSource;
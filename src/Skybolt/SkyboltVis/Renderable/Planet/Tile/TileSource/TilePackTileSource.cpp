@@ -0,0 +1,112 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "TilePackTileSource.h"
+
+#include <cstring>
+#include <vector>
+
+namespace skybolt {
+namespace vis {
+
+//! Header stored at the start of each tile payload, followed by the image data
+struct TilePackImageHeader
+{
+	std::uint32_t version;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t pixelFormat;
+	std::uint32_t dataType;
+	std::uint32_t internalTextureFormat;
+	std::uint32_t packing;
+	std::uint32_t compression; //!< Reserved for compressed payloads. Currently always 0, meaning raw pixels.
+};
+
+static const std::uint32_t imageHeaderVersion = 1;
+
+TilePackTileSource::TilePackTileSource(const TileSourcePtr& tileSource, const std::filesystem::path& packPath) :
+	mTileSource(tileSource),
+	mPack(std::make_unique<file::TilePack>(packPath, tileSource ? file::TilePack::OpenMode::ReadWrite : file::TilePack::OpenMode::ReadOnly))
+{
+}
+
+osg::ref_ptr<osg::Image> TilePackTileSource::createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const
+{
+	osg::ref_ptr<osg::Image> image = readImage(key);
+	if (image || !mTileSource)
+	{
+		return image;
+	}
+
+	image = mTileSource->createImage(key, cancelSupplier);
+	if (image)
+	{
+		writeImage(key, *image);
+	}
+	return image;
+}
+
+osg::ref_ptr<osg::Image> TilePackTileSource::readImage(const skybolt::QuadTreeTileKey& key) const
+{
+	osg::ref_ptr<osg::Image> image;
+	mPack->read(key, [&](const std::uint8_t* data, size_t size) {
+		TilePackImageHeader header;
+		if (size < sizeof(header))
+		{
+			return;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (header.version != imageHeaderVersion || header.compression != 0)
+		{
+			return;
+		}
+
+		// Validate the header against the payload before allocating, so that a corrupt header cannot cause a huge allocation
+		size_t imageSize = osg::Image::computeImageSizeInBytes(header.width, header.height, 1, header.pixelFormat, header.dataType, header.packing);
+		if (imageSize == 0 || imageSize != size - sizeof(header))
+		{
+			return;
+		}
+
+		image = new osg::Image;
+		image->allocateImage(header.width, header.height, 1, header.pixelFormat, header.dataType, header.packing);
+		image->setInternalTextureFormat(header.internalTextureFormat);
+		if (!image->data() || image->getTotalSizeInBytes() != imageSize)
+		{
+			image = nullptr;
+			return;
+		}
+		std::memcpy(image->data(), data + sizeof(header), imageSize);
+	});
+	return image;
+}
+
+void TilePackTileSource::writeImage(const skybolt::QuadTreeTileKey& key, const osg::Image& image) const
+{
+	// Only uncompressed 2D images are supported
+	if (image.isCompressed() || image.r() != 1 || !image.data())
+	{
+		return;
+	}
+
+	TilePackImageHeader header;
+	header.version = imageHeaderVersion;
+	header.width = image.s();
+	header.height = image.t();
+	header.pixelFormat = image.getPixelFormat();
+	header.dataType = image.getDataType();
+	header.internalTextureFormat = image.getInternalTextureFormat();
+	header.packing = image.getPacking();
+	header.compression = 0;
+
+	std::vector<std::uint8_t> payload(sizeof(header) + image.getTotalSizeInBytes());
+	std::memcpy(payload.data(), &header, sizeof(header));
+	std::memcpy(payload.data() + sizeof(header), image.data(), image.getTotalSizeInBytes());
+	mPack->append(key, payload.data(), payload.size());
+}
+
+} // namespace vis
+} // namespace skybolt
@@ -0,0 +1,41 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "TileSource.h"
+#include <SkyboltVis/SkyboltVisFwd.h>
+#include <SkyboltCommon/File/TilePack.h>
+
+namespace skybolt {
+namespace vis {
+
+//! Reads tiles from a skybolt::file::TilePack.
+//! Images are stored as raw pixels, so reading a tile is a copy from the mapped file without decoding.
+//! If a source tile source is provided, tiles missing from the pack are created by the source and appended to the pack,
+//! allowing the pack to be used as a single file alternative to CachedTileSource.
+class TilePackTileSource : public TileSource
+{
+public:
+	//! @param tileSource is the source of tiles not in the pack. May be null, in which case the pack is opened read only.
+	//! @throws skybolt::Exception if the pack could not be opened, or if tileSource is null and the pack does not exist
+	TilePackTileSource(const TileSourcePtr& tileSource, const std::filesystem::path& packPath);
+
+	osg::ref_ptr<osg::Image> createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override;
+
+	static std::string getFileExtension() { return ".tilepack"; }
+
+private:
+	osg::ref_ptr<osg::Image> readImage(const skybolt::QuadTreeTileKey& key) const;
+	void writeImage(const skybolt::QuadTreeTileKey& key, const osg::Image& image) const;
+
+private:
+	TileSourcePtr mTileSource;
+	std::unique_ptr<file::TilePack> mPack;
+};
+
+} // namespace vis
+} // namespace skybolt
@@ -11,6 +11,8 @@
 using namespace skybolt;
 using namespace skybolt::vis;
 
+static const int schedulerThreadCount = 4;
+
 struct DummyTileImages : public TileImages
 {
 	DummyTileImages(skybolt::QuadTreeTileKey key) : key(key) {};
@@ -51,7 +53,7 @@ TEST_CASE("Test tile loads on background thread")
 	QuadTreeTileKey key(0, 0, 0);
 	auto result = std::make_shared<TileImagesPtr>();
 
-	AsyncTileLoader loader(imagesLoader, &scheduler);
+	AsyncTileLoader loader(imagesLoader, &scheduler, schedulerThreadCount);
 	loader.load(key, result, progressCallback);
 	
 	CHECK(progressCallback->state == TileProgressCallback::State::Loading);
@@ -77,7 +79,7 @@ TEST_CASE("Test background loading tile cancels load when cancelled")
 	QuadTreeTileKey key(0, 0, 0);
 	auto result = std::make_shared<TileImagesPtr>();
 
-	AsyncTileLoader loader(imagesLoader, &scheduler);
+	AsyncTileLoader loader(imagesLoader, &scheduler, schedulerThreadCount);
 	loader.load(key, result, progressCallback);
 
 	progressCallback->requestCancel();
@@ -89,3 +91,117 @@ TEST_CASE("Test background loading tile cancels load when cancelled")
 	CHECK(progressCallback->state == TileProgressCallback::State::FailedOrCanceled);
 	CHECK(!result->get());
 }
+
+
+TEST_CASE("Test pending tile loads are discarded when cancelled before starting")
+{
+	auto imagesLoader = std::make_shared<DummyTileImagesLoader>();
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	AsyncTileLoader loader(imagesLoader, &scheduler, schedulerThreadCount);
+
+	// Fill the running load slots
+	std::vector<std::shared_ptr<TileProgressCallback>> runningCallbacks;
+	for (int i = 0; i < loader.getMaxRunningLoads(); ++i)
+	{
+		auto progressCallback = std::make_shared<TileProgressCallback>();
+		loader.load(QuadTreeTileKey(1, i, 0), std::make_shared<TileImagesPtr>(), progressCallback);
+		runningCallbacks.push_back(progressCallback);
+	}
+	CHECK(loader.getPendingLoadCount() == 0);
+
+	auto canceledCallback = std::make_shared<TileProgressCallback>();
+	auto canceledResult = std::make_shared<TileImagesPtr>();
+	loader.load(QuadTreeTileKey(0, 0, 0), canceledResult, canceledCallback);
+
+	auto pendingCallback = std::make_shared<TileProgressCallback>();
+	pendingCallback->priority = 1.0;
+	auto pendingResult = std::make_shared<TileImagesPtr>();
+	loader.load(QuadTreeTileKey(0, 1, 0), pendingResult, pendingCallback);
+
+	CHECK(loader.getPendingLoadCount() == 2);
+
+	canceledCallback->requestCancel();
+
+	imagesLoader->doLoad = true;
+	loader.waitForLoads();
+	loader.update();
+
+	CHECK(canceledCallback->state == TileProgressCallback::State::FailedOrCanceled);
+	CHECK(loader.getPendingLoadCount() == 0);
+
+	loader.waitForLoads();
+	loader.update();
+
+	CHECK(pendingCallback->state == TileProgressCallback::State::Loaded);
+	CHECK(pendingResult->get());
+	CHECK(!canceledResult->get());
+}
+
+TEST_CASE("Running load limit only shrinks after loads stall for several updates")
+{
+	auto imagesLoader = std::make_shared<DummyTileImagesLoader>();
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	AsyncTileLoader loader(imagesLoader, &scheduler, schedulerThreadCount);
+	int initialMaxRunningLoads = loader.getMaxRunningLoads();
+	CHECK(loader.getMaxRequestedLoads() > initialMaxRunningLoads);
+
+	// Fill the running load slots and leave one load pending, so that the loader is saturated
+	std::vector<std::shared_ptr<TileProgressCallback>> callbacks;
+	for (int i = 0; i <= initialMaxRunningLoads; ++i)
+	{
+		auto progressCallback = std::make_shared<TileProgressCallback>();
+		loader.load(QuadTreeTileKey(1, i, 0), std::make_shared<TileImagesPtr>(), progressCallback);
+		callbacks.push_back(progressCallback);
+	}
+	CHECK(loader.getPendingLoadCount() == 1);
+
+	// A few updates without completed loads are normal while loads are in progress
+	for (int i = 0; i < 10; ++i)
+	{
+		loader.update();
+	}
+	CHECK(loader.getMaxRunningLoads() == initialMaxRunningLoads);
+
+	// Sustained lack of progress shrinks the limit
+	for (int i = 0; i < 100; ++i)
+	{
+		loader.update();
+	}
+	CHECK(loader.getMaxRunningLoads() < initialMaxRunningLoads);
+
+	imagesLoader->doLoad = true;
+	loader.waitForLoads();
+}
+
+TEST_CASE("Running load limit does not exceed the scheduler thread count")
+{
+	auto imagesLoader = std::make_shared<DummyTileImagesLoader>();
+	imagesLoader->doLoad = true;
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	AsyncTileLoader loader(imagesLoader, &scheduler, schedulerThreadCount);
+	CHECK(loader.getMaxRunningLoads() <= schedulerThreadCount);
+
+	// Keep the loader saturated with loads that complete
+	std::vector<std::shared_ptr<TileProgressCallback>> callbacks;
+	for (int update = 0; update < 200; ++update)
+	{
+		while (loader.getPendingLoadCount() < 10)
+		{
+			auto progressCallback = std::make_shared<TileProgressCallback>();
+			loader.load(QuadTreeTileKey(10, update, int(callbacks.size())), std::make_shared<TileImagesPtr>(), progressCallback);
+			callbacks.push_back(progressCallback);
+		}
+		loader.waitForLoads();
+		loader.update();
+		CHECK(loader.getMaxRunningLoads() <= schedulerThreadCount);
+	}
+}
@@ -0,0 +1,236 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltVis/Renderable/Planet/Features/MappedFeatureTile.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace skybolt;
+using namespace skybolt::mapfeatures;
+using skybolt::sim::LatLonAlt;
+
+static std::vector<LatLonAlt> createPoints(int count, double seed)
+{
+	std::vector<LatLonAlt> points;
+	for (int i = 0; i < count; ++i)
+	{
+		points.push_back(LatLonAlt(seed + i * 0.001, seed - i * 0.002, seed * 10 + i));
+	}
+	return points;
+}
+
+static std::vector<FeaturePtr> createFeatures(int countPerType)
+{
+	std::vector<FeaturePtr> features;
+	for (int i = 0; i < countPerType; ++i)
+	{
+		auto road = std::make_shared<Road>();
+		road->points = createPoints(2 + i % 5, i);
+		road->width = 3.0f + i;
+		road->laneCount = 1 + i % 3;
+		features.push_back(road);
+	}
+	for (int i = 0; i < countPerType; ++i)
+	{
+		auto building = std::make_shared<Building>();
+		building->points = createPoints(4 + i % 3, -i);
+		building->height = 10.0f + i;
+		features.push_back(building);
+	}
+	for (int i = 0; i < countPerType; ++i)
+	{
+		auto water = std::make_shared<Water>();
+		water->points = createPoints(3 + i % 7, 0.5 * i);
+		features.push_back(water);
+	}
+
+	auto airport = std::make_shared<Airport>();
+	Airport::Runway runway;
+	runway.name = "16L/34R";
+	runway.start = sim::LatLon(0.1, 0.2);
+	runway.end = sim::LatLon(0.3, 0.4);
+	runway.width = 45.0f;
+	airport->runways.push_back(runway);
+	airport->altitude = 120.0;
+	features.push_back(airport);
+
+	return features;
+}
+
+static std::string getTestDirectory()
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "SkyboltMappedFeatureTileTest";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+	return path.string();
+}
+
+static void writeTileV1(const std::vector<FeaturePtr>& features, const std::string& filename)
+{
+	std::ofstream f(filename, std::ios::binary);
+	saveTileV1(features, f);
+}
+
+static void writeTileV2(const std::vector<FeaturePtr>& features, const std::string& filename)
+{
+	std::ofstream f(filename, std::ios::binary);
+	saveTileV2(features, f);
+}
+
+static void checkTileMatchesFeatures(const MappedFeatureTile& tile, const std::vector<FeaturePtr>& features, int countPerType)
+{
+	REQUIRE(tile.getRoads().size() == countPerType);
+	REQUIRE(tile.getBuildings().size() == countPerType);
+	REQUIRE(tile.getWaters().size() == countPerType);
+	REQUIRE(tile.getAirports().size() == 1);
+
+	for (int i = 0; i < countPerType; ++i)
+	{
+		const Road& road = static_cast<const Road&>(*features[i]);
+		LatLonAltPointsView points = tile.getRoads().getPoints(i);
+		CHECK(std::vector<LatLonAlt>(points.begin(), points.end()) == road.points);
+		CHECK(tile.getRoads().widths[i] == road.width);
+		CHECK(tile.getRoads().laneCounts[i] == road.laneCount);
+
+		const Building& building = static_cast<const Building&>(*features[countPerType + i]);
+		points = tile.getBuildings().getPoints(i);
+		CHECK(std::vector<LatLonAlt>(points.begin(), points.end()) == building.points);
+		CHECK(tile.getBuildings().heights[i] == building.height);
+
+		const Water& water = static_cast<const Water&>(*features[2 * countPerType + i]);
+		points = tile.getWaters().getPoints(i);
+		CHECK(std::vector<LatLonAlt>(points.begin(), points.end()) == water.points);
+	}
+
+	const Airport& airport = *tile.getAirports().front();
+	REQUIRE(airport.runways.size() == 1);
+	CHECK(airport.runways.front().name == "16L/34R");
+	CHECK(airport.runways.front().width == 45.0f);
+	CHECK(airport.altitude == 120.0);
+}
+
+TEST_CASE("MappedFeatureTile reads version 2 tiles in place")
+{
+	std::string filename = getTestDirectory() + "/tile.ftr";
+	int countPerType = 10;
+	std::vector<FeaturePtr> features = createFeatures(countPerType);
+	writeTileV2(features, filename);
+
+	MappedFeatureTile tile(filename);
+	checkTileMatchesFeatures(tile, features, countPerType);
+}
+
+TEST_CASE("MappedFeatureTile reads version 1 tiles")
+{
+	std::string filename = getTestDirectory() + "/tile.ftr";
+	int countPerType = 10;
+	std::vector<FeaturePtr> features = createFeatures(countPerType);
+	writeTileV1(features, filename);
+
+	MappedFeatureTile tile(filename);
+	checkTileMatchesFeatures(tile, features, countPerType);
+}
+
+TEST_CASE("Empty feature tile round trips")
+{
+	std::string filename = getTestDirectory() + "/tile.ftr";
+	writeTileV2({}, filename);
+
+	MappedFeatureTile tile(filename);
+	CHECK(tile.getRoads().size() == 0);
+	CHECK(tile.getBuildings().size() == 0);
+	CHECK(tile.getWaters().size() == 0);
+	CHECK(tile.getAirports().empty());
+}
+
+TEST_CASE("Convert feature tiles from version 1 to version 2")
+{
+	std::string directory = getTestDirectory();
+	std::filesystem::create_directories(directory + "/3/1");
+	std::string filename = directory + "/3/1/2.ftr";
+	int countPerType = 10;
+	std::vector<FeaturePtr> features = createFeatures(countPerType);
+	writeTileV1(features, filename);
+
+	CHECK(convertTilesToV2(directory) == 1);
+	CHECK(convertTilesToV2(directory) == 0); // Already converted
+
+	std::vector<FeaturePtr> loadedFeatures;
+	loadTile(filename, loadedFeatures);
+	CHECK(loadedFeatures.size() == features.size());
+
+	MappedFeatureTile tile(filename);
+	checkTileMatchesFeatures(tile, features, countPerType);
+}
+
+TEST_CASE("MappedFeatureTile throws on truncated tile")
+{
+	std::string filename = getTestDirectory() + "/tile.ftr";
+	writeTileV2(createFeatures(10), filename);
+	std::filesystem::resize_file(filename, std::filesystem::file_size(filename) / 2);
+
+	CHECK_THROWS_AS(MappedFeatureTile(filename), skybolt::Exception);
+}
+
+TEST_CASE("Benchmark feature tile loading", "[.][benchmark]")
+{
+	std::string directory = getTestDirectory();
+	std::string filenameV1 = directory + "/v1.ftr";
+	std::string filenameV2 = directory + "/v2.ftr";
+
+	std::vector<FeaturePtr> features = createFeatures(20000);
+	writeTileV1(features, filenameV1);
+	writeTileV2(features, filenameV2);
+
+	// Load each tile and read every point, so that the mapped tile pays for accessing its data
+	auto loadV1AndSumAltitudes = [&] {
+		double sum = 0;
+		std::vector<FeaturePtr> loadedFeatures;
+		loadTile(filenameV1, loadedFeatures);
+		for (const FeaturePtr& feature : loadedFeatures)
+		{
+			if (feature->type() != FeatureAirport)
+			{
+				for (const LatLonAlt& point : static_cast<const PolyFeature&>(*feature).points)
+				{
+					sum += point.alt;
+				}
+			}
+		}
+		return sum;
+	};
+
+	auto loadV2AndSumAltitudes = [&] {
+		double sum = 0;
+		MappedFeatureTile tile(filenameV2);
+		for (const PolyFeaturesView* view : {(const PolyFeaturesView*)&tile.getRoads(), (const PolyFeaturesView*)&tile.getBuildings(), &tile.getWaters()})
+		{
+			for (size_t j = 0; j < view->size(); ++j)
+			{
+				for (const LatLonAlt& point : view->getPoints(j))
+				{
+					sum += point.alt;
+				}
+			}
+		}
+		return sum;
+	};
+
+	CHECK(loadV1AndSumAltitudes() == Approx(loadV2AndSumAltitudes()).margin(1e-3));
+
+	BENCHMARK("Version 1")
+	{
+		return loadV1AndSumAltitudes();
+	};
+
+	BENCHMARK("Version 2")
+	{
+		return loadV2AndSumAltitudes();
+	};
+}
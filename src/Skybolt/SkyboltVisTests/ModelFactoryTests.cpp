@@ -0,0 +1,133 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltVis/Renderable/Model/ModelFactory.h>
+#include <SkyboltCommon/Exception.h>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osgDB/WriteFile>
+#include <osgUtil/UpdateVisitor>
+
+#include <filesystem>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+static std::string writeTestModel(const std::string& name, int vertexCount)
+{
+	osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+	osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(vertexCount);
+	geometry->setVertexArray(vertices);
+	geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertexCount));
+
+	osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+	geode->addDrawable(geometry);
+
+	std::string filename = (std::filesystem::temp_directory_path() / (name + ".osgt")).string();
+	REQUIRE(osgDB::writeNodeFile(*geode, filename));
+	return filename;
+}
+
+static ModelFactoryConfig createConfig(px_sched::Scheduler* scheduler)
+{
+	ModelFactoryConfig config;
+	config.defaultProgram = new osg::Program;
+	config.scheduler = scheduler;
+	return config;
+}
+
+TEST_CASE("Models are cached and shared")
+{
+	std::string filename = writeTestModel("ModelFactoryTestsCached", 10);
+
+	ModelFactory factory(createConfig(nullptr));
+	osg::ref_ptr<osg::Node> model = factory.createModel(filename);
+	REQUIRE(model);
+	CHECK(factory.createModel(filename) == model);
+	CHECK(factory.getCacheSizeBytes() >= 10 * sizeof(osg::Vec3));
+
+	std::filesystem::remove(filename);
+}
+
+TEST_CASE("Loading missing model throws")
+{
+	ModelFactory factory(createConfig(nullptr));
+	CHECK_THROWS_AS(factory.createModel("ModelFactoryTestsMissing.osgt"), skybolt::Exception);
+	CHECK(factory.getCacheSizeBytes() == 0);
+}
+
+TEST_CASE("Asynchronously loaded model is added to placeholder in update traversal")
+{
+	std::string filename = writeTestModel("ModelFactoryTestsAsync", 10);
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	ModelFactory factory(createConfig(&scheduler));
+	osg::ref_ptr<osg::Group> placeholder = factory.createModelAsync(filename);
+	REQUIRE(placeholder);
+
+	factory.waitForLoads();
+	osgUtil::UpdateVisitor visitor;
+	placeholder->accept(visitor);
+
+	REQUIRE(placeholder->getNumChildren() == 1);
+	CHECK(placeholder->getChild(0) == factory.createModel(filename).get());
+
+	std::filesystem::remove(filename);
+}
+
+TEST_CASE("Prefetched models are loaded concurrently with synchronous requests")
+{
+	std::vector<std::string> filenames;
+	for (int i = 0; i < 8; ++i)
+	{
+		filenames.push_back(writeTestModel("ModelFactoryTestsPrefetch" + std::to_string(i), 10));
+	}
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	ModelFactory factory(createConfig(&scheduler));
+	factory.prefetch(filenames);
+
+	// Requests made while prefetching must return the same models as the prefetch
+	std::vector<osg::ref_ptr<osg::Node>> models;
+	for (const std::string& filename : filenames)
+	{
+		models.push_back(factory.createModel(filename));
+	}
+
+	factory.waitForLoads();
+	for (size_t i = 0; i < filenames.size(); ++i)
+	{
+		CHECK(factory.createModel(filenames[i]) == models[i]);
+		std::filesystem::remove(filenames[i]);
+	}
+}
+
+TEST_CASE("Unused models are evicted when cache exceeds capacity")
+{
+	std::string filenameA = writeTestModel("ModelFactoryTestsEvictA", 1000);
+	std::string filenameB = writeTestModel("ModelFactoryTestsEvictB", 1000);
+
+	ModelFactoryConfig config = createConfig(nullptr);
+	config.cacheCapacityBytes = 1000 * sizeof(osg::Vec3) + 100;
+	ModelFactory factory(config);
+
+	factory.createModel(filenameA); // Not referenced outside the cache, so can be evicted
+	osg::ref_ptr<osg::Node> modelB = factory.createModel(filenameB);
+	CHECK(factory.getCacheSizeBytes() <= config.cacheCapacityBytes);
+
+	// Model B is in use, so is not evicted when model A is reloaded
+	factory.createModel(filenameA);
+	CHECK(factory.createModel(filenameB) == modelB);
+
+	std::filesystem::remove(filenameA);
+	std::filesystem::remove(filenameB);
+}
@@ -17,6 +17,7 @@
 #include <SkyboltCommon/NumericComparison.h>
 
 #include <boost/optional/optional_io.hpp>
+#include <atomic>
 
 using namespace skybolt;
 using namespace skybolt::vis;
@@ -108,4 +109,133 @@ TEST_CASE("Test AsyncPlanetAltitudeProvider background loads tile")
 	CHECK(eventually([&]{
 		return provider.getAltitudeOrRequestLoad(sim::LatLon(1.4, -3.0)) == altitude;
 	}));
-}
\ No newline at end of file
+}
+
+static osg::ref_ptr<osg::Image> createRampImage(int size)
+{
+	auto image = new osg::Image;
+	image->allocateImage(size, size, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
+	uint16_t* p = reinterpret_cast<uint16_t*>(image->data());
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			p[x + y * size] = floatToHeightmapValue(-float(x * 3 + y * 5));
+		}
+	}
+	return image;
+}
+
+static std::vector<sim::LatLon> createGridPositions(int countPerAxis)
+{
+	std::vector<sim::LatLon> positions;
+	for (int i = 0; i < countPerAxis; ++i)
+	{
+		for (int j = 0; j < countPerAxis; ++j)
+		{
+			double lat = -1.5 + 3.0 * double(i) / double(countPerAxis);
+			double lon = -3.1 + 6.2 * double(j) / double(countPerAxis);
+			positions.push_back(sim::LatLon(lat, lon));
+		}
+	}
+	return positions;
+}
+
+TEST_CASE("Test SynchronousPlanetAltitudeProvider batched altitudes match single altitudes")
+{
+	auto source = std::make_shared<DummyTileSource>();
+	source->images[QuadTreeTileKey(1, 0, 0)] = createRampImage(16);
+	source->images[QuadTreeTileKey(1, 1, 0)] = createRampImage(16);
+
+	TilePlanetAltitudeProvider provider(source, 2);
+
+	std::vector<sim::LatLon> positions = createGridPositions(10);
+	std::vector<double> altitudes;
+	provider.getAltitudes(positions, altitudes);
+
+	REQUIRE(altitudes.size() == positions.size());
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		CHECK(altitudes[i] == provider.getAltitude(positions[i]));
+	}
+}
+
+TEST_CASE("Benchmark SynchronousPlanetAltitudeProvider batched altitudes", "[.][benchmark]")
+{
+	auto source = std::make_shared<DummyTileSource>();
+	for (int y = 0; y < 4; ++y)
+	{
+		for (int x = 0; x < 8; ++x)
+		{
+			source->images[QuadTreeTileKey(2, x, y)] = createRampImage(256);
+		}
+	}
+
+	TilePlanetAltitudeProvider provider(source, 2);
+	std::vector<sim::LatLon> positions = createGridPositions(1000);
+	std::vector<double> altitudes(positions.size());
+
+	// Warm up the tile cache
+	provider.getAltitudes(positions, altitudes);
+
+	BENCHMARK("Single")
+	{
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			altitudes[i] = provider.getAltitude(positions[i]);
+		}
+		return altitudes.back();
+	};
+
+	BENCHMARK("Batched")
+	{
+		provider.getAltitudes(positions, altitudes);
+		return altitudes.back();
+	};
+}
+
+
+TEST_CASE("Test SynchronousPlanetAltitudeProvider reports cache stats")
+{
+	auto source = std::make_shared<DummyTileSource>();
+	source->images[QuadTreeTileKey(1, 0, 0)] = createDummyImage();
+
+	TilePlanetAltitudeProvider provider(source, 1);
+	CHECK(provider.getAltitude(sim::LatLon(1.4, -3.0)) == altitude);
+	CHECK(provider.getAltitude(sim::LatLon(1.4, -3.0)) == altitude);
+
+	CacheStats stats = provider.getCacheStats();
+	CHECK(stats.hits == 1);
+	CHECK(stats.misses == 1);
+	CHECK(stats.itemCount == 1);
+	CHECK(stats.sizeBytes == source->images[QuadTreeTileKey(1, 0, 0)]->getTotalSizeInBytes());
+}
+
+
+TEST_CASE("Test AsyncPlanetAltitudeProvider coalesces requests for the same tile")
+{
+	auto source = std::make_shared<DummyTileSource>();
+	source->images[QuadTreeTileKey(1, 0, 0)] = createDummyImage();
+
+	px_sched::Scheduler scheduler;
+	scheduler.init();
+
+	TileAsyncPlanetAltitudeProvider provider(&scheduler, source, 1);
+
+	std::atomic<int> callbackCount = 0;
+	for (int i = 0; i < 10; ++i)
+	{
+		provider.requestAltitude(sim::LatLon(1.4, -3.0), [&](double result) {
+			if (result == altitude)
+			{
+				++callbackCount;
+			}
+		});
+	}
+
+	CHECK(eventually([&]{
+		return callbackCount == 10;
+	}));
+	CHECK(provider.getPendingLoadCount() == 0);
+	CHECK(source->requests.size() == 1);
+}
@@ -0,0 +1,83 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <SkyboltVis/Renderable/Planet/Tile/TileSource/TilePackTileSource.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace skybolt;
+using namespace skybolt::vis;
+
+class CountingTileSource : public TileSource
+{
+public:
+	osg::ref_ptr<osg::Image> createImage(const skybolt::QuadTreeTileKey& key, std::function<bool()> cancelSupplier) const override
+	{
+		++createCount;
+		osg::ref_ptr<osg::Image> image = new osg::Image;
+		image->allocateImage(4, 3, 1, GL_RED, GL_UNSIGNED_SHORT);
+		image->setInternalTextureFormat(GL_R16);
+		uint16_t* p = reinterpret_cast<uint16_t*>(image->data());
+		for (int i = 0; i < 4 * 3; ++i)
+		{
+			p[i] = uint16_t(key.x * 100 + i);
+		}
+		return image;
+	}
+
+	mutable int createCount = 0;
+};
+
+TEST_CASE("TilePackTileSource caches tiles from source tile source")
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "SkyboltTilePackTileSourceTest" / ("test" + TilePackTileSource::getFileExtension());
+	std::filesystem::remove_all(path.parent_path());
+
+	auto source = std::make_shared<CountingTileSource>();
+	osg::ref_ptr<osg::Image> expected = source->createImage(QuadTreeTileKey(1, 1, 0), nullptr);
+	source->createCount = 0;
+
+	{
+		TilePackTileSource tileSource(source, path);
+		CHECK(tileSource.createImage(QuadTreeTileKey(1, 1, 0), [] { return false; }));
+		CHECK(source->createCount == 1);
+	}
+
+	// Reopen and read tile from pack without using source
+	TilePackTileSource tileSource(nullptr, path);
+	osg::ref_ptr<osg::Image> image = tileSource.createImage(QuadTreeTileKey(1, 1, 0), [] { return false; });
+	REQUIRE(image);
+	CHECK(image->s() == expected->s());
+	CHECK(image->t() == expected->t());
+	CHECK(image->getPixelFormat() == expected->getPixelFormat());
+	CHECK(image->getDataType() == expected->getDataType());
+	CHECK(image->getInternalTextureFormat() == expected->getInternalTextureFormat());
+	REQUIRE(image->getTotalSizeInBytes() == expected->getTotalSizeInBytes());
+	CHECK(std::memcmp(image->data(), expected->data(), image->getTotalSizeInBytes()) == 0);
+
+	CHECK(!tileSource.createImage(QuadTreeTileKey(1, 0, 0), [] { return false; }));
+}
+
+TEST_CASE("TilePackTileSource ignores tiles whose header does not match the payload size")
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "SkyboltTilePackTileSourceTest" / ("test" + TilePackTileSource::getFileExtension());
+	std::filesystem::remove_all(path.parent_path());
+
+	{
+		// Header of a huge image, followed by a small payload
+		std::uint32_t header[] = {1, 1000000, 1000000, GL_RED, GL_UNSIGNED_SHORT, GL_R16, 1, 0};
+		std::vector<std::uint8_t> payload(sizeof(header) + 16);
+		std::memcpy(payload.data(), header, sizeof(header));
+
+		file::TilePack pack(path);
+		pack.append(QuadTreeTileKey(1, 1, 0), payload.data(), payload.size());
+	}
+
+	TilePackTileSource tileSource(nullptr, path);
+	CHECK(!tileSource.createImage(QuadTreeTileKey(1, 1, 0), [] { return false; }));
+}
@@ -7,6 +7,7 @@
 
 #include <catch2/catch.hpp>
 
+#include <SkyboltVis/Renderable/Planet/Tile/NormalMapHelpers.h>
 #include <SkyboltVis/Shader/ShaderProgramRegistry.h>
 #include <SkyboltVis/TextureGenerator/GpuTextureGenerator.h>
 #include "SkyboltVis/TextureGenerator/GpuTextureGeneratorStateSets.h"
@@ -14,8 +15,89 @@
 
 #include <osgDB/WriteFile>
 
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
 using namespace skybolt::vis;
 
+static osg::ref_ptr<osg::Image> createRandomHeightmap(int width, int height)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image;
+	image->allocateImage(width, height, 1, GL_RED, GL_UNSIGNED_SHORT);
+	image->setInternalTextureFormat(GL_R16);
+
+	std::mt19937 generator(width * height);
+	std::uniform_int_distribution<int> distribution(0, 65535);
+
+	uint16_t* p = reinterpret_cast<uint16_t*>(image->data());
+	for (int i = 0; i < width * height; ++i)
+	{
+		p[i] = uint16_t(distribution(generator));
+	}
+	return image;
+}
+
+//! @returns the largest difference between the x and y components of two normal maps
+static int calcMaxNormalDifference(const osg::Image& a, const osg::Image& b)
+{
+	int maxDifference = 0;
+	for (int i = 0; i < a.s() * a.t(); ++i)
+	{
+		for (int c = 0; c < 2; ++c)
+		{
+			maxDifference = std::max(maxDifference, std::abs(int(a.data()[3 * i + c]) - int(b.data()[3 * i + c])));
+		}
+	}
+	return maxDifference;
+}
+
+TEST_CASE("Normal map generated from heightmap matches scalar reference")
+{
+	osg::Vec2f texelWorldSize(30, 20);
+
+	// Include sizes that are not a multiple of the vector width to test edge handling
+	for (int size : {2, 3, 5, 8, 9, 257})
+	{
+		osg::ref_ptr<osg::Image> heightmap = createRandomHeightmap(size, size + 1);
+		osg::ref_ptr<osg::Image> result = createNormalmapFromHeightmap(*heightmap, texelWorldSize);
+		osg::ref_ptr<osg::Image> reference = createNormalmapFromHeightmapScalar(*heightmap, texelWorldSize);
+
+		REQUIRE(result->s() == reference->s());
+		REQUIRE(result->t() == reference->t());
+		CHECK(calcMaxNormalDifference(*result, *reference) <= 1);
+	}
+}
+
+TEST_CASE("Flat heightmap produces vertical normals")
+{
+	osg::ref_ptr<osg::Image> heightmap = createRandomHeightmap(16, 16);
+	std::fill_n(reinterpret_cast<uint16_t*>(heightmap->data()), 16 * 16, uint16_t(1000));
+
+	osg::ref_ptr<osg::Image> result = createNormalmapFromHeightmap(*heightmap, osg::Vec2f(10, 10));
+	for (int i = 0; i < 16 * 16; ++i)
+	{
+		CHECK(int(result->data()[3 * i]) == 128);
+		CHECK(int(result->data()[3 * i + 1]) == 128);
+	}
+}
+
+TEST_CASE("Benchmark normal map generation from heightmap", "[.][benchmark]")
+{
+	osg::ref_ptr<osg::Image> heightmap = createRandomHeightmap(1024, 1024);
+	osg::Vec2f texelWorldSize(30, 30);
+
+	BENCHMARK("Scalar")
+	{
+		return createNormalmapFromHeightmapScalar(*heightmap, texelWorldSize);
+	};
+
+	BENCHMARK("Vectorized")
+	{
+		return createNormalmapFromHeightmap(*heightmap, texelWorldSize);
+	};
+}
+
 TEST_CASE("Generate normal map from vector displacement map")
 {
 	// TODO: reenable
@@ -11,98 +11,473 @@
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <SkyboltCommon/Math/QuadTree.h>
 #include <osgDB/WriteFile>
+#include <px_sched/px_sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <mutex>
+#include <thread>
 
 using namespace skybolt;
 using namespace vis;
 
-struct TileGenerator
+namespace {
+
+//! Tile waiting for its four children to be downsampled into its image
+struct ParentTile
+{
+	QuadTreeTileKey key;
+	Box2d bounds;
+	osg::ref_ptr<osg::Image> image;
+	std::atomic<int> remainingChildren = 4;
+	std::shared_ptr<ParentTile> parent;
+};
+
+typedef std::shared_ptr<ParentTile> ParentTilePtr;
+
+//! @returns true if all layers have the same format with a data type supported by the typed sampling and downsampling functions
+bool hasUniformTypedFormat(const std::vector<TileMapGeneratorLayer>& layers)
+{
+	GLenum pixelFormat = layers.front().image->getPixelFormat();
+	GLenum dataType = layers.front().image->getDataType();
+	if (dataType != GL_UNSIGNED_BYTE && dataType != GL_UNSIGNED_SHORT)
+	{
+		return false;
+	}
+
+	for (const TileMapGeneratorLayer& layer : layers)
+	{
+		if (layer.image->getPixelFormat() != pixelFormat || layer.image->getDataType() != dataType)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//! Matches the texel selection of osg::Image::getColor(const osg::Vec2&)
+template <typename T>
+void sampleNearest(const osg::Image& image, const osg::Vec2d& p, int componentCount, T* result)
+{
+	int x = math::clamp(int(float(p.x()) * float(image.s() - 1)), 0, image.s() - 1);
+	int y = math::clamp(int(float(p.y()) * float(image.t() - 1)), 0, image.t() - 1);
+
+	const T* src = reinterpret_cast<const T*>(image.data(x, y));
+	for (int c = 0; c < componentCount; ++c)
+	{
+		result[c] = src[c];
+	}
+}
+
+//! Matches the texel selection and weights of vis::getColorBilinear()
+template <typename T>
+void sampleBilinear(const osg::Image& image, const osg::Vec2d& p, int componentCount, T* result)
+{
+	int sMax = image.s() - 1;
+	int tMax = image.t() - 1;
+
+	float u = math::clamp(float(p.x()) * float(image.s()), 0.0f, float(sMax));
+	float v = math::clamp(float(p.y()) * float(image.t()), 0.0f, float(tMax));
+
+	int u0 = (int)u;
+	int u1 = std::min(u0 + 1, sMax);
+	int v0 = (int)v;
+	int v1 = std::min(v0 + 1, tMax);
+
+	float fracU = u - u0;
+	float fracV = v - v0;
+
+	const T* d00 = reinterpret_cast<const T*>(image.data(u0, v0));
+	const T* d10 = reinterpret_cast<const T*>(image.data(u1, v0));
+	const T* d01 = reinterpret_cast<const T*>(image.data(u0, v1));
+	const T* d11 = reinterpret_cast<const T*>(image.data(u1, v1));
+
+	for (int c = 0; c < componentCount; ++c)
+	{
+		float d0 = math::lerp(float(d00[c]), float(d10[c]), fracU);
+		float d1 = math::lerp(float(d01[c]), float(d11[c]), fracU);
+		result[c] = T(math::lerp(d0, d1, fracV));
+	}
+}
+
+//! Downsamples source image by a factor of 2 into the destination image at the given pixel offset
+template <typename T>
+void downsample(const osg::Image& src, osg::Image& dst, int offsetX, int offsetY, int componentCount, Filtering filtering)
+{
+	int width = src.s() / 2;
+	int height = src.t() / 2;
+
+	for (int y = 0; y < height; ++y)
+	{
+		const T* row0 = reinterpret_cast<const T*>(src.data(0, y * 2));
+		const T* row1 = reinterpret_cast<const T*>(src.data(0, y * 2 + 1));
+		T* out = reinterpret_cast<T*>(dst.data(offsetX, offsetY + y));
+
+		if (filtering == Filtering::NearestNeighbor)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int c = 0; c < componentCount; ++c)
+				{
+					*out++ = row0[x * 2 * componentCount + c];
+				}
+			}
+		}
+		else
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				int i0 = x * 2 * componentCount;
+				int i1 = i0 + componentCount;
+				for (int c = 0; c < componentCount; ++c)
+				{
+					unsigned int sum = unsigned(row0[i0 + c]) + row0[i1 + c] + row1[i0 + c] + row1[i1 + c];
+					*out++ = T((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+//! Generic downsampling for formats not supported by the typed version
+void downsampleGeneric(const osg::Image& src, osg::Image& dst, int offsetX, int offsetY, Filtering filtering)
 {
-	TileGenerator(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering = Filtering::Bilinear) :
-		outputDirectory(outputDirectory), tileDimensions(tileDimensions), layers(layers), filtering(filtering)
+	for (int y = 0; y < src.t() / 2; ++y)
+	{
+		for (int x = 0; x < src.s() / 2; ++x)
+		{
+			osg::Vec4f c = src.getColor(x * 2, y * 2);
+			if (filtering != Filtering::NearestNeighbor)
+			{
+				c = (c + src.getColor(x * 2 + 1, y * 2) + src.getColor(x * 2, y * 2 + 1) + src.getColor(x * 2 + 1, y * 2 + 1)) * 0.25f;
+			}
+			dst.setColor(c, offsetX + x, offsetY + y);
+		}
+	}
+}
+
+class TileMapBuilder
+{
+public:
+	TileMapBuilder(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering, const TileMapGeneratorOptions& options) :
+		mOutputDirectory(outputDirectory),
+		mTileDimensions(tileDimensions),
+		mLayers(layers),
+		mFiltering(filtering),
+		mMaxJobsInFlight(std::max(1, options.maxJobsInFlight)),
+		mTypedFormat(hasUniformTypedFormat(layers)),
+		mComponentCount(osg::Image::computeNumComponents(layers.back().image->getPixelFormat()))
 	{
 		for (const TileMapGeneratorLayer& layer : layers)
 		{
-			layerResolutions.push_back(std::max(layer.image->s() / layer.bounds.size().x(), layer.image->t() / layer.bounds.size().y()));
+			mLayerResolutions.push_back(std::max(layer.image->s() / layer.bounds.size().x(), layer.image->t() / layer.bounds.size().y()));
 		}
+
+		int threadCount = options.threadCount > 0 ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+		px_sched::SchedulerParams schedulerParams;
+		schedulerParams.max_running_threads = threadCount;
+		schedulerParams.num_threads = threadCount;
+		mScheduler.init(schedulerParams);
 	}
 
-	bool operator()(const DefaultTile<osg::Vec2d>& tile) const
+	~TileMapBuilder()
 	{
-		osg::Image* srcImage = layers.back().image;
+		mScheduler.waitFor(mSync);
+	}
 
-		osg::ref_ptr<osg::Image> image = new osg::Image();
-		image->allocateImage(tileDimensions.x(), tileDimensions.y(), 1, srcImage->getPixelFormat(), srcImage->getDataType());
+	void addRootTile(const QuadTreeTileKey& key, const Box2d& bounds)
+	{
+		addTile(key, bounds, nullptr);
+	}
+
+	void waitForCompletion()
+	{
+		mScheduler.waitFor(mSync);
+	}
 
+private:
+	//! Called on the main thread. Traverses tiles depth first, queuing leaf tiles for generation from the layers.
+	void addTile(const QuadTreeTileKey& key, const Box2d& bounds, const ParentTilePtr& parent)
+	{
+		if (requiresSubdivision(bounds))
+		{
+			auto tile = std::make_shared<ParentTile>();
+			tile->key = key;
+			tile->bounds = bounds;
+			tile->image = createTileImage();
+			tile->parent = parent;
+
+			// Use QuadTree's subdivision scheme to guarantee the same layout as other quad tree users
+			QuadTree<DefaultTile<osg::Vec2d>> tree(createDefaultTile<osg::Vec2d>, key, bounds);
+			tree.subdivide(tree.getRoot());
+			for (const auto& child : tree.getRoot().children)
+			{
+				addTile(child->key, child->bounds, tile);
+			}
+		}
+		else
+		{
+			runJob([this, key, bounds, parent] {
+				completeTile(key, bounds, sampleLayers(bounds), parent);
+			});
+		}
+	}
+
+	bool requiresSubdivision(const Box2d& bounds) const
+	{
 		float maxSrcResolution = 0;
-		for (int y = 0; y < tileDimensions.y(); ++y)
+		for (int i = (int)mLayers.size() - 1; i >= 0; --i)
 		{
-			for (int x = 0; x < tileDimensions.x(); ++x)
+			const TileMapGeneratorLayer& layer = mLayers[i];
+			if (layer.bounds.intersects(bounds))
 			{
-				Box2d pixelBounds(osg::Vec2d(double(x) / double(tileDimensions.x()), double(y) / double(tileDimensions.y())),
-								  osg::Vec2d(double(x+1) / double(tileDimensions.x()), double(y+1) / double(tileDimensions.y())));
+				maxSrcResolution = std::max(maxSrcResolution, mLayerResolutions[i]);
+				if (contains(layer.bounds, bounds))
+				{
+					// Layers below this one are hidden
+					break;
+				}
+			}
+		}
 
-				osg::Vec2d size = tile.bounds.size();
-				pixelBounds.minimum = tile.bounds.minimum + math::componentWiseMultiply(pixelBounds.minimum, size);
-				pixelBounds.maximum = tile.bounds.minimum + math::componentWiseMultiply(pixelBounds.maximum, size);
+		float outputResolution = std::max(mTileDimensions.x() / bounds.size().x(), mTileDimensions.y() / bounds.size().y());
+		return maxSrcResolution > outputResolution;
+	}
 
-				bool pixelWritten = false;
+	static bool contains(const Box2d& outer, const Box2d& inner)
+	{
+		return outer.minimum.x() <= inner.minimum.x() && outer.minimum.y() <= inner.minimum.y()
+			&& outer.maximum.x() >= inner.maximum.x() && outer.maximum.y() >= inner.maximum.y();
+	}
+
+	osg::ref_ptr<osg::Image> createTileImage() const
+	{
+		const osg::Image* srcImage = mLayers.back().image;
+
+		osg::ref_ptr<osg::Image> image = new osg::Image();
+		image->allocateImage(mTileDimensions.x(), mTileDimensions.y(), 1, srcImage->getPixelFormat(), srcImage->getDataType());
+		return image;
+	}
+
+	//! Called on a worker thread
+	osg::ref_ptr<osg::Image> sampleLayers(const Box2d& bounds) const
+	{
+		osg::ref_ptr<osg::Image> image = createTileImage();
+
+		// Find layers that could contribute to this tile, in priority order
+		std::vector<int> layerIndices;
+		for (int i = (int)mLayers.size() - 1; i >= 0; --i)
+		{
+			if (mLayers[i].bounds.intersects(bounds))
+			{
+				layerIndices.push_back(i);
+			}
+		}
+
+		if (!mTypedFormat)
+		{
+			sampleLayersGeneric(bounds, layerIndices, *image);
+		}
+		else if (image->getDataType() == GL_UNSIGNED_BYTE)
+		{
+			sampleLayersTyped<std::uint8_t>(bounds, layerIndices, *image);
+		}
+		else
+		{
+			sampleLayersTyped<std::uint16_t>(bounds, layerIndices, *image);
+		}
+		return image;
+	}
+
+	Box2d getPixelBounds(const Box2d& tileBounds, int x, int y) const
+	{
+		Box2d pixelBounds(osg::Vec2d(double(x) / double(mTileDimensions.x()), double(y) / double(mTileDimensions.y())),
+						  osg::Vec2d(double(x+1) / double(mTileDimensions.x()), double(y+1) / double(mTileDimensions.y())));
 
-				for (int i = layers.size() - 1; i >= 0; --i)
+		osg::Vec2d size = tileBounds.size();
+		pixelBounds.minimum = tileBounds.minimum + math::componentWiseMultiply(pixelBounds.minimum, size);
+		pixelBounds.maximum = tileBounds.minimum + math::componentWiseMultiply(pixelBounds.maximum, size);
+		return pixelBounds;
+	}
+
+	//! @returns index of the highest priority layer intersecting the pixel, or -1 if there is none
+	int findLayer(const std::vector<int>& layerIndices, const Box2d& pixelBounds) const
+	{
+		for (int i : layerIndices)
+		{
+			if (mLayers[i].bounds.intersects(pixelBounds))
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	template <typename T>
+	void sampleLayersTyped(const Box2d& bounds, const std::vector<int>& layerIndices, osg::Image& image) const
+	{
+		for (int y = 0; y < mTileDimensions.y(); ++y)
+		{
+			T* out = reinterpret_cast<T*>(image.data(0, y));
+			for (int x = 0; x < mTileDimensions.x(); ++x)
+			{
+				Box2d pixelBounds = getPixelBounds(bounds, x, y);
+				int i = findLayer(layerIndices, pixelBounds);
+				if (i >= 0)
 				{
-					const TileMapGeneratorLayer& layer = layers[i];
-					if (layer.bounds.intersects(pixelBounds))
-					{// TODO: downsample filter
-						maxSrcResolution = std::max(maxSrcResolution, layerResolutions[i]);
-
-						osg::Vec2d pSrc = math::componentWiseDivide(pixelBounds.center() - layer.bounds.minimum, layer.bounds.size());
-						osg::Vec4f c;
-						switch (filtering)
-						{
-						case Filtering::NearestNeighbor:
-							c = layer.image->getColor(pSrc);
-							break;
-						case Filtering::Bilinear:
-							c = vis::getColorBilinear(*layer.image, osg::Vec2f(pSrc.x() * layer.image->s(), pSrc.y() * layer.image->t()));
-							break;
-						default:
-							assert(!"Not implemented");
-						}
-						image->setColor(c, x, y);
-						pixelWritten = true;
+					const TileMapGeneratorLayer& layer = mLayers[i];
+					osg::Vec2d pSrc = math::componentWiseDivide(pixelBounds.center() - layer.bounds.minimum, layer.bounds.size());
+					switch (mFiltering)
+					{
+					case Filtering::NearestNeighbor:
+						sampleNearest(*layer.image, pSrc, mComponentCount, out);
+						break;
+					case Filtering::Bilinear:
+						sampleBilinear(*layer.image, pSrc, mComponentCount, out);
 						break;
+					default:
+						assert(!"Not implemented");
 					}
 				}
+				else
+				{
+					std::fill(out, out + mComponentCount, T(0));
+				}
+				out += mComponentCount;
+			}
+		}
+	}
 
-				if (!pixelWritten)
+	void sampleLayersGeneric(const Box2d& bounds, const std::vector<int>& layerIndices, osg::Image& image) const
+	{
+		for (int y = 0; y < mTileDimensions.y(); ++y)
+		{
+			for (int x = 0; x < mTileDimensions.x(); ++x)
+			{
+				Box2d pixelBounds = getPixelBounds(bounds, x, y);
+				int i = findLayer(layerIndices, pixelBounds);
+				osg::Vec4f c(0, 0, 0, 0);
+				if (i >= 0)
 				{
-					image->setColor(osg::Vec4(0,0,0,0), x, y);
+					const TileMapGeneratorLayer& layer = mLayers[i];
+					osg::Vec2d pSrc = math::componentWiseDivide(pixelBounds.center() - layer.bounds.minimum, layer.bounds.size());
+					switch (mFiltering)
+					{
+					case Filtering::NearestNeighbor:
+						c = layer.image->getColor(pSrc);
+						break;
+					case Filtering::Bilinear:
+						c = vis::getColorBilinear(*layer.image, osg::Vec2f(pSrc.x() * layer.image->s(), pSrc.y() * layer.image->t()));
+						break;
+					default:
+						assert(!"Not implemented");
+					}
 				}
+				image.setColor(c, x, y);
 			}
 		}
+	}
+
+	//! Called on a worker thread when a tile's image is complete.
+	//! Queues the image to be written, and downsamples it into the parent, completing the parent if this was its last child.
+	void completeTile(const QuadTreeTileKey& key, const Box2d& bounds, const osg::ref_ptr<osg::Image>& image, const ParentTilePtr& parent)
+	{
+		runJob([this, key, image] {
+			writeTile(key, *image);
+		});
+
+		if (parent)
+		{
+			osg::Vec2d parentCenter = parent->bounds.center();
+			osg::Vec2d center = bounds.center();
+			int offsetX = center.x() > parentCenter.x() ? mTileDimensions.x() / 2 : 0;
+			int offsetY = center.y() > parentCenter.y() ? mTileDimensions.y() / 2 : 0;
 
-		std::string path = outputDirectory + "/" + std::to_string(tile.key.level);
+			// Each child writes to a different quadrant of the parent image, so no locking is required
+			if (!mTypedFormat)
+			{
+				downsampleGeneric(*image, *parent->image, offsetX, offsetY, mFiltering);
+			}
+			else if (image->getDataType() == GL_UNSIGNED_BYTE)
+			{
+				downsample<std::uint8_t>(*image, *parent->image, offsetX, offsetY, mComponentCount, mFiltering);
+			}
+			else
+			{
+				downsample<std::uint16_t>(*image, *parent->image, offsetX, offsetY, mComponentCount, mFiltering);
+			}
+
+			if (--parent->remainingChildren == 0)
+			{
+				completeTile(parent->key, parent->bounds, parent->image, parent->parent);
+			}
+		}
+	}
+
+	void writeTile(const QuadTreeTileKey& key, const osg::Image& image) const
+	{
+		std::string path = mOutputDirectory + "/" + std::to_string(key.level);
 		std::filesystem::create_directory(path);
-		path += +"/" + std::to_string(tile.key.x);
+		path += "/" + std::to_string(key.x);
 		std::filesystem::create_directory(path);
 
-		path += "/" + std::to_string(tile.key.y) + ".png";
+		path += "/" + std::to_string(key.y) + ".png";
 
 		printf("Writing %s\n", path.c_str());
-		osgDB::writeImageFile(*image, path);
+		if (!osgDB::writeImageFile(image, path))
+		{
+			fprintf(stderr, "Could not write %s\n", path.c_str());
+		}
+	}
+
+	//! Runs the job on the scheduler.
+	//! If called from the main thread, blocks while the maximum number of jobs are in flight.
+	//! Worker threads never block, so jobs spawned by other jobs cannot deadlock.
+	void runJob(std::function<void()> job)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mJobsInFlightMutex);
+			if (std::this_thread::get_id() == mMainThreadId)
+			{
+				mJobsInFlightChanged.wait(lock, [this] { return mJobsInFlight < mMaxJobsInFlight; });
+			}
+			++mJobsInFlight;
+		}
 
-		float outputResolution = std::max(tileDimensions.x() / tile.bounds.size().x(), tileDimensions.y() / tile.bounds.size().y());
-		return (maxSrcResolution > outputResolution);
+		mScheduler.run([this, job = std::move(job)] {
+			job();
+			{
+				std::scoped_lock<std::mutex> lock(mJobsInFlightMutex);
+				--mJobsInFlight;
+			}
+			mJobsInFlightChanged.notify_all();
+		}, &mSync);
 	}
 
-	const std::string& outputDirectory;
-	const osg::Vec2i& tileDimensions;
-	const std::vector<TileMapGeneratorLayer>& layers;
-	std::vector<float> layerResolutions;
-	Filtering filtering;
+private:
+	const std::string mOutputDirectory;
+	const osg::Vec2i mTileDimensions;
+	const std::vector<TileMapGeneratorLayer>& mLayers;
+	const Filtering mFiltering;
+	const int mMaxJobsInFlight;
+	const bool mTypedFormat; //!< True if layers can be sampled with typed functions rather than osg::Image::getColor()
+	const int mComponentCount;
+	std::vector<float> mLayerResolutions;
+
+	px_sched::Scheduler mScheduler;
+	px_sched::Sync mSync;
+
+	const std::thread::id mMainThreadId = std::this_thread::get_id();
+	std::mutex mJobsInFlightMutex;
+	std::condition_variable mJobsInFlightChanged;
+	int mJobsInFlight = 0;
 };
 
-void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering)
+} // namespace
+
+void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering, const TileMapGeneratorOptions& options)
 {
 	if (layers.empty())
 	{
@@ -114,14 +489,13 @@ void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileD
 		throw skybolt::Exception("Output directory '" + outputDirectory + "' does not exist");
 	}
 
-	Box2d bounds(osg::Vec2d(-math::piD(), -math::halfPiD()), osg::Vec2d(0, math::halfPiD()));
-	QuadTree<DefaultTile<osg::Vec2d>> treeLeft(createDefaultTile<osg::Vec2d>, QuadTreeTileKey(0, 0, 0), bounds);
-	
-	bounds = Box2d(osg::Vec2d(0, -math::halfPiD()), osg::Vec2d(math::piD(), math::halfPiD()));
-	QuadTree<DefaultTile<osg::Vec2d>> treeRight(createDefaultTile<osg::Vec2d>, QuadTreeTileKey(0, 1, 0), bounds);
-
-	TileGenerator tileGenerator(outputDirectory, tileDimensions, layers, filtering);
+	if (tileDimensions.x() % 2 != 0 || tileDimensions.y() % 2 != 0)
+	{
+		throw skybolt::Exception("Tile dimensions must be even");
+	}
 
-	treeLeft.subdivideRecursively(treeLeft.getRoot(), tileGenerator);
-	treeRight.subdivideRecursively(treeRight.getRoot(), tileGenerator);
+	TileMapBuilder builder(outputDirectory, tileDimensions, layers, filtering, options);
+	builder.addRootTile(QuadTreeTileKey(0, 0, 0), Box2d(osg::Vec2d(-math::piD(), -math::halfPiD()), osg::Vec2d(0, math::halfPiD())));
+	builder.addRootTile(QuadTreeTileKey(0, 1, 0), Box2d(osg::Vec2d(0, -math::halfPiD()), osg::Vec2d(math::piD(), math::halfPiD())));
+	builder.waitForCompletion();
 }
@@ -18,9 +18,19 @@ struct TileMapGeneratorLayer
 
 enum class Filtering
 {
-	NearestNeighbor,
-	Bilinear
+	NearestNeighbor, //!< Coarser levels are point sampled from their children
+	Bilinear //!< Coarser levels are 2x2 box filtered from their children
 };
 
-//! Generates herichical tile map in XYZ format
-void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering);
+struct TileMapGeneratorOptions
+{
+	int threadCount = 0; //!< Number of worker threads. If 0, the number of hardware threads is used.
+	int maxJobsInFlight = 64; //!< Maximum number of tile generation and write jobs queued at once. Bounds memory use.
+};
+
+//! Generates herichical tile map in XYZ format.
+//! Tiles at the deepest level required by the layer resolutions are sampled from the layers in parallel,
+//! and each coarser tile is downsampled from its four children rather than resampled from the layers.
+//! Tile dimensions must be even.
+void generateTileMap(const std::string& outputDirectory, const osg::Vec2i& tileDimensions, const std::vector<TileMapGeneratorLayer>& layers, Filtering filtering,
+	const TileMapGeneratorOptions& options = TileMapGeneratorOptions());
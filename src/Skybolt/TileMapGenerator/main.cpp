@@ -7,9 +7,14 @@
 #include "TileMapGenerator.h"
 #include <SkyboltVis/OsgImageHelpers.h>
 #include <SkyboltVis/OsgMathHelpers.h>
+#include <SkyboltCommon/File/FileUtility.h>
 #include <SkyboltCommon/Math/MathUtility.h>
 #include <osgDB/ReadFile>
 
+#include <chrono>
+#include <filesystem>
+#include <random>
+
 using namespace skybolt::vis;
 using namespace skybolt;
 
@@ -141,7 +146,70 @@ int main_dem()
 	return EXIT_SUCCESS;
 }
 
-int main()
+osg::ref_ptr<osg::Image> createSyntheticHeightmap(int width, int height)
+{
+	osg::ref_ptr<osg::Image> image = new osg::Image();
+	image->allocateImage(width, height, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
+
+	std::mt19937 generator(width);
+	std::uniform_int_distribution<int> noise(0, 255);
+
+	uint16_t* p = (uint16_t*)image->data();
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			*p++ = uint16_t(16384 + 8192 * std::sin(x * 0.01) * std::cos(y * 0.013) + noise(generator));
+		}
+	}
+	return image;
+}
+
+//! Generates a tile map from synthetic layers and reports the time taken
+int main_benchmark()
+{
+	std::string outputDirectory = (std::filesystem::temp_directory_path() / "TileMapGeneratorBenchmark").string();
+	std::filesystem::remove_all(outputDirectory);
+	std::filesystem::create_directories(outputDirectory);
+
+	osg::Vec2i tileDimensions(256, 256);
+
+	std::vector<TileMapGeneratorLayer> layers;
+	{
+		TileMapGeneratorLayer layer;
+		layer.image = createSyntheticHeightmap(4096, 2048);
+		layer.bounds = Box2d(osg::Vec2d(-math::piD(), -math::halfPiD()), osg::Vec2d(math::piD(), math::halfPiD()));
+		layers.push_back(layer);
+	}
+	{
+		TileMapGeneratorLayer layer;
+		layer.image = createSyntheticHeightmap(2048, 2048);
+		layer.bounds = Box2d(osg::Vec2d(osg::DegreesToRadians(-125.0), osg::DegreesToRadians(45.0)), osg::Vec2d(osg::DegreesToRadians(-120.0), osg::DegreesToRadians(50.0)));
+		layers.push_back(layer);
+	}
+
+	try
+	{
+		auto start = std::chrono::steady_clock::now();
+		generateTileMap(outputDirectory, tileDimensions, layers, Filtering::Bilinear);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		size_t tileCount = file::findFilenamesInDirectoryRecursive(outputDirectory, ".png").size();
+		std::cout << "Generated " << tileCount << " tiles in " << seconds << "s" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
 {
+	if (argc > 1 && std::string(argv[1]) == "--benchmark")
+	{
+		return main_benchmark();
+	}
 	return main_dem();
 }
\ No newline at end of file
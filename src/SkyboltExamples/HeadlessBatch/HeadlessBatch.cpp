@@ -0,0 +1,112 @@
+/* Copyright 2012-2020 Matthew Reid
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Runs batches of independent simulations without rendering, e.g. for Monte Carlo trials on machines without a GPU.
+
+#include <SkyboltEngine/EngineCommandLineParser.h>
+#include <SkyboltEngine/EngineRoot.h>
+#include <SkyboltEngine/EngineRootFactory.h>
+#include <SkyboltEngine/EngineSettings.h>
+#include <SkyboltEngine/EntityFactory.h>
+#include <SkyboltEngine/GetExecutablePath.h>
+#include <SkyboltEngine/Plugin/PluginHelpers.h>
+#include <SkyboltEngine/UpdateLoop/HeadlessRunner.h>
+
+#include <SkyboltSim/World.h>
+#include <SkyboltSim/Spatial/Position.h>
+
+#include <SkyboltCommon/Random.h>
+#include <SkyboltCommon/Math/MathUtility.h>
+
+#include <iostream>
+#include <mutex>
+
+using namespace skybolt;
+using namespace skybolt::sim;
+
+namespace po = boost::program_options;
+
+//! Spawns entities at random positions drawn from the run's seed, so that each run can be reproduced
+static void createEntities(EngineRoot& engineRoot, const std::string& templateName, int entityCount, std::uint32_t seed)
+{
+	const EntityFactory& entityFactory = *engineRoot.entityFactory;
+	World& world = *engineRoot.simWorld;
+
+	world.addEntity(entityFactory.createEntity("PlanetEarth"));
+
+	Random random(int(seed));
+	for (int i = 0; i < entityCount; ++i)
+	{
+		LatLonAlt position(
+			math::degToRadD() * random.rangedRand(-33.9f, -33.8f),
+			math::degToRadD() * random.rangedRand(151.1f, 151.3f),
+			random.rangedRand(500.0f, 3000.0f));
+
+		world.addEntity(entityFactory.createEntity(templateName, "", toGeocentric(LatLonAltPosition(position)).position));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	try
+	{
+		po::options_description desc;
+		EngineCommandLineParser::addOptions(desc);
+		desc.add_options()
+			("template", po::value<std::string>()->required(), "entity template to spawn in each run")
+			("entityCount", po::value<int>()->default_value(1), "number of entities to spawn in each run")
+			("runs", po::value<int>()->default_value(1), "number of independent runs")
+			("threads", po::value<int>()->default_value(0), "number of runs executed in parallel, or 0 for one per CPU core")
+			("seed", po::value<std::uint32_t>()->default_value(0), "seed of the first run. Run i uses seed + i.")
+			("duration", po::value<double>()->default_value(60.0), "simulation time of each run in seconds")
+			("dt", po::value<double>()->default_value(1.0 / 60.0), "fixed simulation time step in seconds");
+
+		auto params = EngineCommandLineParser::parse(argc, argv, desc);
+
+		nlohmann::json settings = readEngineSettings(params);
+		std::string pluginsDir = getExecutablePath().append("plugins").string();
+		std::vector<PluginFactory> pluginFactories = loadPluginFactories<Plugin, PluginConfig>(pluginsDir);
+
+		EngineRootConfig engineConfig = EngineRootFactory::createConfig(pluginFactories, settings);
+		engineConfig.enableVis = false;
+		engineConfig.schedulerThreadCount = 1; // Runs are already executed in parallel
+
+		BatchRunConfig batchConfig;
+		batchConfig.runCount = params["runs"].as<int>();
+		batchConfig.threadCount = params["threads"].as<int>();
+		batchConfig.baseSeed = params["seed"].as<std::uint32_t>();
+
+		HeadlessRunConfig runConfig;
+		runConfig.dt = params["dt"].as<double>();
+		runConfig.duration = params["duration"].as<double>();
+
+		std::string templateName = params["template"].as<std::string>();
+		int entityCount = params["entityCount"].as<int>();
+
+		std::mutex engineCreationMutex;
+		BatchRunStats stats = runBatch(batchConfig, [&] (const BatchRun& run) {
+			std::unique_ptr<EngineRoot> engineRoot;
+			{
+				// Plugins are not required to support concurrent creation
+				std::scoped_lock lock(engineCreationMutex);
+				engineRoot = std::make_unique<EngineRoot>(engineConfig);
+			}
+			createEntities(*engineRoot, templateName, entityCount, run.seed);
+			return runHeadless(*engineRoot, runConfig);
+		});
+
+		std::cout << "Simulated " << stats.getSimDuration() << "s over " << stats.runs.size() << " runs in " << stats.wallDuration << "s ("
+			<< stats.getThroughput() << " sim seconds per wall second)" << std::endl;
+
+		return stats.getFailedRunCount() == 0 ? 0 : 1;
+	}
+	catch (const std::exception& e)
+	{
+		printf("%s\n", e.what());
+	}
+
+	return 1;
+}
@@ -327,7 +327,7 @@ MainWindow::MainWindow(const std::vector<PluginFactory>& enginePluginFactories,
 	mEngineSettings = readOrCreateEngineSettingsFile(this, mSettings);
 
 	mEngineRoot = EngineRootFactory::create(enginePluginFactories, mEngineSettings);
-	mSimStepper = std::make_unique<SimStepper>(mEngineRoot->systemRegistry);
+	mSimStepper = std::make_unique<SimStepper>(mEngineRoot->systemRegistry, mEngineRoot->simStepperConfig);
 
 	mOsgWidget = new OsgWidget();
 	mRenderTarget = vis::createAndAddViewportToWindow(*mOsgWidget->getWindow(), mEngineRoot->programs.getRequiredProgram("compositeFinal"));
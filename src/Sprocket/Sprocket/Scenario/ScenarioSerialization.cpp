@@ -107,12 +107,7 @@ static void loadCameraController(CameraControllerSelector& cameraControllerSelec
 
 static Entity* findObjectInWorld(const World& world, const std::string& name)
 {
-	for (const EntityPtr& entity : world.getEntities())
-	{
-		if (getName(*entity) == name)
-			return entity.get();
-	}
-	return nullptr;
+	return world.findEntityByName(name).get();
 }
 
 static sim::AttachmentComponent* findFreeAttachmentAcceptingEntityTemplate(const Entity& entity, const std::string& templateName)